@@ -0,0 +1,192 @@
+/* attitude_estimator.c */
+#include "attitude_estimator.h"
+#include <math.h>
+#include <string.h>
+
+#define ATT_RAD2DEG                 (57.29577951f)
+#define ATT_GRAVITY                 (9.80665f)
+#define ATT_DT_MAX_S                (0.05f)     /* longer gaps (frame loss) -> re-seed from accel */
+#define ATT_EKF_R_GATED_SCALE       (100.0f)    /* R inflation while accel is outside the gate */
+
+static attitude_estimator_config_t att_config =
+{
+    /* cf_kp, cf_ki: ~0.3Hz crossover, bias converges in a few seconds */
+    2.0f, 0.3f,
+
+    /* ekf_q_angle, ekf_q_bias, ekf_r_acc */
+    0.02f, 0.0005f, 4.0f,
+
+    /* acc_gate_g */
+    0.15f
+};
+
+static attitude_mode_enum att_mode = ATTITUDE_MODE_YIS;
+
+static float att_roll = 0.0f;
+static float att_rate = 0.0f;
+static float att_bias = 0.0f;
+static float att_acc_roll = 0.0f;
+static uint8 att_acc_used = 0;
+static uint8 att_seeded = 0;
+
+/* EKF covariance, symmetric: p00 roll, p01 roll/bias, p11 bias */
+static float p00 = 1.0f, p01 = 0.0f, p11 = 0.1f;
+
+/* Accel tilt reference. Returns 0 when the frame carried no accel (0x10 not enabled
+ * on the module), 1 when usable, 2 when present but outside the 1g gate. */
+static uint8 acc_roll_from(float acc_y, float acc_z, float *roll_deg)
+{
+    float norm = sqrtf(acc_y * acc_y + acc_z * acc_z) * (1.0f / ATT_GRAVITY);
+
+    if (norm < 1e-3f)
+    {
+        return 0;
+    }
+    *roll_deg = atan2f(acc_y, acc_z) * ATT_RAD2DEG;
+    return (fabsf(norm - 1.0f) <= att_config.acc_gate_g) ? 1u : 2u;
+}
+
+static void complementary_update(float gyro, float acc_roll, uint8 acc_ok, float dt)
+{
+    att_roll += (gyro - att_bias) * dt;
+    if (acc_ok)
+    {
+        float e = acc_roll - att_roll;
+        att_roll += att_config.cf_kp * e * dt;
+        att_bias -= att_config.cf_ki * e * dt;
+    }
+}
+
+static void ekf_update(float gyro, float acc_roll, uint8 acc_ok, float dt)
+{
+    /* predict: roll += (gyro - bias) * dt, F = [1 -dt; 0 1] */
+    att_roll += (gyro - att_bias) * dt;
+
+    p00 += dt * (dt * p11 - 2.0f * p01) + att_config.ekf_q_angle * dt;
+    p01 -= dt * p11;
+    p11 += att_config.ekf_q_bias * dt;
+
+    /* correct with accel roll, H = [1 0]. A gated sample still goes in, just heavily de-weighted,
+       so a long manoeuvre cannot let the covariance grow without bound. */
+    {
+        float r = acc_ok ? att_config.ekf_r_acc : att_config.ekf_r_acc * ATT_EKF_R_GATED_SCALE;
+        float s = p00 + r;
+        float k0 = p00 / s;
+        float k1 = p01 / s;
+        float y = acc_roll - att_roll;
+
+        att_roll += k0 * y;
+        att_bias += k1 * y;
+
+        p11 -= k1 * p01;
+        p01 -= k1 * p00;    /* uses the old p00 */
+        p00 -= k0 * p00;
+    }
+}
+
+void attitude_estimator_init(attitude_mode_enum mode)
+{
+    att_mode = mode;
+    att_roll = 0.0f;
+    att_rate = 0.0f;
+    att_bias = 0.0f;
+    att_acc_roll = 0.0f;
+    att_acc_used = 0;
+    att_seeded = 0;
+
+    p00 = 1.0f;
+    p01 = 0.0f;
+    p11 = 0.1f;
+}
+
+void attitude_estimator_set_mode(attitude_mode_enum mode)
+{
+    if (mode != att_mode)
+    {
+        /* keep the bias, re-seed the angle from the next accel sample */
+        att_mode = mode;
+        att_seeded = 0;
+    }
+}
+
+attitude_mode_enum attitude_estimator_get_mode(void)
+{
+    return att_mode;
+}
+
+void attitude_estimator_set_config(const attitude_estimator_config_t *config)
+{
+    if (config != NULL)
+    {
+        att_config = *config;
+    }
+}
+
+void attitude_estimator_get_config(attitude_estimator_config_t *config)
+{
+    if (config != NULL)
+    {
+        *config = att_config;
+    }
+}
+
+void attitude_estimator_update(float gyro_x_dps, float acc_y, float acc_z, float yis_roll_deg, float dt_s)
+{
+    uint8 acc_state = acc_roll_from(acc_y, acc_z, &att_acc_roll);
+    uint8 acc_ok = (acc_state == 1u);
+
+    if (att_mode == ATTITUDE_MODE_YIS || acc_state == 0u)
+    {
+        /* no accel stream: gyro-only integration would drift, fall back to the module roll */
+        att_seeded = 0;
+        att_roll = yis_roll_deg;
+        att_rate = gyro_x_dps - att_bias;
+        att_acc_used = 0;
+        return;
+    }
+
+    if (!att_seeded || dt_s <= 0.0f || dt_s > ATT_DT_MAX_S)
+    {
+        /* first sample or a gap: start from the accel angle (or the module angle if accel is unusable) */
+        att_roll = acc_ok ? att_acc_roll : yis_roll_deg;
+        att_rate = gyro_x_dps - att_bias;
+        att_seeded = 1;
+        att_acc_used = acc_ok;
+        return;
+    }
+
+    if (att_mode == ATTITUDE_MODE_EKF)
+    {
+        ekf_update(gyro_x_dps, att_acc_roll, acc_ok, dt_s);
+    }
+    else
+    {
+        complementary_update(gyro_x_dps, att_acc_roll, acc_ok, dt_s);
+    }
+
+    att_rate = gyro_x_dps - att_bias;
+    att_acc_used = acc_ok;
+}
+
+float attitude_estimator_get_roll(void)
+{
+    return att_roll;
+}
+
+float attitude_estimator_get_rate(void)
+{
+    return att_rate;
+}
+
+void attitude_estimator_get_estimate(attitude_estimate_t *out)
+{
+    if (out == NULL)
+    {
+        return;
+    }
+    out->roll_deg = att_roll;
+    out->rate_dps = att_rate;
+    out->gyro_bias_dps = att_bias;
+    out->acc_roll_deg = att_acc_roll;
+    out->acc_used = att_acc_used;
+}
@@ -0,0 +1,54 @@
+/* attitude_estimator.h */
+#ifndef ATTITUDE_ESTIMATOR_H
+#define ATTITUDE_ESTIMATOR_H
+
+#include "zf_common_headfile.h"
+
+/* Roll estimation from the YIS raw gyro (0x20) + accelerometer (0x10) fields.
+ * All angles in deg, rates in deg/s, acceleration in m/s^2 (YIS units). */
+typedef enum
+{
+    ATTITUDE_MODE_YIS = 0,          /* pass-through: trust the module's internal roll */
+    ATTITUDE_MODE_COMPLEMENTARY,    /* PI complementary filter, integral term tracks gyro bias */
+    ATTITUDE_MODE_EKF,              /* 2-state Kalman filter: [roll, gyro bias] */
+} attitude_mode_enum;
+
+typedef struct
+{
+    /* complementary */
+    float cf_kp;                    /* accel correction gain (1/s); crossover ~ kp/(2*pi) Hz */
+    float cf_ki;                    /* bias tracking gain (1/s^2) */
+
+    /* EKF */
+    float ekf_q_angle;              /* gyro noise density, deg^2/s */
+    float ekf_q_bias;               /* bias random walk, (deg/s)^2/s */
+    float ekf_r_acc;                /* accel roll measurement noise, deg^2 */
+
+    /* accel gating: ignore/de-weight accel while |a| is far from 1g */
+    float acc_gate_g;               /* reject when ||a|/g - 1| > gate */
+} attitude_estimator_config_t;
+
+typedef struct
+{
+    float roll_deg;                 /* estimate */
+    float rate_dps;                 /* bias corrected gyro */
+    float gyro_bias_dps;            /* tracked gyro bias */
+    float acc_roll_deg;             /* last accelerometer-only roll */
+    uint8 acc_used;                 /* last update applied an accel correction */
+} attitude_estimate_t;
+
+void  attitude_estimator_init           (attitude_mode_enum mode);
+void  attitude_estimator_set_mode       (attitude_mode_enum mode);
+attitude_mode_enum attitude_estimator_get_mode (void);
+void  attitude_estimator_set_config     (const attitude_estimator_config_t *config);
+void  attitude_estimator_get_config     (attitude_estimator_config_t *config);
+
+/* One IMU sample. Call at the full IMU frame rate with the real sample interval.
+ * In ATTITUDE_MODE_YIS the module roll is passed through, the other modes ignore it. */
+void  attitude_estimator_update         (float gyro_x_dps, float acc_y, float acc_z, float yis_roll_deg, float dt_s);
+
+float attitude_estimator_get_roll       (void);
+float attitude_estimator_get_rate       (void);
+void  attitude_estimator_get_estimate   (attitude_estimate_t *out);
+
+#endif
@@ -1,34 +1,139 @@
 /* balance_control.c */
 #include "balance_control.h"
-#include "driver_imu.h"
+#include "driver_imu_fusion.h"
 #include "driver_odrive.h"
+#include "driver_motor.h"
+#include "driver_servo.h"
+#include "attitude_estimator.h"
+#include "imu_calibration.h"
+#include "pid.h"
+#include "gain_schedule.h"
+#include "lqr_gains.h"
+#include "profiler.h"
+#include "flight_recorder.h"
+#include "snapshot.h"
 #include <string.h>
 #include <math.h>
 
 /* =========================
  * Timing
- * ========================= */
-#define BALANCE_CTRL_DT_S              (0.005f)  /* 5ms ISR */
-#define BALANCE_ANGLE_TICK_DIV         (3u)      /* run angle loop every 3*5ms=15ms */
-#define BALANCE_ANGLE_DT_S             (BALANCE_CTRL_DT_S * (float)BALANCE_ANGLE_TICK_DIV)
+ * =========================
+ * BALANCE_SCHEDULE_PIT: one control step per 5ms PIT tick on the newest frame.
+ * BALANCE_SCHEDULE_IMU_FRAME: every verified IMU frame requests a step (through
+ * the trigger set with balance_control_set_step_trigger, so it still runs in the
+ * PIT ISR); the PIT only steps in once no frame has arrived for
+ * BALANCE_WATCHDOG_US. dt is measured either way: between sample arrival times
+ * for frame steps, between steps otherwise. */
+#define BALANCE_SCHEDULE_PIT           (0)
+#define BALANCE_SCHEDULE_IMU_FRAME     (1)
+#ifndef BALANCE_SCHEDULE                          /* frame scheduling pays off from 200 Hz, at 100 Hz the loop rate halves */
+#define BALANCE_SCHEDULE               (BALANCE_SCHEDULE_PIT)
+#endif
+
+#define BALANCE_CTRL_DT_S              (0.005f)  /* 5ms PIT, also dt of the first step */
+#define BALANCE_ANGLE_DT_S             (0.015f)  /* angle loop period, rounded to whole steps */
+#define BALANCE_WATCHDOG_US            (12000u)  /* > one 100 Hz frame period plus jitter */
+#define BALANCE_DT_MIN_S               (0.0005f)
+#define BALANCE_DT_MAX_S               (0.05f)
 
 /* =========================
  * Units / scaling
  * =========================
  * IMPORTANT:
- *  - If yis_imu.roll is in deg and yis_imu.wx is in deg/s -> set to 1.0f
+ *  - If the YIS roll is in deg and its wx is in deg/s -> set to 1.0f
  *  - If they are in rad / rad/s -> set to 1.0f too, but your tuning + safety thresholds must match rad.
  */
 #define BALANCE_IMU_SCALE              (1.0f)
 
+/* Roll source: ATTITUDE_MODE_YIS trusts the module's internal filter,
+ * COMPLEMENTARY / EKF fuse raw gyro + accel at the IMU frame rate.
+ * Frames without accel (0x10) automatically fall back to the module roll. */
+#define BALANCE_ATTITUDE_MODE          (ATTITUDE_MODE_COMPLEMENTARY)
+
 /* Optional safety: stop if tilt too large (in SAME UNIT as scaled roll) */
 #define BALANCE_FALL_ANGLE_LIMIT       (35.0f)   /* e.g. 35deg if using deg */
 
+/* IMU sample age (measurement -> this tick, see imu_get_sample_age_us).
+ * Older than the stale limit: frames stopped or are being dropped, control is
+ * disabled. Otherwise roll is carried forward by roll_rate * age. */
+#define BALANCE_IMU_STALE_US           (25000u)  /* a few 100 Hz frame periods */
+#define BALANCE_IMU_LATENCY_COMP       (1)
+
 /* =========================
  * Output limits
  * ========================= */
 #define BALANCE_TORQUE_LIMIT           (3.0f)    /* final torque command limit to ODrive */
 
+/* =========================
+ * Mode
+ * =========================
+ * BALANCE_MODE_PID runs the cascade below, BALANCE_MODE_LQR a state feedback over
+ * roll error, roll rate and wheel speed every tick, with the gains
+ * tools/sim/lqr_design.cpp computes from the linearised bike (lqr_gains.h).
+ * BALANCE_MODE_STEER is the cascade with its torque demand shared with the
+ * steering servo (see Steering). Each runs in the same tick on the same inputs,
+ * so they can be swapped at runtime and compared on the bike. */
+#define BALANCE_MODE_DEFAULT           (BALANCE_MODE_PID)
+#define BALANCE_LQR_GAIN_SET_DEFAULT   (1u)      /* "nominal" */
+
+/* =========================
+ * Gain schedule
+ * =========================
+ * Every gain of both modes is a gain_schedule.h row over forward speed. There is
+ * no drive wheel encoder, so the speed is the ESC command (motor_get_speed(),
+ * percent) times BALANCE_SPEED_MPS_PER_PERCENT through a first order lag for
+ * the spin-up. Measure both on the bike; the breakpoints are in m/s. */
+#define BALANCE_SPEED_MPS_PER_PERCENT  (0.05f)   /* 100% ~ 5 m/s */
+#define BALANCE_SPEED_TAU_S            (0.8f)
+
+/* =========================
+ * Wheel momentum desaturation
+ * =========================
+ * Holding off a steady roll torque (load off centre, wind, a trim error) takes
+ * a steady motor torque, so the reaction wheel keeps spinning up until the
+ * ODrive has no torque left and the bike falls. In the cascade modes a slow PI
+ * loop on the wheel speed therefore biases the angle loop's target: leaning
+ * into the load lets gravity carry it and the wheel spins down. It runs every
+ * BALANCE_DESAT_DT_S on a filtered wheel speed, far below the angle loop, and
+ * its bias is limited in size and slew. BALANCE_MODE_LQR has the wheel speed in
+ * its state already. A positive torque command spins the wheel up forward and
+ * pushes the frame towards negative roll, so positive kp and ki give a
+ * negative bias for a positive wheel speed. */
+#define BALANCE_DESAT_DEFAULT          (1)
+#define BALANCE_DESAT_DT_S             (0.05f)
+#define BALANCE_DESAT_SPEED_TAU_S      (0.2f)    /* wheel speed filter */
+#define BALANCE_DESAT_KP               (0.05f)   /* deg per rps */
+#define BALANCE_DESAT_KI               (0.02f)   /* deg per rps*s */
+#define BALANCE_DESAT_LIMIT_DEG        (5.0f)
+#define BALANCE_DESAT_SLEW_DEG_S       (1.0f)
+
+/* =========================
+ * Steering (BALANCE_MODE_STEER)
+ * =========================
+ * The cascade's torque demand is split between the steering servo and the
+ * wheel. Steering by delta at speed v puts a roll torque of about
+ * m * h / wheelbase * v^2 * delta on the frame (BALANCE_STEER_NM_PER_DEG_V2, from
+ * 4.5 kg, 0.16 m, 0.3 m: measure the bike). Below BALANCE_STEER_SPEED_MIN_MPS the
+ * wheel does everything; from there to BALANCE_STEER_SPEED_FULL_MPS the steering
+ * share grows to the whole demand. The servo only takes the slow part: the
+ * demand goes through two first order lags of BALANCE_STEER_TAU_S, because
+ * steering fast rocks the frame by itself (the front of the bike moves
+ * sideways) and the cascade's ringing must stay on the wheel. The servo is
+ * written every BALANCE_STEER_DT_S from the control tick, one command per 50 Hz
+ * PWM period, limited in angle and rate. Every tick the wheel gets the demand
+ * minus what the angle on the PWM delivers, so it covers the servo's delay,
+ * its limits and the fast part. A servo angle above
+ * SERVO_ANGLE_CENTER steers towards positive roll for BALANCE_STEER_SIGN +1,
+ * which pushes the frame back like a positive torque command. */
+#define BALANCE_STEER_NM_PER_DEG_V2    (0.0419f) /* Nm per deg of steering per (m/s)^2 */
+#define BALANCE_STEER_SPEED_MIN_MPS    (0.8f)
+#define BALANCE_STEER_SPEED_FULL_MPS   (2.0f)
+#define BALANCE_STEER_DT_S             (0.02f)   /* = 1 / SERVO_PWM_FREQ */
+#define BALANCE_STEER_TAU_S            (0.2f)    /* each of the two demand filters */
+#define BALANCE_STEER_ANGLE_LIMIT_DEG  (20.0f)   /* either side of SERVO_ANGLE_CENTER */
+#define BALANCE_STEER_RATE_DEG_S       (300.0f)
+#define BALANCE_STEER_SIGN             (1.0f)
+
 /* =========================
  * Data structures
  * ========================= */
@@ -48,28 +153,6 @@ typedef struct
     float alpha;
 } LowPassFilter_t;
 
-typedef struct
-{
-    float kp;
-    float ki;
-    float kd;
-    float integral;
-    float last_error;
-    float max_integral;
-    float output_limit;
-} AnglePID_t;
-
-typedef struct
-{
-    float kp;
-    float ki;
-    float kd;
-    float integral;
-    float last_error;
-    float max_integral;
-    float output_limit;
-} AngularVelocityPID_t;
-
 /* =========================
  * Static variables
  * ========================= */
@@ -78,38 +161,133 @@ static AttitudeData_t attitude_data;
 /* Gyro LPF: alphaԽԽ족ͺԽС󡣽 0.15~0.35  */
 static LowPassFilter_t gyr_lpf = { 0.0f, 0.20f };
 
-/* ⻷Ƕ -> ĿٶȣλIMU */
-static AnglePID_t angle_pid =
+/* ⻷Ƕ -> ĿٶȣλIMU
+ * ڻٶ -> ջᱻƵ BALANCE_TORQUE_LIMIT
+ * עڻ kp ű/һ£ôȡ
+ * Ϊٶȶϵϵĳֵٶȱ仯DFlash бĵȱʱΪ׼
+ */
+static const float gain_defaults[GAIN_RATE_KD + 1] =
+{
+    /* kp   ki   kd */
+    1.0f, 0.0f, 0.0f,       /* ǶȻ */
+    -1.0f, 0.00f, 0.0f,     /* ٶȻ */
+};
+static const float schedule_speeds[GAIN_SCHEDULE_POINTS] = { 0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f };
+
+/* ڵķΧ {min, max}˳ͬ gain_schedule_gain_enum */
+static const float gain_limits[GAIN_RATE_KD + 1][2] =
+{
+    { -10.0f, 10.0f }, { -10.0f, 5.0f }, { -10.0f, 2.0f },
+    { -20.0f, 0.0f },  { -10.0f, 1.0f }, { -10.0f, 1.0f },     /* ٶȻ Kp Ǹ */
+};
+
+/* Բֵ΢֣Ŀͻ䲻΢ֳ÷㿹ͣ pid.hkp ki kd ȡ gains */
+static const pid_config_t angle_pid_config =
 {
     /* kp   ki   kd */
-    1.0f, 0.0f, 0.0f,
+    0.0f, 0.0f, 0.0f,
 
-    /* integral, last_error */
-    0.0f, 0.0f,
+    /* setpoint_weight_p, setpoint_weight_d, derivative_tau_s, tracking_tau_s */
+    1.0f, 0.0f, 0.02f, 0.0f,
 
-    /* max_integral, output_limit */
-    50.0f, 80.0f   /* output_limit ǡĿٶȡֵ */
+    /* output_limit */
+    80.0f   /* Ŀٶȡֵ */
 };
 
-/* ڻٶ -> ջᱻƵ BALANCE_TORQUE_LIMIT
- * ע kp ű/һ£ôȡ
- */
-static AngularVelocityPID_t velocity_pid =
+static const pid_config_t velocity_pid_config =
 {
-    /* kp     ki    kd */
-    -1.0f, 0.00f, 0.0f,
+    /* kp   ki   kd */
+    0.0f, 0.0f, 0.0f,
 
-    /* integral, last_error */
-    0.0f, 0.0f,
+    /* setpoint_weight_p, setpoint_weight_d, derivative_tau_s, tracking_tau_s */
+    1.0f, 0.0f, 0.01f, 5.0f,    /* ƽʱس޷أٷᱻ޵ĲԳƴƫ */
 
-    /* max_integral, output_limit */
-    10.0f, BALANCE_TORQUE_LIMIT
+    /* output_limitִ޷Իֱ */
+    BALANCE_TORQUE_LIMIT
 };
 
-static float target_angle = 0.4f;                 /* ĿǶƫã0.4 */
+static const pid_config_t desat_pid_config =
+{
+    /* kp   ki   kd */
+    BALANCE_DESAT_KP, BALANCE_DESAT_KI, 0.0f,
+
+    /* setpoint_weight_p, setpoint_weight_d, derivative_tau_s, tracking_tau_s */
+    1.0f, 0.0f, 0.0f, 0.0f,
+
+    /* output_limit */
+    BALANCE_DESAT_LIMIT_DEG
+};
+
+static pid_controller_t angle_pid;
+static pid_controller_t velocity_pid;
+static pid_controller_t desat_pid;
+
+/* ȱνӿڣCORE_UIв༭ gains_snapshot  5ms ж */
+static gain_schedule_table_t schedule;
+static uint8 schedule_ready = 0;
+static int8  schedule_edit_point = -1;            /* ڵĶϵ㣬-1 Ϊȫ */
+static uint8 schedule_lqr_gain_set = BALANCE_LQR_GAIN_SET_DEFAULT;  /* LQR ȡԵ lqr_gains.h 飬LQR_GAIN_SET_NUM Ϊ DFlash */
+static gain_schedule_table_t gains_slots[2];
+static snapshot_t gains_snapshot;                 /* schedule -> 5ms ISR */
+
+/* 5ms жϣԼı븱뱾 */
+static uint32 gains_applied = 0;                  /* ѱ gains_snapshot  */
+static gain_schedule_table_t schedule_received;
+static gain_schedule_lut_t schedule_lut;
+static float scheduled[GAIN_SCHEDULE_GAIN_NUM];   /* ǰٶµȫ */
+static float forward_speed_mps = 0.0f;            /* ǰٶȹ */
+
+static float target_angle = 0.0f;                 /* ƽĿǶȣװƫ IMU 궨 roll_offset ۳ */
 static float target_angular_velocity = 0.0f;      /* ⻷ */
 static float torque_cmd = 0.0f;                   /*  ODrive Ť */
 static uint8 control_enable = 0;                  /* ʹܱ־ */
+static balance_mode_enum balance_mode = BALANCE_MODE_DEFAULT;
+static float wheel_speed_rps = 0.0f;              /* Ķ ODrive ٣Գܣ */
+static uint8 wheel_speed_valid = 0;
+static volatile uint8 desat_enable = BALANCE_DESAT_DEFAULT;  /* β࿪أжֻ */
+static float desat_bias_deg = 0.0f;               /* ȥͻӵĿǶϵƫ */
+static float desat_wheel_rps = 0.0f;              /* ˲ */
+static float desat_elapsed_s = 0.0f;
+static float steer_deg = 0.0f;                    /* λָ */
+static float steer_share = 0.0f;                  /* תеر */
+static float steer_applied_deg = 0.0f;            /* ִеָ */
+static float steer_lpf_nm = 0.0f;
+static float steer_demand_nm = 0.0f;              /* ͨ */
+static float steer_elapsed_s = 0.0f;
+static uint32 imu_sample_age_us = 0xFFFFFFFFu;    /*  IMU ʱ */
+static uint32 imu_sample_time = 0;                /*  IMU ĵʱ (system_getval) */
+static uint16 imu_sample_tid = 0;
+
+/* ƽĵ */
+static callback_function step_trigger = NULL;     /* ֡ʱһģĿλ 5ms жϵķ */
+static volatile uint8 step_requested = 0;
+static uint8  step_started = 0;
+static uint32 last_step_time = 0;                 /* һĿʼʱ */
+static uint32 last_step_basis = 0;                /* һʱ̣֡Ϊ䵽ʱ̣Ϊʼʱ */
+static uint16 last_step_tid = 0;
+static float  angle_elapsed_s = 0.0f;
+static uint32 last_frame_time = 0;                /* һ֡ʱ */
+static uint8  frame_seen = 0;
+static const imu_calibration_t *imu_cal = NULL;   /* 궨ֻ */
+
+/* =========================
+ * State snapshot (ISR -> UI)
+ * =========================
+ * The 5ms ISR is the only writer and fills the back slot in place; readers on
+ * any core retry instead of blocking it (see snapshot.h).
+ */
+static balance_control_state_t state_slots[2];
+static snapshot_t state_snapshot;
+
+/* =========================
+ * Estimator snapshot (frame handler -> 5ms ISR)
+ * =========================
+ * The frame handler runs in the CPU0 mailbox ISR (prio 44), below the 5ms ISR
+ * (prio 50) that may preempt it in the middle of an update. Roll and rate are
+ * published together so the controller never pairs two different samples.
+ */
+static attitude_estimate_t estimate_slots[2];
+static snapshot_t estimate_snapshot;
 
 /* =========================
  * Utilities
@@ -121,124 +299,238 @@ static inline float constrain_float(float value, float min_val, float max_val)
     return value;
 }
 
-/* PID with simple conditional integration anti-windup */
-static float pid_update(float error, float *integral, float *last_error,
-                        float kp, float ki, float kd, float dt,
-                        float max_integral, float output_limit)
+static float low_pass_filter(LowPassFilter_t *lpf, float input)
 {
-    if (dt <= 0.0f) dt = 1e-6f;
-
-    float p_term = kp * error;
+    lpf->last_value = lpf->last_value * (1.0f - lpf->alpha) + input * lpf->alpha;
+    return lpf->last_value;
+}
 
-    float derivative = (error - *last_error) / dt;
-    *last_error = error;
-    float d_term = kd * derivative;
+/* =========================
+ * IMU read
+ * ========================= */
+/* Runs in the frame handler for every verified frame, so the estimator sees the
+   full IMU rate; dt is the spacing of the samples' measurement stamps. The
+   calibration sees the raw sample, the estimator the bias corrected gyro. */
+static void imu_frame_isr(void)
+{
+    yis_imu_t frame;
+    attitude_estimate_t estimate;
+    uint32 frame_time;
+    float dt;
+    float gyro[3], acc[3];
+
+    if (!imu_get_sample(&frame)) return;
+
+    frame_time = system_getval() - imu_get_sample_age_us(&frame) * 100u;
+    dt = frame_seen ? (float)(frame_time - last_frame_time) * 1e-8f : 0.0f;
+    last_frame_time = frame_time;
+    frame_seen = 1;
+    attitude_estimator_update(frame.wx - imu_cal->gyro_bias[0], frame.ay, frame.az, frame.roll, dt);
+    attitude_estimator_get_estimate(&estimate);
+    snapshot_publish(&estimate_snapshot, &estimate);
+
+    gyro[0] = frame.wx;
+    gyro[1] = frame.wy;
+    gyro[2] = frame.wz;
+    acc[0] = frame.ax;
+    acc[1] = frame.ay;
+    acc[2] = frame.az;
+    imu_calibration_update(gyro, acc, estimate.roll_deg, dt);
+
+#if BALANCE_SCHEDULE == BALANCE_SCHEDULE_IMU_FRAME
+    step_requested = 1;
+    if (step_trigger != NULL)
+    {
+        step_trigger();
+    }
+    else
+    {
+        balance_control_update_5ms_isr();   /* no trigger (host sim): step right here */
+    }
+#endif
+}
 
-    /* Predict output without adding more integral */
-    float i_term = ki * (*integral);
-    float out_pre = p_term + i_term + d_term;
+static void read_imu_data(void)
+{
+    yis_imu_t imu;
+    attitude_estimate_t estimate;
 
-    /* Determine saturation */
-    uint8 saturated_hi = (out_pre > output_limit);
-    uint8 saturated_lo = (out_pre < -output_limit);
+    PROFILER_BEGIN(PROFILER_READ_IMU);
 
-    /* Only integrate if:
-       - not saturated, OR
-       - integral will help pull output back (error tends to reduce saturation)
-    */
-    uint8 allow_integrate = 0;
-    if (!saturated_hi && !saturated_lo)
+    /* one whole frame, even if a new one is being published under us */
+    if (imu_get_sample(&imu))
     {
-        allow_integrate = 1;
+        imu_sample_age_us = imu_get_sample_age_us(&imu);
+        imu_sample_time = system_getval() - imu_sample_age_us * 100u;
+        imu_sample_tid = imu.tid;
     }
     else
     {
-        /* If output is too high, we want error < 0 to pull it down
-           If output is too low, we want error > 0 to pull it up
-        */
-        if (saturated_hi && (error < 0.0f)) allow_integrate = 1;
-        if (saturated_lo && (error > 0.0f)) allow_integrate = 1;
+        memset(&imu, 0, sizeof(imu));
+        imu_sample_age_us = 0xFFFFFFFFu;
     }
 
-    if (allow_integrate)
+    /* roll and rate of the same estimator update */
+    if (!snapshot_read(&estimate_snapshot, &estimate))
     {
-        *integral += error * dt;
-        *integral = constrain_float(*integral, -max_integral, max_integral);
+        memset(&estimate, 0, sizeof(estimate));
     }
 
-    i_term = ki * (*integral);
-    float output = p_term + i_term + d_term;
-    return constrain_float(output, -output_limit, output_limit);
-}
-
-static float low_pass_filter(LowPassFilter_t *lpf, float input)
-{
-    lpf->last_value = lpf->last_value * (1.0f - lpf->alpha) + input * lpf->alpha;
-    return lpf->last_value;
-}
-
-/* =========================
- * IMU read
- * ========================= */
-static void read_imu_data(void)
-{
-    attitude_data.gyr[0] = yis_imu.wx;
-    attitude_data.gyr[1] = yis_imu.wy;
-    attitude_data.gyr[2] = yis_imu.wz;
+    /* calibrated, then bias tracked by the estimator (wx - calibrated bias in ATTITUDE_MODE_YIS) */
+    attitude_data.gyr[0] = estimate.rate_dps;
+    attitude_data.gyr[1] = imu.wy - imu_cal->gyro_bias[1];
+    attitude_data.gyr[2] = imu.wz - imu_cal->gyro_bias[2];
 
     /* ֻ roll_rate õ x ᣬʱûõ */
     attitude_data.gyr_filtered[0] = low_pass_filter(&gyr_lpf, attitude_data.gyr[0]);
     attitude_data.gyr_filtered[1] = attitude_data.gyr[1];
     attitude_data.gyr_filtered[2] = attitude_data.gyr[2];
 
-    attitude_data.eul[0] = yis_imu.roll;
-    attitude_data.eul[1] = yis_imu.pitch;
-    attitude_data.eul[2] = yis_imu.yaw;
+    attitude_data.eul[0] = estimate.roll_deg - imu_cal->roll_offset;
+#if BALANCE_IMU_LATENCY_COMP
+    if (imu_sample_age_us <= BALANCE_IMU_STALE_US)
+    {
+        attitude_data.eul[0] += attitude_data.gyr[0] * ((float)imu_sample_age_us * 1e-6f);
+    }
+#endif
+    attitude_data.eul[1] = imu.pitch;
+    attitude_data.eul[2] = imu.yaw;
+
+    PROFILER_END(PROFILER_READ_IMU);
 }
 
 /* =========================
  * Control loops
  * ========================= */
-static void angle_loop_control(void)
+static void angle_loop_control(float dt)
 {
-    const float dt = BALANCE_ANGLE_DT_S;
+    PROFILER_BEGIN(PROFILER_ANGLE_LOOP);
 
     /* current_angle in your chosen unit (deg or rad) */
     float current_angle = attitude_data.roll_filtered * BALANCE_IMU_SCALE;
-    float angle_error = target_angle - current_angle;
 
     /* Output: target angular velocity */
-    target_angular_velocity = pid_update(angle_error,
-                                         &angle_pid.integral,
-                                         &angle_pid.last_error,
-                                         angle_pid.kp,
-                                         angle_pid.ki,
-                                         angle_pid.kd,
-                                         dt,
-                                         angle_pid.max_integral,
-                                         angle_pid.output_limit);
+    target_angular_velocity = pid_update(&angle_pid, target_angle + desat_bias_deg, current_angle, 0.0f, dt);
+
+    PROFILER_END(PROFILER_ANGLE_LOOP);
+}
+
+/* Wheel speed -> target bias, every tick for the filter, the PI every
+   BALANCE_DESAT_DT_S. Switched off or in another mode the bias returns to 0 at
+   the slew rate; without a wheel speed it holds. */
+static void desat_control(float dt)
+{
+    float step;
+
+    if (!control_enable)
+    {
+        pid_reset(&desat_pid);
+        desat_bias_deg = 0.0f;
+        desat_wheel_rps = wheel_speed_valid ? wheel_speed_rps : 0.0f;
+        desat_elapsed_s = 0.0f;
+        return;
+    }
+    if (!wheel_speed_valid)
+    {
+        return;
+    }
+    desat_wheel_rps += (wheel_speed_rps - desat_wheel_rps) * (dt / (BALANCE_DESAT_SPEED_TAU_S + dt));
+
+    desat_elapsed_s += dt;
+    if (desat_elapsed_s < BALANCE_DESAT_DT_S - 0.5f * dt)
+    {
+        return;
+    }
+    step = BALANCE_DESAT_SLEW_DEG_S * desat_elapsed_s;
+    if (desat_enable && balance_mode != BALANCE_MODE_LQR)
+    {
+        float bias = pid_update(&desat_pid, 0.0f, desat_wheel_rps, 0.0f, desat_elapsed_s);
+
+        desat_bias_deg += constrain_float(bias - desat_bias_deg, -step, step);
+    }
+    else
+    {
+        pid_reset(&desat_pid);
+        desat_bias_deg -= constrain_float(desat_bias_deg, -step, step);
+    }
+    desat_elapsed_s = 0.0f;
+}
+
+/* torque = -K x (scheduled lqr_gains.h rows); without a valid wheel speed that term is left out */
+static float state_feedback_control(float current_angle, float current_rate)
+{
+    const float *k = &scheduled[GAIN_LQR_ROLL];
+    float feedback = k[0] * (current_angle - target_angle) + k[1] * current_rate;
+
+    if (wheel_speed_valid)
+    {
+        feedback += k[2] * wheel_speed_rps;
+    }
+    return -feedback;
+}
+
+/* Torque demand -> servo share (BALANCE_MODE_STEER), returns the wheel's part.
+   In the other modes, or disabled, the servo goes back to centre at its rate. */
+static float steer_allocate(float torque, float dt)
+{
+    float authority = BALANCE_STEER_NM_PER_DEG_V2 * forward_speed_mps * forward_speed_mps;
+    float target = 0.0f;
+    float step;
+
+    if (balance_mode != BALANCE_MODE_STEER && steer_deg == 0.0f && steer_applied_deg == 0.0f)
+    {
+        return torque;
+    }
+    if (balance_mode == BALANCE_MODE_STEER && control_enable)
+    {
+        steer_lpf_nm += (torque - steer_lpf_nm) * (dt / (BALANCE_STEER_TAU_S + dt));
+        steer_demand_nm += (steer_lpf_nm - steer_demand_nm) * (dt / (BALANCE_STEER_TAU_S + dt));
+    }
+    else
+    {
+        steer_lpf_nm = 0.0f;
+        steer_demand_nm = 0.0f;
+    }
+
+    steer_elapsed_s += dt;
+    if (steer_elapsed_s >= BALANCE_STEER_DT_S - 0.5f * dt)
+    {
+        steer_share = 0.0f;
+        if (balance_mode == BALANCE_MODE_STEER && control_enable && authority > 0.0f)
+        {
+            steer_share = constrain_float((forward_speed_mps - BALANCE_STEER_SPEED_MIN_MPS)
+                                          / (BALANCE_STEER_SPEED_FULL_MPS - BALANCE_STEER_SPEED_MIN_MPS), 0.0f, 1.0f);
+            target = constrain_float(steer_share * steer_demand_nm / authority,
+                                     -BALANCE_STEER_ANGLE_LIMIT_DEG, BALANCE_STEER_ANGLE_LIMIT_DEG);
+        }
+        /* the last command is on the PWM now, this one from the next period */
+        steer_applied_deg = steer_deg;
+        step = BALANCE_STEER_RATE_DEG_S * steer_elapsed_s;
+        steer_deg += constrain_float(target - steer_deg, -step, step);
+        servo_set_angle(SERVO_ANGLE_CENTER + BALANCE_STEER_SIGN * steer_deg);
+        steer_elapsed_s = 0.0f;
+    }
+    return torque - authority * steer_applied_deg;
 }
 
-static void velocity_loop_control(void)
+static void velocity_loop_control(float dt)
 {
-    const float dt = BALANCE_CTRL_DT_S;
+    PROFILER_BEGIN(PROFILER_VELOCITY_LOOP);
 
     float current_rate = attitude_data.roll_rate * BALANCE_IMU_SCALE;
-    float rate_error = target_angular_velocity - current_rate;
-
-    /* IMPORTANT:
-       velocity_pid.output_limit MUST match actuator limit (torque limit),
-       otherwise windup still happens.
-    */
-    float torque = pid_update(rate_error,
-                              &velocity_pid.integral,
-                              &velocity_pid.last_error,
-                              velocity_pid.kp,
-                              velocity_pid.ki,
-                              velocity_pid.kd,
-                              dt,
-                              velocity_pid.max_integral,
-                              velocity_pid.output_limit);
+    float torque;
+
+    if (balance_mode == BALANCE_MODE_LQR)
+    {
+        /* the design model has no filter lag: rate straight from the estimator, not gyr_lpf */
+        torque = state_feedback_control(attitude_data.roll_filtered * BALANCE_IMU_SCALE,
+                                        attitude_data.gyr[0] * BALANCE_IMU_SCALE);
+    }
+    else
+    {
+        torque = pid_update(&velocity_pid, target_angular_velocity, current_rate, 0.0f, dt);
+    }
+    torque = steer_allocate(torque, dt);
 
     torque_cmd = constrain_float(torque, -BALANCE_TORQUE_LIMIT, BALANCE_TORQUE_LIMIT);
 
@@ -247,11 +539,25 @@ static void velocity_loop_control(void)
         float roll_now = attitude_data.roll_filtered * BALANCE_IMU_SCALE;
         if (fabsf(roll_now) > BALANCE_FALL_ANGLE_LIMIT)
         {
-            /* auto disable */
+            /* auto disable, keep what led up to it */
+            if (control_enable)
+            {
+                flight_recorder_trigger(FLIGHT_RECORDER_CAUSE_FALL);
+            }
             control_enable = 0;
         }
     }
 
+    /* Safety: no fresh IMU frame, stop */
+    if (imu_sample_age_us > BALANCE_IMU_STALE_US)
+    {
+        if (control_enable)
+        {
+            flight_recorder_trigger(FLIGHT_RECORDER_CAUSE_IMU_STALE);
+        }
+        control_enable = 0;
+    }
+
     /* Send to ODrive */
     if (control_enable)
     {
@@ -263,22 +569,103 @@ static void velocity_loop_control(void)
         torque_cmd = 0.0f;
     }
 
-    /* Extra: if saturated too long and not correcting, decay integral a bit */
-    static uint8 saturation_counter = 0;
-    if ((fabsf(torque_cmd) > (BALANCE_TORQUE_LIMIT * 0.97f)) &&
-        (rate_error * torque_cmd) > 0.0f) /* error and output same sign -> not correcting */
+    PROFILER_END(PROFILER_VELOCITY_LOOP);
+}
+
+/* One flight recorder entry per tick: plain stores, no formatting */
+static void record_flight(uint8 angle_loop_ran, uint8 watchdog_step)
+{
+    flight_record_t *record = flight_recorder_slot();
+    uint8 flags = 0u;
+
+    if (record == NULL)
+    {
+        return;
+    }
+
+    if (wheel_speed_valid)
     {
-        saturation_counter++;
-        if (saturation_counter > 100) /* ~500ms */
-        {
-            velocity_pid.integral *= 0.5f;
-            saturation_counter = 50;
-        }
+        flags |= FLIGHT_RECORD_SPEED_VALID;
     }
-    else
+    if (balance_mode == BALANCE_MODE_LQR)
+    {
+        flags |= FLIGHT_RECORD_LQR;
+    }
+    if (control_enable)
+    {
+        flags |= FLIGHT_RECORD_ENABLE;
+    }
+    if (angle_loop_ran)
+    {
+        flags |= FLIGHT_RECORD_ANGLE_LOOP;
+    }
+    if (imu_sample_age_us > BALANCE_IMU_STALE_US)
+    {
+        flags |= FLIGHT_RECORD_IMU_STALE;
+    }
+    if (watchdog_step)
+    {
+        flags |= FLIGHT_RECORD_WATCHDOG;
+    }
+    if (fabsf(desat_bias_deg) >= BALANCE_DESAT_LIMIT_DEG)
     {
-        saturation_counter = 0;
+        flags |= FLIGHT_RECORD_DESAT_LIMIT;
     }
+
+    record->roll = attitude_data.roll_filtered * BALANCE_IMU_SCALE;
+    record->roll_rate = attitude_data.roll_rate * BALANCE_IMU_SCALE;
+    record->target_angle = target_angle + desat_bias_deg;
+    record->target_rate = target_angular_velocity;
+    record->angle_integral = angle_pid.integral;
+    record->rate_integral = velocity_pid.integral;
+    record->torque_cmd = torque_cmd;
+    record->wheel_speed = wheel_speed_valid ? wheel_speed_rps : 0.0f;
+    record->isr_us = (uint16)profiler_last_us(PROFILER_BALANCE_ISR);
+    record->flags = flags;
+
+    flight_recorder_commit();
+}
+
+static void publish_state(void)
+{
+    balance_control_state_t *slot = snapshot_write_begin(&state_snapshot);
+
+    slot->roll_deg = attitude_data.eul[0] * BALANCE_IMU_SCALE;
+    slot->roll_filtered_deg = attitude_data.roll_filtered * BALANCE_IMU_SCALE;
+    slot->roll_rate_deg_s = attitude_data.roll_rate * BALANCE_IMU_SCALE;
+
+    slot->target_angle = target_angle;
+    slot->target_rate = target_angular_velocity;
+    slot->control_output = torque_cmd;
+    slot->mode = (uint8)balance_mode;
+    slot->forward_speed_mps = forward_speed_mps;
+    slot->wheel_speed_rps = desat_wheel_rps;
+    slot->desat_bias_deg = desat_bias_deg;
+    slot->desat_enable = desat_enable;
+    slot->steer_deg = steer_deg;
+    slot->steer_share = steer_share;
+
+    slot->isr_time_us = profiler_last_us(PROFILER_BALANCE_ISR);
+    slot->isr_time_max_us = profiler_max_us(PROFILER_BALANCE_ISR);
+
+    snapshot_write_commit(&state_snapshot);
+}
+
+/* Flat rows: the cascade gains above, the LQR rows from the default set */
+static void schedule_defaults(void)
+{
+    uint32 g;
+
+    memcpy(schedule.speed_mps, schedule_speeds, sizeof(schedule.speed_mps));
+    for (g = 0; g <= GAIN_RATE_KD; g++)
+    {
+        gain_schedule_fill(&schedule, (gain_schedule_gain_enum)g, gain_defaults[g]);
+    }
+    for (g = 0; g < LQR_STATE_NUM; g++)
+    {
+        gain_schedule_fill(&schedule, (gain_schedule_gain_enum)(GAIN_LQR_ROLL + g), lqr_gain_sets[BALANCE_LQR_GAIN_SET_DEFAULT].k[g]);
+    }
+    schedule_lqr_gain_set = BALANCE_LQR_GAIN_SET_DEFAULT;
 }
 
 /* =========================
@@ -287,48 +674,197 @@ static void velocity_loop_control(void)
 void balance_control_init(void)
 {
     memset(&attitude_data, 0, sizeof(attitude_data));
+    snapshot_init(&state_snapshot, state_slots, sizeof(balance_control_state_t));
+    snapshot_init(&estimate_snapshot, estimate_slots, sizeof(attitude_estimate_t));
 
-    gyr_lpf.last_value = 0.0f;
+    attitude_estimator_init(BALANCE_ATTITUDE_MODE);
+    imu_calibration_init();             /* DFlash record if one was stored */
+    imu_cal = imu_calibration_get();
+    imu_set_frame_callback(imu_frame_isr);
 
-    angle_pid.integral = 0.0f;
-    angle_pid.last_error = 0.0f;
+    step_requested = 0;
+    step_started = 0;
+    angle_elapsed_s = 0.0f;
+    frame_seen = 0;
+    imu_sample_age_us = 0xFFFFFFFFu;
 
-    velocity_pid.integral = 0.0f;
-    velocity_pid.last_error = 0.0f;
+    gyr_lpf.last_value = 0.0f;
+
+    /* ȱֻڵһγʼ֮õ gains  */
+    if (!schedule_ready)
+    {
+        schedule_defaults();
+        if (gain_schedule_load(&schedule))
+        {
+            schedule_lqr_gain_set = LQR_GAIN_SET_NUM;
+        }
+        schedule_ready = 1;
+    }
+    forward_speed_mps = 0.0f;
+
+    /* PID  angle/velocity_pid_config 濪ʼлֵ */
+    pid_init(&angle_pid, &angle_pid_config);
+    pid_init(&velocity_pid, &velocity_pid_config);
+    pid_init(&desat_pid, &desat_pid_config);
+    desat_bias_deg = 0.0f;
+    desat_wheel_rps = 0.0f;
+    desat_elapsed_s = 0.0f;
+    steer_deg = 0.0f;
+    steer_share = 0.0f;
+    steer_applied_deg = 0.0f;
+    steer_lpf_nm = 0.0f;
+    steer_demand_nm = 0.0f;
+    steer_elapsed_s = 0.0f;
+    scheduled[GAIN_ANGLE_KP] = angle_pid_config.kp;
+    scheduled[GAIN_ANGLE_KI] = angle_pid_config.ki;
+    scheduled[GAIN_ANGLE_KD] = angle_pid_config.kd;
+    scheduled[GAIN_RATE_KP] = velocity_pid_config.kp;
+    scheduled[GAIN_RATE_KI] = velocity_pid_config.ki;
+    scheduled[GAIN_RATE_KD] = velocity_pid_config.kd;
+    snapshot_init(&gains_snapshot, gains_slots, sizeof(gain_schedule_table_t));
+    snapshot_publish(&gains_snapshot, &schedule);
+    gains_applied = snapshot_sequence(&gains_snapshot) - 1u;
 
     target_angular_velocity = 0.0f;
     torque_cmd = 0.0f;
 
     control_enable = 0;
 
+    publish_state();
+
     odrive_stop();
 }
 
-void balance_control_update_5ms_isr(void)
+/* Tuning interface side: hand the whole table to the ISR */
+static void publish_gains(void)
 {
-    static uint8 tick = 0;
+    snapshot_publish(&gains_snapshot, &schedule);
+}
+
+/* ISR side: ESC command -> m/s through the spin-up lag */
+static void estimate_forward_speed(float dt)
+{
+    float command = (float)motor_get_speed() * BALANCE_SPEED_MPS_PER_PERCENT;
+
+    forward_speed_mps += (command - forward_speed_mps) * (dt / (BALANCE_SPEED_TAU_S + dt));
+}
+
+/* ISR side: a new table is compiled once, then every tick the gains at the
+   current speed take effect without a step in either loop output. Both come
+   from one table, so a change never mixes old and new rows. */
+static void apply_gains(void)
+{
+    float now[GAIN_SCHEDULE_GAIN_NUM];
+    uint32 sequence = snapshot_sequence(&gains_snapshot);
+
+    if (sequence != gains_applied && snapshot_read(&gains_snapshot, &schedule_received))
+    {
+        gains_applied = sequence;
+        gain_schedule_compile(&schedule_lut, &schedule_received);
+    }
+    gain_schedule_eval(&schedule_lut, forward_speed_mps, now);
+
+    /* pid_set_gains() only when a loop's gains moved (flat rows: never) */
+    if (memcmp(&now[GAIN_ANGLE_KP], &scheduled[GAIN_ANGLE_KP], 3u * sizeof(float)) != 0)
+    {
+        pid_set_gains(&angle_pid, now[GAIN_ANGLE_KP], now[GAIN_ANGLE_KI], now[GAIN_ANGLE_KD]);
+    }
+    if (memcmp(&now[GAIN_RATE_KP], &scheduled[GAIN_RATE_KP], 3u * sizeof(float)) != 0)
+    {
+        pid_set_gains(&velocity_pid, now[GAIN_RATE_KP], now[GAIN_RATE_KI], now[GAIN_RATE_KD]);
+    }
+    memcpy(scheduled, now, sizeof(scheduled));
+}
+
+/* One control step on the newest frame. dt: arrival spacing of the frames the
+   two steps ran on when this one has a new frame (frame scheduling), otherwise
+   the time between the steps. */
+static void control_step(uint8 watchdog_step)
+{
+    uint32 now = system_getval();
+    uint32 basis = now;
+    uint8 angle_loop_ran = 0;
+    float dt = BALANCE_CTRL_DT_S;
+
+    PROFILER_MARK(PROFILER_BALANCE_PERIOD);
+    PROFILER_BEGIN(PROFILER_BALANCE_ISR);
 
     read_imu_data();
+    wheel_speed_valid = odrive_get_speed(&wheel_speed_rps);
+
+#if BALANCE_SCHEDULE == BALANCE_SCHEDULE_IMU_FRAME
+    if (imu_sample_age_us != 0xFFFFFFFFu && (!step_started || imu_sample_tid != last_step_tid))
+    {
+        basis = imu_sample_time;
+    }
+#endif
+    if (step_started)
+    {
+        dt = constrain_float((float)(int32)(basis - last_step_basis) * 1e-8f, BALANCE_DT_MIN_S, BALANCE_DT_MAX_S);
+    }
+    step_started = 1;
+    last_step_time = now;
+    last_step_basis = basis;
+    last_step_tid = imu_sample_tid;
+
+    estimate_forward_speed(dt);
+    apply_gains();
+    desat_control(dt);
+
+    /* angle loop on whole steps, the one closest to BALANCE_ANGLE_DT_S (cascade modes) */
+    angle_elapsed_s += dt;
+    if (balance_mode != BALANCE_MODE_LQR && angle_elapsed_s >= BALANCE_ANGLE_DT_S - 0.5f * dt)
+    {
+        angle_loop_ran = 1;
+    }
 
-    /* Here we assume yis_imu.roll is already an estimated roll angle.
-       If it is raw/unfiltered, you should run proper attitude estimation. */
+    /* roll comes from attitude_estimator (see BALANCE_ATTITUDE_MODE) */
     attitude_data.roll_filtered = attitude_data.eul[0];
 
     /* roll rate from gyro (filtered) */
     attitude_data.roll_rate = attitude_data.gyr_filtered[0];
 
-    if (tick == 0u)
+    if (angle_loop_ran)
     {
-        angle_loop_control();
+        angle_loop_control(angle_elapsed_s);
+        angle_elapsed_s = 0.0f;
     }
 
-    velocity_loop_control();
+    velocity_loop_control(dt);
+
+    record_flight(angle_loop_ran, watchdog_step);
 
-    tick++;
-    if (tick >= BALANCE_ANGLE_TICK_DIV)
+    /* Closed before publishing so the snapshot carries this tick's time;
+       the publish itself is a fixed ~10 word copy. */
+    PROFILER_END(PROFILER_BALANCE_ISR);
+
+    publish_state();
+}
+
+/* Body of the 5ms PIT ISR, which frame steps are also routed through */
+void balance_control_update_5ms_isr(void)
+{
+#if BALANCE_SCHEDULE == BALANCE_SCHEDULE_IMU_FRAME
+    if (step_requested)
+    {
+        step_requested = 0;
+        control_step(0);
+        return;
+    }
+    /* watchdog: the PIT only steps in when frames stopped */
+    if (step_started && (system_getval() - last_step_time) < BALANCE_WATCHDOG_US * 100u)
     {
-        tick = 0u;
+        return;
     }
+    control_step(1);
+#else
+    control_step(0);
+#endif
+}
+
+void balance_control_set_step_trigger(callback_function trigger)
+{
+    step_trigger = trigger;
 }
 
 void balance_control_set_target_angle(float angle_deg_or_rad)
@@ -348,13 +884,10 @@ void balance_control_get_state(balance_control_state_t *out_state)
         return;
     }
 
-    out_state->roll_deg = attitude_data.eul[0] * BALANCE_IMU_SCALE;
-    out_state->roll_filtered_deg = attitude_data.roll_filtered * BALANCE_IMU_SCALE;
-    out_state->roll_rate_deg_s = attitude_data.roll_rate * BALANCE_IMU_SCALE;
-
-    out_state->target_angle = target_angle;
-    out_state->target_rate = target_angular_velocity;
-    out_state->control_output = torque_cmd;
+    if (!snapshot_read(&state_snapshot, out_state))
+    {
+        memset(out_state, 0, sizeof(*out_state));
+    }
 }
 
 float balance_control_get_output(void)
@@ -369,11 +902,8 @@ void balance_control_set_enable(uint8 enable)
     if (!enable)
     {
         /* reset integrators when disabling */
-        velocity_pid.integral = 0.0f;
-        velocity_pid.last_error = 0.0f;
-
-        angle_pid.integral = 0.0f;
-        angle_pid.last_error = 0.0f;
+        pid_reset(&velocity_pid);
+        pid_reset(&angle_pid);
 
         target_angular_velocity = 0.0f;
         torque_cmd = 0.0f;
@@ -387,62 +917,187 @@ uint8 balance_control_get_enable(void)
     return control_enable;
 }
 
+void balance_control_set_mode(balance_mode_enum mode)
+{
+    if (mode >= BALANCE_MODE_NUM || mode == balance_mode)
+    {
+        return;
+    }
+    /* ģʽӾֹʼĻ⻷ȥƫ */
+    pid_reset(&velocity_pid);
+    pid_reset(&angle_pid);
+    pid_reset(&desat_pid);
+    target_angular_velocity = 0.0f;
+    angle_elapsed_s = 0.0f;
+    desat_bias_deg = 0.0f;
+    balance_mode = mode;
+}
+
+void balance_control_set_desat_enable(uint8 enable)
+{
+    desat_enable = enable ? 1u : 0u;
+}
+
+uint8 balance_control_get_desat_enable(void)
+{
+    return desat_enable;
+}
+
+balance_mode_enum balance_control_get_mode(void)
+{
+    return balance_mode;
+}
+
+uint8 balance_control_get_lqr_gain_set_num(void)
+{
+    return (uint8)LQR_GAIN_SET_NUM;
+}
+
+const char *balance_control_get_lqr_gain_set_name(uint8 gain_set)
+{
+    if (gain_set == LQR_GAIN_SET_NUM)
+    {
+        return "stored";
+    }
+    return (gain_set < LQR_GAIN_SET_NUM) ? lqr_gain_sets[gain_set].name : "?";
+}
+
+/* The LQR rows at every breakpoint from one lqr_gains.h set */
+void balance_control_select_lqr_gain_set(uint8 gain_set)
+{
+    uint32 i;
+
+    if (gain_set >= LQR_GAIN_SET_NUM)
+    {
+        return;
+    }
+    for (i = 0; i < LQR_STATE_NUM; i++)
+    {
+        gain_schedule_fill(&schedule, (gain_schedule_gain_enum)(GAIN_LQR_ROLL + i), lqr_gain_sets[gain_set].k[i]);
+    }
+    schedule_lqr_gain_set = gain_set;
+    publish_gains();
+}
+
+uint8 balance_control_get_lqr_gain_set(void)
+{
+    return schedule_lqr_gain_set;
+}
+
+void balance_control_get_schedule(gain_schedule_table_t *table)
+{
+    if (table != NULL)
+    {
+        *table = schedule;
+    }
+}
+
+uint8 balance_control_set_schedule(const gain_schedule_table_t *table)
+{
+    if (table == NULL || !gain_schedule_valid(table))
+    {
+        return 0;
+    }
+    schedule = *table;
+    schedule_lqr_gain_set = LQR_GAIN_SET_NUM;
+    publish_gains();
+    return 1;
+}
+
+void balance_control_save_schedule(void)
+{
+    gain_schedule_save(&schedule);
+}
+
+void balance_control_select_schedule_point(int8 point)
+{
+    schedule_edit_point = (point >= 0 && point < GAIN_SCHEDULE_POINTS) ? point : -1;
+}
+
+int8 balance_control_get_schedule_point(void)
+{
+    return schedule_edit_point;
+}
+
+/* ڣѡеĶϵ㣬ȫϵһƽƣƽȻƽģ */
+static void adjust_gain(gain_schedule_gain_enum gain, float delta)
+{
+    uint32 i;
+
+    for (i = 0; i < GAIN_SCHEDULE_POINTS; i++)
+    {
+        float *value = &schedule.gain[gain][i];
+
+        if (schedule_edit_point >= 0 && i != (uint32)schedule_edit_point)
+        {
+            continue;
+        }
+        *value = constrain_float(*value + delta, gain_limits[gain][0], gain_limits[gain][1]);
+    }
+    publish_gains();
+}
+
+/* ʾĶϵ㣺ѡеǸȫʱȡ뵱ǰٶ */
+static uint8 display_point(void)
+{
+    balance_control_state_t state;
+
+    if (schedule_edit_point >= 0)
+    {
+        return (uint8)schedule_edit_point;
+    }
+    balance_control_get_state(&state);
+    return gain_schedule_nearest(&schedule, state.forward_speed_mps);
+}
+
 void balance_control_adjust_angle_kp(float delta)
 {
-    angle_pid.kp += delta;
-    if (angle_pid.kp < -10.0f) angle_pid.kp = -10.0f;
-    if (angle_pid.kp > 10.0f) angle_pid.kp = 10.0f;  // ֵ
+    adjust_gain(GAIN_ANGLE_KP, delta);
 }
 
 void balance_control_adjust_angle_ki(float delta)
 {
-    angle_pid.ki += delta;
-    if (angle_pid.ki < -10.0f) angle_pid.ki = -10.0f;
-    if (angle_pid.ki > 5.0f) angle_pid.ki = 5.0f;  // ֵ
+    adjust_gain(GAIN_ANGLE_KI, delta);
 }
 
 void balance_control_adjust_angle_kd(float delta)
 {
-    angle_pid.kd += delta;
-    if (angle_pid.kd < -10.0f) angle_pid.kd = -10.0f;
-    if (angle_pid.kd > 2.0f) angle_pid.kd = 2.0f;  // ֵ
+    adjust_gain(GAIN_ANGLE_KD, delta);
 }
 
 void balance_control_adjust_velocity_kp(float delta)
 {
-    velocity_pid.kp += delta;
-    if (velocity_pid.kp > 0.0f) velocity_pid.kp = 0.0f;     // KpǸ
-    if (velocity_pid.kp < -20.0f) velocity_pid.kp = -20.0f; // Сֵ
+    adjust_gain(GAIN_RATE_KP, delta);
 }
 
 void balance_control_adjust_velocity_ki(float delta)
 {
-    velocity_pid.ki += delta;
-    if (velocity_pid.ki < -10.0f) velocity_pid.ki = -10.0f;
-    if (velocity_pid.ki > 1.0f) velocity_pid.ki = 1.0f;  // ֵ
+    adjust_gain(GAIN_RATE_KI, delta);
 }
 
 void balance_control_adjust_velocity_kd(float delta)
 {
-    velocity_pid.kd += delta;
-    if (velocity_pid.kd < -10.0f) velocity_pid.kd = -10.0f;
-    if (velocity_pid.kd > 1.0f) velocity_pid.kd = 1.0f;  // ֵ
+    adjust_gain(GAIN_RATE_KD, delta);
 }
 
 void balance_control_get_pid_params(float *angle_kp, float *vel_kp, float *vel_ki)
 {
-    if (angle_kp) *angle_kp = angle_pid.kp;
-    if (vel_kp) *vel_kp = velocity_pid.kp;
-    if (vel_ki) *vel_ki = velocity_pid.ki;
+    uint8 p = display_point();
+
+    if (angle_kp) *angle_kp = schedule.gain[GAIN_ANGLE_KP][p];
+    if (vel_kp) *vel_kp = schedule.gain[GAIN_RATE_KP][p];
+    if (vel_ki) *vel_ki = schedule.gain[GAIN_RATE_KI][p];
 }
 
 void balance_control_get_pid_params_full(float *angle_kp, float *angle_ki, float *angle_kd,
                                           float *vel_kp, float *vel_ki, float *vel_kd)
 {
-    if (angle_kp) *angle_kp = angle_pid.kp;
-    if (angle_ki) *angle_ki = angle_pid.ki;
-    if (angle_kd) *angle_kd = angle_pid.kd;
-    if (vel_kp) *vel_kp = velocity_pid.kp;
-    if (vel_ki) *vel_ki = velocity_pid.ki;
-    if (vel_kd) *vel_kd = velocity_pid.kd;
+    uint8 p = display_point();
+
+    if (angle_kp) *angle_kp = schedule.gain[GAIN_ANGLE_KP][p];
+    if (angle_ki) *angle_ki = schedule.gain[GAIN_ANGLE_KI][p];
+    if (angle_kd) *angle_kd = schedule.gain[GAIN_ANGLE_KD][p];
+    if (vel_kp) *vel_kp = schedule.gain[GAIN_RATE_KP][p];
+    if (vel_ki) *vel_ki = schedule.gain[GAIN_RATE_KI][p];
+    if (vel_kd) *vel_kd = schedule.gain[GAIN_RATE_KD][p];
 }
@@ -3,6 +3,16 @@
 #define BALANCE_CONTROL_H
 
 #include "zf_common_headfile.h"
+#include "gain_schedule.h"
+
+typedef enum
+{
+    BALANCE_MODE_PID = 0,       /* angle -> rate -> torque cascade (pid.h) */
+    BALANCE_MODE_LQR,           /* state feedback on roll, roll rate and wheel speed, every tick (lqr_gains.h) */
+    BALANCE_MODE_STEER,         /* cascade, torque demand shared between steering servo and wheel by speed */
+
+    BALANCE_MODE_NUM,
+} balance_mode_enum;
 
 typedef struct
 {
@@ -12,17 +22,60 @@ typedef struct
     float target_angle;
     float target_rate;
     float control_output;
+    uint8 mode;                 /* balance_mode_enum */
+    float forward_speed_mps;    /* estimate the gains are scheduled on */
+    float wheel_speed_rps;      /* filtered ODrive wheel speed the desaturation runs on */
+    float desat_bias_deg;       /* added to target_angle by the desaturation loop */
+    uint8 desat_enable;
+    float steer_deg;            /* servo command from SERVO_ANGLE_CENTER, BALANCE_MODE_STEER */
+    float steer_share;          /* part of the torque demand given to steering, 0..1 */
+    uint32 isr_time_us;         /* execution time of the last control tick */
+    uint32 isr_time_max_us;     /* worst case since boot / profiler_reset() */
 } balance_control_state_t;
 
 void balance_control_init(void);
 void balance_control_update_5ms_isr(void);
 
+/* Frame scheduling (BALANCE_SCHEDULE_IMU_FRAME): called from the IMU frame handler
+ * to run the next step in the 5ms PIT ISR, i.e. raise that ISR's service request.
+ * Without a trigger the step runs directly in the frame handler. */
+void balance_control_set_step_trigger(callback_function trigger);
+
 void balance_control_set_target_angle(float angle_deg);
 float balance_control_get_target_angle(void);
 
 void balance_control_set_enable(uint8 enable);  // ʹ/ֹ
 uint8 balance_control_get_enable(void);         // ȡʹ״̬
 
+/* Control mode. Call from the control context (CORE_CONTROL mailbox handler), like
+ * set_enable; the loops of the new mode start from rest. */
+void balance_control_set_mode(balance_mode_enum mode);
+balance_mode_enum balance_control_get_mode(void);
+
+/* Wheel momentum desaturation (cascade modes): slowly biases the target roll
+ * so the reaction wheel spins down. Any core; switched off, the bias returns to
+ * 0 at its slew rate. */
+void balance_control_set_desat_enable(uint8 enable);
+uint8 balance_control_get_desat_enable(void);
+
+/* Gain schedule (gain_schedule.h), owned by the tuning side like the adjusters
+ * below: every change hands the whole table to the 5ms ISR, which evaluates it
+ * at the forward speed estimate each tick. select_lqr_gain_set fills the LQR
+ * rows from an lqr_gains.h row; get_lqr_gain_set returns the row in use,
+ * get_lqr_gain_set_num() when the table came from DFlash or set_schedule. */
+uint8 balance_control_get_lqr_gain_set_num(void);
+const char *balance_control_get_lqr_gain_set_name(uint8 lqr_gain_set);
+void balance_control_select_lqr_gain_set(uint8 lqr_gain_set);
+uint8 balance_control_get_lqr_gain_set(void);
+void balance_control_get_schedule(gain_schedule_table_t *table);
+uint8 balance_control_set_schedule(const gain_schedule_table_t *table);    /* 0: invalid, unchanged */
+void balance_control_save_schedule(void);                                   /* DFlash, loaded at init */
+
+/* Breakpoint the adjusters below change and the getters show; -1: all of them
+ * move together, shown at the breakpoint nearest the current speed */
+void balance_control_select_schedule_point(int8 point);
+int8 balance_control_get_schedule_point(void);
+
 // PIDڽӿ
 void balance_control_adjust_angle_kp(float delta);      // ڽǶȻKp
 void balance_control_adjust_angle_ki(float delta);      // ڽǶȻKi
@@ -38,6 +91,8 @@ void balance_control_get_pid_params(float *angle_kp, float *vel_kp, float *vel_k
 void balance_control_get_pid_params_full(float *angle_kp, float *angle_ki, float *angle_kd,
                                           float *vel_kp, float *vel_ki, float *vel_kd);
 
+/* Reads the snapshot published by the 5ms ISR at the end of every tick.
+ * Safe to call from the main loop or another core; never touches the control loop. */
 void balance_control_get_state(balance_control_state_t *out_state);
 float balance_control_get_output(void);
 
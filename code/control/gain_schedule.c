@@ -0,0 +1,165 @@
+/* gain_schedule.c */
+#include "gain_schedule.h"
+#include <math.h>
+#include <string.h>
+
+#define GAIN_SCHEDULE_SHAPE             ((uint32)GAIN_SCHEDULE_POINTS << 8 | (uint32)GAIN_SCHEDULE_GAIN_NUM)
+
+uint8 gain_schedule_valid(const gain_schedule_table_t *table)
+{
+    uint32 g, i;
+
+    for (i = 0; i < GAIN_SCHEDULE_POINTS; i++)
+    {
+        if (!isfinite(table->speed_mps[i]) || (i > 0u && !(table->speed_mps[i] > table->speed_mps[i - 1u])))
+        {
+            return 0;
+        }
+        for (g = 0; g < GAIN_SCHEDULE_GAIN_NUM; g++)
+        {
+            if (!isfinite(table->gain[g][i]))
+            {
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+void gain_schedule_fill(gain_schedule_table_t *table, gain_schedule_gain_enum gain, float value)
+{
+    uint32 i;
+
+    for (i = 0; i < GAIN_SCHEDULE_POINTS; i++)
+    {
+        table->gain[gain][i] = value;
+    }
+}
+
+uint8 gain_schedule_nearest(const gain_schedule_table_t *table, float speed_mps)
+{
+    uint8 best = 0;
+    uint8 i;
+
+    for (i = 1; i < GAIN_SCHEDULE_POINTS; i++)
+    {
+        if (fabsf(table->speed_mps[i] - speed_mps) < fabsf(table->speed_mps[best] - speed_mps))
+        {
+            best = i;
+        }
+    }
+    return best;
+}
+
+/* Segment i spans breakpoints i .. i+1 and ends at boundary = speed[i+1], as
+   Ifx_LutLinearF32 expects; the divisions happen here, once per table */
+void gain_schedule_compile(gain_schedule_lut_t *lut, const gain_schedule_table_t *table)
+{
+    uint32 g, i;
+
+    for (g = 0; g < GAIN_SCHEDULE_GAIN_NUM; g++)
+    {
+        for (i = 0; i < GAIN_SCHEDULE_SEGMENTS; i++)
+        {
+            Ifx_LutLinearF32_Item *item = &lut->segment[g][i];
+            float x0 = table->speed_mps[i], x1 = table->speed_mps[i + 1u];
+            float y0 = table->gain[g][i], y1 = table->gain[g][i + 1u];
+
+            item->gain = (y1 - y0) / (x1 - x0);
+            item->offset = y0 - item->gain * x0;
+            item->boundary = x1;
+        }
+        lut->lut[g].segmentCount = (sint8)GAIN_SCHEDULE_SEGMENTS;
+        lut->lut[g].segments = lut->segment[g];
+    }
+    lut->speed_min = table->speed_mps[0];
+    lut->speed_max = table->speed_mps[GAIN_SCHEDULE_POINTS - 1];
+}
+
+/* Ifx_LutLinearF32_searchPosSeq() with the search shared by all rows */
+void gain_schedule_eval(const gain_schedule_lut_t *lut, float speed_mps, float gain[GAIN_SCHEDULE_GAIN_NUM])
+{
+    const Ifx_LutLinearF32_Item *boundaries = lut->segment[0];
+    uint32 g, i = 0;
+
+    /* NaN compares false: it ends up at the low end */
+    if (!(speed_mps > lut->speed_min)) speed_mps = lut->speed_min;
+    else if (speed_mps > lut->speed_max) speed_mps = lut->speed_max;
+
+    while (i < GAIN_SCHEDULE_SEGMENTS - 1u && speed_mps > boundaries[i].boundary)
+    {
+        i++;
+    }
+    for (g = 0; g < GAIN_SCHEDULE_GAIN_NUM; g++)
+    {
+        gain[g] = lut->segment[g][i].gain * speed_mps + lut->segment[g][i].offset;
+    }
+}
+
+/* ================= DFlash record ================= */
+static uint32 record_check(const uint32 *record)
+{
+    uint32 check = 0;
+    uint32 i;
+
+    for (i = 0; i < GAIN_SCHEDULE_RECORD_WORDS - 1u; i++)
+    {
+        check ^= record[i];
+    }
+    return ~check;
+}
+
+void gain_schedule_pack(const gain_schedule_table_t *table, uint32 record[GAIN_SCHEDULE_RECORD_WORDS])
+{
+    record[0] = GAIN_SCHEDULE_MAGIC;
+    record[1] = GAIN_SCHEDULE_SHAPE;
+    memcpy(&record[2], table, sizeof(*table));
+    record[GAIN_SCHEDULE_RECORD_WORDS - 1u] = record_check(record);
+}
+
+uint8 gain_schedule_unpack(const uint32 record[GAIN_SCHEDULE_RECORD_WORDS], gain_schedule_table_t *table)
+{
+    gain_schedule_table_t candidate;
+
+    if (record[0] != GAIN_SCHEDULE_MAGIC || record[1] != GAIN_SCHEDULE_SHAPE
+        || record[GAIN_SCHEDULE_RECORD_WORDS - 1u] != record_check(record))
+    {
+        return 0;
+    }
+    memcpy(&candidate, &record[2], sizeof(candidate));
+    if (!gain_schedule_valid(&candidate))
+    {
+        return 0;
+    }
+    *table = candidate;
+    return 1;
+}
+
+#if GAIN_SCHEDULE_FLASH
+uint8 gain_schedule_load(gain_schedule_table_t *table)
+{
+    uint32 record[GAIN_SCHEDULE_RECORD_WORDS];
+
+    flash_read_page(0, GAIN_SCHEDULE_FLASH_PAGE, record, GAIN_SCHEDULE_RECORD_WORDS);
+    return gain_schedule_unpack(record, table);
+}
+
+void gain_schedule_save(const gain_schedule_table_t *table)
+{
+    uint32 record[GAIN_SCHEDULE_RECORD_WORDS];
+
+    gain_schedule_pack(table, record);
+    flash_write_page(0, GAIN_SCHEDULE_FLASH_PAGE, record, GAIN_SCHEDULE_RECORD_WORDS);
+}
+#else
+uint8 gain_schedule_load(gain_schedule_table_t *table)
+{
+    (void)table;
+    return 0;
+}
+
+void gain_schedule_save(const gain_schedule_table_t *table)
+{
+    (void)table;
+}
+#endif
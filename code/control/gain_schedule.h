@@ -0,0 +1,87 @@
+/* gain_schedule.h */
+#ifndef GAIN_SCHEDULE_H
+#define GAIN_SCHEDULE_H
+
+#include "zf_common_headfile.h"
+#include "Ifx_LutLinearF32.h"
+
+/* Controller gains scheduled on forward speed, hardware independent so it also
+ * builds on the host (tools/sim/gain_schedule_check.c).
+ *
+ * Every gain is a row of GAIN_SCHEDULE_POINTS values over one set of speed
+ * breakpoints shared by all rows. Between breakpoints a gain is interpolated
+ * linearly, outside them it holds the end value (gains are never extrapolated).
+ * gain_schedule_compile() turns a table into one Ifx_LutLinearF32 per gain, with
+ * slope and offset per segment computed once. gain_schedule_eval() then does a
+ * single segment search for all rows, because they share the breakpoints, and
+ * one multiply-add per gain. The result is the same as
+ * Ifx_LutLinearF32_searchPosSeq() on each LUT.
+ *
+ * The table is edited and stored by the tuning side. The control side
+ * evaluates only its own compiled copy, and balance_control.c hands whole
+ * tables over through a snapshot. The record in DFlash page
+ * GAIN_SCHEDULE_FLASH_PAGE carries the table shape and a check word; a table
+ * of another shape or with non-increasing breakpoints is not loaded.
+ * Set GAIN_SCHEDULE_FLASH to 0 to build without DFlash (host).
+ */
+#ifndef GAIN_SCHEDULE_FLASH
+#define GAIN_SCHEDULE_FLASH             (1)
+#endif
+
+#define GAIN_SCHEDULE_POINTS            (6)
+#define GAIN_SCHEDULE_SEGMENTS          (GAIN_SCHEDULE_POINTS - 1)
+
+#define GAIN_SCHEDULE_FLASH_PAGE        (3)         /* 0 YIS mode, 1 IMU calibration, 2 magnetometer */
+#define GAIN_SCHEDULE_MAGIC             (0x47534331u)   /* "GSC1" */
+
+typedef enum
+{
+    GAIN_ANGLE_KP = 0,                  /* cascade, angle loop */
+    GAIN_ANGLE_KI,
+    GAIN_ANGLE_KD,
+    GAIN_RATE_KP,                       /* cascade, rate loop */
+    GAIN_RATE_KI,
+    GAIN_RATE_KD,
+    GAIN_LQR_ROLL,                      /* state feedback, lqr_gains.h order */
+    GAIN_LQR_RATE,
+    GAIN_LQR_WHEEL,
+
+    GAIN_SCHEDULE_GAIN_NUM,
+} gain_schedule_gain_enum;
+
+#define GAIN_SCHEDULE_RECORD_WORDS      (3u + GAIN_SCHEDULE_POINTS * (1u + GAIN_SCHEDULE_GAIN_NUM))
+
+typedef struct
+{
+    float speed_mps[GAIN_SCHEDULE_POINTS];                          /* strictly increasing */
+    float gain[GAIN_SCHEDULE_GAIN_NUM][GAIN_SCHEDULE_POINTS];
+} gain_schedule_table_t;
+
+typedef struct
+{
+    Ifx_LutLinearF32 lut[GAIN_SCHEDULE_GAIN_NUM];
+    Ifx_LutLinearF32_Item segment[GAIN_SCHEDULE_GAIN_NUM][GAIN_SCHEDULE_SEGMENTS];
+    float speed_min;
+    float speed_max;
+} gain_schedule_lut_t;
+
+/* Breakpoints finite and strictly increasing, gains finite */
+uint8   gain_schedule_valid     (const gain_schedule_table_t *table);
+
+/* Whole row set to one value (no scheduling for that gain) */
+void    gain_schedule_fill      (gain_schedule_table_t *table, gain_schedule_gain_enum gain, float value);
+
+/* Breakpoint closest to speed_mps */
+uint8   gain_schedule_nearest   (const gain_schedule_table_t *table, float speed_mps);
+
+/* table must be valid */
+void    gain_schedule_compile   (gain_schedule_lut_t *lut, const gain_schedule_table_t *table);
+void    gain_schedule_eval      (const gain_schedule_lut_t *lut, float speed_mps, float gain[GAIN_SCHEDULE_GAIN_NUM]);
+
+/* DFlash record: magic, shape, breakpoints, rows, check */
+void    gain_schedule_pack      (const gain_schedule_table_t *table, uint32 record[GAIN_SCHEDULE_RECORD_WORDS]);
+uint8   gain_schedule_unpack    (const uint32 record[GAIN_SCHEDULE_RECORD_WORDS], gain_schedule_table_t *table);
+uint8   gain_schedule_load      (gain_schedule_table_t *table);         /* 0: no valid record, table untouched */
+void    gain_schedule_save      (const gain_schedule_table_t *table);
+
+#endif
@@ -0,0 +1,376 @@
+/* imu_calibration.c */
+#include "imu_calibration.h"
+#include "snapshot.h"
+#include <math.h>
+#include <string.h>
+
+#define CAL_GRAVITY                 (9.80665f)
+#define CAL_CHANNELS                (4u)        /* gyro x y z, roll */
+#define CAL_RECORD_WORDS            (6u)        /* magic, bias x y z, roll offset, check */
+
+typedef struct
+{
+    uint32 n;
+    float  elapsed_s;
+    float  mean[CAL_CHANNELS];
+    float  m2[CAL_CHANNELS];            /* sum of squared deviations (Welford) */
+} cal_window_t;
+
+typedef struct
+{
+    imu_calibration_status_t status;
+    uint32 done_id;                     /* bumped by every finished routine */
+} cal_published_t;
+
+/* CORE_CONTROL: calibration in use, windows, routine */
+static imu_calibration_t cal = {{0.0f, 0.0f, 0.0f}, 0.0f};
+static cal_window_t window;
+static imu_calibration_routine_enum routine = IMU_CAL_ROUTINE_IDLE;
+static float routine_sum[CAL_CHANNELS];
+static uint32 routine_windows = 0;
+static float routine_elapsed_s = 0.0f;
+static uint32 still_windows = 0;
+static uint32 rejected_windows = 0;
+static float window_std = 0.0f;
+static uint8 window_still = 0;
+static uint8 cal_loaded = 0;
+static uint32 done_id = 0;
+
+/* any core -> CORE_CONTROL */
+static volatile uint8 start_requested = 0;
+
+/* CORE_CONTROL -> any core */
+static cal_published_t published_slots[2];
+static snapshot_t published;
+
+/* imu_calibration_task() only */
+static uint32 saved_id = 0;
+static imu_calibration_routine_enum reported = IMU_CAL_ROUTINE_IDLE;
+static uint32 reported_windows = 0;
+
+static void window_reset(void)
+{
+    memset(&window, 0, sizeof(window));
+}
+
+static void publish(void)
+{
+    cal_published_t *slot = snapshot_write_begin(&published);
+
+    slot->status.calibration = cal;
+    slot->status.routine = routine;
+    slot->status.still = window_still;
+    slot->status.loaded = cal_loaded;
+    slot->status.routine_windows = routine_windows;
+    slot->status.still_windows = still_windows;
+    slot->status.rejected_windows = rejected_windows;
+    slot->status.window_std_dps = window_std;
+    slot->done_id = done_id;
+    snapshot_write_commit(&published);
+}
+
+/* ================= DFlash record ================= */
+static uint32 record_check(const uint32 *record)
+{
+    uint32 check = 0;
+    uint32 i;
+
+    for (i = 0; i < CAL_RECORD_WORDS - 1u; i++)
+    {
+        check ^= record[i];
+    }
+    return ~check;
+}
+
+#if IMU_CALIBRATION_FLASH
+static uint8 cal_load(imu_calibration_t *out)
+{
+    uint32 record[CAL_RECORD_WORDS];
+    float values[4];
+
+    flash_read_page(0, IMU_CAL_FLASH_PAGE, record, CAL_RECORD_WORDS);
+    if (record[0] != IMU_CAL_MAGIC || record[CAL_RECORD_WORDS - 1u] != record_check(record))
+    {
+        return 0;
+    }
+    memcpy(values, &record[1], sizeof(values));
+    if (!(fabsf(values[0]) <= IMU_CAL_BIAS_MAX_DPS && fabsf(values[1]) <= IMU_CAL_BIAS_MAX_DPS
+          && fabsf(values[2]) <= IMU_CAL_BIAS_MAX_DPS && fabsf(values[3]) <= IMU_CAL_ROLL_MAX_DEG))
+    {
+        return 0;
+    }
+    memcpy(out->gyro_bias, values, 3u * sizeof(float));
+    out->roll_offset = values[3];
+    return 1;
+}
+
+static void cal_save(const imu_calibration_t *in)
+{
+    uint32 record[CAL_RECORD_WORDS];
+
+    record[0] = IMU_CAL_MAGIC;
+    memcpy(&record[1], in->gyro_bias, 3u * sizeof(float));
+    memcpy(&record[4], &in->roll_offset, sizeof(float));
+    record[CAL_RECORD_WORDS - 1u] = record_check(record);
+    flash_write_page(0, IMU_CAL_FLASH_PAGE, record, CAL_RECORD_WORDS);
+}
+#else
+static uint8 cal_load(imu_calibration_t *out)
+{
+    (void)out;
+    (void)record_check;
+    return 0;
+}
+
+static void cal_save(const imu_calibration_t *in)
+{
+    (void)in;
+}
+#endif
+
+/* ================= Windows ================= */
+static void routine_window(uint8 still)
+{
+    uint32 i;
+
+    if (!still)
+    {
+        routine_windows = 0;            /* must be still windows in a row */
+        memset(routine_sum, 0, sizeof(routine_sum));
+        return;
+    }
+
+    for (i = 0; i < CAL_CHANNELS; i++)
+    {
+        routine_sum[i] += window.mean[i];
+    }
+    routine_windows++;
+    if (routine_windows < IMU_CAL_ROUTINE_WINDOWS)
+    {
+        return;
+    }
+
+    for (i = 0; i < CAL_CHANNELS; i++)
+    {
+        routine_sum[i] /= (float)routine_windows;
+    }
+    if (fabsf(routine_sum[3]) > IMU_CAL_ROLL_MAX_DEG)
+    {
+        routine = IMU_CAL_ROUTINE_FAILED;   /* leaning, not at the balance point */
+        return;
+    }
+    cal.gyro_bias[0] = routine_sum[0];
+    cal.gyro_bias[1] = routine_sum[1];
+    cal.gyro_bias[2] = routine_sum[2];
+    cal.roll_offset = routine_sum[3];
+    routine = IMU_CAL_ROUTINE_DONE;
+    done_id++;
+}
+
+static void window_finish(void)
+{
+    float variance, largest = 0.0f;
+    uint8 still = 1;
+    uint32 i;
+
+    for (i = 0; i < 3u; i++)
+    {
+        variance = window.m2[i] / (float)(window.n - 1u);
+        largest = (variance > largest) ? variance : largest;
+        if (fabsf(window.mean[i]) > IMU_CAL_BIAS_MAX_DPS)
+        {
+            still = 0;
+        }
+    }
+    window_std = sqrtf(largest);
+    if (window_std > IMU_CAL_STILL_STD_DPS)
+    {
+        still = 0;
+    }
+    window_still = still;
+
+    if (still)
+    {
+        still_windows++;
+    }
+    else
+    {
+        rejected_windows++;
+    }
+
+    if (routine == IMU_CAL_ROUTINE_RUNNING)
+    {
+        routine_window(still);
+    }
+    else if (still)
+    {
+        for (i = 0; i < 3u; i++)
+        {
+            cal.gyro_bias[i] += (window.mean[i] - cal.gyro_bias[i]) * IMU_CAL_BIAS_GAIN;
+        }
+    }
+
+    window_reset();
+    publish();
+}
+
+/* ================= Public ================= */
+void imu_calibration_init(void)
+{
+    memset(&cal, 0, sizeof(cal));
+    snapshot_init(&published, published_slots, sizeof(cal_published_t));
+
+    cal_loaded = cal_load(&cal);
+    window_reset();
+    routine = IMU_CAL_ROUTINE_IDLE;
+    routine_windows = 0;
+    still_windows = 0;
+    rejected_windows = 0;
+    window_std = 0.0f;
+    window_still = 0;
+    start_requested = 0;
+    publish();
+}
+
+void imu_calibration_update(const float gyro[3], const float acc[3], float roll_deg, float dt_s)
+{
+    float x[CAL_CHANNELS];
+    float acc_norm2 = acc[0] * acc[0] + acc[1] * acc[1] + acc[2] * acc[2];
+    float g_low = CAL_GRAVITY * (1.0f - IMU_CAL_ACC_GATE_G);
+    float g_high = CAL_GRAVITY * (1.0f + IMU_CAL_ACC_GATE_G);
+    float inv_n, d;
+    uint32 i;
+
+    if (start_requested)
+    {
+        start_requested = 0;
+        routine = IMU_CAL_ROUTINE_RUNNING;
+        routine_windows = 0;
+        routine_elapsed_s = 0.0f;
+        memset(routine_sum, 0, sizeof(routine_sum));
+        window_reset();
+        publish();
+    }
+    if (routine == IMU_CAL_ROUTINE_RUNNING)
+    {
+        routine_elapsed_s += dt_s;
+        if (routine_elapsed_s > IMU_CAL_ROUTINE_TIMEOUT_S)
+        {
+            routine = IMU_CAL_ROUTINE_FAILED;
+            publish();
+        }
+    }
+
+    /* moving: this window is not a standstill (frames without accel skip that test) */
+    if (fabsf(gyro[0] - cal.gyro_bias[0]) > IMU_CAL_MOTION_DPS
+        || fabsf(gyro[1] - cal.gyro_bias[1]) > IMU_CAL_MOTION_DPS
+        || fabsf(gyro[2] - cal.gyro_bias[2]) > IMU_CAL_MOTION_DPS
+        || (acc_norm2 > 1.0f && (acc_norm2 < g_low * g_low || acc_norm2 > g_high * g_high)))
+    {
+        if (window.n != 0u)
+        {
+            rejected_windows++;
+            window_still = 0;
+            if (routine == IMU_CAL_ROUTINE_RUNNING)
+            {
+                routine_window(0);
+            }
+            window_reset();
+            publish();
+        }
+        return;
+    }
+
+    x[0] = gyro[0];
+    x[1] = gyro[1];
+    x[2] = gyro[2];
+    x[3] = roll_deg;
+    window.n++;
+    window.elapsed_s += dt_s;
+    inv_n = 1.0f / (float)window.n;
+    for (i = 0; i < CAL_CHANNELS; i++)
+    {
+        d = x[i] - window.mean[i];
+        window.mean[i] += d * inv_n;
+        window.m2[i] += d * (x[i] - window.mean[i]);
+    }
+
+    if (window.elapsed_s >= IMU_CAL_WINDOW_S && window.n > 1u)
+    {
+        window_finish();
+    }
+}
+
+const imu_calibration_t *imu_calibration_get(void)
+{
+    return &cal;
+}
+
+void imu_calibration_start(void)
+{
+    start_requested = 1;
+}
+
+void imu_calibration_get_status(imu_calibration_status_t *status)
+{
+    cal_published_t now;
+
+    if (!snapshot_read(&published, &now))
+    {
+        memset(status, 0, sizeof(*status));
+        return;
+    }
+    *status = now.status;
+    if (status->routine == IMU_CAL_ROUTINE_DONE && saved_id == now.done_id)
+    {
+        status->routine = IMU_CAL_ROUTINE_SAVED;
+    }
+}
+
+/* Blocks for the DFlash write (one word page) after a finished routine */
+void imu_calibration_task(void)
+{
+    cal_published_t now;
+
+    if (!snapshot_read(&published, &now))
+    {
+        return;
+    }
+
+    if (now.status.routine == IMU_CAL_ROUTINE_DONE && saved_id != now.done_id)
+    {
+        cal_save(&now.status.calibration);
+        saved_id = now.done_id;
+        printf("imu calibration: bias %.3f %.3f %.3f deg/s  roll offset %.2f deg, saved\r\n",
+               now.status.calibration.gyro_bias[0], now.status.calibration.gyro_bias[1],
+               now.status.calibration.gyro_bias[2], now.status.calibration.roll_offset);
+    }
+    else if (now.status.routine != reported
+             || (now.status.routine == IMU_CAL_ROUTINE_RUNNING && now.status.routine_windows != reported_windows))
+    {
+        if (now.status.routine == IMU_CAL_ROUTINE_RUNNING)
+        {
+            printf("imu calibration: hold still at the balance point (%lu/%u)\r\n",
+                   (unsigned long)now.status.routine_windows, (unsigned)IMU_CAL_ROUTINE_WINDOWS);
+        }
+        else if (now.status.routine == IMU_CAL_ROUTINE_FAILED)
+        {
+            printf("imu calibration: failed (moving or leaning), calibration unchanged\r\n");
+        }
+    }
+    reported = now.status.routine;
+    reported_windows = now.status.routine_windows;
+}
+
+void imu_calibration_report(void)
+{
+    imu_calibration_status_t status;
+
+    imu_calibration_get_status(&status);
+    printf("imu cal bias %.3f %.3f %.3f deg/s  roll offset %.2f deg  (%s)\r\n",
+           status.calibration.gyro_bias[0], status.calibration.gyro_bias[1], status.calibration.gyro_bias[2],
+           status.calibration.roll_offset, status.loaded ? "DFlash" : "default");
+    printf("imu cal standstill %s  windows still %lu rejected %lu  std %.2f deg/s\r\n",
+           status.still ? "yes" : "no", (unsigned long)status.still_windows,
+           (unsigned long)status.rejected_windows, status.window_std_dps);
+}
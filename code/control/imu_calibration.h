@@ -0,0 +1,92 @@
+/* imu_calibration.h */
+#ifndef IMU_CALIBRATION_H
+#define IMU_CALIBRATION_H
+
+#include "zf_common_headfile.h"
+
+/* Gyro bias and IMU mounting (roll) offset, hardware independent so it also
+ * builds on the host (tools/sim/imu_calibration_check.c).
+ *
+ * Every IMU sample goes through imu_calibration_update() uncorrected. Samples are
+ * collected into windows of IMU_CAL_WINDOW_S with running mean and variance per
+ * gyro axis and for the roll estimate. A sample moving faster than
+ * IMU_CAL_MOTION_DPS (after the current bias) or with |a| off 1 g by more than
+ * IMU_CAL_ACC_GATE_G throws the window away; a full window is a standstill when
+ * every gyro axis stays below IMU_CAL_STILL_STD_DPS standard deviation and its
+ * mean below IMU_CAL_BIAS_MAX_DPS.
+ *
+ * Automatic: each standstill window pulls the gyro bias toward its mean by
+ * IMU_CAL_BIAS_GAIN. The roll offset is never learned automatically, standing
+ * still says nothing about being upright.
+ * Guided: imu_calibration_start() with the bike held still at its balance point.
+ * IMU_CAL_ROUTINE_WINDOWS standstill windows in a row set the gyro bias and the
+ * roll offset (the roll reading there, within IMU_CAL_ROLL_MAX_DEG) outright;
+ * motion restarts the count, IMU_CAL_ROUTINE_TIMEOUT_S ends it as failed.
+ * imu_calibration_task() then stores the result in DFlash page
+ * IMU_CAL_FLASH_PAGE, and imu_calibration_init() applies it at boot.
+ *
+ * The consumer subtracts imu_calibration_get()->gyro_bias from the gyro and
+ * roll_offset from the roll; nothing else is done per sample on its side.
+ * imu_calibration_update() and the calibration it returns belong to one context
+ * (CORE_CONTROL); start, status and task may be called from any core.
+ * Set IMU_CALIBRATION_FLASH to 0 to build without DFlash (host).
+ */
+#ifndef IMU_CALIBRATION_FLASH
+#define IMU_CALIBRATION_FLASH           (1)
+#endif
+
+#define IMU_CAL_WINDOW_S                (1.0f)
+#define IMU_CAL_MOTION_DPS              (5.0f)      /* any axis, after the current bias */
+#define IMU_CAL_ACC_GATE_G              (0.05f)
+#define IMU_CAL_STILL_STD_DPS           (0.5f)      /* sensor noise passes, hand tremor does not */
+#define IMU_CAL_BIAS_MAX_DPS            (3.0f)      /* larger means are motion, not bias */
+#define IMU_CAL_BIAS_GAIN               (0.2f)      /* per standstill window, ~5 s time constant */
+#define IMU_CAL_ROUTINE_WINDOWS         (3u)
+#define IMU_CAL_ROUTINE_TIMEOUT_S       (20.0f)
+#define IMU_CAL_ROLL_MAX_DEG            (5.0f)      /* larger offsets are a lean, not the mounting */
+
+#define IMU_CAL_FLASH_PAGE              (1)         /* DFlash page 0 holds the YIS mode */
+#define IMU_CAL_MAGIC                   (0x494D4331u)   /* "IMC1" */
+
+typedef struct
+{
+    float gyro_bias[3];                 /* deg/s, subtracted from the gyro */
+    float roll_offset;                  /* deg, roll reading at the balance point */
+} imu_calibration_t;
+
+typedef enum
+{
+    IMU_CAL_ROUTINE_IDLE = 0,
+    IMU_CAL_ROUTINE_RUNNING,            /* waiting for / collecting standstill windows */
+    IMU_CAL_ROUTINE_DONE,               /* result applied, not stored yet */
+    IMU_CAL_ROUTINE_SAVED,
+    IMU_CAL_ROUTINE_FAILED,             /* timed out or not upright; calibration unchanged */
+} imu_calibration_routine_enum;
+
+typedef struct
+{
+    imu_calibration_t calibration;
+    imu_calibration_routine_enum routine;
+    uint8  still;                       /* the last full window was a standstill */
+    uint8  loaded;                      /* boot calibration came from DFlash */
+    uint32 routine_windows;             /* standstill windows collected by the routine */
+    uint32 still_windows;               /* total, automatic and routine */
+    uint32 rejected_windows;
+    float  window_std_dps;              /* largest gyro axis of the last full window */
+} imu_calibration_status_t;
+
+void  imu_calibration_init          (void);
+
+/* One uncorrected IMU sample: gyro deg/s, acc m/s^2, roll deg (estimator output
+ * before the roll offset), dt_s the sample interval */
+void  imu_calibration_update        (const float gyro[3], const float acc[3], float roll_deg, float dt_s);
+
+/* Calibration in use; stays valid, updated in place by imu_calibration_update() */
+const imu_calibration_t *imu_calibration_get (void);
+
+void  imu_calibration_start         (void);     /* guided routine, bike still at its balance point */
+void  imu_calibration_get_status    (imu_calibration_status_t *status);
+void  imu_calibration_task          (void);     /* stores a finished routine, reports progress */
+void  imu_calibration_report        (void);
+
+#endif
@@ -0,0 +1,25 @@
+/* lqr_gains.h - generated by tools/sim/lqr_design.cpp, do not edit */
+#ifndef LQR_GAINS_H
+#define LQR_GAINS_H
+
+/* Plant: 4.50 kg, centre of mass 0.160 m, roll inertia 0.160 kg*m^2, wheel inertia 0.0045 kg*m^2,
+ * torque sign +1; zero order hold at 5 ms.
+ * torque = -(k[0] (roll - target) + k[1] roll_rate + k[2] wheel_speed), in deg, deg/s, turns/s -> N*m */
+#define LQR_STATE_NUM                   (3)
+
+typedef struct
+{
+    const char *name;
+    float k[LQR_STATE_NUM];
+} lqr_gain_set_t;
+
+static const lqr_gain_set_t lqr_gain_sets[] =
+{
+    { "soft",    { -4.916609e-01f, -5.841015e-02f, -4.055062e-02f } },
+    { "nominal", { -6.418970e-01f, -6.937471e-02f, -5.303211e-02f } },
+    { "stiff",   { -1.088021e+00f, -9.126855e-02f, -7.472634e-02f } },
+};
+
+#define LQR_GAIN_SET_NUM                (sizeof(lqr_gain_sets) / sizeof(lqr_gain_sets[0]))
+
+#endif
@@ -0,0 +1,95 @@
+/* pid.c */
+#include "pid.h"
+#include <math.h>
+
+#define PID_DT_MIN_S                (1e-6f)
+
+static inline float pid_clamp(float value, float limit)
+{
+    if (value > limit) return limit;
+    if (value < -limit) return -limit;
+    return value;
+}
+
+/* Once per gain change, so pid_update() needs no division for it */
+static void pid_tracking(pid_controller_t *pid)
+{
+    const pid_config_t *c = &pid->config;
+    float tau = c->tracking_tau_s;
+
+    if (tau <= 0.0f && c->ki != 0.0f)
+    {
+        tau = 0.5f * fabsf(c->kp / c->ki);
+    }
+    pid->tracking_gain = (tau > 0.0f) ? 1.0f / tau : 0.0f;     /* 0: the whole excess per step */
+}
+
+void pid_init(pid_controller_t *pid, const pid_config_t *config)
+{
+    pid->config = *config;
+    pid_tracking(pid);
+    pid_reset(pid);
+}
+
+void pid_reset(pid_controller_t *pid)
+{
+    pid->integral = 0.0f;
+    pid->rate = 0.0f;
+    pid->last_d_input = 0.0f;
+    pid->last_p_input = 0.0f;
+    pid->output = 0.0f;
+    pid->started = 0;
+}
+
+/* The integral absorbs the step the new kp / kd would give on the last inputs */
+void pid_set_gains(pid_controller_t *pid, float kp, float ki, float kd)
+{
+    pid_config_t *c = &pid->config;
+
+    if (ki != 0.0f && pid->started)
+    {
+        pid->integral += (c->kp - kp) * pid->last_p_input + (c->kd - kd) * pid->rate;
+    }
+    c->kp = kp;
+    c->ki = ki;
+    c->kd = kd;
+    if (ki == 0.0f)
+    {
+        pid->integral = 0.0f;
+    }
+    pid_tracking(pid);
+}
+
+float pid_update(pid_controller_t *pid, float setpoint, float measurement, float feedforward, float dt_s)
+{
+    const pid_config_t *c = &pid->config;
+    float p_input = c->setpoint_weight_p * setpoint - measurement;
+    float d_input = c->setpoint_weight_d * setpoint - measurement;
+    float unclamped, output, tracking;
+
+    if (dt_s < PID_DT_MIN_S) dt_s = PID_DT_MIN_S;
+
+    /* kd = 0 (the usual case) costs no division */
+    if (c->kd != 0.0f && pid->started)
+    {
+        float raw = (d_input - pid->last_d_input) / dt_s;
+        pid->rate += (raw - pid->rate) * (dt_s / (c->derivative_tau_s + dt_s));
+    }
+    pid->last_d_input = d_input;
+    pid->last_p_input = p_input;
+    pid->started = 1;
+
+    unclamped = c->kp * p_input + pid->integral + c->kd * pid->rate + feedforward;
+    output = pid_clamp(unclamped, c->output_limit);
+
+    if (c->ki != 0.0f)
+    {
+        /* back-calculation, at most the whole excess per step */
+        tracking = dt_s * pid->tracking_gain;
+        if (tracking > 1.0f || pid->tracking_gain == 0.0f) tracking = 1.0f;
+        pid->integral += c->ki * (setpoint - measurement) * dt_s + (output - unclamped) * tracking;
+    }
+
+    pid->output = output;
+    return output;
+}
@@ -0,0 +1,56 @@
+/* pid.h */
+#ifndef PID_H
+#define PID_H
+
+#include "zf_common_headfile.h"
+
+/* PID controller shared by the control loops, hardware independent so it also
+ * builds on the host (tools/sim/pid_check.c).
+ *
+ *   u = kp (b r - y) + I + kd D + feedforward,   clamped to +-output_limit
+ *   D = d/dt (c r - y) through a first order filter with derivative_tau_s
+ *   I' = ki (r - y) + (u_clamped - u) / tracking_tau_s
+ *
+ * b and c are the setpoint weights: c = 0 differentiates the measurement only,
+ * so a setpoint step gives no derivative kick; b < 1 softens the proportional
+ * reaction to it. Windup is handled by back-calculation: while the output is
+ * clamped the integral is pulled toward the value that just reaches the limit,
+ * with time constant tracking_tau_s (0: half the integral time |kp / ki|, which
+ * follows gain changes). The integral is kept in output units, so a ki
+ * change does not move the output, and pid_set_gains() shifts it by the step a
+ * kp or kd change would cause (bumpless). Without integral action (ki = 0) the
+ * integral stays 0 and gain changes act at once.
+ */
+typedef struct
+{
+    float kp;
+    float ki;                           /* 1/s */
+    float kd;                           /* s */
+    float setpoint_weight_p;            /* b, usually 1 */
+    float setpoint_weight_d;            /* c, 0 = derivative on measurement */
+    float derivative_tau_s;             /* derivative filter time constant, 0 = unfiltered */
+    float tracking_tau_s;               /* back-calculation time constant, 0 = |kp / ki| / 2 */
+    float output_limit;                 /* symmetric, > 0 */
+} pid_config_t;
+
+typedef struct
+{
+    pid_config_t config;
+    float integral;                     /* I, output units */
+    float rate;                         /* filtered d/dt (c r - y) */
+    float last_d_input;                 /* c r - y of the last update */
+    float last_p_input;                 /* b r - y of the last update */
+    float output;                       /* last clamped output */
+    float tracking_gain;                /* 1 / tracking time constant */
+    uint8 started;                      /* last_d_input is valid */
+} pid_controller_t;
+
+void  pid_init          (pid_controller_t *pid, const pid_config_t *config);
+void  pid_reset         (pid_controller_t *pid);
+
+/* Bumpless: call from the context that runs pid_update() */
+void  pid_set_gains     (pid_controller_t *pid, float kp, float ki, float kd);
+
+float pid_update        (pid_controller_t *pid, float setpoint, float measurement, float feedforward, float dt_s);
+
+#endif
@@ -7,6 +7,7 @@
 * 1. IPS200Ļʼ
 * 2. ʵʱʾϵͳ״̬Ƕȡٶȡȣ
 * 3. ṩȫĻʾԽ
+* 4. ʽַ񣺾̬ǩֻһΣÿˢֻݱ仯ַ
 * 
 ********************************************************************************************************************/
 
@@ -14,8 +15,185 @@
 #include "zf_device_ips200.h"
 #include <string.h>
 
+// ========== ַ ==========
+// ui_back Ϊ֡Ҫʾݣui_front ΪĻеݡ
+// ÿַֻ߲֡ͬкϲΣһһʾд롣
+// ոκǰɫ¶ֻбɫȽʱɫΪ0
+typedef struct {
+    char   ch;
+    uint16 color;
+} ui_cell_t;
+
+#define UI_COLOR_TITLE          (RGB565_CYAN)
+#define UI_COLOR_LABEL          (RGB565_WHITE)
+#define UI_COLOR_SELECT         (RGB565_GREEN)
+#define UI_COLOR_SECTION        (RGB565_YELLOW)
+#define UI_COLOR_HINT           (RGB565_GRAY)
+#define UI_COLOR_BG             (RGB565_BLACK)
+
+// ========== 沼֣, У ==========
+#define UI_ROW_TITLE            (0)
+#define UI_ROW_STATUS           (1)
+#define UI_ROW_ANGLE            (2)
+#define UI_ROW_RATE             (3)
+#define UI_ROW_OUTPUT           (4)
+#define UI_ROW_SPEED            (5)
+#define UI_ROW_ISR              (6)
+#define UI_ROW_PID_TITLE        (7)
+#define UI_ROW_PID              (8)                  // 6PID￪ʼ
+#define UI_ROW_HINT             (15)
+#define UI_COL_VALUE            (5)                  // ʵʱֵ
+#define UI_COL_UNIT             (12)                 // λ
+#define UI_COL_PID_VALUE        (6)                  // PIDֵ
+
 // ========== ̬ ==========
 static uint32 last_display_update = 0;  // ϴĻʱ
+static ui_cell_t ui_front[UI_ROWS][UI_COLS];
+static ui_cell_t ui_back[UI_ROWS][UI_COLS];
+static uint8 ui_front_valid = 0;        // 0Ļδ֪һ֡
+static ui_render_stats_t ui_stats;
+
+static const char *const ui_pid_labels[6] = { "AKp:", "AKi:", "AKd:", "VKp:", "VKi:", "VKd:" };
+
+// ========== д ==========
+static void ui_put_string(uint8 row, uint8 col, const char *str, uint16 color)
+{
+    while (*str != '\0' && col < UI_COLS) {
+        ui_back[row][col].ch = *str++;
+        ui_back[row][col].color = color;
+        col++;
+    }
+}
+
+// ̶ֶΣ㲿ֲո񣬾ֵϳʱ
+static void ui_put_field(uint8 row, uint8 col, uint8 width, const char *str, uint16 color)
+{
+    while (width-- > 0 && col < UI_COLS) {
+        ui_back[row][col].ch = (*str != '\0') ? *str++ : ' ';
+        ui_back[row][col].color = color;
+        col++;
+    }
+}
+
+//  ips200_show_float ͬĸʽֱ num λֶο num + pointnum + 2
+static void ui_put_float(uint8 row, uint8 col, float value, uint8 num, uint8 pointnum, uint16 color)
+{
+    char buffer[17];
+    double offset = 1.0;
+    double value_temp = value;
+    uint8 i;
+
+    for (i = 0; i < num; i++) {
+        offset *= 10;
+    }
+    value_temp = value_temp - ((int)value_temp / (int)offset) * offset;
+    memset(buffer, 0, sizeof(buffer));
+    func_double_to_str(buffer, value_temp, pointnum);
+    ui_put_field(row, col, (uint8)(num + pointnum + 2), buffer, color);
+}
+
+static void ui_put_uint(uint8 row, uint8 col, uint32 value, uint8 num, uint16 color)
+{
+    char buffer[12];
+    uint32 offset = 1;
+    uint8 i;
+
+    if (num < 10) {
+        for (i = 0; i < num; i++) {
+            offset *= 10;
+        }
+        value %= offset;
+    }
+    memset(buffer, 0, sizeof(buffer));
+    func_uint_to_str(buffer, value);
+    ui_put_field(row, col, num, buffer, color);
+}
+
+static inline uint8 ui_cell_equal(const ui_cell_t *a, const ui_cell_t *b)
+{
+    if (a->ch != b->ch) return 0;
+    return (a->ch == ' ') || (a->color == b->color);
+}
+
+// ========== ̬ݣǩ⡢ʾֻؽʱд ==========
+static void ui_compose_static(void)
+{
+    uint8 i;
+
+    for (i = 0; i < UI_ROWS; i++) {
+        uint8 j;
+        for (j = 0; j < UI_COLS; j++) {
+            ui_back[i][j].ch = ' ';
+            ui_back[i][j].color = UI_COLOR_LABEL;
+        }
+    }
+
+    ui_put_string(UI_ROW_TITLE, 4, "Balance Ctrl", UI_COLOR_TITLE);
+    ui_put_string(UI_ROW_STATUS, 0, "Status:", UI_COLOR_LABEL);
+    ui_put_string(UI_ROW_ANGLE, 0, "Ang:", UI_COLOR_LABEL);
+    ui_put_string(UI_ROW_ANGLE, UI_COL_UNIT, "deg", UI_COLOR_LABEL);
+    ui_put_string(UI_ROW_RATE, 0, "Rate:", UI_COLOR_LABEL);
+    ui_put_string(UI_ROW_OUTPUT, 0, "Out:", UI_COLOR_LABEL);
+    ui_put_string(UI_ROW_OUTPUT, UI_COL_UNIT, "Nm", UI_COLOR_LABEL);
+    ui_put_string(UI_ROW_SPEED, 0, "Spd:", UI_COLOR_LABEL);
+    ui_put_string(UI_ROW_SPEED, UI_COL_UNIT, "r/s", UI_COLOR_LABEL);
+    ui_put_string(UI_ROW_ISR, 0, "ISR:", UI_COLOR_LABEL);
+    ui_put_string(UI_ROW_ISR, UI_COL_UNIT, "us", UI_COLOR_LABEL);
+    ui_put_string(UI_ROW_PID_TITLE, 0, "-- PID Params --", UI_COLOR_SECTION);
+    ui_put_string(UI_ROW_HINT, 0, "K1:ON/OFF", UI_COLOR_HINT);
+    ui_put_string(UI_ROW_HINT + 1, 0, "K2:Select K3:+ K4:-", UI_COLOR_HINT);
+}
+
+// ========== ͱ仯ַ ==========
+// ͬһͬɫб仯ַϲΪһΣд
+static uint32 ui_flush(uint32 *runs)
+{
+    char text[UI_COLS];
+    uint32 pixels = 0;
+    uint8 row, col;
+
+    *runs = 0;
+    for (row = 0; row < UI_ROWS; row++) {
+        col = 0;
+        while (col < UI_COLS) {
+            if (ui_cell_equal(&ui_back[row][col], &ui_front[row][col])) {
+                col++;
+                continue;
+            }
+
+            uint8 start = col;
+            uint16 color = ui_back[row][col].color;
+            uint8 len = 0;
+            while (col < UI_COLS
+                   && !ui_cell_equal(&ui_back[row][col], &ui_front[row][col])
+                   && (ui_back[row][col].ch == ' ' || ui_back[row][col].color == color)) {
+                text[len++] = ui_back[row][col].ch;
+                ui_front[row][col] = ui_back[row][col];
+                col++;
+            }
+
+            ips200_set_color(color, UI_COLOR_BG);
+            ips200_show_string_run(UI_ORIGIN_X + start * UI_CELL_WIDTH, UI_ORIGIN_Y + row * UI_CELL_HEIGHT, text, len);
+            pixels += (uint32)len * UI_CELL_WIDTH * UI_CELL_HEIGHT;
+            (*runs)++;
+        }
+    }
+    return pixels;
+}
+
+// ========== ؽһΣ֮ȫݰ ==========
+static void ui_invalidate(void)
+{
+    uint8 i, j;
+
+    for (i = 0; i < UI_ROWS; i++) {
+        for (j = 0; j < UI_COLS; j++) {
+            ui_front[i][j].ch = ' ';
+            ui_front[i][j].color = UI_COLOR_LABEL;
+        }
+    }
+    ui_front_valid = 0;
+}
 
 // ========== ʼUIģ ==========
 void ui_control_init(void)
@@ -36,6 +214,8 @@ void ui_control_init(void)
 
     // Ļ
     ips200_clear();
+    ui_invalidate();
+    memset(&ui_stats, 0, sizeof(ui_stats));
 
     printf("IPS200 Screen initialized successfully.\r\n");
 }
@@ -48,6 +228,15 @@ void ui_control_show_splash(void)
     ips200_show_string(40, 100, "Bike Balance System");
     ips200_set_color(RGB565_GREEN, RGB565_BLACK);
     ips200_show_string(60, 120, "Initializing...");
+    ui_invalidate();
+}
+
+// ========== ȡˢͳ ==========
+void ui_control_get_stats(ui_render_stats_t *stats)
+{
+    if (stats != NULL) {
+        *stats = ui_stats;
+    }
 }
 
 // ========== ȫʾַ ==========
@@ -89,6 +278,7 @@ void ui_safe_show_float(uint16 x, uint16 y, float value, uint8 int_digits, uint8
 void ui_clear_screen(void)
 {
     ips200_clear();
+    ui_invalidate();
 }
 
 // ========== Ļɫ ==========
@@ -101,6 +291,9 @@ void ui_set_color(uint16 pen_color, uint16 bg_color)
 void ui_control_update(const ui_display_data_t *data)
 {
     uint32 current_time = system_getval_ms();
+    uint32 start_time;
+    uint8 full_redraw = 0;
+    uint8 i;
 
     // Ƿ񵽴¼һεʱǿƸ£
     if (last_display_update != 0 && (current_time - last_display_update) < UI_UPDATE_INTERVAL_MS) {
@@ -108,130 +301,54 @@ void ui_control_update(const ui_display_data_t *data)
     }
 
     last_display_update = current_time;
+    start_time = system_getval();
+
+    // Ļδ֪ʼ֮󣩣һβд̬
+    if (!ui_front_valid) {
+        ips200_clear();
+        ui_compose_static();
+        ui_front_valid = 1;
+        full_redraw = 1;
+    }
 
-    // Ļ
-    ips200_clear();
-
-    // ========== ʾ ==========
-    ips200_set_color(RGB565_CYAN, RGB565_BLACK);
-    ips200_show_string(35, 2, "Balance Ctrl");
-    
-    uint16 y = 20;
-
-    // ========== ʾϵͳ״̬ ==========
-    ips200_set_color(RGB565_WHITE, RGB565_BLACK);
-    ips200_show_string(5, y, "Status:");
+    // ========== ϵͳ״̬ ==========
     if (data->system_status == 0) {
-        ips200_set_color(RGB565_GREEN, RGB565_BLACK);
-        ips200_show_string(60, y, "RUN ");
+        ui_put_field(UI_ROW_STATUS, 7, 4, "RUN", RGB565_GREEN);
     } else {
-        ips200_set_color(RGB565_RED, RGB565_BLACK);
-        ips200_show_string(60, y, "STOP");
+        ui_put_field(UI_ROW_STATUS, 7, 4, "STOP", RGB565_RED);
     }
-    y += 18;
 
-    // ========== ʾʵʱ ==========
-    ips200_set_color(RGB565_WHITE, RGB565_BLACK);
-    ips200_show_string(5, y, "Ang:");
-    ips200_show_float(45, y, data->angle, 2, 2);
-    ips200_show_string(100, y, "deg");
-    y += 16;
-
-    ips200_show_string(5, y, "Rate:");
-    ips200_show_float(45, y, data->angular_velocity, 3, 1);
-    y += 16;
-
-    ips200_show_string(5, y, "Out:");
-    ips200_show_float(45, y, data->control_output, 1, 3);
-    ips200_show_string(100, y, "Nm");
-    y += 16;
-
-    // ========== ʾ ==========
-    ips200_show_string(5, y, "Spd:");
-    ips200_show_float(45, y, data->wheel_speed_rps, 2, 2);
-    ips200_show_string(100, y, "r/s");
-    y += 18;
-
-    // ========== ʾPID ==========
-    ips200_set_color(RGB565_YELLOW, RGB565_BLACK);
-    ips200_show_string(5, y, "-- PID Params --");
-    y += 16;
-
-    // ǶKp (0)
-    if (data->selected_param == 0) {
-        ips200_set_color(RGB565_GREEN, RGB565_BLACK);
-        ips200_show_string(5, y, ">");
-    } else {
-        ips200_set_color(RGB565_WHITE, RGB565_BLACK);
-        ips200_show_string(5, y, " ");
-    }
-    ips200_show_string(15, y, "AKp:");
-    ips200_show_float(50, y, data->angle_kp, 1, 2);
-    y += 14;
+    // ========== ʵʱ ==========
+    ui_put_float(UI_ROW_ANGLE, UI_COL_VALUE, data->angle, 2, 2, UI_COLOR_LABEL);
+    ui_put_float(UI_ROW_RATE, UI_COL_VALUE, data->angular_velocity, 3, 1, UI_COLOR_LABEL);
+    ui_put_float(UI_ROW_OUTPUT, UI_COL_VALUE, data->control_output, 1, 3, UI_COLOR_LABEL);
+    ui_put_float(UI_ROW_SPEED, UI_COL_VALUE, data->wheel_speed_rps, 2, 2, UI_COLOR_LABEL);
+    ui_put_uint(UI_ROW_ISR, UI_COL_VALUE, data->isr_time_max_us, 5, UI_COLOR_LABEL);
 
-    // ǶKi (1)
-    if (data->selected_param == 1) {
-        ips200_set_color(RGB565_GREEN, RGB565_BLACK);
-        ips200_show_string(5, y, ">");
-    } else {
-        ips200_set_color(RGB565_WHITE, RGB565_BLACK);
-        ips200_show_string(5, y, " ");
-    }
-    ips200_show_string(15, y, "AKi:");
-    ips200_show_float(50, y, data->angle_ki, 1, 2);
-    y += 14;
+    // ========== PIDѡеһи ==========
+    for (i = 0; i < 6; i++) {
+        uint16 color = (data->selected_param == i) ? UI_COLOR_SELECT : UI_COLOR_LABEL;
+        uint8 row = (uint8)(UI_ROW_PID + i);
 
-    // ǶKd (2)
-    if (data->selected_param == 2) {
-        ips200_set_color(RGB565_GREEN, RGB565_BLACK);
-        ips200_show_string(5, y, ">");
-    } else {
-        ips200_set_color(RGB565_WHITE, RGB565_BLACK);
-        ips200_show_string(5, y, " ");
+        ui_put_field(row, 0, 1, (data->selected_param == i) ? ">" : " ", color);
+        ui_put_string(row, 1, ui_pid_labels[i], color);
     }
-    ips200_show_string(15, y, "AKd:");
-    ips200_show_float(50, y, data->angle_kd, 1, 2);
-    y += 14;
-
-    // ٶKp (3)
-    if (data->selected_param == 3) {
-        ips200_set_color(RGB565_GREEN, RGB565_BLACK);
-        ips200_show_string(5, y, ">");
-    } else {
-        ips200_set_color(RGB565_WHITE, RGB565_BLACK);
-        ips200_show_string(5, y, " ");
+    ui_put_float(UI_ROW_PID + 0, UI_COL_PID_VALUE, data->angle_kp, 1, 2, (data->selected_param == 0) ? UI_COLOR_SELECT : UI_COLOR_LABEL);
+    ui_put_float(UI_ROW_PID + 1, UI_COL_PID_VALUE, data->angle_ki, 1, 2, (data->selected_param == 1) ? UI_COLOR_SELECT : UI_COLOR_LABEL);
+    ui_put_float(UI_ROW_PID + 2, UI_COL_PID_VALUE, data->angle_kd, 1, 2, (data->selected_param == 2) ? UI_COLOR_SELECT : UI_COLOR_LABEL);
+    ui_put_float(UI_ROW_PID + 3, UI_COL_PID_VALUE, data->velocity_kp, 2, 2, (data->selected_param == 3) ? UI_COLOR_SELECT : UI_COLOR_LABEL);
+    ui_put_float(UI_ROW_PID + 4, UI_COL_PID_VALUE, data->velocity_ki, 1, 3, (data->selected_param == 4) ? UI_COLOR_SELECT : UI_COLOR_LABEL);
+    ui_put_float(UI_ROW_PID + 5, UI_COL_PID_VALUE, data->velocity_kd, 1, 2, (data->selected_param == 5) ? UI_COLOR_SELECT : UI_COLOR_LABEL);
+
+    // ========== ֻͱ仯ַ ==========
+    ui_stats.last_pixels = ui_flush(&ui_stats.last_runs);
+    if (full_redraw) {
+        ui_stats.last_pixels += (uint32)ips200_width_max * ips200_height_max;
     }
-    ips200_show_string(15, y, "VKp:");
-    ips200_show_float(50, y, data->velocity_kp, 2, 2);
-    y += 14;
-
-    // ٶKi (4)
-    if (data->selected_param == 4) {
-        ips200_set_color(RGB565_GREEN, RGB565_BLACK);
-        ips200_show_string(5, y, ">");
-    } else {
-        ips200_set_color(RGB565_WHITE, RGB565_BLACK);
-        ips200_show_string(5, y, " ");
+    ui_stats.total_pixels += ui_stats.last_pixels;
+    ui_stats.last_us = (system_getval() - start_time) / 100;
+    if (!full_redraw && ui_stats.last_us > ui_stats.max_us) {
+        ui_stats.max_us = ui_stats.last_us;
     }
-    ips200_show_string(15, y, "VKi:");
-    ips200_show_float(50, y, data->velocity_ki, 1, 3);
-    y += 14;
-
-    // ٶKd (5)
-    if (data->selected_param == 5) {
-        ips200_set_color(RGB565_GREEN, RGB565_BLACK);
-        ips200_show_string(5, y, ">");
-    } else {
-        ips200_set_color(RGB565_WHITE, RGB565_BLACK);
-        ips200_show_string(5, y, " ");
-    }
-    ips200_show_string(15, y, "VKd:");
-    ips200_show_float(50, y, data->velocity_kd, 1, 2);
-    y += 16;
-
-    // ========== ʾʾ ==========
-    ips200_set_color(RGB565_GRAY, RGB565_BLACK);
-    ips200_show_string(5, y, "K1:ON/OFF");
-    y += 14;
-    ips200_show_string(5, y, "K2:Select K3:+ K4:-");
+    ui_stats.frames++;
 }
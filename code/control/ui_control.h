@@ -7,6 +7,7 @@
 * 1. IPS200Ļʼ
 * 2. ʵʱʾϵͳ״̬Ƕȡٶȡȣ
 * 3. ṩȫĻʾԽ
+* 4. ʽַ񣺾̬ǩֻһΣÿˢֻݱ仯ַ
 * 
 ********************************************************************************************************************/
 
@@ -19,13 +20,14 @@
 #define IPS200_TYPE             (IPS200_TYPE_SPI)    // ʵĻѡIPS200_TYPE_SPI  IPS200_TYPE_PARALLEL8
 
 // ========== ʾ ==========
-#define UI_UPDATE_INTERVAL_MS   (500)                // Ļ¼룩
-#define UI_TITLE_Y              (5)                  // Y
-#define UI_DATA_START_Y         (30)                 // ʾʼY
-#define UI_LINE_HEIGHT          (16)                 // и
-#define UI_COL1_X               (5)                  // һУǩ
-#define UI_COL2_X               (80)                 // ڶУֵ
-#define UI_COL3_X               (140)                // Уλ
+// Ļ 8x16 廮Ϊַ񣬽 (, ) 
+#define UI_UPDATE_INTERVAL_MS   (100)                // Ļ¼룩
+#define UI_ORIGIN_X             (4)                  // ϽX
+#define UI_ORIGIN_Y             (2)                  // ϽY
+#define UI_CELL_WIDTH           (8)                  // ַ
+#define UI_CELL_HEIGHT          (16)                 // ַߣиߣ
+#define UI_COLS                 (29)                 //  (240 - 4) / 8
+#define UI_ROWS                 (19)                 //  (320 - 2) / 16
 
 // ========== ʾݽṹ ==========
 typedef struct {
@@ -43,8 +45,19 @@ typedef struct {
     float velocity_kd;          // ٶȻKd
     uint8 selected_param;       // ǰѡеĲ0~5
     float wheel_speed_rps;      // ٣ת/룩
+    uint32 isr_time_max_us;     // 5msжִʱ䣨΢룩
 } ui_display_data_t;
 
+// ========== ˢͳ ==========
+typedef struct {
+    uint32 frames;              // ˢ֡
+    uint32 last_us;             // һ֡ˢºʱ΢룩
+    uint32 max_us;              // ˢºʱ΢룬֡
+    uint32 last_pixels;         // һ֡д
+    uint32 last_runs;           // һ֡ʾ
+    uint32 total_pixels;        // ۼд
+} ui_render_stats_t;
+
 // ========== ⲿ ==========
 extern uint16 ips200_width_max;     // Ļ
 extern uint16 ips200_height_max;    // Ļ߶
@@ -66,12 +79,18 @@ void ui_control_update(const ui_display_data_t *data);
 
 /**
  * @brief ʾ
- * @note ͨڳʼɺ
+ * @note ͨڳʼɺãһ ui_control_update() ػ
  */
 void ui_control_show_splash(void);
 
 /**
- * @brief ȫʾַ߽飩
+ * @brief ȡˢͳƣʱ
+ * @param stats 
+ */
+void ui_control_get_stats(ui_render_stats_t *stats);
+
+/**
+ * @brief ȫʾַ߽飬ֱӻƣַ
  * @param x X
  * @param y Y
  * @param str Ҫʾַ
@@ -90,6 +109,7 @@ void ui_safe_show_float(uint16 x, uint16 y, float value, uint8 int_digits, uint8
 
 /**
  * @brief Ļ
+ * @note ͬʱַ¼֮ˢ»ػȫ
  */
 void ui_clear_screen(void);
 
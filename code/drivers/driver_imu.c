@@ -1,242 +1,345 @@
 /* yis_imu.c */
 #include <driver_imu.h>
+#include "yis_parser.h"
+#include "profiler.h"
+#include "multicore.h"
+#include "snapshot.h"
+#include "isr_config.h"
+#include "IfxDma_Dma.h"
+#include "IfxStm.h"
 
 #define LED1                    (P20_9)
 
 /* ================= UART  ================= */
 #define YIS_UART_INDEX          UART_5
-#define YIS_BAUDRATE            115200
+#define YIS_BAUDRATE_DEFAULT    115200          /* ģ */
 #define YIS_TX_PIN              UART5_TX_P22_2
 #define YIS_RX_PIN              UART5_RX_P22_3
 
-/* ================= Э鶨 ================= */
-#define YIS_HEADER_1            0x59
-#define YIS_HEADER_2            0x53
+/* =================  =================
+ * ϵȰ DFlash бģʽ򿪴ڣYIS_CONFIRM_MS յ㹻ĺϷֱ֡ʹãκ
+ * Э̣ڸѡϼҵģ鵱ǰĲʣٴߵͲлزʺ
+ * Ƶյ֡ȷϡֻģ RAMȷͨŷͱģʽ DFlash
+ * ͨҵģ顢һһΪãͨʱģ鵱ǰúʵƵʡ
+ * Э DMA ֮ǰѯɣжϡҪǿЭ̣ YIS_CONFIG_FLASH_PAGE ɡ
+ */
+#define YIS_CMD_CLASS_SYSTEM    (0x02u)
+#define YIS_CMD_SET_BAUDRATE    (0x02u)         /*  uint32 С */
+#define YIS_CMD_SET_RATE        (0x03u)         /* Ƶ Hz uint16 С */
+#define YIS_CMD_SAVE            (0x0Fu)         /* ǰдģ flash޲ */
+
+#define YIS_PROBE_MS            (60)            /* ģ飺ÿʼʱ䣬100Hz ʱԼ 6 ֡ */
+#define YIS_CONFIRM_MS          (100)           /* ȷϣʱ䣬֡Ӧյ 80% */
+#define YIS_APPLY_MS            (20)            /* ȴģЧ */
+
+#define YIS_CONFIG_FLASH_PAGE   (0)             /* DFlash Ͷҳϻռĩβҳ */
+#define YIS_CONFIG_MAGIC        (0x59494331u)   /* "YIC1" */
+
+typedef struct
+{
+    uint32 baudrate;
+    uint32 rate_hz;
+} yis_mode_t;
 
-/* ================= ȺϷ ================= */
-#define YIS_MAX_PAYLOAD_LEN     (128u)  /*  <= data_buffer С */
-#define YIS_MIN_PAYLOAD_LEN     (1u)    /* ɰЭ0/1/2... */
+static const yis_mode_t yis_modes[] =
+{
+    {921600, 400},
+    {460800, 200},
+    {YIS_BAUDRATE_DEFAULT, 100},                /*  */
+};
+#define YIS_MODE_COUNT          (sizeof(yis_modes) / sizeof(yis_modes[0]))
+
+/* =================  DMA =================
+ * UART5 Ľ󽻸 DMA ͨ YIS_DMA_CHÿֽ DMA  RXDATA ᵽ CPU2 RAM е
+ * λĿĵַѭCPU ֽڽжϡ
+ * ASCLIN ûп߼⣬˲õδģʽÿδֽɽ
+ * ǡòһ֡ DMA жٰ֡һ֡䡣
+ * ͬÿֻ֡һжϣʧʱȰ֡ͷжϼ¶롣
+ */
+#define YIS_DMA_BUFFER_SIZE     (512)   /* 2   IFX_ALIGN  IfxDma_ChannelIncrementCircular_512 һ */
 
-/* ================= ״̬ ================= */
-typedef enum
+/* ================= ȫֱ ================= */
+/* һֻ֡ CORE_SENSOR  DMA жϷ˶õͬһ֡ȫֶ */
+static yis_imu_t yis_snapshot_slots[2];
+static snapshot_t yis_snapshot;
+static uint32 yis_stm_ticks_per_us = 100;
+static yis_mode_t yis_mode = {YIS_BAUDRATE_DEFAULT, 0};   /* õĽrate_hz Ϊ 0 ʾδҵģ */
+
+#pragma section all "cpu2_dsram"
+static IFX_ALIGN(512) uint8 yis_dma_buffer[YIS_DMA_BUFFER_SIZE];   /* DMA д CORE_SENSOR ȡ */
+static yis_parser_t yis_parser;         /* ֻ DMA ж CPU  */
+static uint32 yis_dma_written = 0;      /* DMA дֽɵ */
+static uint32 yis_dma_armed = 0;        /* ǰֽ */
+static uint32 yis_dma_interrupts = 0;
+#pragma section all restore
+
+/* ================= ֡ ================= */
+/* ÿõһ֡һΣDMA жУտɿ˶ȡֱӷ */
+static void yis_publish_frame(const yis_imu_t *sample)
 {
-    STATE_IDLE = 0,
-    STATE_HEADER1,
-    STATE_HEADER2,
-    STATE_SKIP_ID1,
-    STATE_SKIP_ID2,
-    STATE_GET_LEN,
-    STATE_DATA,
-    STATE_SKIP_CK1,
-    STATE_SKIP_CK2,
+    PROFILER_MARK(PROFILER_YIS_FRAME);
 
-    /* ֡Եʣֱֽﱾ֡ĩβٸλ */
-    STATE_DROP_FRAME
+    snapshot_publish(&yis_snapshot, sample);
+}
 
-} yis_parse_state_t;
+/* ================= DMA  ================= */
+static void yis_dma_start(uint32 count)
+{
+    if (count > YIS_DMA_BUFFER_SIZE / 2) count = YIS_DMA_BUFFER_SIZE / 2;    /* ǰܱ */
 
-/* ================= ȫֱ ================= */
-yis_imu_t yis_imu = {0};
+    yis_dma_armed = count;
+    IfxDma_setChannelTransferCount(&MODULE_DMA, (IfxDma_ChannelId)YIS_DMA_CH, count);
+    IfxDma_enableChannelTransaction(&MODULE_DMA, (IfxDma_ChannelId)YIS_DMA_CH);
+}
 
-static uint8  data_buffer[YIS_MAX_PAYLOAD_LEN];
-static uint8  frame_len = 0;       /* payload  */
-static uint8  data_index = 0;      /* payload ѽֽ */
-static yis_parse_state_t parser_state = STATE_IDLE;
+static void yis_dma_init(void)
+{
+    Ifx_ASCLIN *asclin = IfxAsclin_getAddress((IfxAsclin_Index)YIS_UART_INDEX);
+    IfxDma_Dma dma;
+    IfxDma_Dma_Config dma_config;
+    IfxDma_Dma_ChannelConfig cfg;
+    IfxDma_Dma_Channel channel;
+
+    IfxDma_Dma_initModuleConfig(&dma_config, &MODULE_DMA);
+    IfxDma_Dma_initModule(&dma, &dma_config);
+    IfxDma_Dma_initChannelConfig(&cfg, &dma);
+
+    cfg.channelId                       = (IfxDma_ChannelId)YIS_DMA_CH;
+    cfg.requestMode                     = IfxDma_ChannelRequestMode_oneTransferPerRequest;
+    cfg.operationMode                   = IfxDma_ChannelOperationMode_single;       /* ȴ */
+    cfg.moveSize                        = IfxDma_ChannelMoveSize_8bit;
+    cfg.blockMode                       = IfxDma_ChannelMove_1;
+    cfg.busPriority                     = IfxDma_ChannelBusPriority_high;
+    cfg.hardwareRequestEnabled          = FALSE;
+
+    cfg.sourceAddress                   = (uint32)&asclin->RXDATA.U;
+    cfg.sourceAddressCircularRange      = IfxDma_ChannelIncrementCircular_none;     /* Դ̶ַ */
+    cfg.sourceCircularBufferEnabled     = TRUE;
+
+    cfg.destinationAddress              = IFXCPU_GLB_ADDR_DSPR(CORE_SENSOR, yis_dma_buffer);
+    cfg.destinationAddressIncrementStep = IfxDma_ChannelIncrementStep_1;
+    cfg.destinationAddressCircularRange = IfxDma_ChannelIncrementCircular_512;
+    cfg.destinationCircularBufferEnabled = TRUE;
+
+    cfg.transferCount                   = YIS_FRAME_HEAD_SIZE;
+    cfg.channelInterruptEnabled         = TRUE;
+    cfg.channelInterruptControl         = IfxDma_ChannelInterruptControl_thresholdLimitMatch;
+    cfg.interruptRaiseThreshold         = 0;                                        /* ʱж */
+    cfg.channelInterruptPriority        = YIS_DMA_INT_PRIO;
+    cfg.channelInterruptTypeOfService   = YIS_DMA_INT_SERVICE;
+
+    IfxDma_Dma_initChannel(&channel, &cfg);
+
+    /*  FIFO  DMA Ӧȼ DMA ͨ */
+    IfxSrc_init(IfxAsclin_getSrcPointerRx(asclin), IfxSrc_Tos_dma, (Ifx_Priority)YIS_DMA_CH);
+    uart_rx_interrupt(YIS_UART_INDEX, 1);
 
-static uint8  drop_remaining = 0;  /* ֡ʱҪ̵ payload ֽڣУ飩 */
-static uint8  drop_ck_remaining = 0; /* ֡ʱҪ̵Уֽڣһ 2 */
+    yis_dma_start(YIS_FRAME_HEAD_SIZE);
+}
 
-static inline int yis_len_is_valid(uint8 len)
+/* ================= DMA ж ================= */
+/* δֽȫд뻺ҵģʽ DMA ǰд
+ * жϵʱ̼һֽڵĵʱ̣һжӳ٣ݴ˰ֽʱ䵹Ƹ֡֡ͷĵʱ */
+void yis_dma_rx_handler(void)
 {
-    if (len < YIS_MIN_PAYLOAD_LEN) return 0;
-    if (len > YIS_MAX_PAYLOAD_LEN) return 0;
-    return 1;
+    uint32 now = IfxStm_getLower(&MODULE_STM0);
+    uint32 needed;
+
+    PROFILER_BEGIN(PROFILER_YIS_PARSER);
+    IfxDma_clearChannelInterrupt(&MODULE_DMA, (IfxDma_ChannelId)YIS_DMA_CH);
+
+    yis_dma_interrupts++;
+    yis_dma_written += yis_dma_armed;
+    needed = yis_parser_process(&yis_parser, yis_dma_written, now, yis_publish_frame);
+    yis_dma_start(needed);              /* һֻ֡輸΢ ԶСһֽʱ ֽ 16 ֽӲ FIFO  */
+    PROFILER_END(PROFILER_YIS_PARSER);
 }
 
-/* ================= ֡ ================= */
-static void yis_parse_frame(void)
+/* ================= ãѯ ================= */
+/*  DMA λͽwindow_ms յĺϷ֡ */
+static uint32 yis_listen(uint32 window_ms)
 {
-    uint8 pos = 0;
+    uint32 start = IfxStm_getLower(&MODULE_STM0);
+    uint32 window = window_ms * 1000u * yis_stm_ticks_per_us;
+    uint32 written = 0;
+    uint8 data;
 
-    while (pos < frame_len)
+    yis_parser_init(&yis_parser, yis_dma_buffer, YIS_DMA_BUFFER_SIZE);
+    while ((uint32)(IfxStm_getLower(&MODULE_STM0) - start) < window)
     {
-        /* Ҫ data_id + sub_len ֽ */
-        if ((uint8)(frame_len - pos) < 2u) break;
+        while (uart_query_byte(YIS_UART_INDEX, &data))
+        {
+            yis_dma_buffer[written & (YIS_DMA_BUFFER_SIZE - 1u)] = data;
+            written++;
+        }
+        yis_parser_process(&yis_parser, written, IfxStm_getLower(&MODULE_STM0), NULL);
+    }
+    return yis_parser.frames;
+}
 
-        uint8 data_id = data_buffer[pos++];
-        uint8 sub_len = data_buffer[pos++];
+/*  mode Ƶȷϴϵ֡ */
+static uint8 yis_confirm(const yis_mode_t *mode)
+{
+    uint32 expected = mode->rate_hz * YIS_CONFIRM_MS / 1000u;
 
-        /* ӶγԽ磺ֱӽ֡ʣಿ֣ */
-        if ((uint8)(frame_len - pos) < sub_len) break;
+    return (yis_listen(YIS_CONFIRM_MS) * 10u >= expected * 8u) ? 1u : 0u;
+}
+
+/* ڸѡģ飬ҵʱͣڸòϣزʣû֡ʱ 0 */
+static uint32 yis_find_baudrate(void)
+{
+    uint32 i;
 
-        /* -------- ٶ (0x20) -------- */
-        if (data_id == 0x20 && sub_len >= 12u)
+    for (i = 0; i < YIS_MODE_COUNT; i++)
+    {
+        uart_init(YIS_UART_INDEX, yis_modes[i].baudrate, YIS_TX_PIN, YIS_RX_PIN);
+        if (yis_listen(YIS_PROBE_MS) >= 2u)
         {
-            int32 raw;
-
-            /* С int32 -> float */
-            raw = (int32)((uint32)data_buffer[pos+3] << 24 |
-                          (uint32)data_buffer[pos+2] << 16 |
-                          (uint32)data_buffer[pos+1] << 8  |
-                          (uint32)data_buffer[pos+0]);
-            yis_imu.wx = raw * 0.000001f;
-            pos += 4;
-
-            raw = (int32)((uint32)data_buffer[pos+3] << 24 |
-                          (uint32)data_buffer[pos+2] << 16 |
-                          (uint32)data_buffer[pos+1] << 8  |
-                          (uint32)data_buffer[pos+0]);
-            yis_imu.wy = raw * 0.000001f;
-            pos += 4;
-
-            raw = (int32)((uint32)data_buffer[pos+3] << 24 |
-                          (uint32)data_buffer[pos+2] << 16 |
-                          (uint32)data_buffer[pos+1] << 8  |
-                          (uint32)data_buffer[pos+0]);
-            yis_imu.wz = raw * 0.000001f;
-            pos += 4;
-
-            /*  sub_len > 12ֽ */
-            if (sub_len > 12u) pos += (uint8)(sub_len - 12u);
+            return yis_modes[i].baudrate;
         }
-        /* -------- ŷ (0x40) -------- */
-        else if (data_id == 0x40 && sub_len >= 12u)
+    }
+    return 0;
+}
+
+static void yis_send_command(uint8 cmd_id, uint32 value, uint8 length)
+{
+    uint8 param[4] = {(uint8)value, (uint8)(value >> 8), (uint8)(value >> 16), (uint8)(value >> 24)};
+    uint8 frame[4 + YIS_FRAME_OVERHEAD];
+    uint32 size = yis_build_command(frame, YIS_CMD_CLASS_SYSTEM, cmd_id, param, length);
+
+    uart_write_buffer(YIS_UART_INDEX, frame, size);
+    system_delay_ms(YIS_APPLY_MS);      /* ʱ䣬֮лز */
+}
+
+/* Э̳ɹʱͣ mode Ĳ */
+static uint8 yis_negotiate(yis_mode_t *mode)
+{
+    uint32 current = yis_find_baudrate();
+    uint32 i;
+
+    if (current == 0u)
+    {
+        return 0;
+    }
+
+    for (i = 0; i < YIS_MODE_COUNT; i++)
+    {
+        yis_send_command(YIS_CMD_SET_BAUDRATE, yis_modes[i].baudrate, 4u);
+        uart_init(YIS_UART_INDEX, yis_modes[i].baudrate, YIS_TX_PIN, YIS_RX_PIN);
+        yis_send_command(YIS_CMD_SET_RATE, yis_modes[i].rate_hz, 2u);
+        if (yis_confirm(&yis_modes[i]))
         {
-            int32 raw;
-
-            raw = (int32)((uint32)data_buffer[pos+3] << 24 |
-                          (uint32)data_buffer[pos+2] << 16 |
-                          (uint32)data_buffer[pos+1] << 8  |
-                          (uint32)data_buffer[pos+0]);
-            yis_imu.pitch = raw * 0.000001f;
-            pos += 4;
-
-            raw = (int32)((uint32)data_buffer[pos+3] << 24 |
-                          (uint32)data_buffer[pos+2] << 16 |
-                          (uint32)data_buffer[pos+1] << 8  |
-                          (uint32)data_buffer[pos+0]);
-            yis_imu.roll = raw * 0.000001f;
-            pos += 4;
-
-            raw = (int32)((uint32)data_buffer[pos+3] << 24 |
-                          (uint32)data_buffer[pos+2] << 16 |
-                          (uint32)data_buffer[pos+1] << 8  |
-                          (uint32)data_buffer[pos+0]);
-            yis_imu.yaw = raw * 0.000001f;
-            pos += 4;
-
-            if (sub_len > 12u) pos += (uint8)(sub_len - 12u);
+            yis_send_command(YIS_CMD_SAVE, 0, 0u);
+            *mode = yis_modes[i];
+            return 1;
         }
-        else
+
+        current = yis_find_baudrate();  /* ģѻʣҲû */
+        if (current == 0u)
         {
-            /* ֱֶ */
-            pos += sub_len;
+            return 0;
         }
     }
+
+    /* ͨģ鵱ǰ */
+    mode->baudrate = current;
+    mode->rate_hz = yis_listen(YIS_CONFIRM_MS) * 1000u / YIS_CONFIRM_MS;
+    return 1;
 }
 
-/* ================= ֽڽ״̬ ================= */
-static void yis_parse_byte(uint8 data)
+/* DFlash ¼magicʡƵʡУ */
+static uint8 yis_config_load(yis_mode_t *mode)
 {
-    switch (parser_state)
+    uint32 record[4];
+
+    flash_read_page(0, YIS_CONFIG_FLASH_PAGE, record, 4);
+    if (record[0] != YIS_CONFIG_MAGIC || record[3] != ~(record[0] ^ record[1] ^ record[2]) || record[2] == 0u)
     {
-        case STATE_IDLE:
-            if (data == YIS_HEADER_1) parser_state = STATE_HEADER1;
-            break;
-
-        case STATE_HEADER1:
-            parser_state = (data == YIS_HEADER_2) ? STATE_HEADER2 : STATE_IDLE;
-            break;
-
-        case STATE_HEADER2:
-            parser_state = STATE_SKIP_ID1;
-            break;
-
-        case STATE_SKIP_ID1:
-            parser_state = STATE_SKIP_ID2;
-            break;
-
-        case STATE_SKIP_ID2:
-            /* ﰴԭ߼ֽھ LEN */
-            frame_len  = data;
-            data_index = 0;
-
-            /* ===== ȺϷԼ ===== */
-            if (!yis_len_is_valid(frame_len))
-            {
-                /* ̵֡ payload(frame_len) + CK1 + CK2 */
-                drop_remaining    = frame_len; /* Ϊ 0 򳬴󣬵 uint8 ضϣ˴Э len  1B */
-                drop_ck_remaining = 2u;
-                parser_state      = STATE_DROP_FRAME;
-                break;
-            }
-
-            parser_state = (frame_len > 0u) ? STATE_DATA : STATE_SKIP_CK1;
-            break;
-
-        case STATE_DATA:
-            /* frame_len ѱ֤ <= buffer */
-            data_buffer[data_index++] = data;
-
-            if (data_index >= frame_len)
-                parser_state = STATE_SKIP_CK1;
-            break;
-
-        case STATE_SKIP_CK1:
-            parser_state = STATE_SKIP_CK2;
-            break;
-
-        case STATE_SKIP_CK2:
-            /* һ֡ payload */
-            yis_parse_frame();
-            parser_state = STATE_IDLE;
-            break;
-
-        case STATE_DROP_FRAME:
-            /* ̵ʣ payload ֽ */
-            if (drop_remaining > 0u)
-            {
-                drop_remaining--;
-            }
-            else if (drop_ck_remaining > 0u)
-            {
-                /* payload ٳУֽڣCK1/CK2 */
-                drop_ck_remaining--;
-            }
-            else
-            {
-                /* ֡λ */
-                parser_state = STATE_IDLE;
-            }
-            break;
-
-        default:
-            parser_state = STATE_IDLE;
-            break;
+        return 0;
     }
+    mode->baudrate = record[1];
+    mode->rate_hz = record[2];
+    return 1;
 }
 
-/* ================= UART жϻص ================= */
-void yis_uart_rx_handler(void)
+static void yis_config_save(const yis_mode_t *mode)
 {
-    uint8 data;
-    while (uart_query_byte(YIS_UART_INDEX, &data))
+    uint32 record[4] = {YIS_CONFIG_MAGIC, mode->baudrate, mode->rate_hz, 0};
+
+    record[3] = ~(record[0] ^ record[1] ^ record[2]);
+    flash_write_page(0, YIS_CONFIG_FLASH_PAGE, record, 4);
+}
+
+/* ʱͣ yis_mode Ĳ */
+static void yis_configure(void)
+{
+    yis_mode_t mode;
+
+    if (yis_config_load(&mode))
     {
-        yis_parse_byte(data);
+        uart_init(YIS_UART_INDEX, mode.baudrate, YIS_TX_PIN, YIS_RX_PIN);
+        if (yis_confirm(&mode))
+        {
+            yis_mode = mode;
+            return;
+        }
+    }
+
+    if (yis_negotiate(&mode))
+    {
+        if (mode.rate_hz != 0u)
+        {
+            yis_config_save(&mode);
+        }
+        yis_mode = mode;
+    }
+    else
+    {
+        /* δģ飺ýգ棬´ϵЭ */
+        yis_mode.baudrate = YIS_BAUDRATE_DEFAULT;
+        yis_mode.rate_hz = 0;
+        uart_init(YIS_UART_INDEX, YIS_BAUDRATE_DEFAULT, YIS_TX_PIN, YIS_RX_PIN);
     }
 }
 
-/* ================= ʼ ================= */
-void yis_init(void)
+/* =================  ================= */
+uint8 yis_get_sample(yis_imu_t *sample)
 {
-    uart_init(YIS_UART_INDEX, YIS_BAUDRATE, YIS_TX_PIN, YIS_RX_PIN);
-    uart_rx_interrupt(YIS_UART_INDEX, 1);
+    return snapshot_read(&yis_snapshot, sample);
+}
 
-    parser_state = STATE_IDLE;
-    frame_len = 0;
-    data_index = 0;
-    drop_remaining = 0;
-    drop_ck_remaining = 0;
+/* ƿɾݴ˲ӳٻܾ */
+uint32 yis_get_sample_age_us(const yis_imu_t *sample)
+{
+    return (IfxStm_getLower(&MODULE_STM0) - sample->timestamp) / yis_stm_ticks_per_us;
 }
 
+/* ================= ͳ ================= */
+void yis_report(void)
+{
+    yis_imu_t sample;
+    uint32 age_us = yis_get_sample(&sample) ? yis_get_sample_age_us(&sample) : 0xFFFFFFFFu;
+
+    printf("yis %lu baud %lu Hz\r\n", (unsigned long)yis_mode.baudrate, (unsigned long)yis_mode.rate_hz);
+    printf("yis frames %lu  dropped %lu  bad ck %lu  bad len %lu  tid resets %lu\r\n",
+           (unsigned long)yis_parser.frames, (unsigned long)yis_parser.dropped,
+           (unsigned long)yis_parser.bad_checksum, (unsigned long)yis_parser.bad_length,
+           (unsigned long)yis_parser.sequence_resets);
+    printf("yis dma irq %lu  skipped %lu  frame %lu B  age %lu us\r\n",
+           (unsigned long)yis_dma_interrupts, (unsigned long)yis_parser.skipped_bytes,
+           (unsigned long)yis_parser.frame_size, (unsigned long)age_us);
+}
 
+/* ================= ʼ ================= */
+void yis_init(void)
+{
+    yis_stm_ticks_per_us = (uint32)(IfxStm_getFrequency(&MODULE_STM0) / 1000000.0f);
+    snapshot_init(&yis_snapshot, yis_snapshot_slots, sizeof(yis_imu_t));
+    yis_configure();                    /* ڰЭ̽ */
+
+    yis_parser_init(&yis_parser, yis_dma_buffer, YIS_DMA_BUFFER_SIZE);
+    yis_parser_set_byte_time(&yis_parser, (uint32)(IfxStm_getFrequency(&MODULE_STM0) * 10.0f / yis_mode.baudrate)); /* 1 ʼ + 8  + 1 ֹͣ */
+    yis_dma_written = 0;
+    yis_dma_interrupts = 0;
+    yis_dma_init();
+}
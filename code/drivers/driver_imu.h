@@ -15,13 +15,42 @@ typedef struct
     float wy;      // Yٶ (deg/s)
     float wz;      // Zٶ (deg/s)
 
+    float ax;      // Xٶ (m/s^2)
+    float ay;      // Yٶ (m/s^2)
+    float az;      // Zٶ (m/s^2)
+
+    float q0;      // Ԫ (ǰ)
+    float q1;
+    float q2;
+    float q3;
+
+    float mx;      // Xųԭʼֵ (mGauss)
+    float my;      // Yųԭʼֵ (mGauss)
+    float mz;      // Zųԭʼֵ (mGauss)
+
+    float temperature;    // ģ¶ (C)
+    uint32 sample_time_us; // ģʱ (usģʱ)
+
+    uint32 timestamp; // ֡ͷֽڵʱ (STM0 ˿ɱ)
+    uint16 tid;       // ģ֡ (TID)
+    uint16 fields;    // ֡Я YIS_FIELD_xxxδЯֶαһֵ֡
+
 } yis_imu_t;
 
-/* ================= ȫ IMU  ================= */
-extern yis_imu_t yis_imu;
+/* ================= yis_imu_t.fields ================= */
+#define YIS_FIELD_TEMPERATURE   (0x0001u)   // ID 0x01
+#define YIS_FIELD_ACC           (0x0002u)   // ID 0x10
+#define YIS_FIELD_GYRO          (0x0004u)   // ID 0x20
+#define YIS_FIELD_MAG           (0x0008u)   // ID 0x31
+#define YIS_FIELD_EULER         (0x0010u)   // ID 0x40
+#define YIS_FIELD_QUATERNION    (0x0020u)   // ID 0x41
+#define YIS_FIELD_SAMPLE_TIME   (0x0040u)   // ID 0x51
 
 /* ================= ӿں ================= */
 void yis_init(void);          // ʼ IMUUART + жϣ
-void yis_uart_rx_handler(void); // UART жϻص
+void yis_dma_rx_handler(void);  // UART5  DMA жϻصÿ֡һΣ
+void yis_report(void);          // Դڴӡͳ
+uint8  yis_get_sample(yis_imu_t *sample);              // ȡһ֡ˡжϾɵãδյκ֡ʱ 0
+uint32 yis_get_sample_age_us(const yis_imu_t *sample); // ֡֡ͷʱ (us)
 
 #endif
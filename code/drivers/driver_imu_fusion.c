@@ -0,0 +1,179 @@
+#include "driver_imu_fusion.h"
+#include "driver_imu_spi.h"
+#include "imu_fusion.h"
+#include "multicore.h"
+#include "snapshot.h"
+#include "IfxStm.h"
+
+/* ================= Ӳ ================= */
+#define IMU_PIT                 (CCU61_CH0)     /* жϷ CPU2 isr_config.h */
+#define IMU_PIT_PERIOD_US       (1000)
+#define IMU_SPI_PERIOD_US       (1000000 / IMU_SPI_ODR_HZ)
+#define IMU_GRAVITY             (9.80665f)
+
+/* IMU660RA  -> YIS ᣺Ԫ i Ϊ YIS  i ȡ IMU660RA  (1..3)ʾ򣻰װд */
+static const int8 imu_axis_map[3] = {1, 2, 3};
+
+/* ================= ȫֱ ================= */
+/* ںֻ CORE_CONTROL 䴦 */
+static yis_imu_t imu_snapshot_slots[2];
+static snapshot_t imu_snapshot;
+static uint32 imu_stm_ticks_per_us = 100;
+
+#pragma section all "cpu2_dsram"
+static imu_fusion_t imu_fusion;         /* ֻ CORE_SENSOR ĲжϷ */
+static uint8  imu_spi_present = 0;      /* IMU660RA ʼɹ */
+static uint8  imu_yis_seen = 0;
+static uint32 imu_yis_timestamp = 0;    /* ںϵһ֡ YIS */
+static uint32 imu_published = 0;
+#pragma section all restore
+
+static callback_function frame_callback = NULL;
+
+/* ================= ں ================= */
+/*  CORE_CONTROL ִУպûص */
+static void imu_sample_handler(const void *data, uint32 length)
+{
+    if (length != sizeof(yis_imu_t)) return;
+
+    snapshot_publish(&imu_snapshot, data);
+    if (frame_callback != NULL) frame_callback();
+}
+
+static void imu_publish(const yis_imu_t *sample)
+{
+    imu_published++;
+    if (IfxCpu_getCoreId() == CORE_CONTROL)
+    {
+        imu_sample_handler(sample, sizeof(yis_imu_t));
+    }
+    else
+    {
+        multicore_post(CORE_CONTROL, MULTICORE_MSG_IMU_SAMPLE, sample, sizeof(yis_imu_t));
+    }
+}
+
+/* ================= IMU660RA  ================= */
+static uint8 imu_spi_raw_saturated(int16 x, int16 y, int16 z)
+{
+    return (x == 32767 || x == -32768 || y == 32767 || y == -32768 || z == 32767 || z == -32768);
+}
+
+static void imu_spi_map(const int16 *in, float *out, float scale)
+{
+    uint8 i;
+    int8 axis;
+
+    for (i = 0; i < 3; i++)
+    {
+        axis = imu_axis_map[i];
+        out[i] = (axis > 0) ? (float)in[axis - 1] * scale : -(float)in[-axis - 1] * scale;
+    }
+}
+
+/* ȡ FIFO ȫںϣǷ */
+static uint8 imu_spi_drain(void)
+{
+    imu_fifo_sample_t samples[IMU_SPI_BATCH_MAX];
+    float gyro[3], acc[3];
+    uint32 n, i;
+    uint8 drained = 0, saturated;
+
+    do
+    {
+        n = imu_spi_read(samples, IMU_SPI_BATCH_MAX);
+        for (i = 0; i < n; i++)
+        {
+            imu_spi_map(samples[i].gyro, gyro, 1.0f / imu660ra_transition_factor[1]);
+            imu_spi_map(samples[i].acc, acc, IMU_GRAVITY / imu660ra_transition_factor[0]);
+            saturated = imu_spi_raw_saturated(samples[i].gyro[0], samples[i].gyro[1], samples[i].gyro[2])
+                     || imu_spi_raw_saturated(samples[i].acc[0], samples[i].acc[1], samples[i].acc[2]);
+            imu_fusion_push_spi(&imu_fusion, gyro, acc, samples[i].timestamp, saturated);
+        }
+        drained |= (n != 0);
+    } while (n == IMU_SPI_BATCH_MAX);
+
+    return drained;
+}
+
+/* 1kHzȡ FIFO ¶ IMU660RA ÿ 5msµ YIS ֡ʱں
+ * ֻ YIS ʱÿһ֡ȴ IMU660RA Ρ */
+void imu_pit_handler(void)
+{
+    yis_imu_t yis, fused;
+    uint32 now = IfxStm_getLower(&MODULE_STM0);
+    uint8 yis_new = 0, spi_new = 0;
+
+    if (imu_spi_present)
+    {
+        spi_new = imu_spi_drain();
+    }
+
+    if (yis_get_sample(&yis) && (!imu_yis_seen || yis.timestamp != imu_yis_timestamp))
+    {
+        imu_yis_seen = 1;
+        imu_yis_timestamp = yis.timestamp;
+        imu_fusion_push_yis(&imu_fusion, &yis);
+        yis_new = 1;
+    }
+
+    if (spi_new || (yis_new && imu_fusion.share >= 1.0f))
+    {
+        if (imu_fusion_output(&imu_fusion, now, &fused))
+        {
+            imu_publish(&fused);
+        }
+    }
+}
+
+/* ================= ص ================= */
+void imu_set_frame_callback(callback_function callback)
+{
+    frame_callback = callback;
+}
+
+/* =================  ================= */
+uint8 imu_get_sample(yis_imu_t *sample)
+{
+    return snapshot_read(&imu_snapshot, sample);
+}
+
+uint32 imu_get_sample_age_us(const yis_imu_t *sample)
+{
+    return (IfxStm_getLower(&MODULE_STM0) - sample->timestamp) / imu_stm_ticks_per_us;
+}
+
+/* ================= ں״̬ ================= */
+void imu_report(void)
+{
+    imu_fusion_status_t status;
+    yis_imu_t sample;
+    uint32 age_us = imu_get_sample(&sample) ? imu_get_sample_age_us(&sample) : 0xFFFFFFFFu;
+
+    imu_fusion_get_status(&imu_fusion, &status);   /* ˶ȡ۲ */
+    printf("imu spi %s  yis share %d%%  switches %lu  published %lu  age %lu us\r\n",
+           imu_spi_present ? "ok" : "absent", (int)(status.yis_share * 100.0f),
+           (unsigned long)status.switches, (unsigned long)imu_published, (unsigned long)age_us);
+    printf("imu faults yis 0x%02x spi 0x%02x  lag %lu us  residual gyro %d.%02d acc %d.%02d\r\n",
+           status.yis_faults, status.spi_faults, (unsigned long)status.lag_us,
+           (int)status.gyro_residual, (int)(status.gyro_residual * 100.0f) % 100,
+           (int)status.acc_residual, (int)(status.acc_residual * 100.0f) % 100);
+    if (imu_spi_present)
+    {
+        imu_spi_report();
+    }
+}
+
+/* ================= ʼ ================= */
+void imu_init(void)
+{
+    multicore_set_handler(MULTICORE_MSG_IMU_SAMPLE, imu_sample_handler);
+    imu_stm_ticks_per_us = (uint32)(IfxStm_getFrequency(&MODULE_STM0) / 1000000.0f);
+    snapshot_init(&imu_snapshot, imu_snapshot_slots, sizeof(yis_imu_t));
+    imu_fusion_init(&imu_fusion, imu_stm_ticks_per_us, IMU_SPI_PERIOD_US);
+
+    imu_spi_present = (imu_spi_init() == 0);    /* ʧʱֻ YIS */
+    imu_yis_seen = 0;
+    imu_published = 0;
+    pit_us_init(IMU_PIT, IMU_PIT_PERIOD_US);
+}
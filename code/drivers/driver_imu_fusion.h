@@ -0,0 +1,21 @@
+/* driver_imu_fusion.h */
+#ifndef _DRIVER_IMU_FUSION_H_
+#define _DRIVER_IMU_FUSION_H_
+
+#include "zf_common_headfile.h"
+#include "driver_imu.h"
+
+/* =================  IMU ================= */
+/* YIS ģ飨UART+  IMU660RASPI CORE_SENSOR ںϣ㷨 imu_fusion.h
+ * ·ʱĬֻ YISIMU660RA ȱһ·ʧЧʱƽлһ·
+ * ʽͬ yis_imu_ttimestamp Ϊʱ̣ѿ۳ YIS ӳ٣ */
+
+/* ================= ӿں ================= */
+void   imu_init(void);              // ʼ IMU660RA FIFO ȡںϣ yis_init ֮ã
+void   imu_pit_handler(void);       // ں PIT жϻصCCU61_CH0CORE_SENSOR1kHz
+void   imu_report(void);            // Դڴӡں״̬
+void   imu_set_frame_callback(callback_function callback); // ÿһںã CORE_CONTROL ĺ˼жִУᱻ 5ms жռС
+uint8  imu_get_sample(yis_imu_t *sample);              // ȡںˡжϾɵãʱ 0
+uint32 imu_get_sample_age_us(const yis_imu_t *sample); // Ӳʱ (us)
+
+#endif
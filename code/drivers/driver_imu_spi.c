@@ -0,0 +1,301 @@
+#include "driver_imu_spi.h"
+#include "multicore.h"
+#include "isr_config.h"
+#include "IfxDma_Dma.h"
+#include "IfxQspi.h"
+#include "IfxStm.h"
+
+/* ================= Ӳ ================= */
+#define IMU_SPI_INT_PIN         (ERU_CH0_REQ0_P15_4)    /* IMU660RA INT1 */
+#define IMU_SPI_INT_GPIO        (P15_4)
+
+/* ================= IMU660RA (BMI270) FIFO ؼĴ ================= */
+#define IMU_REG_FIFO_LENGTH_0   (0x24)
+#define IMU_REG_FIFO_DATA       (0x26)
+#define IMU_REG_FIFO_DOWNS      (0x45)
+#define IMU_REG_FIFO_WTM_0      (0x46)
+#define IMU_REG_FIFO_WTM_1      (0x47)
+#define IMU_REG_FIFO_CONFIG_0   (0x48)
+#define IMU_REG_FIFO_CONFIG_1   (0x49)
+#define IMU_REG_INT1_IO_CTRL    (0x53)
+#define IMU_REG_INT_LATCH       (0x55)
+#define IMU_REG_INT_MAP_DATA    (0x58)
+#define IMU_REG_CMD             (0x7E)
+
+#define IMU_CONF_1600HZ         (0xAC)          /* ACC_CONF / GYR_CONFģʽ ˲ 1600Hz */
+#define IMU_FIFO_DOWNS_FILTERED (0x88)          /* ˲  */
+#define IMU_FIFO_STREAM         (0x00)          /* 󸲸֡Ӵʱ */
+#define IMU_FIFO_GYR_ACC        (0xC0)          /*  + ٶȼƣ֡ͷ */
+#define IMU_INT1_PUSH_PULL_HIGH (0x0A)          /* ʹ  ߵƽЧ */
+#define IMU_INT_NOT_LATCHED     (0x00)
+#define IMU_INT_MAP_FWM_INT1    (0x02)          /* FIFO ˮλ -> INT1 */
+#define IMU_CMD_FIFO_FLUSH      (0xB0)
+
+#define IMU_SPI_LENGTH_BYTES    (1u + IMU_FIFO_DUMMY_BYTES + 2u)                                  /* ַ ֽ FIFO_LENGTH_0/1 */
+#define IMU_SPI_BURST_BYTES     (1u + IMU_FIFO_DUMMY_BYTES + IMU_SPI_BATCH_MAX * IMU_FIFO_FRAME_BYTES)
+#define IMU_SPI_RING            (128u)          /* 2  */
+
+typedef enum
+{
+    IMU_SPI_IDLE = 0,
+    IMU_SPI_LENGTH,                             /* ڶ FIFO_LENGTH */
+    IMU_SPI_BURST,                              /* ͻ FIFO_DATA */
+} imu_spi_stage_enum;
+
+/* ================= ȫֱ ================= */
+#pragma section all "cpu2_dsram"
+static uint8 imu_spi_tx[IMU_SPI_BURST_BYTES];   /* ֽΪĴַ ෢ 0 */
+static uint8 imu_spi_rx[IMU_SPI_BURST_BYTES];   /* DMA д CORE_SENSOR ȡ */
+static imu_fifo_t imu_spi_fifo;
+static imu_fifo_sample_t imu_spi_batch[IMU_SPI_BATCH_MAX];
+static imu_fifo_sample_t imu_spi_ring[IMU_SPI_RING];
+static volatile uint32 imu_spi_ring_write = 0;  /* DMA жд */
+static volatile uint32 imu_spi_ring_read = 0;   /* imu_spi_read()  */
+static volatile imu_spi_stage_enum imu_spi_stage = IMU_SPI_IDLE;
+static volatile uint8 imu_spi_pending = 0;      /* ȡڼˮλж */
+static uint32 imu_spi_read_time = 0;            /* ζȡˮλжʱ̣STM0 */
+static uint32 imu_spi_waiting = 0;              /* FIFO_LENGTH ֡ */
+static uint32 imu_spi_count = 0;                /* ͻֽ */
+static uint32 imu_spi_bacon = 0;
+static uint32 imu_spi_interrupts = 0;
+static uint32 imu_spi_restarts = 0;             /* ƽԸ ٶ */
+static uint32 imu_spi_overruns = 0;             /* ֡ */
+#pragma section all restore
+
+/* ================= Ĵдʼã ================= */
+static void imu_spi_write_register(uint8 reg, uint8 data)
+{
+    IMU660RA_CS(0);
+    spi_write_8bit_register(IMU660RA_SPI, reg | IMU660RA_SPI_W, data);
+    IMU660RA_CS(1);
+    system_delay_us(2);                         /* ģʽд֮ 2us */
+}
+
+/* ================= DMA ͻ ================= */
+/* ͨ imu_spi_tx ֽ QSPI  FIFOͨյֽڰ imu_spi_rx
+ * ߶ QSPI  FIFO ͨ count ֽڲж */
+static void imu_spi_transfer(uint8 reg, uint32 count)
+{
+    Ifx_QSPI *qspi = IfxQspi_getAddress((IfxQspi_Index)IMU660RA_SPI);
+
+    imu_spi_tx[0] = reg | IMU660RA_SPI_R;
+    imu_spi_count = count;
+
+    IfxDma_setChannelSourceAddress(&MODULE_DMA, (IfxDma_ChannelId)IMU_SPI_TX_DMA_CH, (void *)IFXCPU_GLB_ADDR_DSPR(CORE_SENSOR, imu_spi_tx));
+    IfxDma_setChannelDestinationAddress(&MODULE_DMA, (IfxDma_ChannelId)IMU_SPI_RX_DMA_CH, (void *)IFXCPU_GLB_ADDR_DSPR(CORE_SENSOR, imu_spi_rx));
+    IfxDma_setChannelTransferCount(&MODULE_DMA, (IfxDma_ChannelId)IMU_SPI_TX_DMA_CH, count);
+    IfxDma_setChannelTransferCount(&MODULE_DMA, (IfxDma_ChannelId)IMU_SPI_RX_DMA_CH, count);
+
+    IMU660RA_CS(0);
+    IfxQspi_writeBasicConfigurationEndStream(qspi, imu_spi_bacon);    /* Ƭѡ GPIO  ÿֽһ֡ */
+    IfxDma_enableChannelTransaction(&MODULE_DMA, (IfxDma_ChannelId)IMU_SPI_RX_DMA_CH);
+    IfxDma_enableChannelTransaction(&MODULE_DMA, (IfxDma_ChannelId)IMU_SPI_TX_DMA_CH);
+}
+
+/* ѹж */
+static void imu_spi_start(uint32 read_time)
+{
+    imu_spi_read_time = read_time;
+    imu_spi_stage = IMU_SPI_LENGTH;
+    imu_spi_transfer(IMU_REG_FIFO_LENGTH_0, IMU_SPI_LENGTH_BYTES);
+}
+
+static void imu_spi_dma_init(void)
+{
+    Ifx_QSPI *qspi = IfxQspi_getAddress((IfxQspi_Index)IMU660RA_SPI);
+    IfxDma_Dma dma;
+    IfxDma_Dma_Config dma_config;
+    IfxDma_Dma_ChannelConfig cfg;
+    IfxDma_Dma_Channel channel;
+
+    IfxDma_Dma_initModuleConfig(&dma_config, &MODULE_DMA);
+    IfxDma_Dma_initModule(&dma, &dma_config);
+
+    /* ͣimu_spi_tx -> DATAENTRY0 */
+    IfxDma_Dma_initChannelConfig(&cfg, &dma);
+    cfg.channelId                       = (IfxDma_ChannelId)IMU_SPI_TX_DMA_CH;
+    cfg.requestMode                     = IfxDma_ChannelRequestMode_oneTransferPerRequest;
+    cfg.operationMode                   = IfxDma_ChannelOperationMode_single;
+    cfg.moveSize                        = IfxDma_ChannelMoveSize_8bit;
+    cfg.blockMode                       = IfxDma_ChannelMove_1;
+    cfg.busPriority                     = IfxDma_ChannelBusPriority_high;
+    cfg.hardwareRequestEnabled          = FALSE;
+    cfg.sourceAddress                   = IFXCPU_GLB_ADDR_DSPR(CORE_SENSOR, imu_spi_tx);
+    cfg.sourceAddressIncrementStep      = IfxDma_ChannelIncrementStep_1;
+    cfg.destinationAddress              = (uint32)&qspi->DATAENTRY[0].U;
+    cfg.destinationAddressCircularRange = IfxDma_ChannelIncrementCircular_none;     /* Ŀĵ̶ַ */
+    cfg.destinationCircularBufferEnabled = TRUE;
+    cfg.transferCount                   = IMU_SPI_LENGTH_BYTES;
+    cfg.channelInterruptEnabled         = FALSE;
+    IfxDma_Dma_initChannel(&channel, &cfg);
+
+    /* գRXEXIT -> imu_spi_rxж */
+    IfxDma_Dma_initChannelConfig(&cfg, &dma);
+    cfg.channelId                       = (IfxDma_ChannelId)IMU_SPI_RX_DMA_CH;
+    cfg.requestMode                     = IfxDma_ChannelRequestMode_oneTransferPerRequest;
+    cfg.operationMode                   = IfxDma_ChannelOperationMode_single;
+    cfg.moveSize                        = IfxDma_ChannelMoveSize_8bit;
+    cfg.blockMode                       = IfxDma_ChannelMove_1;
+    cfg.busPriority                     = IfxDma_ChannelBusPriority_high;
+    cfg.hardwareRequestEnabled          = FALSE;
+    cfg.sourceAddress                   = (uint32)&qspi->RXEXIT.U;
+    cfg.sourceAddressCircularRange      = IfxDma_ChannelIncrementCircular_none;     /* Դ̶ַ */
+    cfg.sourceCircularBufferEnabled     = TRUE;
+    cfg.destinationAddress              = IFXCPU_GLB_ADDR_DSPR(CORE_SENSOR, imu_spi_rx);
+    cfg.destinationAddressIncrementStep = IfxDma_ChannelIncrementStep_1;
+    cfg.transferCount                   = IMU_SPI_LENGTH_BYTES;
+    cfg.channelInterruptEnabled         = TRUE;
+    cfg.channelInterruptControl         = IfxDma_ChannelInterruptControl_thresholdLimitMatch;
+    cfg.interruptRaiseThreshold         = 0;                                        /* ʱж */
+    cfg.channelInterruptPriority        = IMU_SPI_DMA_INT_PRIO;
+    cfg.channelInterruptTypeOfService   = IMU_SPI_DMA_INT_SERVICE;
+    IfxDma_Dma_initChannel(&channel, &cfg);
+
+    /* QSPI շ FIFO 󣬸 DMA Ӧȼ DMA ͨ */
+    IfxQspi_setTxFifoMode(qspi, IfxQspi_FifoMode_singleMove);
+    IfxQspi_setRxFifoMode(qspi, IfxQspi_FifoMode_singleMove);
+    IfxQspi_setReceiveFifoInterrruptThreshold(qspi, IfxQspi_RxFifoInt_0);
+    IfxSrc_init(IfxQspi_getTransmitSrc(qspi), IfxSrc_Tos_dma, (Ifx_Priority)IMU_SPI_TX_DMA_CH);
+    IfxSrc_init(IfxQspi_getReceiveSrc(qspi), IfxSrc_Tos_dma, (Ifx_Priority)IMU_SPI_RX_DMA_CH);
+    IfxSrc_enable(IfxQspi_getTransmitSrc(qspi));
+    IfxSrc_enable(IfxQspi_getReceiveSrc(qspi));
+    qspi->GLOBALCON1.B.TXEN = 1;
+    qspi->GLOBALCON1.B.RXEN = 1;
+}
+
+/* ================= ˮλж ================= */
+void imu_spi_exti_handler(void)
+{
+    uint32 now = IfxStm_getLower(&MODULE_STM0);
+    uint32 interrupt_state = interrupt_global_disable();
+
+    imu_spi_interrupts++;
+    if (imu_spi_stage == IMU_SPI_IDLE)
+    {
+        imu_spi_start(now);
+    }
+    else
+    {
+        imu_spi_pending = 1;                    /* ζٶ */
+    }
+    interrupt_global_enable(interrupt_state);
+}
+
+/* ================= DMA ж ================= */
+static void imu_spi_queue(const imu_fifo_sample_t *samples, uint32 count)
+{
+    uint32 write = imu_spi_ring_write;
+    uint32 i;
+
+    for (i = 0; i < count; i++)
+    {
+        if (write - imu_spi_ring_read >= IMU_SPI_RING)
+        {
+            imu_spi_overruns += count - i;      /* ߸ µ */
+            break;
+        }
+        imu_spi_ring[write & (IMU_SPI_RING - 1u)] = samples[i];
+        write++;
+    }
+    imu_spi_ring_write = write;
+}
+
+void imu_spi_dma_handler(void)
+{
+    uint32 interrupt_state, take, n;
+    uint8 again;
+
+    IfxDma_clearChannelInterrupt(&MODULE_DMA, (IfxDma_ChannelId)IMU_SPI_RX_DMA_CH);
+    IMU660RA_CS(1);
+
+    if (imu_spi_stage == IMU_SPI_LENGTH)
+    {
+        imu_spi_waiting = imu_fifo_frames(imu_spi_rx[2], imu_spi_rx[3]);
+        if (imu_spi_waiting != 0u)
+        {
+            take = (imu_spi_waiting < IMU_SPI_BATCH_MAX) ? imu_spi_waiting : IMU_SPI_BATCH_MAX;
+            imu_spi_stage = IMU_SPI_BURST;
+            imu_spi_transfer(IMU_REG_FIFO_DATA, 1u + IMU_FIFO_DUMMY_BYTES + take * IMU_FIFO_FRAME_BYTES);
+            return;
+        }
+    }
+    else if (imu_spi_stage == IMU_SPI_BURST)
+    {
+        n = imu_fifo_decode(&imu_spi_fifo, &imu_spi_rx[1], imu_spi_count - 1u, imu_spi_read_time, imu_spi_waiting,
+                            imu_spi_batch, IMU_SPI_BATCH_MAX);
+        imu_spi_queue(imu_spi_batch, n);
+    }
+
+    /* ꣺ڼˮλжϣ FIFO ˮλϣINT1 Ϊߵƽʱٶ */
+    interrupt_state = interrupt_global_disable();
+    again = imu_spi_pending || gpio_get_level(IMU_SPI_INT_GPIO);
+    imu_spi_pending = 0;
+    imu_spi_stage = IMU_SPI_IDLE;
+    if (again)
+    {
+        imu_spi_restarts++;
+        imu_spi_start(IfxStm_getLower(&MODULE_STM0));
+    }
+    interrupt_global_enable(interrupt_state);
+}
+
+/* ================= ȡ ================= */
+uint32 imu_spi_read(imu_fifo_sample_t *samples, uint32 max)
+{
+    uint32 read = imu_spi_ring_read;
+    uint32 n = 0;
+
+    while (read != imu_spi_ring_write && n < max)
+    {
+        samples[n++] = imu_spi_ring[read & (IMU_SPI_RING - 1u)];
+        read++;
+    }
+    imu_spi_ring_read = read;
+    return n;
+}
+
+/* ================= ȡͳ ================= */
+void imu_spi_report(void)
+{
+    printf("imu660ra fifo frames %lu  batches %lu  irq %lu  restarts %lu\r\n",
+           (unsigned long)imu_spi_fifo.frames, (unsigned long)imu_spi_fifo.batches,
+           (unsigned long)imu_spi_interrupts, (unsigned long)imu_spi_restarts);
+    printf("imu660ra empty reads %lu  resyncs %lu  overruns %lu  period %lu ns\r\n",
+           (unsigned long)imu_spi_fifo.invalid, (unsigned long)imu_spi_fifo.resyncs,
+           (unsigned long)imu_spi_overruns, (unsigned long)(imu_spi_fifo.period * 10.0f));
+}
+
+/* ================= ʼ ================= */
+uint8 imu_spi_init(void)
+{
+    Ifx_QSPI *qspi = IfxQspi_getAddress((IfxQspi_Index)IMU660RA_SPI);
+    uint32 ticks_per_us = (uint32)(IfxStm_getFrequency(&MODULE_STM0) / 1000000.0f);
+
+    if (imu660ra_init())                        /* ʼļ̡ϵ */
+    {
+        return 1;
+    }
+
+    imu_spi_write_register(IMU660RA_ACC_CONF, IMU_CONF_1600HZ);
+    imu_spi_write_register(IMU660RA_GYR_CONF, IMU_CONF_1600HZ);
+    imu_spi_write_register(IMU_REG_FIFO_DOWNS, IMU_FIFO_DOWNS_FILTERED);
+    imu_spi_write_register(IMU_REG_FIFO_WTM_0, (uint8)((IMU_SPI_WATERMARK * IMU_FIFO_FRAME_BYTES) & 0xFF));
+    imu_spi_write_register(IMU_REG_FIFO_WTM_1, (uint8)((IMU_SPI_WATERMARK * IMU_FIFO_FRAME_BYTES) >> 8));
+    imu_spi_write_register(IMU_REG_FIFO_CONFIG_0, IMU_FIFO_STREAM);
+    imu_spi_write_register(IMU_REG_FIFO_CONFIG_1, IMU_FIFO_GYR_ACC);
+    imu_spi_write_register(IMU_REG_INT1_IO_CTRL, IMU_INT1_PUSH_PULL_HIGH);
+    imu_spi_write_register(IMU_REG_INT_LATCH, IMU_INT_NOT_LATCHED);
+    imu_spi_write_register(IMU_REG_INT_MAP_DATA, IMU_INT_MAP_FWM_INT1);
+    imu_spi_write_register(IMU_REG_CMD, IMU_CMD_FIFO_FLUSH);
+
+    imu_spi_bacon = qspi->BACON.U;              /*  SPI ã8 λ MSB ȳ ʱӳ٣ */
+    imu_fifo_init(&imu_spi_fifo, ticks_per_us, IMU_SPI_ODR_HZ, IMU_SPI_WATERMARK);
+    imu_spi_ring_write = 0;
+    imu_spi_ring_read = 0;
+    imu_spi_stage = IMU_SPI_IDLE;
+    imu_spi_pending = 0;
+
+    imu_spi_dma_init();
+    exti_init(IMU_SPI_INT_PIN, EXTI_TRIGGER_RISING);
+    return 0;
+}
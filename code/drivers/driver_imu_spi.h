@@ -0,0 +1,24 @@
+/* driver_imu_spi.h */
+#ifndef _DRIVER_IMU_SPI_H_
+#define _DRIVER_IMU_SPI_H_
+
+#include "zf_common_headfile.h"
+#include "imu_fifo.h"
+
+/* ================= IMU660RA FIFO ʽȡ ================= */
+/* ٶȼ IMU_SPI_ODR_HZ дƬ FIFOܹ IMU_SPI_WATERMARK ֡ INT1 ؽ EXTI
+ * ȶ FIFO_LENGTHһ QSPI DMA ͻȫ֡루imu_fifo.c֡ʱ̷
+ * CPU ֻÿ 3 ж֣EXTI DMA ȴ SPI շ
+ * ʼ֮ SPI_0 鱾ռٵ imu660ra_get_acc() / imu660ra_get_gyro() */
+#define IMU_SPI_ODR_HZ          (1600)
+#define IMU_SPI_WATERMARK       (8)             /* ֡1600Hz  5ms һ */
+#define IMU_SPI_BATCH_MAX       (32)            /* һͻ֡һ */
+
+/* ================= ӿں ================= */
+uint8  imu_spi_init(void);              // ʼ IMU660RA  FIFO ʽȡ 0 ɹ CORE_SENSOR жϿǰã
+void   imu_spi_exti_handler(void);      // INT1 ˮλжϻصERU ͨ 0CORE_SENSOR
+void   imu_spi_dma_handler(void);       // QSPI  DMA жϻصCORE_SENSOR
+uint32 imu_spi_read(imu_fifo_sample_t *samples, uint32 max);   // ȡѽȵȳظֻ CORE_SENSOR ͬһж
+void   imu_spi_report(void);            // Դڴӡȡͳ
+
+#endif
@@ -0,0 +1,244 @@
+#include "driver_mag.h"
+#include "driver_imu.h"
+#include "snapshot.h"
+
+#define MAG_RECORD_WORDS        (12u)   /* magic, Ӳ 3,  6, ǿ, У */
+#define MAG_PROGRESS_SAMPLES    (200u)  /* ɼÿӡһν */
+
+typedef enum
+{
+    MAG_STATE_RUN = 0,
+    MAG_STATE_COLLECT,
+} mag_state_enum;
+
+/* ================= ȫֱ ================= */
+/* ֻ mag_task  */
+static mag_calibration_t mag_cal;
+static mag_fit_t mag_fit;
+static mag_state_enum mag_state = MAG_STATE_RUN;
+static uint8  mag_loaded = 0;
+static uint32 mag_last_timestamp = 0;
+static uint32 mag_samples = 0;
+static float  mag_raw[3];
+
+/*  -> mag_task */
+static volatile uint8 mag_toggle_requested = 0;
+
+/* mag_task ->  */
+static mag_heading_t mag_heading_slots[2];
+static snapshot_t mag_heading_snapshot;
+
+static const char *mag_fit_results[] = {"ok", "too few samples", "not enough tilt and heading",
+                                        "not an ellipsoid", "distorted"};
+
+/* ================= DFlash ¼ ================= */
+static uint32 mag_record_check(const uint32 *record)
+{
+    uint32 check = 0;
+    uint32 i;
+
+    for (i = 0; i < MAG_RECORD_WORDS - 1u; i++)
+    {
+        check ^= record[i];
+    }
+    return ~check;
+}
+
+static uint8 mag_cal_load(mag_calibration_t *out)
+{
+    uint32 record[MAG_RECORD_WORDS];
+    float values[10];
+
+    flash_read_page(0, MAG_CAL_FLASH_PAGE, record, MAG_RECORD_WORDS);
+    if (record[0] != MAG_CAL_MAGIC || record[MAG_RECORD_WORDS - 1u] != mag_record_check(record))
+    {
+        return 0;
+    }
+    memcpy(values, &record[1], sizeof(values));
+    if (!(values[9] > 0.0f))
+    {
+        return 0;
+    }
+    memcpy(out->hard_iron, values, 3u * sizeof(float));
+    out->soft_iron[0][0] = values[3];
+    out->soft_iron[0][1] = out->soft_iron[1][0] = values[4];
+    out->soft_iron[0][2] = out->soft_iron[2][0] = values[5];
+    out->soft_iron[1][1] = values[6];
+    out->soft_iron[1][2] = out->soft_iron[2][1] = values[7];
+    out->soft_iron[2][2] = values[8];
+    out->field = values[9];
+    return 1;
+}
+
+/* һ DFlash д */
+static void mag_cal_save(const mag_calibration_t *in)
+{
+    uint32 record[MAG_RECORD_WORDS];
+    float values[10];
+
+    memcpy(values, in->hard_iron, 3u * sizeof(float));
+    values[3] = in->soft_iron[0][0];
+    values[4] = in->soft_iron[0][1];
+    values[5] = in->soft_iron[0][2];
+    values[6] = in->soft_iron[1][1];
+    values[7] = in->soft_iron[1][2];
+    values[8] = in->soft_iron[2][2];
+    values[9] = in->field;
+
+    record[0] = MAG_CAL_MAGIC;
+    memcpy(&record[1], values, sizeof(values));
+    record[MAG_RECORD_WORDS - 1u] = mag_record_check(record);
+    flash_write_page(0, MAG_CAL_FLASH_PAGE, record, MAG_RECORD_WORDS);
+}
+
+/* ================= Դ ================= */
+/* ȡһų mGaussٶⵥλֻ÷򣩣ûʱ 0 */
+#if MAG_SOURCE == MAG_SOURCE_IMU963RA
+static uint8 mag_source_init(void)
+{
+    return (imu963ra_init() == 0);
+}
+
+static uint8 mag_source_read(float mag[3], float acc[3])
+{
+    imu963ra_get_mag();
+    imu963ra_get_acc();
+    mag[0] = imu963ra_mag_transition(imu963ra_mag_x) * 1000.0f;
+    mag[1] = imu963ra_mag_transition(imu963ra_mag_y) * 1000.0f;
+    mag[2] = imu963ra_mag_transition(imu963ra_mag_z) * 1000.0f;
+    acc[0] = imu963ra_acc_transition(imu963ra_acc_x);
+    acc[1] = imu963ra_acc_transition(imu963ra_acc_y);
+    acc[2] = imu963ra_acc_transition(imu963ra_acc_z);
+    return 1;
+}
+#else
+static uint8 mag_source_init(void)
+{
+    return 1;
+}
+
+static uint8 mag_source_read(float mag[3], float acc[3])
+{
+    yis_imu_t sample;
+
+    if (!yis_get_sample(&sample) || sample.timestamp == mag_last_timestamp || !(sample.fields & YIS_FIELD_MAG))
+    {
+        return 0;
+    }
+    mag_last_timestamp = sample.timestamp;
+    mag[0] = sample.mx;
+    mag[1] = sample.my;
+    mag[2] = sample.mz;
+    acc[0] = sample.ax;
+    acc[1] = sample.ay;
+    acc[2] = sample.az;
+    return 1;
+}
+#endif
+
+/* ================= 궨 ================= */
+static void mag_calibration_finish(void)
+{
+    mag_calibration_t result;
+    float residual;
+    mag_fit_result_enum fit_result = mag_fit_solve(&mag_fit, &result, &residual);
+
+    if (fit_result != MAG_FIT_OK)
+    {
+        printf("mag calibration: %s (%lu samples, residual %.3f), calibration unchanged\r\n",
+               mag_fit_results[fit_result], (unsigned long)mag_fit.count, residual);
+        return;
+    }
+    mag_cal = result;
+    mag_loaded = 1;
+    mag_cal_save(&mag_cal);
+    printf("mag calibration: hard iron %.1f %.1f %.1f  field %.1f mGauss  residual %.3f, saved\r\n",
+           mag_cal.hard_iron[0], mag_cal.hard_iron[1], mag_cal.hard_iron[2], mag_cal.field, residual);
+}
+
+void mag_calibration_toggle(void)
+{
+    mag_toggle_requested = 1;
+}
+
+/* =================  ================= */
+void mag_task(void)
+{
+    mag_heading_t heading;
+    float acc[3];
+
+    if (mag_toggle_requested)
+    {
+        mag_toggle_requested = 0;
+        if (mag_state == MAG_STATE_RUN)
+        {
+            mag_fit_reset(&mag_fit);
+            mag_state = MAG_STATE_COLLECT;
+            printf("mag calibration: turn the bike through all headings, tilted every way, then 'm'\r\n");
+        }
+        else
+        {
+            mag_state = MAG_STATE_RUN;
+            mag_calibration_finish();
+        }
+    }
+
+    if (!mag_source_read(mag_raw, acc))
+    {
+        return;
+    }
+    mag_samples++;
+
+    if (mag_state == MAG_STATE_COLLECT)
+    {
+        mag_fit_add(&mag_fit, mag_raw);
+        if (mag_fit.count % MAG_PROGRESS_SAMPLES == 0u)
+        {
+            printf("mag calibration: %lu samples\r\n", (unsigned long)mag_fit.count);
+        }
+    }
+
+    mag_heading(&mag_cal, mag_raw, acc, &heading);
+    snapshot_publish(&mag_heading_snapshot, &heading);
+}
+
+/* ================= º ================= */
+uint8 mag_get_heading(mag_heading_t *heading)
+{
+    return snapshot_read(&mag_heading_snapshot, heading);
+}
+
+void mag_report(void)
+{
+    mag_heading_t heading;
+
+    if (mag_get_heading(&heading))
+    {
+        printf("mag heading %.1f deg  field %.2f  %s  raw %.0f %.0f %.0f mGauss  samples %lu\r\n",
+               heading.heading_deg, heading.field_ratio, heading.valid ? "valid" : "invalid",
+               mag_raw[0], mag_raw[1], mag_raw[2], (unsigned long)mag_samples);
+    }
+    else
+    {
+        printf("mag no samples\r\n");
+    }
+    printf("mag cal hard iron %.1f %.1f %.1f  field %.1f mGauss  (%s)\r\n",
+           mag_cal.hard_iron[0], mag_cal.hard_iron[1], mag_cal.hard_iron[2], mag_cal.field,
+           mag_loaded ? "DFlash" : "none");
+}
+
+/* ================= ʼ ================= */
+void mag_init(void)
+{
+    snapshot_init(&mag_heading_snapshot, mag_heading_slots, sizeof(mag_heading_t));
+    mag_calibration_identity(&mag_cal, 0.0f);       /* δ궨ճ㵫ʼЧ */
+    mag_loaded = mag_cal_load(&mag_cal);
+    mag_state = MAG_STATE_RUN;
+    mag_toggle_requested = 0;
+    mag_samples = 0;
+
+    if (!mag_source_init())
+    {
+        printf("mag: IMU963RA init failed\r\n");
+    }
+}
@@ -0,0 +1,30 @@
+/* driver_mag.h */
+#ifndef _DRIVER_MAG_H_
+#define _DRIVER_MAG_H_
+
+#include "zf_common_headfile.h"
+#include "mag_calibration.h"
+
+/* ================= ƺ ================= */
+/* ԭʼֵӲ/УüٶȼƸбź㷨 mag_calibration.h
+ * 궨Դ 'm' ʼɼѳﻺתȦͬʱǰҸбԼ 45 ȣٰ 'm' ϣ
+ * ͨ DFlashMAG_CAL_FLASH_PAGEϵԶءֻڳŵʱڶǲϻᱻܾ */
+
+/* ================= Դ ================= */
+#define MAG_SOURCE_YIS          (0)     /* YIS ģ֡еĴųID 0x31ģд򿪣 */
+#define MAG_SOURCE_IMU963RA     (1)     /* IMU ϻװ IMU963RA IMU660RA ͬһʱںֻ YIS */
+#ifndef MAG_SOURCE
+#define MAG_SOURCE              MAG_SOURCE_YIS
+#endif
+
+#define MAG_CAL_FLASH_PAGE      (2)             /* DFlash ҳ 0 Ϊ YIS ģʽҳ 1 Ϊ IMU 궨 */
+#define MAG_CAL_MAGIC           (0x4D414731u)   /* "MAG1" */
+
+/* ================= ӿں ================= */
+void  mag_init(void);                       //  DFlash еı궨ʼԴ imu_init ֮ã
+void  mag_task(void);                       // ȡ궨ɼϡ㺽CORE_TELEMETRY 10ms
+void  mag_calibration_toggle(void);         // ʼ / 궨ɼ
+uint8 mag_get_heading(mag_heading_t *heading);  // ȡº˾ɵãʱ 0
+void  mag_report(void);                     // Դڴӡ궨
+
+#endif
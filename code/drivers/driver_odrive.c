@@ -7,26 +7,52 @@
 * 1. ODriveʼ
 * 2. ؿģʽ
 * 3. ٶȶȡܣѯ
+* 4. ͨŷʽUART6 ASCII / CAN0 CANSimpleODRIVE_TRANSPORT ѡ
 * 
 ********************************************************************************************************************/
 
 #include "driver_odrive.h"
 #include "zf_driver_uart.h"
+#include "odrive_cansimple.h"
+#include "profiler.h"
+#include "snapshot.h"
+#include "IfxStm.h"
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
 
+#if ODRIVE_TRANSPORT == ODRIVE_TRANSPORT_CAN
+#include "IfxCan_Can.h"
+#endif
+
 // ========== ̬ ==========
 static float current_torque = 0.0f;              // ǰõ
-static float wheel_speed_rps = 0.0f;             // ǰ٣ת/룩
-static volatile uint8 wheel_speed_valid = 0;    // Ч־
 
+// ݿգֻɽշUARTѯ / CANжϣȡõͬһ֡ȫֶ
+static odrive_encoder_t encoder_slots[2];
+static snapshot_t encoder_snapshot;
+
+#if ODRIVE_TRANSPORT == ODRIVE_TRANSPORT_UART
 // л
 static char line_buf[128];                       // л
 static uint8 line_len = 0;                       // ǰг
 
 // ֹظ»ذͻ
 static uint8 waiting_speed_resp = 0;
+#else
+static IfxCan_Can can_module;
+static IfxCan_Can_Node can_node;
+static odrive_can_feedback_t can_feedback;       // CANжд
+static volatile uint32 last_speed_ms = 0;        // һα֡ʱ
+static uint32 encoder_timeout_ticks = 0;         // ODRIVE_CAN_SPEED_TIMEOUT_MS  STM0 
+
+static IFX_CONST IfxCan_Can_Pins can_pins =
+{
+    &ODRIVE_CAN_TX_PIN, IfxPort_OutputMode_pushPull,
+    &ODRIVE_CAN_RX_PIN, IfxPort_InputMode_pullUp,
+    IfxPort_PadDriver_cmosAutomotiveSpeed2
+};
+#endif
 
 // ========== ڲ ==========
 
@@ -48,6 +74,8 @@ static inline float odrive_constrain_torque(float torque)
 
 // ========== ⲿӿں ==========
 
+#if ODRIVE_TRANSPORT == ODRIVE_TRANSPORT_UART
+
 /**
  * @brief ʼODrive
  */
@@ -58,8 +86,7 @@ void odrive_init(void)
     
     // ʼ״̬
     current_torque = 0.0f;
-    wheel_speed_rps = 0.0f;
-    wheel_speed_valid = 0;
+    snapshot_init(&encoder_snapshot, encoder_slots, sizeof(odrive_encoder_t));
     line_len = 0;
     waiting_speed_resp = 0;
     
@@ -88,9 +115,14 @@ void odrive_set_torque(float torque)
     
     // : c 0 <torque>
     // ODriveؿʽc <axis> <torque>
+    PROFILER_BEGIN(PROFILER_ODRIVE_FORMAT);
     sprintf(cmd, "c 0 %.6f", torque);  // 6λСȷ
+    PROFILER_END(PROFILER_ODRIVE_FORMAT);
+
+    PROFILER_BEGIN(PROFILER_ODRIVE_TX);
     uart_write_string(ODRIVE_UART_INDEX, cmd);
     uart_write_byte(ODRIVE_UART_INDEX, '\r');  // ODriveԻس
+    PROFILER_END(PROFILER_ODRIVE_TX);
 }
 
 /**
@@ -134,8 +166,11 @@ void odrive_poll(void)
             float v = strtof(line_buf, &endp);
             if (endp != line_buf)
             {
-                wheel_speed_rps = v;      // turns/s
-                wheel_speed_valid = 1;
+                odrive_encoder_t *encoder = snapshot_write_begin(&encoder_snapshot);
+                encoder->vel_rps = v;     // turns/s
+                encoder->pos_turns = 0.0f;
+                encoder->timestamp = IfxStm_getLower(&MODULE_STM0);
+                snapshot_write_commit(&encoder_snapshot);
             }
 
             line_len = 0;
@@ -157,6 +192,182 @@ void odrive_poll(void)
     }
 }
 
+/**
+ * @brief CANʽûCANжϣʵԱ isr.c ͨŷʽ޸
+ */
+void odrive_can_rx_isr(void)
+{
+}
+
+#else
+
+/**
+ * @brief һ֡дCAN TX FIFOȴ
+ * @note  жϣأжϣͣͺ̨ٶ󣩶ã
+ *        TX FIFO Ķ--джɣռʱ֡ᶪʧ򱻸
+ * @return 1=ӣ0=FIFO/æ
+ */
+static uint8 odrive_can_send(const odrive_can_frame_t *frame)
+{
+    IfxCan_Message message;
+    uint32 data[2];
+    uint32 interrupt_state;
+    IfxCan_Status status;
+
+    IfxCan_Can_initMessage(&message);
+    message.messageId = frame->id;
+    message.dataLengthCode = (IfxCan_DataLengthCode)frame->dlc;
+    message.remoteTransmitRequest = frame->rtr;
+    message.storeInTxFifoQueue = TRUE;
+    memcpy(data, frame->data, sizeof(data));
+
+    interrupt_state = interrupt_global_disable();
+    status = IfxCan_Can_sendMessage(&can_node, &message, data);
+    interrupt_global_enable(interrupt_state);
+
+    return (status == IfxCan_Status_ok) ? 1 : 0;
+}
+
+/**
+ * @brief ʼODriveCAN01Mbit/sRX FIFO0 + Ϣжϣ
+ */
+void odrive_init(void)
+{
+    IfxCan_Can_Config can_config;
+    IfxCan_Can_NodeConfig node_config;
+    odrive_can_frame_t frame;
+
+    IfxCan_Can_initModuleConfig(&can_config, &ODRIVE_CAN_MODULE);
+    IfxCan_Can_initModule(&can_module, &can_config);
+
+    IfxCan_Can_initNodeConfig(&node_config, &can_module);
+    node_config.nodeId = ODRIVE_CAN_NODE;
+    node_config.baudRate.baudrate = ODRIVE_CAN_BAUDRATE;
+    node_config.calculateBitTimingValues = TRUE;
+    node_config.frame.type = IfxCan_FrameType_transmitAndReceive;
+    node_config.frame.mode = IfxCan_FrameMode_standard;
+
+    // ͣ8FIFO֡Ӽ
+    node_config.txConfig.txMode = IfxCan_TxMode_fifo;
+    node_config.txConfig.dedicatedTxBuffersNumber = 0;
+    node_config.txConfig.txFifoQueueSize = 8;
+
+    // գȫFIFO0ڵɸѡ˸ɵ֡
+    node_config.filterConfig.standardListSize = 0;
+    node_config.filterConfig.standardFilterForNonMatchingFrames = IfxCan_NonMatchingFrame_acceptToRxFifo0;
+    node_config.rxConfig.rxMode = IfxCan_RxMode_fifo0;
+    node_config.rxConfig.rxFifo0Size = 16;
+    node_config.rxConfig.rxFifo0OperatingMode = IfxCan_RxFifoMode_overwrite;
+
+    node_config.interruptConfig.rxFifo0NewMessageEnabled = TRUE;
+    node_config.interruptConfig.rxf0n.interruptLine = IfxCan_InterruptLine_0;
+    node_config.interruptConfig.rxf0n.priority = CAN0_RX_INT_PRIO;
+    node_config.interruptConfig.rxf0n.typeOfService = CAN0_INT_SERVICE;
+
+    node_config.pins = &can_pins;
+    IfxCan_Can_initNode(&can_node, &node_config);
+
+    // ʼ״̬
+    current_torque = 0.0f;
+    snapshot_init(&encoder_snapshot, encoder_slots, sizeof(odrive_encoder_t));
+    encoder_timeout_ticks = (uint32)(IfxStm_getFrequency(&MODULE_STM0) / 1000.0f) * ODRIVE_CAN_SPEED_TIMEOUT_MS;
+    memset(&can_feedback, 0, sizeof(can_feedback));
+
+    // ȴODrive
+    system_delay_ms(100);
+
+    // ؿ + ֱͨ룬UARTʽODriveԤõģʽһ
+    odrive_can_pack_set_controller_mode(ODRIVE_CAN_NODE_ID, ODRIVE_CONTROL_MODE_TORQUE_CONTROL,
+                                        ODRIVE_INPUT_MODE_PASSTHROUGH, &frame);
+    odrive_can_send(&frame);
+
+    // óʼΪ0
+    odrive_stop();
+
+    printf("ODrive initialized on CAN0 (%d baud, node %d)\r\n", ODRIVE_CAN_BAUDRATE, ODRIVE_CAN_NODE_ID);
+    printf("ODrive torque mode ready.\r\n");
+}
+
+/**
+ * @brief ODriveأSet_Input_Torqueһ֡4ֽڣ
+ */
+void odrive_set_torque(float torque)
+{
+    odrive_can_frame_t frame;
+
+    // طΧ
+    torque = odrive_constrain_torque(torque);
+
+    // 浱ǰ
+    current_torque = torque;
+
+    PROFILER_BEGIN(PROFILER_ODRIVE_FORMAT);
+    odrive_can_pack_set_input_torque(ODRIVE_CAN_NODE_ID, torque, &frame);
+    PROFILER_END(PROFILER_ODRIVE_FORMAT);
+
+    PROFILER_BEGIN(PROFILER_ODRIVE_TX);
+    odrive_can_send(&frame);
+    PROFILER_END(PROFILER_ODRIVE_TX);
+}
+
+/**
+ * @brief ȡODriveٶȣ
+ * @note ±֡ODriveͣencoder_rate_ms
+ *       ֻͳʱʱŷԶ֡󣬱ȱʧʱȫû
+ */
+void odrive_request_speed(void)
+{
+    odrive_can_frame_t frame;
+
+    if (system_getval_ms() - last_speed_ms < ODRIVE_CAN_SPEED_TIMEOUT_MS) return;
+
+    odrive_can_pack_request(ODRIVE_CAN_NODE_ID, ODRIVE_CAN_CMD_GET_ENCODER_ESTIMATES, &frame);
+    odrive_can_send(&frame);
+}
+
+/**
+ * @brief жɣٳʱ odrive_get_encoder() ʱжϣ¿
+ */
+void odrive_poll(void)
+{
+}
+
+/**
+ * @brief CAN0 RX FIFO0 ϢжϣȡFIFO
+ */
+void odrive_can_rx_isr(void)
+{
+    IfxCan_Message message;
+    odrive_can_frame_t frame;
+    uint32 data[2];
+
+    IfxCan_Node_clearInterruptFlag(can_node.node, IfxCan_Interrupt_rxFifo0NewMessage);
+
+    while (IfxCan_Can_getRxFifo0FillLevel(&can_node) > 0)
+    {
+        IfxCan_Can_initMessage(&message);
+        message.readFromRxFifo0 = TRUE;
+        IfxCan_Can_readMessage(&can_node, &message, data);
+
+        frame.id = message.messageId;
+        frame.dlc = (uint8)message.dataLengthCode;
+        frame.rtr = 0;
+        memcpy(frame.data, data, sizeof(frame.data));
+
+        if (odrive_can_decode(&frame, ODRIVE_CAN_NODE_ID, &can_feedback) == ODRIVE_CAN_CMD_GET_ENCODER_ESTIMATES)
+        {
+            odrive_encoder_t *encoder = snapshot_write_begin(&encoder_snapshot);
+            encoder->vel_rps = can_feedback.vel_rps;    // turns/s
+            encoder->pos_turns = can_feedback.pos_turns;
+            encoder->timestamp = IfxStm_getLower(&MODULE_STM0);
+            snapshot_write_commit(&encoder_snapshot);
+            last_speed_ms = system_getval_ms();
+        }
+    }
+}
+
+#endif
+
 /**
  * @brief ȡǰ
  * @param out_rps 洢ֵת/룩
@@ -164,9 +375,30 @@ void odrive_poll(void)
  */
 uint8 odrive_get_speed(float *out_rps)
 {
+    odrive_encoder_t encoder;
+
     if (!out_rps) return 0;
-    if (!wheel_speed_valid) return 0;
-    *out_rps = wheel_speed_rps;
+    if (!odrive_get_encoder(&encoder)) return 0;
+    *out_rps = encoder.vel_rps;
+    return 1;
+}
+
+/**
+ * @brief ȡһα
+ * @note CANʽ°ʱжϳʱSTM0 ˶ܶȡĸ϶һ
+ */
+uint8 odrive_get_encoder(odrive_encoder_t *out)
+{
+    odrive_encoder_t encoder;
+
+    if (!out) return 0;
+    if (!snapshot_read(&encoder_snapshot, &encoder)) return 0;
+
+#if ODRIVE_TRANSPORT == ODRIVE_TRANSPORT_CAN
+    if (IfxStm_getLower(&MODULE_STM0) - encoder.timestamp >= encoder_timeout_ticks) return 0;
+#endif
+
+    *out = encoder;
     return 1;
 }
 
@@ -8,9 +8,12 @@
 * 2. ؿģʽ
 * 3. ٶȶȡ
 * 
-* ע⣺ODriveͨUARTӿʹASCIIЭͨ
+* ͨŷʽ ODRIVE_TRANSPORT ѡ
+*   UARTASCIIЭ
 *      ʽc 0 <torque> 
 *      ʽr axis0.encoder.vel_estimate ȡٶ
+*   CAN CANSimpleЭ飨 odrive_cansimple.h
+*      Set_Input_Torque һ֡أGet_Encoder_Estimates ODriveڷ
 * 
 ********************************************************************************************************************/
 
@@ -19,16 +22,38 @@
 
 #include "zf_common_headfile.h"
 
-// ========== ODriveӲ ==========
+// ========== ͨŷʽѡ ==========
+#define ODRIVE_TRANSPORT_UART   (0)                   // UART6 ASCII115200ÿԼ1.2msʱ
+#define ODRIVE_TRANSPORT_CAN    (1)                   // CAN0 CANSimpleдTX FIFOأٰ
+#define ODRIVE_TRANSPORT        (ODRIVE_TRANSPORT_UART)  // ΪCAN軻CANշ·ţODriveCANSimple
+
+// ========== ODriveӲãUART ==========
 #define ODRIVE_UART_INDEX       (UART_6)              // ʹUART6ODrive
 #define ODRIVE_BAUDRATE         (115200)              // ODriveĬϲ
 #define ODRIVE_TX_PIN           (UART6_TX_P22_0)      // ODrive TX
 #define ODRIVE_RX_PIN           (UART6_RX_P23_1)      // ODrive RX
 
+// ========== ODriveӲãCAN ==========
+#define ODRIVE_CAN_MODULE       (MODULE_CAN0)         // MCMCAN0
+#define ODRIVE_CAN_NODE         (IfxCan_NodeId_0)     // ڵ0
+#define ODRIVE_CAN_BAUDRATE     (1000000)             //  odrv0.can.config.baud_rate һ
+#define ODRIVE_CAN_TX_PIN       (IfxCan_TXD00_P33_8_OUT)   // շTXD
+#define ODRIVE_CAN_RX_PIN       (IfxCan_RXD00E_P33_7_IN)   // շRXDP20_7KEY2RXD00B
+#define ODRIVE_CAN_NODE_ID      (0)                   //  odrv0.axis0.config.can.node_id һ
+#define ODRIVE_CAN_SPEED_TIMEOUT_MS (50)              // ʱδյ֡Ч
+
 // ========== ODrive ==========
 #define ODRIVE_TORQUE_MAX       (18.0f)               // ƣNm
 #define ODRIVE_TORQUE_MIN       (-18.0f)              // СƣNm
 
+// ==========  ==========
+typedef struct
+{
+    float  vel_rps;                                   // ٣ת/룩
+    float  pos_turns;                                 // λãȦUARTʽ²ȡΪ0
+    uint32 timestamp;                                 // յʱ̣STM0˿ɱȣ
+} odrive_encoder_t;
+
 // ==========  ==========
 
 /**
@@ -40,13 +65,14 @@ void odrive_init(void);
 /**
  * @brief ODrive
  * @param torque ĿأNmԶ޷ڡ18NmΧ
- * @note ʽ: "c 0 <torque>\r"
+ * @note UARTʽ: "c 0 <torque>\r"CAN Set_Input_Torque ֡
  */
 void odrive_set_torque(float torque);
 
 /**
  * @brief ȡODriveٶȣ
  * @note ֻȴӦ
+ * @note CANʽODriveͣжʱԶ֡
  * @note Ҫ odrive_poll() ѭиƵ
  * @note Ƶʣ20-50Hzÿ20-50msһΣ
  */
@@ -71,9 +97,23 @@ void odrive_poll(void);
  */
 uint8 odrive_get_speed(float *out_rps);
 
+/**
+ * @brief ȡһαݵٶȡλáʱͬһ֡
+ * @param out 
+ * @return 1=Чݣ0=Ч/δյ/CANʽ³ ODRIVE_CAN_SPEED_TIMEOUT_MS
+ * @note ˡжϾɵãдһ
+ */
+uint8 odrive_get_encoder(odrive_encoder_t *out);
+
 /**
  * @brief ֹͣODriveΪ0
  */
 void odrive_stop(void);
 
+/**
+ * @brief CANжϴȡRX FIFO0/֡
+ * @note  isr.c  CAN0 жеã ODRIVE_TRANSPORT_CAN ʱЧ
+ */
+void odrive_can_rx_isr(void);
+
 #endif /* DRIVER_ODRIVE_H */
@@ -0,0 +1,115 @@
+/* imu_fifo.c */
+#include "imu_fifo.h"
+
+static inline int16 fifo_load16(const uint8 *p)
+{
+    return (int16)((uint16)p[0] | ((uint16)p[1] << 8));
+}
+
+void imu_fifo_init(imu_fifo_t *fifo, uint32 ticks_per_us, uint32 odr_hz, uint32 watermark)
+{
+    memset(fifo, 0, sizeof(*fifo));
+    fifo->watermark = watermark;
+    fifo->period_nominal = (float)ticks_per_us * 1e6f / (float)odr_hz;
+    fifo->period = fifo->period_nominal;
+}
+
+uint32 imu_fifo_frames(uint8 length_0, uint8 length_1)
+{
+    uint32 bytes = ((uint32)length_0 | ((uint32)length_1 << 8)) & IMU_FIFO_LENGTH_MASK;
+
+    return bytes / IMU_FIFO_FRAME_BYTES;
+}
+
+/* Advance the time line by the n frames just read; behind frames stayed in the FIFO */
+static void fifo_track(imu_fifo_t *fifo, uint32 n, uint32 behind, uint32 read_time, uint8 fresh)
+{
+    float newest = (float)(int32)(read_time - fifo->base) - (float)behind * fifo->period;
+    float predicted, error, limit;
+
+    if (!fifo->locked)
+    {
+        fifo->last_time = fresh ? newest : newest - 0.5f * fifo->period;
+        fifo->locked = 1;
+        fifo->since_fresh = 0;
+    }
+    else
+    {
+        predicted = fifo->last_time + (float)n * fifo->period;
+        error = newest - predicted;
+        fifo->since_fresh += n;
+
+        if (error > IMU_FIFO_RESYNC_PERIODS * fifo->period || error < -IMU_FIFO_RESYNC_PERIODS * fifo->period)
+        {
+            fifo->last_time = fresh ? newest : newest - 0.5f * fifo->period;
+            fifo->since_fresh = 0;
+            fifo->resyncs++;
+        }
+        else if (fresh)
+        {
+            fifo->last_time = predicted + error * IMU_FIFO_TIME_GAIN;
+            fifo->period += error / (float)fifo->since_fresh * IMU_FIFO_PERIOD_GAIN;
+            fifo->since_fresh = 0;
+
+            limit = fifo->period_nominal * IMU_FIFO_PERIOD_TOLERANCE;
+            if (fifo->period > fifo->period_nominal + limit) fifo->period = fifo->period_nominal + limit;
+            if (fifo->period < fifo->period_nominal - limit) fifo->period = fifo->period_nominal - limit;
+        }
+        else
+        {
+            /* late burst: the newest frame was written within one period before read_time */
+            if (predicted > newest) predicted = newest;
+            if (predicted < newest - fifo->period) predicted = newest - fifo->period;
+            fifo->last_time = predicted;
+        }
+    }
+
+    /* keep the float small: move the base up to the newest frame */
+    fifo->base += (uint32)(int32)fifo->last_time;
+    fifo->last_time -= (float)(int32)fifo->last_time;
+}
+
+uint32 imu_fifo_decode(imu_fifo_t *fifo, const uint8 *burst, uint32 length, uint32 read_time, uint32 waiting,
+                       imu_fifo_sample_t *out, uint32 max)
+{
+    const uint8 *p = burst + IMU_FIFO_DUMMY_BYTES;
+    uint32 frames, i, n = 0;
+
+    if (length <= IMU_FIFO_DUMMY_BYTES)
+    {
+        return 0;
+    }
+    frames = (length - IMU_FIFO_DUMMY_BYTES) / IMU_FIFO_FRAME_BYTES;
+
+    for (i = 0; i < frames && n < max; i++, p += IMU_FIFO_FRAME_BYTES)
+    {
+        imu_fifo_sample_t *s = &out[n];
+
+        s->gyro[0] = fifo_load16(p + 0);
+        s->gyro[1] = fifo_load16(p + 2);
+        s->gyro[2] = fifo_load16(p + 4);
+        s->acc[0] = fifo_load16(p + 6);
+        s->acc[1] = fifo_load16(p + 8);
+        s->acc[2] = fifo_load16(p + 10);
+        if (s->gyro[0] == IMU_FIFO_INVALID && s->acc[0] == IMU_FIFO_INVALID)
+        {
+            fifo->invalid++;
+            continue;
+        }
+        n++;
+    }
+    if (n == 0u)
+    {
+        return 0;
+    }
+
+    fifo_track(fifo, n, waiting > n ? waiting - n : 0u, read_time, waiting == fifo->watermark);
+    for (i = 0; i < n; i++)
+    {
+        out[i].timestamp = fifo->base + (uint32)(int32)(fifo->last_time - (float)(n - 1u - i) * fifo->period);
+    }
+
+    fifo->frames += n;
+    fifo->batches++;
+    return n;
+}
@@ -0,0 +1,68 @@
+/* imu_fifo.h */
+#ifndef IMU_FIFO_H
+#define IMU_FIFO_H
+
+#include "zf_common_headfile.h"
+
+/* IMU660RA (BMI270 core) FIFO burst decoder, hardware independent so it also
+ * builds on the host (tools/sim/imu_fifo_check.c).
+ *
+ * The FIFO runs headerless with gyro and accel enabled: every frame is 12 bytes,
+ * gyro x y z then accel x y z, int16 little endian. A burst read of FIFO_DATA
+ * starts with one dummy byte (SPI read protocol of the part), then whole frames.
+ *
+ * The sensor stamps nothing in this mode, so frame times are reconstructed on a
+ * tracked time line: the newest frame read is predicted at last + n * period.
+ * A burst started by the watermark interrupt with exactly the watermark waiting
+ * ("fresh") measures it: the frame completing the watermark was written at
+ * read_time, the interrupt time, less the frames left behind. That pulls the
+ * prediction by IMU_FIFO_TIME_GAIN and the period (sensor clock vs STM) by
+ * IMU_FIFO_PERIOD_GAIN. A late burst (more waiting) only bounds it: the newest
+ * frame was written within one period before read_time. An error beyond
+ * IMU_FIFO_RESYNC_PERIODS (lost interrupt, FIFO overflow) restarts the line.
+ */
+#define IMU_FIFO_FRAME_BYTES        (12u)
+#define IMU_FIFO_DUMMY_BYTES        (1u)
+#define IMU_FIFO_LENGTH_MASK        (0x3FFFu)   /* FIFO_LENGTH_1 bits 5:0 | FIFO_LENGTH_0 */
+#define IMU_FIFO_INVALID            (-32768)    /* 0x8000: value read from an empty FIFO */
+
+#define IMU_FIFO_TIME_GAIN          (0.1f)
+#define IMU_FIFO_PERIOD_GAIN        (0.01f)
+#define IMU_FIFO_PERIOD_TOLERANCE   (0.03f)     /* clock tolerance of the part, clamps the estimate */
+#define IMU_FIFO_RESYNC_PERIODS     (4.0f)
+
+typedef struct
+{
+    int16  gyro[3];                     /* raw, part axes */
+    int16  acc[3];
+    uint32 timestamp;                   /* STM ticks, measurement time */
+} imu_fifo_sample_t;
+
+typedef struct
+{
+    uint32 watermark;                   /* frames */
+    float  period_nominal;              /* ticks per frame at the configured ODR */
+    float  period;                      /* ticks per frame, tracked */
+    float  last_time;                   /* newest frame, ticks relative to base */
+    uint32 base;                        /* STM time last_time is counted from */
+    uint8  locked;
+    uint32 since_fresh;                 /* frames since the last measured burst */
+
+    uint32 frames;                      /* decoded */
+    uint32 invalid;                     /* empty FIFO reads dropped */
+    uint32 batches;
+    uint32 resyncs;
+} imu_fifo_t;
+
+void   imu_fifo_init       (imu_fifo_t *fifo, uint32 ticks_per_us, uint32 odr_hz, uint32 watermark);
+
+/* FIFO_LENGTH_0 / _1 as read -> whole frames waiting */
+uint32 imu_fifo_frames     (uint8 length_0, uint8 length_1);
+
+/* Decode one burst (dummy byte included). read_time: watermark interrupt (or
+ * burst restart) time; waiting: frames the fill level showed, the burst may
+ * read fewer. Writes up to max samples, oldest first; returns the count. */
+uint32 imu_fifo_decode     (imu_fifo_t *fifo, const uint8 *burst, uint32 length, uint32 read_time, uint32 waiting,
+                            imu_fifo_sample_t *out, uint32 max);
+
+#endif
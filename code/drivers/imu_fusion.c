@@ -0,0 +1,442 @@
+/* imu_fusion.c */
+#include "imu_fusion.h"
+
+#define IMU_FUSION_MASK             (IMU_FUSION_HISTORY - 1u)
+#define IMU_FUSION_SATURATED_US     (100000u)   /* a saturated sample keeps the SPI IMU out this long */
+#define IMU_FUSION_ROLL_TAU_S       (1.0f)      /* pull of the integrated roll toward the YIS roll */
+
+static inline float fusion_alpha(float dt, float tau)
+{
+    return dt / (tau + dt);
+}
+
+static inline uint8 fusion_elapsed(uint32 now, uint32 since, uint32 us, uint32 ticks_per_us)
+{
+    return (uint32)(now - since) >= us * ticks_per_us;
+}
+
+/* header arrival - YIS measurement time: lag to the end of the matching SPI window, plus half of it */
+static inline uint32 fusion_lag_ticks(const imu_fusion_t *fusion)
+{
+    return fusion->lag * fusion->spi_period + (fusion->window - 1u) * fusion->spi_period / 2u;
+}
+
+/* mean of count SPI samples ending at index last */
+static void fusion_spi_mean(const imu_fusion_t *fusion, uint32 last, uint32 count, float gyro[3], float acc[3])
+{
+    float scale = 1.0f / (float)count;
+    uint32 i, axis;
+
+    for (axis = 0; axis < 3u; axis++)
+    {
+        gyro[axis] = 0.0f;
+        acc[axis] = 0.0f;
+    }
+    for (i = 0; i < count; i++)
+    {
+        const imu_fusion_spi_sample_t *s = &fusion->history[(last - i) & IMU_FUSION_MASK];
+
+        for (axis = 0; axis < 3u; axis++)
+        {
+            gyro[axis] += s->gyro[axis];
+            acc[axis] += s->acc[axis];
+        }
+    }
+    for (axis = 0; axis < 3u; axis++)
+    {
+        gyro[axis] *= scale;
+        acc[axis] *= scale;
+    }
+}
+
+/* Align the new YIS frame with the SPI history: lag search, residual, offsets */
+static void fusion_compare(imu_fusion_t *fusion)
+{
+    const yis_imu_t *yis = &fusion->yis;
+    const float yis_gyro[3] = {yis->wx, yis->wy, yis->wz};
+    const float yis_acc[3] = {yis->ax, yis->ay, yis->az};
+    uint32 oldest = fusion->spi_count - IMU_FUSION_HISTORY;
+    uint32 newest = fusion->spi_count - 1u;
+    uint32 window, k, axis, best;
+    float dt, alpha, gyro[3], acc[3], error, residual_g, residual_a;
+
+    if (fusion->spi_count < IMU_FUSION_HISTORY || fusion->spi_period == 0u)
+    {
+        return;
+    }
+    if ((int32)(fusion->history[newest & IMU_FUSION_MASK].timestamp - yis->timestamp) < 0)
+    {
+        return;                                 /* SPI batch covering the header not in yet */
+    }
+    fusion->yis_pending = 0;
+
+    /* newest SPI sample taken no later than the header */
+    while ((int32)(fusion->history[newest & IMU_FUSION_MASK].timestamp - yis->timestamp) > 0)
+    {
+        newest--;
+        if (newest - oldest < IMU_FUSION_LAG_STEPS + IMU_FUSION_WINDOW_MAX)
+        {
+            return;                             /* header older than the history covers */
+        }
+    }
+
+    window = (fusion->yis_period + fusion->spi_period / 2u) / fusion->spi_period;
+    window = (window < 1u) ? 1u : (window > IMU_FUSION_WINDOW_MAX ? IMU_FUSION_WINDOW_MAX : window);
+    fusion->window = window;
+    dt = (float)fusion->yis_period / ((float)fusion->ticks_per_us * 1e6f);
+
+    /* lag: smallest running gyro error, only learnt while both streams are sound */
+    if (!fusion->residual_high && fusion->spi_faults == 0u)
+    {
+        alpha = fusion_alpha(dt, IMU_FUSION_LAG_TAU_S);
+        best = fusion->lag;
+        for (k = 0; k < IMU_FUSION_LAG_STEPS; k++)
+        {
+            fusion_spi_mean(fusion, newest - k, window, gyro, acc);
+            error = 0.0f;
+            for (axis = 0; axis < 3u; axis++)
+            {
+                float e = gyro[axis] - fusion->gyro_offset[axis] - yis_gyro[axis];
+                error += e * e;
+            }
+            fusion->lag_score[k] += (error - fusion->lag_score[k]) * alpha;
+            if (fusion->lag_score[k] < fusion->lag_score[best])
+            {
+                best = k;
+            }
+        }
+        fusion->lag = best;
+    }
+
+    /* residual and offsets at that lag */
+    fusion_spi_mean(fusion, newest - fusion->lag, window, gyro, acc);
+    if (fusion->gyro_residual < 0.0f)
+    {
+        for (axis = 0; axis < 3u; axis++)   /* seed: take the first difference as the offset */
+        {
+            fusion->gyro_offset[axis] = gyro[axis] - yis_gyro[axis];
+            fusion->acc_offset[axis] = acc[axis] - yis_acc[axis];
+        }
+        fusion->gyro_residual = 0.0f;
+    }
+
+    residual_g = 0.0f;
+    residual_a = 0.0f;
+    for (axis = 0; axis < 3u; axis++)
+    {
+        float eg = gyro[axis] - fusion->gyro_offset[axis] - yis_gyro[axis];
+        float ea = acc[axis] - fusion->acc_offset[axis] - yis_acc[axis];
+
+        residual_g += eg * eg;
+        residual_a += ea * ea;
+    }
+    alpha = fusion_alpha(dt, IMU_FUSION_RESIDUAL_TAU_S);
+    fusion->gyro_residual += (sqrtf(residual_g) - fusion->gyro_residual) * alpha;
+    fusion->acc_residual += (sqrtf(residual_a) - fusion->acc_residual) * alpha;
+
+    if (fusion->gyro_residual > IMU_FUSION_GYRO_RESIDUAL || fusion->acc_residual > IMU_FUSION_ACC_RESIDUAL)
+    {
+        if (!fusion->residual_high)
+        {
+            fusion->residual_high = 1;
+            fusion->residual_since = yis->timestamp;
+        }
+        return;
+    }
+    fusion->residual_high = 0;
+    if (fusion->spi_faults != 0u)
+    {
+        return;
+    }
+
+    /* both agree: let the SPI offsets follow slow drift */
+    alpha = fusion_alpha(dt, IMU_FUSION_OFFSET_TAU_S);
+    for (axis = 0; axis < 3u; axis++)
+    {
+        fusion->gyro_offset[axis] += (gyro[axis] - yis_gyro[axis] - fusion->gyro_offset[axis]) * alpha;
+        fusion->acc_offset[axis] += (acc[axis] - yis_acc[axis] - fusion->acc_offset[axis]) * alpha;
+    }
+}
+
+/* faults now, and usable once healthy for IMU_FUSION_RECOVER_US */
+static void fusion_health(imu_fusion_t *fusion, uint32 now)
+{
+    uint32 tpu = fusion->ticks_per_us;
+    const imu_fusion_spi_sample_t *last = &fusion->history[(fusion->spi_count - 1u) & IMU_FUSION_MASK];
+    uint8 yis_faults = 0, spi_faults = 0;
+
+    if (fusion->yis_count == 0u)
+    {
+        yis_faults |= IMU_FUSION_FAULT_ABSENT;
+    }
+    else if (fusion_elapsed(now, fusion->yis.timestamp, IMU_FUSION_YIS_STALE_US, tpu))
+    {
+        yis_faults |= IMU_FUSION_FAULT_STALE;
+    }
+
+    if (fusion->spi_count == 0u)
+    {
+        spi_faults |= IMU_FUSION_FAULT_ABSENT;
+    }
+    else
+    {
+        if (fusion_elapsed(now, last->timestamp, IMU_FUSION_SPI_STALE_US, tpu))
+        {
+            spi_faults |= IMU_FUSION_FAULT_STALE;
+        }
+        if (fusion->spi_stuck_run >= IMU_FUSION_STUCK_SAMPLES)
+        {
+            spi_faults |= IMU_FUSION_FAULT_STUCK;
+        }
+        if (fusion->spi_saturated && !fusion_elapsed(now, fusion->spi_saturated_time, IMU_FUSION_SATURATED_US, tpu))
+        {
+            spi_faults |= IMU_FUSION_FAULT_SATURATED;
+        }
+    }
+
+    /* disagreement: the YIS wins ties, it is the calibrated module */
+    if (yis_faults == 0u && spi_faults == 0u && fusion->residual_high &&
+        fusion_elapsed(now, fusion->residual_since, IMU_FUSION_RESIDUAL_HOLD_US, tpu))
+    {
+        spi_faults |= IMU_FUSION_FAULT_RESIDUAL;
+    }
+
+    if (yis_faults != 0u)
+    {
+        fusion->yis_healthy_since = now;
+        fusion->yis_usable = 0;
+    }
+    else if (fusion_elapsed(now, fusion->yis_healthy_since, IMU_FUSION_RECOVER_US, tpu))
+    {
+        fusion->yis_usable = 1;
+    }
+
+    if (spi_faults != 0u)
+    {
+        fusion->spi_healthy_since = now;
+        fusion->spi_usable = 0;
+    }
+    else if (fusion_elapsed(now, fusion->spi_healthy_since, IMU_FUSION_RECOVER_US, tpu))
+    {
+        fusion->spi_usable = 1;
+    }
+
+    fusion->yis_faults = yis_faults;
+    fusion->spi_faults = spi_faults;
+}
+
+void imu_fusion_init(imu_fusion_t *fusion, uint32 ticks_per_us, uint32 spi_period_us)
+{
+    memset(fusion, 0, sizeof(*fusion));
+    fusion->ticks_per_us = ticks_per_us;
+    fusion->spi_period = spi_period_us * ticks_per_us;
+    fusion->yis_period = 10000u * ticks_per_us;
+    fusion->window = 1;
+    fusion->gyro_residual = -1.0f;             /* offsets not seeded yet */
+    fusion->share = 1.0f;
+    fusion->share_target = 1.0f;
+    fusion->yis_faults = IMU_FUSION_FAULT_ABSENT;
+    fusion->spi_faults = IMU_FUSION_FAULT_ABSENT;
+}
+
+void imu_fusion_push_spi(imu_fusion_t *fusion, const float gyro[3], const float acc[3], uint32 timestamp, uint8 saturated)
+{
+    const imu_fusion_spi_sample_t *prev = &fusion->history[(fusion->spi_count - 1u) & IMU_FUSION_MASK];
+    imu_fusion_spi_sample_t *sample = &fusion->history[fusion->spi_count & IMU_FUSION_MASK];
+    uint32 axis;
+
+    if (fusion->spi_count != 0u && memcmp(prev->gyro, gyro, sizeof(prev->gyro)) == 0 &&
+        memcmp(prev->acc, acc, sizeof(prev->acc)) == 0)
+    {
+        fusion->spi_stuck_run++;
+    }
+    else
+    {
+        fusion->spi_stuck_run = 0;
+    }
+
+    for (axis = 0; axis < 3u; axis++)
+    {
+        sample->gyro[axis] = gyro[axis];
+        sample->acc[axis] = acc[axis];
+        fusion->spi_sum_gyro[axis] += gyro[axis];
+        fusion->spi_sum_acc[axis] += acc[axis];
+    }
+    sample->timestamp = timestamp;
+    fusion->spi_sum_count++;
+    fusion->spi_count++;
+
+    if (saturated)
+    {
+        fusion->spi_saturated = 1;
+        fusion->spi_saturated_time = timestamp;
+    }
+
+    if (fusion->yis_pending)
+    {
+        fusion_compare(fusion);
+    }
+}
+
+void imu_fusion_push_yis(imu_fusion_t *fusion, const yis_imu_t *sample)
+{
+    if (fusion->yis_count != 0u)
+    {
+        uint32 period = sample->timestamp - fusion->yis.timestamp;
+
+        if (period != 0u && period < IMU_FUSION_YIS_STALE_US * fusion->ticks_per_us)
+        {
+            fusion->yis_period = period;
+        }
+    }
+    fusion->yis = *sample;
+    fusion->yis_count++;
+    fusion->yis_new = 1;
+    fusion->yis_pending = 1;
+
+    fusion_compare(fusion);
+}
+
+uint8 imu_fusion_output(imu_fusion_t *fusion, uint32 now, yis_imu_t *out)
+{
+    const imu_fusion_spi_sample_t *last = &fusion->history[(fusion->spi_count - 1u) & IMU_FUSION_MASK];
+    float target, dt, step, w, spi_gyro[3], spi_acc[3];
+    uint32 spi_time, yis_time, timestamp, axis;
+
+    fusion_health(fusion, now);
+
+    if (fusion->yis_usable && fusion->spi_usable)
+    {
+        target = IMU_FUSION_YIS_SHARE;
+    }
+    else if (fusion->yis_usable)
+    {
+        target = 1.0f;
+    }
+    else if (fusion->spi_usable)
+    {
+        target = 0.0f;
+    }
+    else
+    {
+        return 0;
+    }
+    if (target != fusion->share_target)
+    {
+        fusion->share_target = target;
+        fusion->switches++;
+    }
+
+    dt = fusion->output_seen ? (float)(now - fusion->output_time) / ((float)fusion->ticks_per_us * 1e6f) : 0.0f;
+    step = dt / IMU_FUSION_BLEND_S;
+    if (!fusion->output_seen)
+    {
+        fusion->share = target;                 /* nothing to fade from */
+    }
+    else if (fusion->share < target)
+    {
+        fusion->share = (fusion->share + step < target) ? fusion->share + step : target;
+    }
+    else
+    {
+        fusion->share = (fusion->share - step > target) ? fusion->share - step : target;
+    }
+    w = fusion->share;
+
+    if (w >= 1.0f && !fusion->yis_new)
+    {
+        return 0;                               /* YIS only: nothing new until the next frame */
+    }
+
+    /* SPI part: mean since the last output, in YIS terms */
+    if (fusion->spi_sum_count != 0u)
+    {
+        float scale = 1.0f / (float)fusion->spi_sum_count;
+
+        for (axis = 0; axis < 3u; axis++)
+        {
+            spi_gyro[axis] = fusion->spi_sum_gyro[axis] * scale - fusion->gyro_offset[axis];
+            spi_acc[axis] = fusion->spi_sum_acc[axis] * scale - fusion->acc_offset[axis];
+        }
+        spi_time = last->timestamp - (fusion->spi_sum_count - 1u) * fusion->spi_period / 2u;
+    }
+    else
+    {
+        for (axis = 0; axis < 3u; axis++)
+        {
+            spi_gyro[axis] = last->gyro[axis] - fusion->gyro_offset[axis];
+            spi_acc[axis] = last->acc[axis] - fusion->acc_offset[axis];
+        }
+        spi_time = last->timestamp;
+    }
+
+    if (fusion->yis_count != 0u)
+    {
+        *out = fusion->yis;
+    }
+    else
+    {
+        memset(out, 0, sizeof(*out));
+    }
+    yis_time = fusion->yis.timestamp - fusion_lag_ticks(fusion);
+
+    out->wx = w * fusion->yis.wx + (1.0f - w) * spi_gyro[0];
+    out->wy = w * fusion->yis.wy + (1.0f - w) * spi_gyro[1];
+    out->wz = w * fusion->yis.wz + (1.0f - w) * spi_gyro[2];
+    out->ax = w * fusion->yis.ax + (1.0f - w) * spi_acc[0];
+    out->ay = w * fusion->yis.ay + (1.0f - w) * spi_acc[1];
+    out->az = w * fusion->yis.az + (1.0f - w) * spi_acc[2];
+
+    /* roll: the YIS one while it carries everything, else integrated and pulled toward it */
+    if (w >= 1.0f || !fusion->output_seen)
+    {
+        fusion->roll = fusion->yis.roll;
+    }
+    else
+    {
+        fusion->roll += out->wx * dt;
+        if (fusion->yis_usable)
+        {
+            fusion->roll += (fusion->yis.roll - fusion->roll) * fusion_alpha(dt, IMU_FUSION_ROLL_TAU_S);
+        }
+    }
+    out->roll = w * fusion->yis.roll + (1.0f - w) * fusion->roll;
+
+    timestamp = spi_time + (uint32)(int32)(w * (float)(int32)(yis_time - spi_time));
+    if (fusion->output_seen && (int32)(timestamp - fusion->output_timestamp) <= 0)
+    {
+        timestamp = fusion->output_timestamp + fusion->ticks_per_us;
+    }
+    out->timestamp = timestamp;
+    out->tid = fusion->output_count++;
+    out->fields |= YIS_FIELD_GYRO | YIS_FIELD_ACC | YIS_FIELD_EULER;
+
+    for (axis = 0; axis < 3u; axis++)
+    {
+        fusion->spi_sum_gyro[axis] = 0.0f;
+        fusion->spi_sum_acc[axis] = 0.0f;
+    }
+    fusion->spi_sum_count = 0;
+    fusion->yis_new = 0;
+    fusion->output_time = now;
+    fusion->output_timestamp = timestamp;
+    fusion->output_seen = 1;
+    return 1;
+}
+
+void imu_fusion_get_status(const imu_fusion_t *fusion, imu_fusion_status_t *status)
+{
+    uint32 axis;
+
+    status->yis_faults = fusion->yis_faults;
+    status->spi_faults = fusion->spi_faults;
+    status->yis_share = fusion->share;
+    status->lag_us = fusion_lag_ticks(fusion) / fusion->ticks_per_us;
+    status->gyro_residual = (fusion->gyro_residual > 0.0f) ? fusion->gyro_residual : 0.0f;
+    status->acc_residual = fusion->acc_residual;
+    for (axis = 0; axis < 3u; axis++)
+    {
+        status->gyro_offset[axis] = fusion->gyro_offset[axis];
+    }
+    status->switches = fusion->switches;
+}
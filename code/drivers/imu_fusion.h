@@ -0,0 +1,138 @@
+/* imu_fusion.h */
+#ifndef IMU_FUSION_H
+#define IMU_FUSION_H
+
+#include "zf_common_headfile.h"
+#include "driver_imu.h"
+
+/* Redundant IMU fusion: YIS module (UART) + on-board SPI IMU, hardware independent
+ * so it also builds on the host (tools/sim/imu_fusion_check.c).
+ *
+ * The SPI IMU is sampled at a fixed high rate and kept in a short history. Every
+ * YIS frame is compared with the SPI mean over the frame interval, shifted back by
+ * a lag that is estimated online (YIS header arrival trails its measurement by
+ * the module filter plus the UART frame time; a frame is compared once the SPI
+ * samples up to its header are in): a running squared error is kept for
+ * every lag candidate and the smallest one wins. At the chosen lag the YIS - SPI
+ * difference gives
+ *   - an SPI offset (gyro bias, accel offset) tracked slowly while both agree, so
+ *     SPI values are expressed in YIS terms and switching does not step;
+ *   - a low-passed residual; above threshold for IMU_FUSION_RESIDUAL_HOLD_US the
+ *     sources disagree and the SPI IMU is dropped (the YIS wins ties).
+ * Stale YIS frames, a stale, stuck or saturated SPI stream mark a source faulted;
+ * it must stay healthy for IMU_FUSION_RECOVER_US before it is used again.
+ *
+ * The output blends gyro and accel as w * YIS + (1 - w) * SPI; w slews toward
+ * IMU_FUSION_YIS_SHARE (both healthy), 1 or 0 over IMU_FUSION_BLEND_S, so a
+ * source change is a crossfade, not a jump. Roll is kept by integrating the
+ * fused rate from the last YIS roll while the YIS share is below 1. The other
+ * yis_imu_t fields are the last YIS ones. The output timestamp is the
+ * measurement time (blended, never going backwards), not a header arrival.
+ *
+ * All times are STM ticks; one instance, one writer context.
+ */
+#define IMU_FUSION_HISTORY          (64u)       /* SPI samples kept, power of two */
+#define IMU_FUSION_LAG_STEPS        (24u)       /* lag candidates, one SPI period apart */
+#define IMU_FUSION_WINDOW_MAX       (20u)       /* SPI samples averaged per YIS frame */
+
+#define IMU_FUSION_YIS_STALE_US     (25000u)
+#define IMU_FUSION_SPI_STALE_US     (20000u)   /* samples come in FIFO batches, 5 ms apart */
+#define IMU_FUSION_STUCK_SAMPLES    (50u)       /* bit-identical SPI samples in a row */
+#define IMU_FUSION_GYRO_RESIDUAL    (8.0f)      /* deg/s, low-passed */
+#define IMU_FUSION_ACC_RESIDUAL     (2.5f)      /* m/s^2, low-passed */
+#define IMU_FUSION_RESIDUAL_TAU_S   (0.05f)
+#define IMU_FUSION_RESIDUAL_HOLD_US (100000u)
+#define IMU_FUSION_RECOVER_US       (500000u)
+#define IMU_FUSION_LAG_TAU_S        (2.0f)
+#define IMU_FUSION_OFFSET_TAU_S     (2.0f)
+#define IMU_FUSION_BLEND_S          (0.05f)     /* full crossfade */
+#define IMU_FUSION_YIS_SHARE        (1.0f)      /* YIS weight while both are healthy */
+
+/* imu_fusion_status_t.yis_faults / spi_faults */
+#define IMU_FUSION_FAULT_ABSENT     (0x01u)     /* never delivered */
+#define IMU_FUSION_FAULT_STALE      (0x02u)
+#define IMU_FUSION_FAULT_STUCK      (0x04u)
+#define IMU_FUSION_FAULT_SATURATED  (0x08u)
+#define IMU_FUSION_FAULT_RESIDUAL   (0x10u)     /* disagreed with the other source */
+
+typedef struct
+{
+    float gyro[3];                      /* deg/s, YIS axes */
+    float acc[3];                       /* m/s^2, YIS axes */
+    uint32 timestamp;
+} imu_fusion_spi_sample_t;
+
+typedef struct
+{
+    uint8  yis_faults;                  /* IMU_FUSION_FAULT_xxx, 0 = in use or usable */
+    uint8  spi_faults;
+    float  yis_share;                   /* current w */
+    uint32 lag_us;                      /* YIS header arrival - measurement */
+    float  gyro_residual;               /* deg/s */
+    float  acc_residual;                /* m/s^2 */
+    float  gyro_offset[3];              /* SPI - YIS */
+    uint32 switches;                    /* changes of the w target */
+} imu_fusion_status_t;
+
+typedef struct
+{
+    uint32 ticks_per_us;
+
+    imu_fusion_spi_sample_t history[IMU_FUSION_HISTORY];
+    uint32 spi_count;                   /* free running */
+    uint32 spi_period;                  /* ticks, nominal */
+    uint32 spi_stuck_run;
+    uint32 spi_saturated_time;
+    uint8  spi_saturated;
+    float  spi_sum_gyro[3];             /* since the last output */
+    float  spi_sum_acc[3];
+    uint32 spi_sum_count;
+
+    yis_imu_t yis;                      /* last YIS frame */
+    uint32 yis_count;
+    uint32 yis_period;                  /* ticks, from frame spacing */
+    uint8  yis_new;                     /* frame since the last output */
+    uint8  yis_pending;                 /* frame waiting for the SPI samples up to its header */
+
+    float  lag_score[IMU_FUSION_LAG_STEPS];
+    uint32 lag;                         /* SPI periods to the end of the matching window */
+    uint32 window;                      /* SPI samples per YIS frame interval */
+    float  gyro_offset[3];
+    float  acc_offset[3];
+    float  gyro_residual;
+    float  acc_residual;
+    uint32 residual_since;
+    uint8  residual_high;
+
+    uint8  yis_faults;
+    uint8  spi_faults;
+    uint32 yis_healthy_since;
+    uint32 spi_healthy_since;
+    uint8  yis_usable;
+    uint8  spi_usable;
+
+    float  share;
+    float  share_target;
+    float  roll;                        /* deg, integrated while the SPI share is > 0 */
+    uint32 output_time;
+    uint32 output_timestamp;
+    uint16 output_count;
+    uint8  output_seen;
+    uint32 switches;
+} imu_fusion_t;
+
+void  imu_fusion_init       (imu_fusion_t *fusion, uint32 ticks_per_us, uint32 spi_period_us);
+
+/* One SPI sample already mapped to YIS axes and units; saturated when any raw axis hit full scale */
+void  imu_fusion_push_spi   (imu_fusion_t *fusion, const float gyro[3], const float acc[3], uint32 timestamp, uint8 saturated);
+
+/* One new YIS frame (timestamp = header arrival) */
+void  imu_fusion_push_yis   (imu_fusion_t *fusion, const yis_imu_t *sample);
+
+/* Build the fused sample at now. Returns 0 when there is nothing new to publish:
+ * no usable source, or YIS only and no frame since the last output. */
+uint8 imu_fusion_output     (imu_fusion_t *fusion, uint32 now, yis_imu_t *out);
+
+void  imu_fusion_get_status (const imu_fusion_t *fusion, imu_fusion_status_t *status);
+
+#endif
@@ -0,0 +1,382 @@
+/* mag_calibration.c */
+#include "mag_calibration.h"
+
+#define MAG_RAD2DEG                 (57.29577951f)
+#define MAG_TERMS                   (9u)
+#define MAG_JACOBI_SWEEPS           (12u)
+#define MAG_PIVOT_MIN               (1e-12)     /* relative to the largest diagonal */
+#define MAG_FORWARD_VERTICAL        (0.9f)      /* |up . x| above: heading undefined */
+
+/* index of (row, col), row <= col, in the packed upper triangle */
+static inline uint32 tri(uint32 row, uint32 col)
+{
+    return row * MAG_TERMS - (row * (row + 1u)) / 2u + col;
+}
+
+void mag_calibration_identity(mag_calibration_t *cal, float field)
+{
+    memset(cal, 0, sizeof(*cal));
+    cal->soft_iron[0][0] = 1.0f;
+    cal->soft_iron[1][1] = 1.0f;
+    cal->soft_iron[2][2] = 1.0f;
+    cal->field = field;
+}
+
+void mag_fit_reset(mag_fit_t *fit)
+{
+    memset(fit, 0, sizeof(*fit));
+}
+
+void mag_fit_add(mag_fit_t *fit, const float mag[3])
+{
+    double x, y, z, r[MAG_TERMS];
+    uint32 i, j, k = 0;
+
+    if (fit->count == 0u)
+    {
+        float norm = sqrtf(mag[0] * mag[0] + mag[1] * mag[1] + mag[2] * mag[2]);
+
+        if (norm <= 0.0f)
+        {
+            return;
+        }
+        fit->scale = 1.0f / norm;
+    }
+
+    x = (double)(mag[0] * fit->scale);
+    y = (double)(mag[1] * fit->scale);
+    z = (double)(mag[2] * fit->scale);
+    r[0] = x * x;
+    r[1] = y * y;
+    r[2] = z * z;
+    r[3] = 2.0 * x * y;
+    r[4] = 2.0 * x * z;
+    r[5] = 2.0 * y * z;
+    r[6] = 2.0 * x;
+    r[7] = 2.0 * y;
+    r[8] = 2.0 * z;
+
+    for (i = 0; i < MAG_TERMS; i++)
+    {
+        for (j = i; j < MAG_TERMS; j++)
+        {
+            fit->ata[k++] += r[i] * r[j];
+        }
+        fit->atb[i] += r[i];
+    }
+    fit->count++;
+}
+
+/* Symmetric 3 x 3: eigenvalues in value, eigenvectors in the columns of vector */
+static void jacobi3(const double m[3][3], double value[3], double vector[3][3])
+{
+    double a[3][3];
+    uint32 sweep, p, q, k;
+
+    memcpy(a, m, sizeof(a));
+    memset(vector, 0, sizeof(double) * 9u);
+    vector[0][0] = vector[1][1] = vector[2][2] = 1.0;
+
+    for (sweep = 0; sweep < MAG_JACOBI_SWEEPS; sweep++)
+    {
+        double off = a[0][1] * a[0][1] + a[0][2] * a[0][2] + a[1][2] * a[1][2];
+
+        if (off < 1e-30)
+        {
+            break;
+        }
+        for (p = 0; p < 2u; p++)
+        {
+            for (q = p + 1u; q < 3u; q++)
+            {
+                double theta, t, c, s, apk, aqk;
+
+                if (a[p][q] == 0.0)
+                {
+                    continue;
+                }
+                theta = (a[q][q] - a[p][p]) / (2.0 * a[p][q]);
+                t = (theta >= 0.0 ? 1.0 : -1.0) / (fabs(theta) + sqrt(theta * theta + 1.0));
+                c = 1.0 / sqrt(t * t + 1.0);
+                s = t * c;
+                for (k = 0; k < 3u; k++)
+                {
+                    apk = a[p][k];
+                    aqk = a[q][k];
+                    a[p][k] = c * apk - s * aqk;
+                    a[q][k] = s * apk + c * aqk;
+                }
+                for (k = 0; k < 3u; k++)
+                {
+                    apk = a[k][p];
+                    aqk = a[k][q];
+                    a[k][p] = c * apk - s * aqk;
+                    a[k][q] = s * apk + c * aqk;
+                }
+                for (k = 0; k < 3u; k++)
+                {
+                    apk = vector[k][p];
+                    aqk = vector[k][q];
+                    vector[k][p] = c * apk - s * aqk;
+                    vector[k][q] = s * apk + c * aqk;
+                }
+            }
+        }
+    }
+    value[0] = a[0][0];
+    value[1] = a[1][1];
+    value[2] = a[2][2];
+}
+
+/* Gaussian elimination with partial pivoting on a copy; 0 when near singular */
+static uint8 solve9(const mag_fit_t *fit, double p[MAG_TERMS])
+{
+    double a[MAG_TERMS][MAG_TERMS + 1u];
+    double largest = 0.0, factor, tmp;
+    uint32 i, j, k, pivot;
+
+    for (i = 0; i < MAG_TERMS; i++)
+    {
+        for (j = 0; j < MAG_TERMS; j++)
+        {
+            a[i][j] = (i <= j) ? fit->ata[tri(i, j)] : fit->ata[tri(j, i)];
+        }
+        a[i][MAG_TERMS] = fit->atb[i];
+        largest = (a[i][i] > largest) ? a[i][i] : largest;
+    }
+
+    for (k = 0; k < MAG_TERMS; k++)
+    {
+        pivot = k;
+        for (i = k + 1u; i < MAG_TERMS; i++)
+        {
+            if (fabs(a[i][k]) > fabs(a[pivot][k]))
+            {
+                pivot = i;
+            }
+        }
+        if (fabs(a[pivot][k]) <= largest * MAG_PIVOT_MIN)
+        {
+            return 0;
+        }
+        if (pivot != k)
+        {
+            for (j = k; j <= MAG_TERMS; j++)
+            {
+                tmp = a[k][j];
+                a[k][j] = a[pivot][j];
+                a[pivot][j] = tmp;
+            }
+        }
+        for (i = k + 1u; i < MAG_TERMS; i++)
+        {
+            factor = a[i][k] / a[k][k];
+            for (j = k; j <= MAG_TERMS; j++)
+            {
+                a[i][j] -= factor * a[k][j];
+            }
+        }
+    }
+
+    for (k = MAG_TERMS; k-- > 0u;)
+    {
+        tmp = a[k][MAG_TERMS];
+        for (j = k + 1u; j < MAG_TERMS; j++)
+        {
+            tmp -= a[k][j] * p[j];
+        }
+        p[k] = tmp / a[k][k];
+    }
+    return 1;
+}
+
+/* Spread of the samples: smallest / largest standard deviation over all directions */
+static double fit_coverage(const mag_fit_t *fit)
+{
+    double cov[3][3], mean[3], value[3], vector[3][3], n = (double)fit->count;
+    double smallest, largest;
+    uint32 i, j;
+
+    for (i = 0; i < 3u; i++)
+    {
+        mean[i] = fit->atb[6u + i] / (2.0 * n);
+    }
+    for (i = 0; i < 3u; i++)
+    {
+        for (j = i; j < 3u; j++)
+        {
+            cov[i][j] = fit->ata[tri(6u + i, 6u + j)] / (4.0 * n) - mean[i] * mean[j];
+            cov[j][i] = cov[i][j];
+        }
+    }
+    jacobi3(cov, value, vector);
+    smallest = value[0];
+    largest = value[0];
+    for (i = 1; i < 3u; i++)
+    {
+        smallest = (value[i] < smallest) ? value[i] : smallest;
+        largest = (value[i] > largest) ? value[i] : largest;
+    }
+    return (largest > 0.0 && smallest > 0.0) ? sqrt(smallest / largest) : 0.0;
+}
+
+mag_fit_result_enum mag_fit_solve(const mag_fit_t *fit, mag_calibration_t *cal, float *residual)
+{
+    double p[MAG_TERMS], m[3][3], inv[3][3], centre[3], value[3], vector[3][3], root[3];
+    double det, k, sum, radius;
+    uint32 i, j, l;
+
+    if (residual != NULL)
+    {
+        *residual = 0.0f;
+    }
+    if (fit->count < MAG_FIT_SAMPLES_MIN)
+    {
+        return MAG_FIT_TOO_FEW;
+    }
+    if (fit_coverage(fit) < MAG_FIT_COVERAGE_MIN || !solve9(fit, p))
+    {
+        return MAG_FIT_SINGULAR;
+    }
+
+    /* algebraic residual from the sums: p'Ap - 2p'b + n */
+    sum = (double)fit->count;
+    for (i = 0; i < MAG_TERMS; i++)
+    {
+        sum -= 2.0 * p[i] * fit->atb[i];
+        for (j = 0; j < MAG_TERMS; j++)
+        {
+            sum += p[i] * p[j] * ((i <= j) ? fit->ata[tri(i, j)] : fit->ata[tri(j, i)]);
+        }
+    }
+    sum = sqrt((sum > 0.0 ? sum : 0.0) / (double)fit->count);
+    if (residual != NULL)
+    {
+        *residual = (float)sum;
+    }
+
+    m[0][0] = p[0]; m[0][1] = p[3]; m[0][2] = p[4];
+    m[1][0] = p[3]; m[1][1] = p[1]; m[1][2] = p[5];
+    m[2][0] = p[4]; m[2][1] = p[5]; m[2][2] = p[2];
+
+    /* centre = -A^-1 v */
+    inv[0][0] = m[1][1] * m[2][2] - m[1][2] * m[2][1];
+    inv[0][1] = m[0][2] * m[2][1] - m[0][1] * m[2][2];
+    inv[0][2] = m[0][1] * m[1][2] - m[0][2] * m[1][1];
+    inv[1][0] = inv[0][1];
+    inv[1][1] = m[0][0] * m[2][2] - m[0][2] * m[2][0];
+    inv[1][2] = m[0][2] * m[1][0] - m[0][0] * m[1][2];
+    inv[2][0] = inv[0][2];
+    inv[2][1] = inv[1][2];
+    inv[2][2] = m[0][0] * m[1][1] - m[0][1] * m[1][0];
+    det = m[0][0] * inv[0][0] + m[0][1] * inv[1][0] + m[0][2] * inv[2][0];
+    if (fabs(det) < 1e-30)
+    {
+        return MAG_FIT_NOT_ELLIPSOID;
+    }
+    for (i = 0; i < 3u; i++)
+    {
+        centre[i] = -(inv[i][0] * p[6] + inv[i][1] * p[7] + inv[i][2] * p[8]) / det;
+    }
+
+    /* (x - c)' A (x - c) = 1 + c' A c */
+    k = 1.0;
+    for (i = 0; i < 3u; i++)
+    {
+        for (j = 0; j < 3u; j++)
+        {
+            k += centre[i] * m[i][j] * centre[j];
+        }
+    }
+    jacobi3(m, value, vector);
+    for (i = 0; i < 3u; i++)
+    {
+        value[i] /= k;
+        if (!(value[i] > 0.0))
+        {
+            return MAG_FIT_NOT_ELLIPSOID;
+        }
+    }
+
+    /* sqrt(M) scaled to the geometric mean radius keeps the field strength */
+    radius = pow(value[0] * value[1] * value[2], -1.0 / 6.0);
+    for (i = 0; i < 3u; i++)
+    {
+        root[i] = sqrt(value[i]) * radius;
+    }
+    {
+        double smallest = root[0], largest = root[0];
+
+        for (i = 1; i < 3u; i++)
+        {
+            smallest = (root[i] < smallest) ? root[i] : smallest;
+            largest = (root[i] > largest) ? root[i] : largest;
+        }
+        if (largest > smallest * MAG_FIT_AXIS_RATIO_MAX || sum > MAG_FIT_RESIDUAL_MAX)
+        {
+            return MAG_FIT_DISTORTED;
+        }
+    }
+
+    for (i = 0; i < 3u; i++)
+    {
+        cal->hard_iron[i] = (float)(centre[i] / fit->scale);
+        for (j = 0; j < 3u; j++)
+        {
+            double w = 0.0;
+
+            for (l = 0; l < 3u; l++)
+            {
+                w += vector[i][l] * root[l] * vector[j][l];
+            }
+            cal->soft_iron[i][j] = (float)w;
+        }
+    }
+    cal->field = (float)(radius / fit->scale);
+    return MAG_FIT_OK;
+}
+
+void mag_calibration_apply(const mag_calibration_t *cal, const float raw[3], float corrected[3])
+{
+    float x = raw[0] - cal->hard_iron[0];
+    float y = raw[1] - cal->hard_iron[1];
+    float z = raw[2] - cal->hard_iron[2];
+
+    corrected[0] = cal->soft_iron[0][0] * x + cal->soft_iron[0][1] * y + cal->soft_iron[0][2] * z;
+    corrected[1] = cal->soft_iron[1][0] * x + cal->soft_iron[1][1] * y + cal->soft_iron[1][2] * z;
+    corrected[2] = cal->soft_iron[2][0] * x + cal->soft_iron[2][1] * y + cal->soft_iron[2][2] * z;
+}
+
+/* heading = atan2(-((m x f) . u), m_h . f_h) with f = body x, u = up */
+void mag_heading(const mag_calibration_t *cal, const float raw[3], const float acc[3], mag_heading_t *out)
+{
+    float m[3], u[3], norm, m_up, across, along, field;
+
+    mag_calibration_apply(cal, raw, m);
+    field = sqrtf(m[0] * m[0] + m[1] * m[1] + m[2] * m[2]);
+    out->field_ratio = (cal->field > 0.0f) ? field / cal->field : 0.0f;
+
+    norm = sqrtf(acc[0] * acc[0] + acc[1] * acc[1] + acc[2] * acc[2]);
+    if (norm <= 0.0f)
+    {
+        out->valid = 0;
+        return;
+    }
+    norm = 1.0f / norm;
+    u[0] = acc[0] * norm;
+    u[1] = acc[1] * norm;
+    u[2] = acc[2] * norm;
+
+    m_up = m[0] * u[0] + m[1] * u[1] + m[2] * u[2];
+    across = m[1] * u[2] - m[2] * u[1];
+    along = m[0] - m_up * u[0];
+    out->heading_deg = atan2f(across, along) * MAG_RAD2DEG;
+    if (out->heading_deg < 0.0f)
+    {
+        out->heading_deg += 360.0f;
+    }
+
+    out->valid = (cal->field > 0.0f)
+              && fabsf(u[0]) < MAG_FORWARD_VERTICAL
+              && fabsf(out->field_ratio - 1.0f) <= MAG_FIELD_TOLERANCE;
+}
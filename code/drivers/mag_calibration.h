@@ -0,0 +1,80 @@
+/* mag_calibration.h */
+#ifndef MAG_CALIBRATION_H
+#define MAG_CALIBRATION_H
+
+#include "zf_common_headfile.h"
+
+/* Magnetometer hard / soft iron calibration and tilt-compensated heading,
+ * hardware independent so it also builds on the host
+ * (tools/sim/mag_calibration_check.c).
+ *
+ * Fit: the raw samples of a distorted field lie on an ellipsoid
+ *   a x^2 + b y^2 + c z^2 + 2d xy + 2e xz + 2f yz + 2g x + 2h y + 2i z = 1.
+ * Every sample adds its 9 term row to the normal equations of that least
+ * squares problem (45 + 9 sums and a count), so memory stays fixed and no
+ * sample is kept. The sums are double: with an offset the size of the field
+ * the 4th order terms cancel far below float resolution. mag_fit_solve()
+ * eliminates the 9 x 9 system once, takes the centre as the hard iron offset
+ * and the symmetric square root of the normalised quadric matrix (3 x 3 Jacobi)
+ * as the soft iron matrix, scaled to keep the mean field strength:
+ *   corrected = soft_iron * (raw - hard_iron)
+ * lies on a sphere of radius field. The fit is refused with too few samples,
+ * too little spread (smallest / largest standard deviation of the samples over
+ * all directions below MAG_FIT_COVERAGE_MIN, also from the sums: yaw-only turns
+ * or the lean of a bike on its wheels leave the centre badly biased), a soft iron axis ratio above MAG_FIT_AXIS_RATIO_MAX or
+ * an algebraic residual above MAG_FIT_RESIDUAL_MAX.
+ *
+ * Heading: the accelerometer gives "up" (specific force at rest), the corrected
+ * field and the body x axis (forward) are projected onto the horizontal plane
+ * and heading is the clockwise angle from magnetic north to forward, 0..360 deg.
+ * Any right-handed sensor frame works as long as x points forward.
+ */
+#define MAG_FIT_SAMPLES_MIN         (200u)
+#define MAG_FIT_COVERAGE_MIN        (0.36)      /* turns with +-45 deg of pitch and roll pass, +-25 deg do not */
+#define MAG_FIT_AXIS_RATIO_MAX      (2.0f)      /* largest / smallest soft iron gain */
+#define MAG_FIT_RESIDUAL_MAX        (0.05f)     /* RMS of the ellipsoid equation */
+#define MAG_FIELD_TOLERANCE         (0.2f)      /* |corrected| off field by more: disturbed */
+
+typedef struct
+{
+    float hard_iron[3];                 /* raw units */
+    float soft_iron[3][3];              /* symmetric */
+    float field;                        /* mean field strength, raw units */
+} mag_calibration_t;
+
+typedef struct
+{
+    double ata[45];                     /* upper triangle of D^T D, row major */
+    double atb[9];                      /* D^T 1 */
+    float  scale;                       /* 1 / first sample norm, conditions the sums */
+    uint32 count;
+} mag_fit_t;
+
+typedef enum
+{
+    MAG_FIT_OK = 0,
+    MAG_FIT_TOO_FEW,
+    MAG_FIT_SINGULAR,                   /* not enough orientations */
+    MAG_FIT_NOT_ELLIPSOID,
+    MAG_FIT_DISTORTED,                  /* axis ratio or residual too large */
+} mag_fit_result_enum;
+
+typedef struct
+{
+    float heading_deg;                  /* 0..360, clockwise from magnetic north */
+    float field_ratio;                  /* |corrected| / field */
+    uint8 valid;                        /* calibrated, level enough and field within tolerance */
+} mag_heading_t;
+
+void  mag_calibration_identity  (mag_calibration_t *cal, float field);
+
+void  mag_fit_reset             (mag_fit_t *fit);
+void  mag_fit_add               (mag_fit_t *fit, const float mag[3]);
+mag_fit_result_enum mag_fit_solve (const mag_fit_t *fit, mag_calibration_t *cal, float *residual);
+
+void  mag_calibration_apply     (const mag_calibration_t *cal, const float raw[3], float corrected[3]);
+
+/* raw mag, acc in any unit (direction only); uncalibrated cal gives the raw heading */
+void  mag_heading               (const mag_calibration_t *cal, const float raw[3], const float acc[3], mag_heading_t *out);
+
+#endif
@@ -0,0 +1,108 @@
+/* odrive_cansimple.c */
+#include "odrive_cansimple.h"
+
+/* =========================
+ * Little endian payload helpers
+ * ========================= */
+static void put_u32(uint8 *p, uint32 v)
+{
+    p[0] = (uint8)(v);
+    p[1] = (uint8)(v >> 8);
+    p[2] = (uint8)(v >> 16);
+    p[3] = (uint8)(v >> 24);
+}
+
+static uint32 get_u32(const uint8 *p)
+{
+    return (uint32)p[0] | ((uint32)p[1] << 8) | ((uint32)p[2] << 16) | ((uint32)p[3] << 24);
+}
+
+static void put_f32(uint8 *p, float v)
+{
+    uint32 bits;
+    memcpy(&bits, &v, sizeof(bits));
+    put_u32(p, bits);
+}
+
+static float get_f32(const uint8 *p)
+{
+    uint32 bits = get_u32(p);
+    float v;
+    memcpy(&v, &bits, sizeof(v));
+    return v;
+}
+
+static void frame_begin(uint8 node_id, odrive_can_cmd_enum cmd, uint8 dlc, odrive_can_frame_t *frame)
+{
+    memset(frame, 0, sizeof(*frame));
+    frame->id = ODRIVE_CAN_ID(node_id, cmd);
+    frame->dlc = dlc;
+}
+
+/* =========================
+ * Encode
+ * ========================= */
+void odrive_can_pack_set_input_torque(uint8 node_id, float torque_nm, odrive_can_frame_t *frame)
+{
+    frame_begin(node_id, ODRIVE_CAN_CMD_SET_INPUT_TORQUE, 4u, frame);
+    put_f32(&frame->data[0], torque_nm);
+}
+
+void odrive_can_pack_set_controller_mode(uint8 node_id, uint32 control_mode, uint32 input_mode, odrive_can_frame_t *frame)
+{
+    frame_begin(node_id, ODRIVE_CAN_CMD_SET_CONTROLLER_MODE, 8u, frame);
+    put_u32(&frame->data[0], control_mode);
+    put_u32(&frame->data[4], input_mode);
+}
+
+void odrive_can_pack_set_axis_state(uint8 node_id, uint32 axis_state, odrive_can_frame_t *frame)
+{
+    frame_begin(node_id, ODRIVE_CAN_CMD_SET_AXIS_STATE, 4u, frame);
+    put_u32(&frame->data[0], axis_state);
+}
+
+void odrive_can_pack_command(uint8 node_id, odrive_can_cmd_enum cmd, odrive_can_frame_t *frame)
+{
+    frame_begin(node_id, cmd, 0u, frame);
+}
+
+void odrive_can_pack_request(uint8 node_id, odrive_can_cmd_enum cmd, odrive_can_frame_t *frame)
+{
+    /* ODrive answers a remote frame with the full payload, DLC must match the answer */
+    frame_begin(node_id, cmd, 8u, frame);
+    frame->rtr = 1u;
+}
+
+/* =========================
+ * Decode
+ * ========================= */
+uint8 odrive_can_decode(const odrive_can_frame_t *frame, uint8 node_id, odrive_can_feedback_t *feedback)
+{
+    uint8 cmd;
+
+    if (frame == NULL || feedback == NULL || frame->rtr || ODRIVE_CAN_NODE_OF(frame->id) != node_id)
+    {
+        return 0u;
+    }
+
+    cmd = ODRIVE_CAN_CMD_OF(frame->id);
+    switch (cmd)
+    {
+        case ODRIVE_CAN_CMD_GET_ENCODER_ESTIMATES:
+            if (frame->dlc < 8u) return 0u;
+            feedback->pos_turns = get_f32(&frame->data[0]);
+            feedback->vel_rps = get_f32(&frame->data[4]);
+            feedback->encoder_count++;
+            return cmd;
+
+        case ODRIVE_CAN_CMD_HEARTBEAT:
+            if (frame->dlc < 5u) return 0u;
+            feedback->axis_error = get_u32(&frame->data[0]);
+            feedback->axis_state = frame->data[4];
+            feedback->heartbeat_count++;
+            return cmd;
+
+        default:
+            return 0u;
+    }
+}
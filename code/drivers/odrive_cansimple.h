@@ -0,0 +1,65 @@
+/* odrive_cansimple.h */
+#ifndef ODRIVE_CANSIMPLE_H
+#define ODRIVE_CANSIMPLE_H
+
+#include "zf_common_headfile.h"
+
+/* ODrive CANSimple protocol (firmware 0.5.x), hardware independent so it also
+ * builds on the host (tools/sim/odrive_can_check.c).
+ *
+ * Standard 11-bit id = node_id << 5 | command, payload little endian.
+ * The ODrive must be configured for the bus and the cyclic feedback, e.g.
+ *   odrv0.can.config.baud_rate = 1000000
+ *   odrv0.axis0.config.can.node_id = 0
+ *   odrv0.axis0.config.can.encoder_rate_ms = 5      (one estimate per control tick)
+ *   odrv0.axis0.config.can.heartbeat_rate_ms = 100
+ */
+#define ODRIVE_CAN_ID(node_id, cmd)             ((((uint32)(node_id)) << 5) | (uint32)(cmd))
+#define ODRIVE_CAN_NODE_OF(id)                  ((uint8)(((id) >> 5) & 0x3Fu))
+#define ODRIVE_CAN_CMD_OF(id)                   ((uint8)((id) & 0x1Fu))
+
+typedef enum
+{
+    ODRIVE_CAN_CMD_HEARTBEAT                = 0x001,
+    ODRIVE_CAN_CMD_ESTOP                    = 0x002,
+    ODRIVE_CAN_CMD_SET_AXIS_STATE           = 0x007,
+    ODRIVE_CAN_CMD_GET_ENCODER_ESTIMATES    = 0x009,
+    ODRIVE_CAN_CMD_SET_CONTROLLER_MODE      = 0x00B,
+    ODRIVE_CAN_CMD_SET_INPUT_TORQUE         = 0x00E,
+    ODRIVE_CAN_CMD_CLEAR_ERRORS             = 0x018,
+} odrive_can_cmd_enum;
+
+#define ODRIVE_AXIS_STATE_IDLE                  (1u)
+#define ODRIVE_AXIS_STATE_CLOSED_LOOP_CONTROL   (8u)
+#define ODRIVE_CONTROL_MODE_TORQUE_CONTROL      (1u)
+#define ODRIVE_INPUT_MODE_PASSTHROUGH           (1u)
+
+typedef struct
+{
+    uint32 id;                      /* standard identifier */
+    uint8  dlc;
+    uint8  rtr;                     /* remote request */
+    uint8  data[8];
+} odrive_can_frame_t;
+
+typedef struct
+{
+    float  pos_turns;               /* Get_Encoder_Estimates */
+    float  vel_rps;
+    uint32 encoder_count;           /* estimate frames decoded */
+    uint32 axis_error;              /* Heartbeat */
+    uint8  axis_state;
+    uint32 heartbeat_count;
+} odrive_can_feedback_t;
+
+void   odrive_can_pack_set_input_torque     (uint8 node_id, float torque_nm, odrive_can_frame_t *frame);
+void   odrive_can_pack_set_controller_mode  (uint8 node_id, uint32 control_mode, uint32 input_mode, odrive_can_frame_t *frame);
+void   odrive_can_pack_set_axis_state       (uint8 node_id, uint32 axis_state, odrive_can_frame_t *frame);
+void   odrive_can_pack_command              (uint8 node_id, odrive_can_cmd_enum cmd, odrive_can_frame_t *frame);    /* no payload: estop, clear errors */
+void   odrive_can_pack_request              (uint8 node_id, odrive_can_cmd_enum cmd, odrive_can_frame_t *frame);    /* remote request for a Get_* message */
+
+/* Updates feedback from a frame addressed by node_id.
+ * Returns the decoded command, 0 for frames of other nodes / commands / short payloads. */
+uint8  odrive_can_decode                    (const odrive_can_frame_t *frame, uint8 node_id, odrive_can_feedback_t *feedback);
+
+#endif
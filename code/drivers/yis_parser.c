@@ -0,0 +1,283 @@
+/* yis_parser.c */
+#include <stddef.h>
+
+#include "yis_parser.h"
+
+#define YIS_LEN_OFFSET          (YIS_FRAME_HEAD_SIZE - 1u)
+
+/* One row per data ID: count values of width bytes (little endian, two's complement)
+ * land at offset in yis_imu_t, floats scaled. int32 float rows are vectors of 3 or 4,
+ * int16 rows a single float, other rows a single uint32. */
+typedef struct
+{
+    uint16 field;                       /* YIS_FIELD_xxx */
+    uint8  offset;
+    uint8  count;
+    uint8  width;
+    uint8  is_float;
+    float  scale;
+} yis_field_t;
+
+static const yis_field_t yis_fields[] =
+{
+    {YIS_FIELD_TEMPERATURE, offsetof(yis_imu_t, temperature),    1, 2, 1, 0.01f},
+    {YIS_FIELD_ACC,         offsetof(yis_imu_t, ax),             3, 4, 1, 0.000001f},
+    {YIS_FIELD_GYRO,        offsetof(yis_imu_t, wx),             3, 4, 1, 0.000001f},
+    {YIS_FIELD_MAG,         offsetof(yis_imu_t, mx),             3, 4, 1, 0.001f},
+    {YIS_FIELD_EULER,       offsetof(yis_imu_t, pitch),          3, 4, 1, 0.000001f},
+    {YIS_FIELD_QUATERNION,  offsetof(yis_imu_t, q0),             4, 4, 1, 0.000001f},
+    {YIS_FIELD_SAMPLE_TIME, offsetof(yis_imu_t, sample_time_us), 1, 4, 0, 1.0f},
+};
+
+/* data ID -> row + 1, 0 = not decoded */
+static const uint8 yis_field_index[256] =
+{
+    [0x01] = 1,                         /* temperature, int16 x 0.01 degC */
+    [0x10] = 2,                         /* acceleration, int32 x 1e-6 m/s^2 */
+    [0x20] = 3,                         /* angular rate, int32 x 1e-6 deg/s */
+    [0x31] = 4,                         /* raw magnetic field, int32 x 1e-3 mGauss */
+    [0x40] = 5,                         /* euler angles pitch, roll, yaw, int32 x 1e-6 deg */
+    [0x41] = 6,                         /* quaternion q0..q3, int32 x 1e-6 */
+    [0x51] = 7,                         /* sample timestamp, uint32 us */
+};
+
+/* byte loads only, the payload has no alignment */
+static inline int32 yis_load(const uint8 *p)
+{
+    return (int32)((uint32)p[3] << 24 | (uint32)p[2] << 16 | (uint32)p[1] << 8 | (uint32)p[0]);
+}
+
+uint16 yis_checksum(const uint8 *data, uint32 length)
+{
+    /* four bytes per step: CK2 gains 4 * CK1 plus the bytes weighted 4, 3, 2, 1;
+       only the low 8 bits count, so 32 bit accumulators can wrap freely */
+    uint32 ck1 = 0u, ck2 = 0u;
+
+    while (length >= 4u)
+    {
+        uint32 b0 = data[0], b1 = data[1], b2 = data[2], b3 = data[3];
+
+        ck2 += (ck1 << 2) + (b0 << 2) + 3u * b1 + (b2 << 1) + b3;
+        ck1 += b0 + b1 + b2 + b3;
+        data += 4;
+        length -= 4u;
+    }
+    while (length--)
+    {
+        ck1 += *data++;
+        ck2 += ck1;
+    }
+    return (uint16)((ck1 & 0xFFu) | ((ck2 & 0xFFu) << 8));
+}
+
+/* TID bookkeeping: a frame that arrives after a gap accounts for the ones in between */
+static void yis_track_sequence(yis_parser_t *parser, uint16 tid)
+{
+    uint16 gap = (uint16)(tid - parser->sample.tid - 1u);
+
+    if (parser->frames == 0u)
+    {
+        return;
+    }
+    if (gap < YIS_TID_MAX_GAP)
+    {
+        parser->dropped += gap;
+    }
+    else
+    {
+        parser->sequence_resets++;
+    }
+}
+
+void yis_decode_payload(const uint8 *payload, uint32 length, yis_imu_t *sample)
+{
+    uint32 pos = 0;
+
+    sample->fields = 0;
+    /* at least data_id + sub_len */
+    while (length - pos >= 2u)
+    {
+        uint8 index = yis_field_index[payload[pos]];
+        uint8 sub_len = payload[pos + 1u];
+        const uint8 *data = &payload[pos + 2u];
+        const yis_field_t *field;
+        uint8 *dst;
+
+        pos += 2u;
+        if (length - pos < sub_len)
+        {
+            break;                              /* truncated field: drop the rest of the frame */
+        }
+        pos += sub_len;
+
+        if (index == 0u)
+        {
+            continue;
+        }
+        field = &yis_fields[index - 1u];
+        if (sub_len < field->count * field->width)
+        {
+            continue;
+        }
+
+        dst = (uint8 *)sample + field->offset;
+        if (field->width == 2u)
+        {
+            *(float *)dst = (float)(int16)((uint16)data[1] << 8 | data[0]) * field->scale;
+        }
+        else if (field->is_float)
+        {
+            float *value = (float *)dst;
+            float scale = field->scale;
+
+            value[0] = (float)yis_load(data) * scale;       /* every int32 float row is a vector of 3 or 4 */
+            value[1] = (float)yis_load(data + 4) * scale;
+            value[2] = (float)yis_load(data + 8) * scale;
+            if (field->count == 4u)
+            {
+                value[3] = (float)yis_load(data + 12) * scale;
+            }
+        }
+        else
+        {
+            *(uint32 *)dst = (uint32)yis_load(data);
+        }
+        sample->fields |= field->field;
+    }
+}
+
+uint32 yis_build_command(uint8 *frame, uint8 cmd_class, uint8 cmd_id, const uint8 *param, uint8 length)
+{
+    uint16 ck;
+
+    frame[0] = YIS_HEADER_1;
+    frame[1] = YIS_HEADER_2;
+    frame[2] = cmd_class;
+    frame[3] = cmd_id;
+    frame[4] = length;
+    memcpy(&frame[YIS_FRAME_HEAD_SIZE], param, length);
+    ck = yis_checksum(frame + 2, length + 3u);
+    frame[YIS_FRAME_HEAD_SIZE + length] = (uint8)ck;
+    frame[YIS_FRAME_HEAD_SIZE + length + 1u] = (uint8)(ck >> 8);
+    return length + YIS_FRAME_OVERHEAD;
+}
+
+void yis_parser_init(yis_parser_t *parser, const uint8 *buffer, uint32 size)
+{
+    memset(parser, 0, sizeof(*parser));
+    parser->buffer = buffer;
+    parser->mask = size - 1u;
+}
+
+void yis_parser_set_byte_time(yis_parser_t *parser, uint32 byte_ticks)
+{
+    parser->byte_ticks = byte_ticks;
+}
+
+uint32 yis_parser_process(yis_parser_t *parser, uint32 write, uint32 now, yis_sample_callback_t callback)
+{
+    const uint8 *buffer = parser->buffer;
+    uint32 size = parser->mask + 1u;
+    uint32 read = parser->read;
+    uint32 expected;
+
+    while (write - read >= 2u)
+    {
+        uint32 available = write - read;
+        uint32 offset = read & parser->mask;
+        uint32 length, total;
+        const uint8 *frame;
+        uint16 tid;
+
+        if (buffer[offset] != YIS_HEADER_1 || buffer[(read + 1u) & parser->mask] != YIS_HEADER_2)
+        {
+            /* jump to the next candidate header within the contiguous part */
+            uint32 run = size - offset;
+            const uint8 *hit;
+
+            if (run > available - 1u)
+            {
+                run = available - 1u;
+            }
+            hit = (const uint8 *)memchr(&buffer[offset + 1u], YIS_HEADER_1, run - 1u);
+            run = (hit != NULL) ? (uint32)(hit - &buffer[offset]) : run;
+            read += run;
+            parser->skipped_bytes += run;
+            continue;
+        }
+
+        if (available <= YIS_LEN_OFFSET)
+        {
+            break;
+        }
+
+        length = buffer[(read + YIS_LEN_OFFSET) & parser->mask];
+        if (length < YIS_MIN_PAYLOAD_LEN || length > YIS_MAX_PAYLOAD_LEN)
+        {
+            read++;
+            parser->skipped_bytes++;
+            parser->bad_length++;
+            continue;
+        }
+
+        total = length + YIS_FRAME_OVERHEAD;
+        if (available < total)
+        {
+            break;
+        }
+
+        if (offset + total <= size)
+        {
+            frame = &buffer[offset];
+        }
+        else
+        {
+            uint32 first = size - offset;       /* frame wraps: one copy per lap of the ring */
+
+            memcpy(parser->scratch, &buffer[offset], first);
+            memcpy(parser->scratch + first, buffer, total - first);
+            frame = parser->scratch;
+        }
+
+        if (yis_checksum(frame + 2, length + 3u) != (uint16)(frame[total - 2u] | (frame[total - 1u] << 8)))
+        {
+            read++;                             /* corrupted, or a header lookalike inside a payload */
+            parser->skipped_bytes++;
+            parser->bad_checksum++;
+            continue;
+        }
+
+        tid = (uint16)(frame[2] | (frame[3] << 8));
+        yis_track_sequence(parser, tid);
+        parser->sample.tid = tid;
+        parser->sample.timestamp = now - (write - 1u - read) * parser->byte_ticks;
+
+        yis_decode_payload(frame + YIS_FRAME_HEAD_SIZE, length, &parser->sample);
+        read += total;
+        parser->frame_size = total;
+        parser->frames++;
+        if (callback != NULL)
+        {
+            callback(&parser->sample);
+        }
+    }
+
+    /* a single trailing byte can only matter if it starts a header */
+    if (write - read == 1u && buffer[read & parser->mask] != YIS_HEADER_1)
+    {
+        read++;
+        parser->skipped_bytes++;
+    }
+    parser->read = read;
+
+    /* bytes still missing: the pending frame once its LEN is known, else a frame of the last size */
+    if (write - read > YIS_LEN_OFFSET)
+    {
+        expected = buffer[(read + YIS_LEN_OFFSET) & parser->mask] + YIS_FRAME_OVERHEAD;
+    }
+    else
+    {
+        expected = (parser->frame_size != 0u) ? parser->frame_size : YIS_FRAME_HEAD_SIZE;
+    }
+    return (expected > write - read) ? (expected - (write - read)) : 1u;
+}
@@ -0,0 +1,80 @@
+/* yis_parser.h */
+#ifndef YIS_PARSER_H
+#define YIS_PARSER_H
+
+#include "zf_common_headfile.h"
+#include "driver_imu.h"
+
+/* YIS frame parser working in place on a receive ring, hardware independent so it
+ * also builds on the host (tools/sim/yis_parse_bench.c).
+ *
+ * Frame: 0x59 0x53 | TID (2) | LEN (1) | LEN payload bytes (TLV: id, len, data) | CK1 CK2
+ *
+ * The ring is the DMA destination buffer: the writer only advances a free-running
+ * byte count, yis_parser_process() scans everything up to it in one go, decodes
+ * every complete frame straight out of the ring and hands the sample to the
+ * callback. Only a frame that wraps around the end of the ring is first copied to
+ * a scratch buffer (once per lap). Bytes in front of a header are skipped, a bad
+ * LEN or a checksum mismatch drops the header and the scan restarts one byte later.
+ *
+ * CK1/CK2 is an 8 bit Fletcher sum over TID, LEN and payload (CK1 += b, CK2 += CK1).
+ * TID counts frames on the module side; gaps in it are counted as dropped frames,
+ * whatever lost them (line errors, cut frames, checksum failures, ring overrun).
+ *
+ * Each sample is stamped with the time its header byte arrived. The producer passes
+ * the time at which the byte just before write arrived; bytes are assumed to arrive
+ * back to back, so every earlier byte is dated byte_ticks apart from there.
+ */
+#define YIS_HEADER_1            (0x59u)
+#define YIS_HEADER_2            (0x53u)
+#define YIS_FRAME_HEAD_SIZE     (5u)        /* header 2 + TID 2 + LEN 1: enough to know the frame size */
+#define YIS_FRAME_OVERHEAD      (7u)        /* header 2 + TID 2 + LEN 1 + checksum 2 */
+#define YIS_MAX_PAYLOAD_LEN     (128u)
+#define YIS_MIN_PAYLOAD_LEN     (1u)
+#define YIS_TID_MAX_GAP         (1000u)     /* larger TID jumps are a module restart or wrap, not losses */
+
+typedef void (*yis_sample_callback_t)(const yis_imu_t *sample);
+
+typedef struct
+{
+    const uint8 *buffer;
+    uint32 mask;                            /* ring size - 1, size is a power of two */
+    uint32 read;                            /* free-running index of the first unparsed byte */
+    uint32 frame_size;                      /* size of the last complete frame, 0 until the first one */
+    uint32 byte_ticks;                      /* timestamp ticks per byte on the line, 0 = stamp with now */
+
+    uint32 frames;                          /* frames that passed the checksum */
+    uint32 skipped_bytes;                   /* bytes outside any frame */
+    uint32 bad_length;                      /* headers dropped for an invalid LEN */
+    uint32 bad_checksum;                    /* headers dropped for a CK1/CK2 mismatch */
+    uint32 dropped;                         /* frames missing from the TID sequence */
+    uint32 sequence_resets;                 /* TID jumps beyond YIS_TID_MAX_GAP */
+
+    yis_imu_t sample;                       /* fields keep their value until a frame carries them */
+
+    uint8  scratch[YIS_MAX_PAYLOAD_LEN + YIS_FRAME_OVERHEAD];
+} yis_parser_t;
+
+void   yis_parser_init      (yis_parser_t *parser, const uint8 *buffer, uint32 size);
+void   yis_parser_set_byte_time (yis_parser_t *parser, uint32 byte_ticks);
+
+/* Parse every complete frame in [read, write). write is the free-running count of
+ * bytes the producer has put into the ring, now the arrival time of byte write - 1.
+ * Returns how many more bytes are needed to complete the next frame, so the
+ * producer can wake the parser exactly then. */
+uint32 yis_parser_process   (yis_parser_t *parser, uint32 write, uint32 now, yis_sample_callback_t callback);
+
+/* CK1 | CK2 << 8 over length bytes (TID, LEN and payload of one frame) */
+uint16 yis_checksum         (const uint8 *data, uint32 length);
+
+/* Decode the TLV payload of one frame through the data ID table in yis_parser.c
+ * (temperature, acceleration, angular rate, magnetic field, euler, quaternion,
+ * sample time). sample->fields says which were present; the others keep their value. */
+void   yis_decode_payload   (const uint8 *payload, uint32 length, yis_imu_t *sample);
+
+/* Build a configuration command into frame (length + YIS_FRAME_OVERHEAD bytes):
+ * header, class, id, LEN, parameters, CK1 CK2. Commands share the data frame
+ * layout with class and id in place of the TID. Returns the frame size. */
+uint32 yis_build_command    (uint8 *frame, uint8 cmd_class, uint8 cmd_id, const uint8 *param, uint8 length);
+
+#endif
@@ -0,0 +1,406 @@
+/* flight_recorder.c */
+#include "flight_recorder.h"
+
+#if FLIGHT_RECORDER_ENABLE
+
+#include "multicore.h"
+#include "zf_driver_flash.h"
+#include "zf_driver_uart.h"
+#include "IfxStm.h"
+
+#define FLIGHT_RECORDER_HEADER_SIZE     (sizeof(flight_recorder_header_t))
+#define FLIGHT_RECORDER_RECORD_SIZE     (sizeof(flight_record_t))
+#define FLIGHT_RECORDER_STREAM_MAX      (FLIGHT_RECORDER_HEADER_SIZE + FLIGHT_RECORDER_RECORDS * FLIGHT_RECORDER_RECORD_SIZE + 4u)
+
+/* One uint32 per DFlash word, so a logical page holds EEPROM_PAGE_LENGTH * 4 bytes */
+#define FLIGHT_RECORDER_PAGE_BYTES      (EEPROM_PAGE_LENGTH * 4u)
+#define FLIGHT_RECORDER_FLASH_PAGES     ((FLIGHT_RECORDER_STREAM_MAX + FLIGHT_RECORDER_PAGE_BYTES - 1u) / FLIGHT_RECORDER_PAGE_BYTES)
+#define FLIGHT_RECORDER_FLASH_FIRST     (EEPROM_PAGE_NUM - FLIGHT_RECORDER_FLASH_PAGES)
+
+/* Debug UART chunk per flight_recorder_task() call, bounded by the free TX ring space */
+#define FLIGHT_RECORDER_DUMP_CHUNK      (256u)
+
+typedef char flight_record_size_check[(sizeof(flight_record_t) == 40u) ? 1 : -1];
+typedef char flight_header_size_check[(sizeof(flight_recorder_header_t) == 32u) ? 1 : -1];
+
+typedef enum
+{
+    DUMP_IDLE = 0,
+    DUMP_RAM,
+    DUMP_FLASH,
+} dump_source_enum;
+
+/* =========================
+ * Ring (LMU RAM, written by CPU0, read by CORE_TELEMETRY once frozen)
+ * ========================= */
+#pragma section all "lmubss"
+static flight_record_t record_storage[FLIGHT_RECORDER_RECORDS];
+#pragma section all restore
+
+static flight_record_t *ring;                           /* uncached alias, NULL until init */
+static uint32 tick_hz = 100000000u;
+
+/* recording state: written by the 5 ms ISR, except rearm of a frozen ring */
+static volatile uint8  state = FLIGHT_RECORDER_RECORDING;
+static volatile uint8  trigger_request = FLIGHT_RECORDER_CAUSE_NONE;
+static volatile uint32 head = 0;
+static volatile uint32 filled = 0;
+static volatile uint32 trigger_position = 0;
+static volatile uint8  trigger_cause = FLIGHT_RECORDER_CAUSE_NONE;
+static uint32 post_remaining = 0;
+static uint8  sequence = 0;
+
+/* frozen trace: CORE_TELEMETRY only */
+static flight_recorder_header_t frozen_header;
+static uint32 frozen_first;
+static uint32 frozen_crc;
+static uint8  frozen_ready = 0;
+static uint32 save_page = 0;
+static uint32 save_pages = 0;
+
+static uint8  dump_source = DUMP_IDLE;
+static uint32 dump_offset;
+static uint32 dump_length;
+
+static uint32 page_buffer[EEPROM_PAGE_LENGTH];
+static sint32 page_cached = -1;                         /* stream page held in page_buffer */
+static uint8  dump_chunk[FLIGHT_RECORDER_DUMP_CHUNK];
+
+static const char *cause_names[] = { "none", "fall", "manual", "imu_stale" };
+
+/* =========================
+ * Stream helpers
+ * ========================= */
+static uint32 stream_length(uint32 record_count)
+{
+    return FLIGHT_RECORDER_HEADER_SIZE + record_count * FLIGHT_RECORDER_RECORD_SIZE + 4u;
+}
+
+/* CRC-32 (IEEE 802.3, reflected), 4 bit table */
+static uint32 crc32_update(uint32 crc, const uint8 *data, uint32 length)
+{
+    static const uint32 table[16] =
+    {
+        0x00000000u, 0x1DB71064u, 0x3B6E20C8u, 0x26D930ACu, 0x76DC4190u, 0x6B6B51F4u, 0x4DB26158u, 0x5005713Cu,
+        0xEDB88320u, 0xF00F9344u, 0xD6D6A3E8u, 0xCB61B38Cu, 0x9B64C2B0u, 0x86D3D2D4u, 0xA00AE278u, 0xBDBDF21Cu,
+    };
+
+    while (length-- > 0u)
+    {
+        crc ^= *data++;
+        crc = (crc >> 4) ^ table[crc & 0x0Fu];
+        crc = (crc >> 4) ^ table[crc & 0x0Fu];
+    }
+    return crc;
+}
+
+/* Copy bytes of the frozen RAM trace as they appear in the stream */
+static void stream_copy_ram(uint32 offset, uint8 *dst, uint32 length)
+{
+    uint32 records_end = FLIGHT_RECORDER_HEADER_SIZE + frozen_header.record_count * FLIGHT_RECORDER_RECORD_SIZE;
+
+    while (length > 0u)
+    {
+        const uint8 *src;
+        uint32 available;
+
+        if (offset < FLIGHT_RECORDER_HEADER_SIZE)
+        {
+            src = (const uint8 *)&frozen_header + offset;
+            available = FLIGHT_RECORDER_HEADER_SIZE - offset;
+        }
+        else if (offset < records_end)
+        {
+            uint32 index = (offset - FLIGHT_RECORDER_HEADER_SIZE) / FLIGHT_RECORDER_RECORD_SIZE;
+            uint32 within = (offset - FLIGHT_RECORDER_HEADER_SIZE) % FLIGHT_RECORDER_RECORD_SIZE;
+
+            src = (const uint8 *)&ring[(frozen_first + index) % FLIGHT_RECORDER_RECORDS] + within;
+            available = FLIGHT_RECORDER_RECORD_SIZE - within;
+        }
+        else
+        {
+            src = (const uint8 *)&frozen_crc + (offset - records_end);
+            available = 4u - (offset - records_end);
+        }
+
+        if (available > length)
+        {
+            available = length;
+        }
+        memcpy(dst, src, available);
+        dst += available;
+        offset += available;
+        length -= available;
+    }
+}
+
+static void stream_load_flash_page(uint32 page)
+{
+    if (page_cached != (sint32)page)
+    {
+        flash_read_page(0, FLIGHT_RECORDER_FLASH_FIRST + page, page_buffer, EEPROM_PAGE_LENGTH);
+        page_cached = (sint32)page;
+    }
+}
+
+static void stream_copy_flash(uint32 offset, uint8 *dst, uint32 length)
+{
+    while (length > 0u)
+    {
+        uint32 within = offset % FLIGHT_RECORDER_PAGE_BYTES;
+        uint32 available = FLIGHT_RECORDER_PAGE_BYTES - within;
+
+        stream_load_flash_page(offset / FLIGHT_RECORDER_PAGE_BYTES);
+        if (available > length)
+        {
+            available = length;
+        }
+        memcpy(dst, (const uint8 *)page_buffer + within, available);
+        dst += available;
+        offset += available;
+        length -= available;
+    }
+}
+
+/* Stream length of the DFlash copy, 0 when there is none */
+static uint32 flash_trace_length(void)
+{
+    flight_recorder_header_t header;
+
+    stream_load_flash_page(0);
+    memcpy(&header, page_buffer, sizeof(header));
+    if (header.magic != FLIGHT_RECORDER_MAGIC || header.version != FLIGHT_RECORDER_VERSION
+        || header.record_size != FLIGHT_RECORDER_RECORD_SIZE || header.record_count > FLIGHT_RECORDER_RECORDS)
+    {
+        return 0u;
+    }
+    return stream_length(header.record_count);
+}
+
+/* Header and CRC of a freshly frozen ring; the ISR no longer writes it */
+static void freeze_trace(void)
+{
+    uint32 count = filled;
+    uint32 i;
+
+    frozen_first = (head + FLIGHT_RECORDER_RECORDS - count) % FLIGHT_RECORDER_RECORDS;
+
+    memset(&frozen_header, 0, sizeof(frozen_header));
+    frozen_header.magic = FLIGHT_RECORDER_MAGIC;
+    frozen_header.version = FLIGHT_RECORDER_VERSION;
+    frozen_header.record_size = FLIGHT_RECORDER_RECORD_SIZE;
+    frozen_header.record_count = count;
+    frozen_header.trigger_index = (trigger_position + FLIGHT_RECORDER_RECORDS - frozen_first) % FLIGHT_RECORDER_RECORDS;
+    frozen_header.tick_hz = tick_hz;
+    frozen_header.cause = trigger_cause;
+
+    frozen_crc = crc32_update(0xFFFFFFFFu, (const uint8 *)&frozen_header, sizeof(frozen_header));
+    for (i = 0; i < count; i++)
+    {
+        frozen_crc = crc32_update(frozen_crc, (const uint8 *)&ring[(frozen_first + i) % FLIGHT_RECORDER_RECORDS],
+                                  FLIGHT_RECORDER_RECORD_SIZE);
+    }
+    frozen_crc ^= 0xFFFFFFFFu;
+
+    save_page = 0;
+    save_pages = (stream_length(count) + FLIGHT_RECORDER_PAGE_BYTES - 1u) / FLIGHT_RECORDER_PAGE_BYTES;
+    frozen_ready = 1;
+}
+
+static void check_frozen(void)
+{
+    if (state == FLIGHT_RECORDER_FROZEN && !frozen_ready)
+    {
+        freeze_trace();
+        printf("flight recorder: frozen (%s), %lu records, trigger at %lu\r\n",
+               cause_names[frozen_header.cause], (unsigned long)frozen_header.record_count,
+               (unsigned long)frozen_header.trigger_index);
+    }
+}
+
+/* One logical DFlash page per call: erase + program blocks the calling core */
+static void save_step(void)
+{
+    uint32 offset = save_page * FLIGHT_RECORDER_PAGE_BYTES;
+    uint32 length = stream_length(frozen_header.record_count) - offset;
+
+    if (length > FLIGHT_RECORDER_PAGE_BYTES)
+    {
+        length = FLIGHT_RECORDER_PAGE_BYTES;
+    }
+
+    memset(page_buffer, 0, sizeof(page_buffer));
+    stream_copy_ram(offset, (uint8 *)page_buffer, length);
+    page_cached = -1;
+
+    flash_erase_page(0, FLIGHT_RECORDER_FLASH_FIRST + save_page);
+    flash_write_page(0, FLIGHT_RECORDER_FLASH_FIRST + save_page, page_buffer, (uint16)((length + 3u) / 4u));
+
+    save_page++;
+    if (save_page >= save_pages)
+    {
+        printf("flight recorder: saved to DFlash pages %u..%u\r\n",
+               (unsigned)FLIGHT_RECORDER_FLASH_FIRST, (unsigned)(FLIGHT_RECORDER_FLASH_FIRST + save_pages - 1u));
+    }
+}
+
+static void dump_step(void)
+{
+    uint32 space = UART0_TX_BUFFER_SIZE - 1u - uart_tx_pending(DEBUG_UART_INDEX);
+    uint32 length = dump_length - dump_offset;
+
+    if (length > space)
+    {
+        length = space;
+    }
+    if (length > FLIGHT_RECORDER_DUMP_CHUNK)
+    {
+        length = FLIGHT_RECORDER_DUMP_CHUNK;
+    }
+    if (length == 0u)
+    {
+        return;
+    }
+
+    if (dump_source == DUMP_RAM)
+    {
+        stream_copy_ram(dump_offset, dump_chunk, length);
+    }
+    else
+    {
+        stream_copy_flash(dump_offset, dump_chunk, length);
+    }
+    uart_write_buffer(DEBUG_UART_INDEX, dump_chunk, length);
+
+    dump_offset += length;
+    if (dump_offset >= dump_length)
+    {
+        dump_source = DUMP_IDLE;
+    }
+}
+
+/* =========================
+ * Public APIs
+ * ========================= */
+void flight_recorder_init(void)
+{
+    tick_hz = (uint32)IfxStm_getFrequency(IfxStm_getAddress(IfxStm_Index_0));
+
+    ring = (flight_record_t *)MULTICORE_NON_CACHED(record_storage);
+    head = 0;
+    filled = 0;
+    sequence = 0;
+    trigger_request = FLIGHT_RECORDER_CAUSE_NONE;
+    state = FLIGHT_RECORDER_RECORDING;
+}
+
+flight_record_t *flight_recorder_slot(void)
+{
+    if (ring == NULL || state == FLIGHT_RECORDER_FROZEN)
+    {
+        return NULL;
+    }
+    return &ring[head];
+}
+
+void flight_recorder_commit(void)
+{
+    flight_record_t *record = &ring[head];
+    uint8 cause = trigger_request;
+
+    record->timestamp = IfxStm_getLower(&MODULE_STM0);
+    record->sequence = sequence++;
+
+    if (state == FLIGHT_RECORDER_RECORDING && cause != FLIGHT_RECORDER_CAUSE_NONE)
+    {
+        record->flags |= FLIGHT_RECORD_TRIGGER;
+        trigger_request = FLIGHT_RECORDER_CAUSE_NONE;
+        trigger_position = head;
+        trigger_cause = cause;
+        post_remaining = FLIGHT_RECORDER_POST_RECORDS;
+        state = FLIGHT_RECORDER_TRIGGERED;
+    }
+
+    head = (head + 1u < FLIGHT_RECORDER_RECORDS) ? (head + 1u) : 0u;
+    if (filled < FLIGHT_RECORDER_RECORDS)
+    {
+        filled++;
+    }
+
+    if (state == FLIGHT_RECORDER_TRIGGERED)
+    {
+        if (post_remaining == 0u)
+        {
+            state = FLIGHT_RECORDER_FROZEN;             /* last store: the ring is complete */
+        }
+        else
+        {
+            post_remaining--;
+        }
+    }
+}
+
+void flight_recorder_trigger(flight_recorder_cause_enum cause)
+{
+    if (state == FLIGHT_RECORDER_RECORDING && trigger_request == FLIGHT_RECORDER_CAUSE_NONE)
+    {
+        trigger_request = (uint8)cause;
+    }
+}
+
+void flight_recorder_rearm(void)
+{
+    if (state != FLIGHT_RECORDER_FROZEN || dump_source != DUMP_IDLE || (frozen_ready && save_page < save_pages))
+    {
+        printf("flight recorder: busy, not re-armed\r\n");
+        return;
+    }
+
+    frozen_ready = 0;
+    head = 0;
+    filled = 0;
+    trigger_request = FLIGHT_RECORDER_CAUSE_NONE;
+    state = FLIGHT_RECORDER_RECORDING;                  /* last store: hands the ring back to the ISR */
+    printf("flight recorder: re-armed\r\n");
+}
+
+void flight_recorder_dump(void)
+{
+    check_frozen();
+    if (frozen_ready)
+    {
+        dump_source = DUMP_RAM;
+        dump_length = stream_length(frozen_header.record_count);
+    }
+    else if ((dump_length = flash_trace_length()) != 0u)
+    {
+        dump_source = DUMP_FLASH;
+    }
+    else
+    {
+        printf("flight recorder: no trace\r\n");
+        return;
+    }
+    dump_offset = 0;
+}
+
+void flight_recorder_task(void)
+{
+    check_frozen();
+
+    if (dump_source != DUMP_IDLE)
+    {
+        dump_step();
+    }
+    else if (frozen_ready && save_page < save_pages)
+    {
+        save_step();
+    }
+}
+
+flight_recorder_state_enum flight_recorder_get_state(void)
+{
+    return (flight_recorder_state_enum)state;
+}
+
+#endif
@@ -0,0 +1,127 @@
+/* flight_recorder.h */
+#ifndef FLIGHT_RECORDER_H
+#define FLIGHT_RECORDER_H
+
+#include "zf_common_headfile.h"
+
+/* Black box for the balance loop.
+ *
+ * Every 5 ms tick balance_control fills one fixed-size binary record (no formatting)
+ * in a ring of FLIGHT_RECORDER_RECORDS entries in LMU RAM, about 5 s of history.
+ * A trigger (fall detected by velocity_loop_control, or 'f' on the debug UART) lets
+ * FLIGHT_RECORDER_POST_RECORDS more ticks through and then freezes the ring, so the
+ * trace shows the lead-up to the fall and how the loop reacted to it.
+ *
+ * Once frozen, flight_recorder_task() (CORE_TELEMETRY) copies the trace to the top
+ * DFlash pages (21 x 4 KB), one page per call, so it survives a reset. 'd' streams
+ * the RAM trace as raw binary to the debug UART (or the DFlash copy when nothing is
+ * frozen), 'a' re-arms the recorder. Anything printed during a dump lands inside
+ * the stream and breaks its CRC. tools/sim/flight_decode turns the stream into CSV.
+ *
+ * Stream layout, little endian:
+ *   flight_recorder_header_t
+ *   record_count x flight_record_t, oldest first
+ *   uint32 CRC-32 (IEEE 802.3) over header and records
+ *
+ * The 5 ms ISR is the only writer of the ring and of the recorder state while
+ * recording; the other core only requests a trigger and re-arms a frozen ring.
+ * Set FLIGHT_RECORDER_ENABLE to 0 to compile the recorder away.
+ */
+#ifndef FLIGHT_RECORDER_ENABLE
+#define FLIGHT_RECORDER_ENABLE          (1)
+#endif
+
+#define FLIGHT_RECORDER_RECORDS         (1024)  /* 5.12 s at 200 Hz, 40 KB of lmubss */
+#define FLIGHT_RECORDER_POST_RECORDS    (100)   /* ticks kept after the trigger (0.5 s) */
+
+#define FLIGHT_RECORDER_MAGIC           (0x43455246u)   /* "FREC" */
+#define FLIGHT_RECORDER_VERSION         (1)
+
+/* flight_record_t.flags */
+#define FLIGHT_RECORD_ENABLE            (0x01u) /* control was enabled at the end of the tick */
+#define FLIGHT_RECORD_ANGLE_LOOP        (0x02u) /* the angle loop ran in this tick */
+#define FLIGHT_RECORD_SPEED_VALID       (0x04u) /* wheel_speed holds a valid ODrive estimate */
+#define FLIGHT_RECORD_TRIGGER           (0x08u) /* tick in which the trigger was taken */
+#define FLIGHT_RECORD_IMU_STALE         (0x10u) /* the IMU sample was older than BALANCE_IMU_STALE_US */
+#define FLIGHT_RECORD_WATCHDOG          (0x20u) /* frame scheduling: step taken by the PIT, no frame arrived */
+#define FLIGHT_RECORD_LQR               (0x40u) /* BALANCE_MODE_LQR: torque from the state feedback, target_rate unused */
+#define FLIGHT_RECORD_DESAT_LIMIT       (0x80u) /* wheel desaturation bias at its limit: the wheel load is more than a lean can carry */
+
+typedef enum
+{
+    FLIGHT_RECORDER_CAUSE_NONE = 0,
+    FLIGHT_RECORDER_CAUSE_FALL,         /* |roll| > BALANCE_FALL_ANGLE_LIMIT while enabled */
+    FLIGHT_RECORDER_CAUSE_MANUAL,       /* 'f' on the debug UART */
+    FLIGHT_RECORDER_CAUSE_IMU_STALE,    /* no fresh YIS frame while enabled */
+} flight_recorder_cause_enum;
+
+typedef enum
+{
+    FLIGHT_RECORDER_RECORDING = 0,
+    FLIGHT_RECORDER_TRIGGERED,          /* counting down the post-trigger records */
+    FLIGHT_RECORDER_FROZEN,
+} flight_recorder_state_enum;
+
+/* 40 bytes, naturally aligned, no padding; the layout is the wire format */
+typedef struct
+{
+    uint32 timestamp;                   /* CPU0 STM ticks, see header.tick_hz */
+    float  roll;                        /* deg, filtered roll the loops ran on */
+    float  roll_rate;                   /* deg/s */
+    float  target_angle;                /* deg, including the wheel desaturation bias */
+    float  target_rate;                 /* deg/s, angle loop output */
+    float  angle_integral;              /* deg/s, angle loop integral term */
+    float  rate_integral;               /* Nm, rate loop integral term */
+    float  torque_cmd;                  /* Nm sent to the ODrive (0 when disabled) */
+    float  wheel_speed;                 /* rps, last ODrive estimate */
+    uint16 isr_us;                      /* previous 5 ms ISR execution time */
+    uint8  flags;                       /* FLIGHT_RECORD_xxx */
+    uint8  sequence;                    /* tick counter, gaps show lost ticks */
+} flight_record_t;
+
+typedef struct
+{
+    uint32 magic;                       /* FLIGHT_RECORDER_MAGIC */
+    uint16 version;                     /* FLIGHT_RECORDER_VERSION */
+    uint16 record_size;                 /* sizeof(flight_record_t) */
+    uint32 record_count;
+    uint32 trigger_index;               /* index of the trigger record in the stream */
+    uint32 tick_hz;                     /* timestamp clock */
+    uint32 cause;                       /* flight_recorder_cause_enum */
+    uint32 reserved[2];
+} flight_recorder_header_t;
+
+#if FLIGHT_RECORDER_ENABLE
+
+/* CPU0, before the 5 ms PIT is started */
+void    flight_recorder_init        (void);
+
+/* 5 ms ISR: slot for this tick, NULL once frozen. Fill every data field, then
+ * commit; timestamp, sequence and the trigger flag are set by the recorder. */
+flight_record_t *flight_recorder_slot (void);
+void    flight_recorder_commit      (void);
+
+/* Any core; taken at the next commit, ignored unless recording */
+void    flight_recorder_trigger     (flight_recorder_cause_enum cause);
+
+/* CORE_TELEMETRY */
+void    flight_recorder_rearm       (void);
+void    flight_recorder_dump        (void);
+void    flight_recorder_task        (void);
+
+flight_recorder_state_enum flight_recorder_get_state (void);
+
+#else
+
+#define flight_recorder_init()          ((void)0)
+#define flight_recorder_slot()          ((flight_record_t *)0)
+#define flight_recorder_commit()        ((void)0)
+#define flight_recorder_trigger(cause)  ((void)0)
+#define flight_recorder_rearm()         ((void)0)
+#define flight_recorder_dump()          ((void)0)
+#define flight_recorder_task()          ((void)0)
+#define flight_recorder_get_state()     (FLIGHT_RECORDER_RECORDING)
+
+#endif
+
+#endif
@@ -0,0 +1,256 @@
+/* multicore.c */
+#include "multicore.h"
+#include "zf_common_fifo.h"
+#include "isr_config.h"
+#include "driver_odrive.h"
+#include "flight_recorder.h"
+#include "imu_calibration.h"
+#include "driver_mag.h"
+#include "IfxStm.h"
+#include "IfxSrc.h"
+#include "Cpu/Irq/IfxCpu_Irq.h"
+
+#define MULTICORE_GPSR(core)            (&MODULE_SRC.GPSR.GPSR[(core)].SR[0])
+
+/* =========================
+ * Task placement
+ * =========================
+ * Control: the 5 ms balance ISR, the IMU sample handler and the CAN RX ISR stay on
+ * CPU0 with the ODrive tasks, so CAN TX is only ever touched from one core. That
+ * core still writes it from three levels (control ISR, mailbox ISR, odrive_speed
+ * task); odrive_can_send() puts each frame into the TX FIFO with interrupts off.
+ */
+static const multicore_task_t multicore_task_table[] =
+{
+    /* name           core            period  function */
+    { "odrive_poll",  CORE_CONTROL,   1,      odrive_poll          },
+    { "odrive_speed", CORE_CONTROL,   50,     odrive_request_speed },
+    { "keys",         CORE_UI,        10,     key_task             },
+    { "ui",           CORE_UI,        10,     ui_task              },
+    { "telemetry",    CORE_TELEMETRY, 10,     telemetry_task       },
+    { "imu_cal",      CORE_TELEMETRY, 10,     imu_calibration_task },
+    { "mag",          CORE_TELEMETRY, 10,     mag_task             },
+#if FLIGHT_RECORDER_ENABLE
+    { "flight_rec",   CORE_TELEMETRY, 10,     flight_recorder_task },
+#endif
+};
+
+#define MULTICORE_TASK_NUM              (sizeof(multicore_task_table) / sizeof(multicore_task_table[0]))
+
+/* =========================
+ * Mailboxes (LMU RAM)
+ * ========================= */
+#pragma section all "lmubss"
+static uint32      mailbox_storage[MULTICORE_CORE_NUM][MULTICORE_MAILBOX_WORDS];
+static ring_struct mailbox_ring[MULTICORE_CORE_NUM];
+#pragma section all restore
+
+static ring_struct *mailbox[MULTICORE_CORE_NUM];                /* uncached aliases, NULL until init */
+static volatile uint32 mailbox_dropped[MULTICORE_CORE_NUM];     /* statistics only, not atomic across producers */
+static multicore_handler_t handler_table[MULTICORE_MSG_NUM];
+
+static const uint8 mailbox_priority[MULTICORE_CORE_NUM] =
+{
+    CPU0_MAILBOX_INT_PRIO, CPU1_MAILBOX_INT_PRIO, CPU2_MAILBOX_INT_PRIO, CPU3_MAILBOX_INT_PRIO
+};
+
+/* =========================
+ * Load / scheduling state
+ * ========================= */
+static uint32 ticks_per_us = 100u;
+static uint32 task_next[MULTICORE_TASK_NUM];                    /* each entry only touched by its own core */
+static volatile uint16 load_permille[MULTICORE_CORE_NUM] = { 0xFFFFu, 0xFFFFu, 0xFFFFu, 0xFFFFu };
+
+static inline uint32 multicore_now(void)
+{
+    return IfxStm_getLower(IfxStm_getAddress((IfxStm_Index)IfxCpu_getCoreId()));
+}
+
+/* =========================
+ * Public APIs
+ * ========================= */
+void multicore_init(void)
+{
+    uint32 stm_clk = (uint32)IfxStm_getFrequency(IfxStm_getAddress((IfxStm_Index)IfxCpu_getCoreId()));
+    uint8 core;
+
+    ticks_per_us = (stm_clk >= 1000000u) ? (stm_clk / 1000000u) : 1u;
+
+    for (core = 0; core < MULTICORE_CORE_NUM; core++)
+    {
+        ring_struct *ring = (ring_struct *)MULTICORE_NON_CACHED(&mailbox_ring[core]);
+
+        ring_init(ring, MULTICORE_NON_CACHED(mailbox_storage[core]), 2, MULTICORE_MAILBOX_WORDS);
+        mailbox_dropped[core] = 0;
+        mailbox[core] = ring;
+
+        IfxSrc_init(MULTICORE_GPSR(core), IfxCpu_Irq_getTos((IfxCpu_ResourceCpu)core), mailbox_priority[core]);
+        IfxSrc_enable(MULTICORE_GPSR(core));
+    }
+}
+
+void multicore_set_handler(multicore_msg_enum msg, multicore_handler_t handler)
+{
+    if (msg < MULTICORE_MSG_NUM)
+    {
+        handler_table[msg] = handler;
+    }
+}
+
+uint8 multicore_post(uint8 core, multicore_msg_enum msg, const void *data, uint32 length)
+{
+    uint32 message[1 + MULTICORE_MSG_MAX_BYTES / 4];
+    uint32 words = 1u + (length + 3u) / 4u;
+
+    if (core >= MULTICORE_CORE_NUM || mailbox[core] == NULL || length > MULTICORE_MSG_MAX_BYTES)
+    {
+        return 0;
+    }
+
+    message[0] = ((uint32)msg << 16) | length;
+    if (length != 0u)
+    {
+        memcpy(&message[1], data, length);
+    }
+
+    if (ring_write_mpsc(mailbox[core], message, words) == 0u)
+    {
+        mailbox_dropped[core]++;
+        return 0;
+    }
+
+    IfxSrc_setRequest(MULTICORE_GPSR(core));
+    return 1;
+}
+
+/* A post that lands after the last peek raises the request again, so nothing is
+ * left behind when the loop exits. */
+void multicore_mailbox_isr(void)
+{
+    ring_struct *ring = mailbox[IfxCpu_getCoreId()];
+    uint32 message[1 + MULTICORE_MSG_MAX_BYTES / 4];
+    uint32 header, msg, length;
+
+    if (ring == NULL)
+    {
+        return;
+    }
+
+    while (ring_peek(ring, &header, 1) != 0u)
+    {
+        msg = header >> 16;
+        length = header & 0xFFFFu;
+        ring_read(ring, message, 1u + (length + 3u) / 4u);
+
+        if (msg < MULTICORE_MSG_NUM && handler_table[msg] != NULL)
+        {
+            handler_table[msg](&message[1], length);
+        }
+    }
+}
+
+void multicore_run(void)
+{
+    uint8  core = (uint8)IfxCpu_getCoreId();
+    uint32 window_ticks = MULTICORE_LOAD_WINDOW_MS * 1000u * ticks_per_us;
+    uint32 gap_ticks = MULTICORE_IDLE_GAP_US * ticks_per_us;
+    uint32 window_start = multicore_now();
+    uint32 idle_ticks = 0;
+    uint32 i;
+
+    for (i = 0; i < MULTICORE_TASK_NUM; i++)
+    {
+        if (multicore_task_table[i].core == core)
+        {
+            task_next[i] = window_start;
+        }
+    }
+
+    while (TRUE)
+    {
+        uint32 next = window_start + window_ticks;
+        uint32 last;
+
+        for (i = 0; i < MULTICORE_TASK_NUM; i++)
+        {
+            const multicore_task_t *task = &multicore_task_table[i];
+            uint32 period_ticks = (uint32)task->period_ms * 1000u * ticks_per_us;
+            uint32 now;
+
+            if (task->core != core)
+            {
+                continue;
+            }
+
+            now = multicore_now();
+            if ((sint32)(now - task_next[i]) >= 0)
+            {
+                task->function();
+                task_next[i] += period_ticks;
+                if ((sint32)(now - task_next[i]) >= 0)
+                {
+                    task_next[i] = now + period_ticks;  /* overran a whole period: drop the missed runs */
+                }
+            }
+            if ((sint32)(task_next[i] - next) < 0)
+            {
+                next = task_next[i];
+            }
+        }
+
+        /* idle until the next task is due, interrupts show up as long steps */
+        last = multicore_now();
+        while ((sint32)(next - last) > 0)
+        {
+            uint32 now = multicore_now();
+
+            if (now - last < gap_ticks)
+            {
+                idle_ticks += now - last;
+            }
+            last = now;
+        }
+
+        if (last - window_start >= window_ticks)
+        {
+            uint32 elapsed = last - window_start;
+
+            load_permille[core] = (uint16)(1000u - (uint32)((uint64)idle_ticks * 1000u / elapsed));
+            window_start = last;
+            idle_ticks = 0;
+        }
+    }
+}
+
+uint16 multicore_load_permille(uint8 core)
+{
+    return (core < MULTICORE_CORE_NUM) ? load_permille[core] : 0xFFFFu;
+}
+
+uint32 multicore_dropped(uint8 core)
+{
+    return (core < MULTICORE_CORE_NUM) ? mailbox_dropped[core] : 0u;
+}
+
+void multicore_report(void)
+{
+    uint8 core;
+
+    printf("load");
+    for (core = 0; core < MULTICORE_CORE_NUM; core++)
+    {
+        uint16 load = load_permille[core];
+
+        if (load == 0xFFFFu)
+        {
+            printf("  cpu%u  --.-%%", core);
+        }
+        else
+        {
+            printf("  cpu%u %3u.%u%%", core, load / 10u, load % 10u);
+        }
+    }
+    printf("   mailbox drops %lu/%lu/%lu/%lu\r\n",
+           (unsigned long)mailbox_dropped[0], (unsigned long)mailbox_dropped[1],
+           (unsigned long)mailbox_dropped[2], (unsigned long)mailbox_dropped[3]);
+}
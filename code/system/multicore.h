@@ -0,0 +1,85 @@
+/* multicore.h */
+#ifndef MULTICORE_H
+#define MULTICORE_H
+
+#include "zf_common_headfile.h"
+
+/* Cross-core work on the TC387.
+ *
+ * Placement: each module belongs to one core, named by the CORE_xxx macros below.
+ * Background tasks are assigned in multicore_task_table (multicore.c) and run by
+ * multicore_run() on their core; interrupts follow through the XXX_INT_SERVICE
+ * macros in isr_config.h, which must agree with the CORE_xxx macros.
+ *
+ * Mailbox: one MPSC ring of 32-bit words per core in non-cached LMU RAM. Any core
+ * or ISR may multicore_post() a message (id + up to MULTICORE_MSG_MAX_BYTES bytes);
+ * the message is copied in whole or dropped, then the target core's GPSR software
+ * interrupt is raised and its mailbox ISR calls the handler registered for the id.
+ * Handlers run in that ISR, so they must be short.
+ *
+ * Load: multicore_run() spends the time between due tasks reading the STM back to
+ * back. Steps shorter than MULTICORE_IDLE_GAP_US count as idle, longer ones were
+ * taken by an interrupt. Load is 1 - idle / elapsed over each MULTICORE_LOAD_WINDOW_MS.
+ * A core that never calls multicore_run() reports 0xFFFF.
+ */
+
+#define MULTICORE_CORE_NUM              (4)
+
+#define CORE_CONTROL                    (0)     /* 5 ms balance ISR, IMU frame consumer, ODrive CAN */
+#define CORE_UI                         (1)     /* keys, parameter tuning, IPS200 */
+#define CORE_TELEMETRY                  (1)     /* debug UART printf, profiler report, seekfree assistant */
+#define CORE_SENSOR                     (2)     /* YIS DMA frame parser, IMU660RA FIFO + fusion PIT */
+
+#define MULTICORE_MAILBOX_WORDS         (256)   /* per core, power of two */
+#define MULTICORE_MSG_MAX_BYTES         (96)    /* a whole yis_imu_t */
+#define MULTICORE_LOAD_WINDOW_MS        (100)
+#define MULTICORE_IDLE_GAP_US           (2)
+
+/* LMU is mapped cached at 0x9xxxxxxx and uncached at 0xBxxxxxxx; the linker
+ * places lmubss at the cached address, every core sharing it goes through the alias. */
+#define MULTICORE_NON_CACHED(address)   ((void *)((uint32)(address) | 0x20000000u))
+
+typedef enum
+{
+    MULTICORE_MSG_CONTROL_ENABLE = 0,   /* CORE_UI -> CORE_CONTROL: uint8, 1 = run, 0 = stop */
+    MULTICORE_MSG_IMU_SAMPLE,           /* CORE_SENSOR -> CORE_CONTROL: fused yis_imu_t (driver_imu_fusion) */
+    MULTICORE_MSG_CONTROL_MODE,         /* CORE_UI -> CORE_CONTROL: uint8, balance_mode_enum */
+
+    MULTICORE_MSG_NUM,
+} multicore_msg_enum;
+
+typedef void (*multicore_handler_t)(const void *data, uint32 length);
+
+typedef struct
+{
+    const char *name;
+    uint8       core;
+    uint16      period_ms;              /* >= 1 */
+    void      (*function)(void);
+} multicore_task_t;
+
+/* Task entry points run from multicore_task_table */
+void    ui_task                 (void); /* user/cpu1_main.c */
+void    key_task                (void); /* user/cpu1_main.c */
+void    telemetry_task          (void); /* user/cpu1_main.c */
+
+/* CPU0 before cpu_wait_event_ready(), ahead of any driver whose ISR is routed to another core */
+void    multicore_init          (void);
+void    multicore_set_handler   (multicore_msg_enum msg, multicore_handler_t handler);
+
+/* Any core, any context. Returns 1 when queued, 0 when dropped (mailbox full or too long). */
+uint8   multicore_post          (uint8 core, multicore_msg_enum msg, const void *data, uint32 length);
+
+/* Body of the GPSR ISR of the calling core (isr.c) */
+void    multicore_mailbox_isr   (void);
+
+/* Background loop of the calling core, after cpu_wait_event_ready(); never returns */
+void    multicore_run           (void);
+
+uint16  multicore_load_permille (uint8 core);
+uint32  multicore_dropped       (uint8 core);
+
+/* One printf line with the load of every core and the mailbox drop counters */
+void    multicore_report        (void);
+
+#endif
@@ -0,0 +1,152 @@
+/* profiler.c */
+#include "profiler.h"
+
+#if PROFILER_ENABLE
+
+static const char *const profiler_names[PROFILER_SECTION_NUM] =
+{
+    "balance_isr",
+    "balance_period",
+    "read_imu",
+    "angle_loop",
+    "velocity_loop",
+    "odrive_format",
+    "odrive_tx",
+    "yis_parser",
+    "yis_frame",
+    "ui",
+};
+
+profiler_entry_t profiler_table[PROFILER_SECTION_NUM];
+
+static uint32 ticks_per_us = 100u;              /* STM clock / 1MHz, read at init */
+static uint8  report_index = PROFILER_SECTION_NUM;
+
+/* =========================
+ * Recording (any ISR / task)
+ * ========================= */
+void profiler_record(profiler_section_enum section, uint32 ticks)
+{
+    profiler_stats_t *s = &profiler_table[section].stats;
+    uint32 us = ticks / ticks_per_us;
+    uint8 bucket = 0u;
+
+    while (us != 0u && bucket < (PROFILER_HIST_BUCKETS - 1u))
+    {
+        us >>= 1;
+        bucket++;
+    }
+
+    s->last_ticks = ticks;
+    if (s->count == 0u || ticks < s->min_ticks) s->min_ticks = ticks;
+    if (ticks > s->max_ticks) s->max_ticks = ticks;
+    s->sum_ticks += ticks;
+    s->count++;
+    s->hist[bucket]++;
+}
+
+/* =========================
+ * Public APIs
+ * ========================= */
+void profiler_init(void)
+{
+    uint32 stm_clk = (uint32)IfxStm_getFrequency(IfxStm_getAddress((IfxStm_Index)IfxCpu_getCoreId()));
+
+    ticks_per_us = (stm_clk >= 1000000u) ? (stm_clk / 1000000u) : 1u;
+    memset(profiler_table, 0, sizeof(profiler_table));
+    report_index = PROFILER_SECTION_NUM;
+}
+
+void profiler_reset(void)
+{
+    uint32 interrupt_state = interrupt_global_disable();
+    uint8 i;
+
+    for (i = 0; i < PROFILER_SECTION_NUM; i++)
+    {
+        memset(&profiler_table[i].stats, 0, sizeof(profiler_table[i].stats));
+    }
+    interrupt_global_enable(interrupt_state);
+}
+
+/* Copied with this core's interrupts off, which is consistent for every section
+ * recorded on the same core; sections owned by another core may be one sample apart. */
+void profiler_get_stats(profiler_section_enum section, profiler_stats_t *out)
+{
+    uint32 interrupt_state;
+
+    if (out == NULL || section >= PROFILER_SECTION_NUM)
+    {
+        return;
+    }
+
+    interrupt_state = interrupt_global_disable();
+    *out = profiler_table[section].stats;
+    interrupt_global_enable(interrupt_state);
+}
+
+uint32 profiler_ticks_to_us(uint32 ticks)
+{
+    return ticks / ticks_per_us;
+}
+
+uint32 profiler_last_us(profiler_section_enum section)
+{
+    return profiler_table[section].stats.last_ticks / ticks_per_us;
+}
+
+uint32 profiler_max_us(profiler_section_enum section)
+{
+    return profiler_table[section].stats.max_ticks / ticks_per_us;
+}
+
+void profiler_report_start(void)
+{
+    report_index = 0u;
+}
+
+uint8 profiler_report_step(void)
+{
+    profiler_stats_t s;
+    float mean_us;
+    uint8 i;
+
+    if (report_index >= PROFILER_SECTION_NUM)
+    {
+        return 0u;
+    }
+    if (report_index == 0u)
+    {
+        printf("\r\nsection          count     last_us  min_us   mean_us   max_us\r\n");
+    }
+
+    profiler_get_stats((profiler_section_enum)report_index, &s);
+    mean_us = (s.count != 0u) ? ((float)s.sum_ticks / (float)s.count / (float)ticks_per_us) : 0.0f;
+
+    printf("%-14s %9lu %9lu %7lu %9.2f %8lu\r\n  hist",
+           profiler_names[report_index], (unsigned long)s.count,
+           (unsigned long)(s.last_ticks / ticks_per_us), (unsigned long)(s.min_ticks / ticks_per_us),
+           mean_us, (unsigned long)(s.max_ticks / ticks_per_us));
+    for (i = 0; i < PROFILER_HIST_BUCKETS; i++)
+    {
+        printf(" %lu", (unsigned long)s.hist[i]);
+    }
+    printf("\r\n");
+
+    report_index++;
+    return (uint8)(report_index < PROFILER_SECTION_NUM);
+}
+
+void profiler_send_assistant(void)
+{
+    uint8 i;
+
+    for (i = 0; i < SEEKFREE_ASSISTANT_SET_OSCILLOSCOPE_COUNT && i < PROFILER_SECTION_NUM; i++)
+    {
+        seekfree_assistant_oscilloscope_data.data[i] = (float)profiler_max_us((profiler_section_enum)i);
+    }
+    seekfree_assistant_oscilloscope_data.channel_num = i;
+    seekfree_assistant_oscilloscope_send(&seekfree_assistant_oscilloscope_data);
+}
+
+#endif
@@ -0,0 +1,128 @@
+/* profiler.h */
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include "zf_common_headfile.h"
+
+/* Execution-time profiling on the per-core STM (raw ticks, no division in the hot path).
+ *
+ * PROFILER_BEGIN / PROFILER_END bracket a section, PROFILER_MARK records the interval
+ * between two consecutive marks (ISR period / jitter). Every section keeps
+ * count/min/max/mean and a log2 histogram in microseconds. A section must only be
+ * entered from one context on one core (the STM of the calling core is used).
+ * Times are wall-clock, so a section preempted by a higher priority ISR includes it.
+ * Cost per BEGIN+END pair is two STM reads and ~20 instructions, so it stays on
+ * in production; set PROFILER_ENABLE to 0 to compile every marker away.
+ */
+#ifndef PROFILER_ENABLE
+#define PROFILER_ENABLE                 (1)
+#endif
+
+#define PROFILER_HIST_BUCKETS           (16)    /* bucket 0: <1us, bucket n: [2^(n-1), 2^n) us, last one open ended */
+
+typedef enum
+{
+    PROFILER_BALANCE_ISR = 0,           /* whole balance_control_update_5ms_isr() */
+    PROFILER_BALANCE_PERIOD,            /* interval between two control ticks (mark) */
+    PROFILER_READ_IMU,                  /* read_imu_data() */
+    PROFILER_ANGLE_LOOP,                /* angle_loop_control() */
+    PROFILER_VELOCITY_LOOP,             /* velocity_loop_control(): rate PID or LQR, includes the ODrive command */
+    PROFILER_ODRIVE_FORMAT,             /* torque command: sprintf (UART) / CANSimple pack (CAN) */
+    PROFILER_ODRIVE_TX,                 /* torque command: UART6 write / CAN TX FIFO put */
+    PROFILER_YIS_PARSER,                /* YIS DMA ISR: frame parser, once per frame */
+    PROFILER_YIS_FRAME,                 /* interval between two complete YIS frames (mark) */
+    PROFILER_UI,                        /* ui_task() in the main loop */
+
+    PROFILER_SECTION_NUM,
+} profiler_section_enum;
+
+typedef struct
+{
+    uint32 count;
+    uint32 last_ticks;
+    uint32 min_ticks;
+    uint32 max_ticks;
+    uint64 sum_ticks;
+    uint32 hist[PROFILER_HIST_BUCKETS];
+} profiler_stats_t;
+
+#if PROFILER_ENABLE
+
+#include "IfxStm.h"
+#include "IfxCpu.h"
+
+typedef struct
+{
+    uint32 start;
+    profiler_stats_t stats;
+} profiler_entry_t;
+
+extern profiler_entry_t profiler_table[PROFILER_SECTION_NUM];
+
+static inline uint32 profiler_now (void)
+{
+    return IfxStm_getLower(IfxStm_getAddress((IfxStm_Index)IfxCpu_getCoreId()));
+}
+
+void    profiler_record         (profiler_section_enum section, uint32 ticks);
+
+static inline void profiler_begin (profiler_section_enum section)
+{
+    profiler_table[section].start = profiler_now();
+}
+
+static inline void profiler_end (profiler_section_enum section)
+{
+    profiler_record(section, profiler_now() - profiler_table[section].start);
+}
+
+static inline void profiler_mark (profiler_section_enum section)
+{
+    uint32 now = profiler_now();
+    uint32 last = profiler_table[section].start;
+
+    profiler_table[section].start = now;
+    if (last != 0u)
+    {
+        profiler_record(section, now - last);
+    }
+}
+
+#define PROFILER_BEGIN(section)         profiler_begin(section)
+#define PROFILER_END(section)           profiler_end(section)
+#define PROFILER_MARK(section)          profiler_mark(section)
+
+void    profiler_init           (void);
+void    profiler_reset          (void);
+void    profiler_get_stats      (profiler_section_enum section, profiler_stats_t *out);
+uint32  profiler_ticks_to_us    (uint32 ticks);
+uint32  profiler_last_us        (profiler_section_enum section);
+uint32  profiler_max_us         (profiler_section_enum section);
+
+/* Text report on the debug UART, one section per call so the main loop is never
+ * blocked for the whole table. Returns 1 while lines are left. */
+void    profiler_report_start   (void);
+uint8   profiler_report_step    (void);
+
+/* Worst case (us) of the first 8 sections as one seekfree assistant oscilloscope frame */
+void    profiler_send_assistant (void);
+
+#else
+
+#define PROFILER_BEGIN(section)         ((void)0)
+#define PROFILER_END(section)           ((void)0)
+#define PROFILER_MARK(section)          ((void)0)
+
+#define profiler_init()                 ((void)0)
+#define profiler_reset()                ((void)0)
+#define profiler_get_stats(section, out) ((void)memset((out), 0, sizeof(profiler_stats_t)))
+#define profiler_ticks_to_us(ticks)     (0u)
+#define profiler_last_us(section)       (0u)
+#define profiler_max_us(section)        (0u)
+#define profiler_report_start()         ((void)0)
+#define profiler_report_step()          (0u)
+#define profiler_send_assistant()       ((void)0)
+
+#endif
+
+#endif
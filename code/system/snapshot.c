@@ -0,0 +1,62 @@
+/* snapshot.c */
+#include "snapshot.h"
+
+#if defined(__TASKING__) || defined(__tricore__)
+#include "Cpu/Std/IfxCpu_Intrinsics.h"
+#define SNAPSHOT_MEMORY_BARRIER()       __dsync()
+#else                                   /* host build: tools/sim */
+#define SNAPSHOT_MEMORY_BARRIER()       __atomic_thread_fence(__ATOMIC_ACQ_REL)
+#endif
+
+void snapshot_init(snapshot_t *snapshot, void *slots, uint32 size)
+{
+    snapshot->sequence = 0;
+    snapshot->size = size;
+    snapshot->slot[0] = (uint8 *)slots;
+    snapshot->slot[1] = (uint8 *)slots + size;
+    memset(slots, 0, 2u * size);
+}
+
+void *snapshot_write_begin(snapshot_t *snapshot)
+{
+    /* back slot: the one the next sequence value will point at */
+    return snapshot->slot[(snapshot->sequence + 1u) & 1u];
+}
+
+void snapshot_write_commit(snapshot_t *snapshot)
+{
+    uint32 next = snapshot->sequence + 1u;
+
+    SNAPSHOT_MEMORY_BARRIER();          /* sample complete before it becomes the front */
+    snapshot->sequence = (next != 0u) ? next : 2u;      /* 0 means never published; 2 keeps slot 0 in front */
+}
+
+void snapshot_publish(snapshot_t *snapshot, const void *data)
+{
+    memcpy(snapshot_write_begin(snapshot), data, snapshot->size);
+    snapshot_write_commit(snapshot);
+}
+
+uint8 snapshot_read(const snapshot_t *snapshot, void *out)
+{
+    uint32 sequence;
+
+    do
+    {
+        sequence = snapshot->sequence;
+        if (sequence == 0u)
+        {
+            return 0;
+        }
+        SNAPSHOT_MEMORY_BARRIER();
+        memcpy(out, snapshot->slot[sequence & 1u], snapshot->size);
+        SNAPSHOT_MEMORY_BARRIER();      /* copy finished before sequence is checked again */
+    } while (sequence != snapshot->sequence);
+
+    return 1;
+}
+
+uint32 snapshot_sequence(const snapshot_t *snapshot)
+{
+    return snapshot->sequence;
+}
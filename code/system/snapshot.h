@@ -0,0 +1,43 @@
+/* snapshot.h */
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include "zf_common_headfile.h"
+
+/* Latest-value publishing of a sensor sample (one writer, any number of readers).
+ *
+ * Two slots and a sequence counter: the writer fills the slot readers are not
+ * pointed at, then bumps sequence, whose low bit names the front slot. The writer
+ * never waits and never touches the front slot, so a reader that interrupts it
+ * (higher priority ISR on the same core) always copies a complete sample. A reader
+ * that is overtaken by two publishes while copying (preempted itself, or on another
+ * core) sees sequence move and copies again.
+ *
+ * Rules: one writer context per snapshot; readers may be anywhere. Storage shared
+ * with another core must not sit behind a data cache (DSPR, or lmubss through
+ * MULTICORE_NON_CACHED). Cost per publish or read: one copy of the sample plus two
+ * dsync.
+ */
+typedef struct
+{
+    volatile uint32 sequence;           /* publishes so far, bit 0 selects the front slot */
+    uint32 size;                        /* bytes per slot */
+    uint8 *slot[2];
+} snapshot_t;
+
+/* slots: 2 * size bytes, word aligned */
+void    snapshot_init           (snapshot_t *snapshot, void *slots, uint32 size);
+
+/* Writer: copy a finished sample in ... */
+void    snapshot_publish        (snapshot_t *snapshot, const void *data);
+/* ... or build it in place: fill the returned slot, then commit */
+void   *snapshot_write_begin    (snapshot_t *snapshot);
+void    snapshot_write_commit   (snapshot_t *snapshot);
+
+/* Reader: copies the newest sample; returns 0 (out untouched) until the first publish */
+uint8   snapshot_read           (const snapshot_t *snapshot, void *out);
+
+/* Changes on every publish; a reader can skip work when it did not move */
+uint32  snapshot_sequence       (const snapshot_t *snapshot);
+
+#endif
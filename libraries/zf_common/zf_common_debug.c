@@ -216,8 +216,7 @@ static void debug_output (char *type, char *file, int line, char *str)
 //-------------------------------------------------------------------------------------------------------------------
 uint32 debug_send_buffer(const uint8 *buff, uint32 len)
 {
-    uart_write_buffer(DEBUG_UART_INDEX, buff, len);
-    return 0;
+    return len - uart_write_buffer(DEBUG_UART_INDEX, buff, len);
 }
 
 #if DEBUG_UART_USE_INTERRUPT                                                    //  ֻôжϲű
@@ -37,73 +37,316 @@
 #include "zf_common_debug.h"
 #include "zf_common_fifo.h"
 
+#if defined(__TASKING__) || defined(__tricore__)
+#include "Cpu/Std/IfxCpu_Intrinsics.h"
+#define RING_MEMORY_BARRIER()                       __dsync()                   // ֮ǰĶдȫɺżִ
+#define RING_COMPARE_AND_SWAP(addr, value, cmp)     ((uint32)__cmpAndSwap((unsigned int *)(addr), (value), (cmp)))
+#define RING_SPIN_WAIT()                            __nop()
+#else                                                                           //  tools/sim/fifo_bench.c
+#include <sched.h>
+#define RING_MEMORY_BARRIER()                       __atomic_thread_fence(__ATOMIC_ACQ_REL)
+#define RING_COMPARE_AND_SWAP(addr, value, cmp)     ((uint32)__sync_val_compare_and_swap((addr), (cmp), (value)))
+#define RING_SPIN_WAIT()                            sched_yield()               // ܱ߳̿ȳȥ ó CPU
+#endif
+
 //-------------------------------------------------------------------------------------------------------------------
-//      FIFO ͷָλ
-// ˵     *fifo               FIFO ָ
-// ˵     offset              ƫ
+//      λ дݵָλ
+// ˵     *ring               λָ
+// ˵     index               дλü
+// ˵     *dat                Դָ
+// ˵     length              Ԫظ
 // ز     void
-// ʹʾ     fifo_head_offset(fifo, 1);
-// עϢ     ļڲ ûùע Ҳ޸
+// ʹʾ     ring_copy_in(ring, head, dat, length);
+// עϢ     ļڲ ûùע Ҳ޸  memcpy
 //-------------------------------------------------------------------------------------------------------------------
-static void fifo_head_offset (fifo_struct *fifo, uint32 offset)
+static void ring_copy_in (ring_struct *ring, uint32 index, const uint8 *dat, uint32 length)
 {
-    fifo->head += offset;
-    
-    while(fifo->max <= fifo->head)                                              // ΧС ֱС󻺳С
+    uint32 offset = index & ring->mask;
+    uint32 first_length = ring->mask + 1 - offset;                              // βռ
+
+    if(1 == length)                                                             // ԪֱӸֵ ʡȥ memcpy 
+    {
+        switch(ring->shift)
+        {
+            case 0:     ((uint8 *)ring->buffer)[offset]  = *dat;                    return;
+            case 1:     ((uint16 *)ring->buffer)[offset] = *(const uint16 *)dat;    return;
+            case 2:     ((uint32 *)ring->buffer)[offset] = *(const uint32 *)dat;    return;
+            default:    break;
+        }
+    }
+    if(first_length > length)
+    {
+        first_length = length;
+    }
+    memcpy((uint8 *)ring->buffer + (offset << ring->shift), dat, first_length << ring->shift);
+    if(length > first_length)
     {
-        fifo->head -= fifo->max;
+        memcpy(ring->buffer, dat + (first_length << ring->shift), (length - first_length) << ring->shift);
     }
 }
 
 //-------------------------------------------------------------------------------------------------------------------
-//      FIFO βָλ
-// ˵     *fifo               FIFO ָ
-// ˵     offset              ƫ
+//      λ ָλö
+// ˵     *ring               λָ
+// ˵     index               λü
+// ˵     *dat                Ŀ껺ָ
+// ˵     length              Ԫظ
 // ز     void
-// ʹʾ     fifo_end_offset(fifo, 1);
-// עϢ     ļڲ ûùע Ҳ޸
+// ʹʾ     ring_copy_out(ring, tail, dat, length);
+// עϢ     ļڲ ûùע Ҳ޸  memcpy
+//-------------------------------------------------------------------------------------------------------------------
+static void ring_copy_out (ring_struct *ring, uint32 index, uint8 *dat, uint32 length)
+{
+    uint32 offset = index & ring->mask;
+    uint32 first_length = ring->mask + 1 - offset;
+
+    if(1 == length)
+    {
+        switch(ring->shift)
+        {
+            case 0:     *dat                = ((uint8 *)ring->buffer)[offset];     return;
+            case 1:     *(uint16 *)dat      = ((uint16 *)ring->buffer)[offset];    return;
+            case 2:     *(uint32 *)dat      = ((uint32 *)ring->buffer)[offset];    return;
+            default:    break;
+        }
+    }
+    if(first_length > length)
+    {
+        first_length = length;
+    }
+    memcpy(dat, (uint8 *)ring->buffer + (offset << ring->shift), first_length << ring->shift);
+    if(length > first_length)
+    {
+        memcpy(dat + (first_length << ring->shift), ring->buffer, (length - first_length) << ring->shift);
+    }
+}
+
+//-------------------------------------------------------------------------------------------------------------------
+//      λ ѯǰݸ
+// ˵     *ring               λָ
+// ز     uint32              ύδԪظ
+// ʹʾ     uint32 len = ring_used(&ring);
+// עϢ
+//-------------------------------------------------------------------------------------------------------------------
+uint32 ring_used (ring_struct *ring)
+{
+    uint32 tail = ring->tail;
+    return ring->head - tail;
+}
+
+//-------------------------------------------------------------------------------------------------------------------
+//      λ ѯʣռ
+// ˵     *ring               λָ
+// ز     uint32              дԪظ
+// ʹʾ     uint32 len = ring_free(&ring);
+// עϢ     SPSC д뷽ʱɿ ȡֻʵʿռ
+//-------------------------------------------------------------------------------------------------------------------
+uint32 ring_free (ring_struct *ring)
+{
+    uint32 head = ring->head;
+    return ring->mask + 1 - (head - ring->tail);
+}
+
+//-------------------------------------------------------------------------------------------------------------------
+//      λ дݣߣ
+// ˵     *ring               λָ
+// ˵     *dat                Դָ
+// ˵     length              Ԫظ
+// ز     uint32              ʵдԪظ ռ䲻ʱֻдܷµĲ
+// ʹʾ     ring_write(&ring, data, 32);
+// עϢ     ֻһд뷽 Ҫж
+//-------------------------------------------------------------------------------------------------------------------
+uint32 ring_write (ring_struct *ring, const void *dat, uint32 length)
+{
+    uint32 head = ring->head;
+    uint32 space = ring->mask + 1 - (head - ring->tail);
+
+    if(length > space)
+    {
+        length = space;
+    }
+    ring_copy_in(ring, head, (const uint8 *)dat, length);
+    RING_MEMORY_BARRIER();                                                      // дŷ head
+    ring->head = head + length;
+
+    return length;
+}
+
+//-------------------------------------------------------------------------------------------------------------------
+//      λ дݣߣ
+// ˵     *ring               λָ
+// ˵     *dat                Դָ
+// ˵     length              Ԫظ
+// ز     uint32              дԪظ ռ䲻ʱ 0
+// ʹʾ     ring_write_mpsc(&log_ring, record, sizeof(record));
+// עϢ      CPU жϿͬʱ ͬһݱ֤  ring_write 
+//              Ԥύڼرձ CPU ж ֹͬд뷽ȴύ
+//-------------------------------------------------------------------------------------------------------------------
+uint32 ring_write_mpsc (ring_struct *ring, const void *dat, uint32 length)
+{
+    uint32 interrupt_state = interrupt_global_disable();
+    uint32 start = 0;
+
+    do
+    {
+        start = ring->reserve;
+        if(length > ring->mask + 1 - (start - ring->tail))
+        {
+            length = 0;
+            break;
+        }
+    }while(start != RING_COMPARE_AND_SWAP(&ring->reserve, start + length, start));
+
+    if(0 != length)
+    {
+        ring_copy_in(ring, start, (const uint8 *)dat, length);
+        RING_MEMORY_BARRIER();
+        while(ring->head != start)                                              // ȴԤǰд뷽ύ
+        {
+            RING_SPIN_WAIT();
+        }
+        ring->head = start + length;
+    }
+    interrupt_global_enable(interrupt_state);
+
+    return length;
+}
+
+//-------------------------------------------------------------------------------------------------------------------
+//      λ ȡݵͷ
+// ˵     *ring               λָ
+// ˵     *dat                Ŀ껺ָ
+// ˵     length              ҪȡԪظ
+// ز     uint32              ʵʶȡԪظ
+// ʹʾ     ring_peek(&ring, data, 32);
+// עϢ
 //-------------------------------------------------------------------------------------------------------------------
-static void fifo_end_offset (fifo_struct *fifo, uint32 offset)
+uint32 ring_peek (ring_struct *ring, void *dat, uint32 length)
 {
-    fifo->end += offset;
-    
-    while(fifo->max <= fifo->end)                                               // ΧС ֱС󻺳С
+    uint32 tail = ring->tail;
+    uint32 used = ring->head - tail;
+
+    RING_MEMORY_BARRIER();                                                      // ȡ head ٶ
+    if(length > used)
     {
-        fifo->end -= fifo->max;
+        length = used;
     }
+    ring_copy_out(ring, tail, (uint8 *)dat, length);
+
+    return length;
+}
+
+//-------------------------------------------------------------------------------------------------------------------
+//      λ ȡݲͷ
+// ˵     *ring               λָ
+// ˵     *dat                Ŀ껺ָ
+// ˵     length              ҪȡԪظ
+// ز     uint32              ʵʶȡԪظ
+// ʹʾ     ring_read(&ring, data, 32);
+// עϢ     ֻһȡ
+//-------------------------------------------------------------------------------------------------------------------
+uint32 ring_read (ring_struct *ring, void *dat, uint32 length)
+{
+    length = ring_peek(ring, dat, length);
+    RING_MEMORY_BARRIER();                                                      // ݶͷſռ
+    ring->tail += length;
+
+    return length;
+}
+
+//-------------------------------------------------------------------------------------------------------------------
+//      λ ȡд ͷ
+// ˵     *ring               λָ
+// ˵     *dat                Ŀ껺ָ
+// ˵     length              ҪȡԪظ
+// ز     uint32              ʵʶȡԪظ
+// ʹʾ     ring_read_newest(&ring, data, 32);
+// עϢ
+//-------------------------------------------------------------------------------------------------------------------
+uint32 ring_read_newest (ring_struct *ring, void *dat, uint32 length)
+{
+    uint32 head = ring->head;
+    uint32 used = head - ring->tail;
+
+    RING_MEMORY_BARRIER();
+    if(length > used)
+    {
+        length = used;
+    }
+    ring_copy_out(ring, head - length, (uint8 *)dat, length);
+
+    return length;
+}
+
+//-------------------------------------------------------------------------------------------------------------------
+//      λ 
+// ˵     *ring               λָ
+// ˵     length              ҪԪظ
+// ز     uint32              ʵʶԪظ
+// ʹʾ     ring_skip(&ring, 32);
+// עϢ     ȡ  ring_peek ʹ
+//-------------------------------------------------------------------------------------------------------------------
+uint32 ring_skip (ring_struct *ring, uint32 length)
+{
+    uint32 tail = ring->tail;
+    uint32 used = ring->head - tail;
+
+    if(length > used)
+    {
+        length = used;
+    }
+    ring->tail = tail + length;
+
+    return length;
+}
+
+//-------------------------------------------------------------------------------------------------------------------
+//      λ 
+// ˵     *ring               λָ
+// ز     void
+// ʹʾ     ring_clear(&ring);
+// עϢ     ȡ ǰύȫ
+//-------------------------------------------------------------------------------------------------------------------
+void ring_clear (ring_struct *ring)
+{
+    ring->tail = ring->head;
+}
+
+//-------------------------------------------------------------------------------------------------------------------
+//      λ ʼ
+// ˵     *ring               λָ
+// ˵     *buffer_addr        ҪصĻ
+// ˵     element_shift       Ԫֽ log2 08bit 116bit 232bit
+// ˵     size                Ԫظ Ϊ 2 
+// ز     void
+// ʹʾ     ring_init(&ring, buffer, 0, 256);
+// עϢ     Ҫд뷽ȡʼʹ֮ǰ
+//-------------------------------------------------------------------------------------------------------------------
+void ring_init (ring_struct *ring, void *buffer_addr, uint32 element_shift, uint32 size)
+{
+    zf_assert(NULL != ring);
+    zf_assert(0 != size && 0 == (size & (size - 1)));
+
+    ring->buffer    = buffer_addr;
+    ring->mask      = size - 1;
+    ring->shift     = element_shift;
+    ring->head      = 0;
+    ring->tail      = 0;
+    ring->reserve   = 0;
 }
 
 //-------------------------------------------------------------------------------------------------------------------
 //      FIFO û
 // ˵     *fifo               FIFO ָ
-// ز     void
+// ز     fifo_state_enum     ״̬
 // ʹʾ     fifo_clear(fifo);
-// עϢ     յǰ FIFO ڴ
+// עϢ     ǰ FIFO еȫ ɶȡ
 //-------------------------------------------------------------------------------------------------------------------
 fifo_state_enum fifo_clear (fifo_struct *fifo)
 {
     zf_assert(NULL != fifo);
-    fifo_state_enum return_state = FIFO_SUCCESS;                                // ֵ
-    do
-    {
-//        if(FIFO_IDLE != fifo->execution)                                        // жǷǰ FIFO Ƿ
-//        {
-//            return_state = FIFO_RESET_UNDO;                                     // òδ
-//            break;
-//        }
-        fifo->execution |= FIFO_RESET;                                          // òλ
-        fifo->head      = 0;                                                    //  FIFO ֵλ
-        fifo->end       = 0;                                                    //  FIFO ֵλ
-        fifo->size      = fifo->max;                                            //  FIFO ֵλ
-        switch(fifo->type)
-        {
-            case FIFO_DATA_8BIT:    memset(fifo->buffer, 0, fifo->max);     break;
-            case FIFO_DATA_16BIT:   memset(fifo->buffer, 0, fifo->max * 2); break;
-            case FIFO_DATA_32BIT:   memset(fifo->buffer, 0, fifo->max * 4); break;
-        }
-        fifo->execution = FIFO_IDLE;                                            // ״̬λ
-    }while(0);
-    return return_state;
+    ring_clear(&fifo->ring);
+    return FIFO_SUCCESS;
 }
 
 //-------------------------------------------------------------------------------------------------------------------
@@ -115,8 +358,8 @@ fifo_state_enum fifo_clear (fifo_struct *fifo)
 //-------------------------------------------------------------------------------------------------------------------
 uint32 fifo_used (fifo_struct *fifo)
 {
-    zf_assert(fifo != NULL);
-    return (fifo->max - fifo->size);                                            // صǰ FIFO ݸ
+    zf_assert(NULL != fifo);
+    return ring_used(&fifo->ring);                                              // صǰ FIFO ݸ
 }
 
 //-------------------------------------------------------------------------------------------------------------------
@@ -130,36 +373,17 @@ uint32 fifo_used (fifo_struct *fifo)
 fifo_state_enum fifo_write_element (fifo_struct *fifo, uint32 dat)
 {
     zf_assert(NULL != fifo);
-    fifo_state_enum return_state = FIFO_SUCCESS;                                // ֵ
+    uint8   dat_8bit    = (uint8)dat;
+    uint16  dat_16bit   = (uint16)dat;
+    void    *element    = &dat;
 
-    do
+    switch(fifo->type)
     {
-        if((FIFO_RESET | FIFO_WRITE) & fifo->execution)                         // д״̬ д뾺ָ
-        {
-            return_state = FIFO_WRITE_UNDO;                                     // дδ
-            break;
-        }
-        fifo->execution |= FIFO_WRITE;                                          // дλ
-
-        if(1 <= fifo->size)                                                     // ʣռ㹻װ±
-        {
-            switch(fifo->type)
-            {
-                case FIFO_DATA_8BIT:    ((uint8 *)fifo->buffer)[fifo->head]  = (uint8)dat;  break;
-                case FIFO_DATA_16BIT:   ((uint16 *)fifo->buffer)[fifo->head] = (uint16)dat; break;
-                case FIFO_DATA_32BIT:   ((uint32 *)fifo->buffer)[fifo->head] = dat; break;
-            }
-            fifo_head_offset(fifo, 1);                                          // ͷָƫ
-            fifo->size -= 1;                                                    // ʣ೤ȼС
-        }
-        else
-        {
-            return_state = FIFO_SPACE_NO_ENOUGH;                                // ǰ FIFO  д ؿռ䲻
-        }
-        fifo->execution &= ~FIFO_WRITE;                                         // дλ
-    }while(0);
-
-    return return_state;
+        case FIFO_DATA_8BIT:    element = &dat_8bit;    break;
+        case FIFO_DATA_16BIT:   element = &dat_16bit;   break;
+        case FIFO_DATA_32BIT:   element = &dat;         break;
+    }
+    return (1 == ring_write(&fifo->ring, element, 1)) ? FIFO_SUCCESS : FIFO_SPACE_NO_ENOUGH;
 }
 
 //-------------------------------------------------------------------------------------------------------------------
@@ -169,110 +393,25 @@ fifo_state_enum fifo_write_element (fifo_struct *fifo, uint32 dat)
 // ˵     length              Ҫдݳ
 // ز     fifo_state_enum     ״̬
 // ʹʾ     zf_log(fifo_write_buffer(&fifo, data, 32) == FIFO_SUCCESS, "fifo_write_buffer error");
-// עϢ
+// עϢ     ռ䲻ʱβд
 //-------------------------------------------------------------------------------------------------------------------
 fifo_state_enum fifo_write_buffer (fifo_struct *fifo, void *dat, uint32 length)
 {
     zf_assert(NULL != fifo);
     fifo_state_enum return_state = FIFO_SUCCESS;                                // ֵ
-    uint32 temp_length = 0;
-    
-    do
-    {
-        if(NULL == dat)
-        {
-            return_state = FIFO_BUFFER_NULL;                                    // û쳣
-            break;
-        }
-        if((FIFO_RESET | FIFO_WRITE) & fifo->execution)                         // д״̬ д뾺ָ
-        {
-            return_state = FIFO_WRITE_UNDO;                                     // дδ
-            break;
-        }
-        fifo->execution |= FIFO_WRITE;                                          // дλ
 
-        if(length <= fifo->size)                                                // ʣռ㹻װ±
-        {
-            temp_length = fifo->max - fifo->head;                               // ͷָ뻺βжٿռ
-
-            if(length > temp_length)                                            // 뻺βȲд λֶβ
-            {
-                switch(fifo->type)
-                {
-                    case FIFO_DATA_8BIT:
-                    {
-                        memcpy(
-                            &(((uint8 *)fifo->buffer)[fifo->head]),
-                            dat, temp_length);                                  // һ
-                        fifo_head_offset(fifo, temp_length);                    // ͷָƫ
-                        memcpy(
-                            &(((uint8 *)fifo->buffer)[fifo->head]),
-                            &(((uint8 *)dat)[temp_length]),
-                            length - temp_length);                              // ڶ
-                        fifo_head_offset(fifo, length - temp_length);           // ͷָƫ
-                    }break;
-                    case FIFO_DATA_16BIT:
-                    {
-                        memcpy(
-                            &(((uint16 *)fifo->buffer)[fifo->head]),
-                            dat, temp_length * 2);                              // һ
-                        fifo_head_offset(fifo, temp_length);                    // ͷָƫ
-                        memcpy(
-                            &(((uint16 *)fifo->buffer)[fifo->head]),
-                            &(((uint16 *)dat)[temp_length]),
-                            (length - temp_length) * 2);                        // ڶ
-                        fifo_head_offset(fifo, length - temp_length);           // ͷָƫ
-                    }break;
-                    case FIFO_DATA_32BIT:
-                    {
-                        memcpy(
-                            &(((uint32 *)fifo->buffer)[fifo->head]),
-                            dat, temp_length * 4);                              // һ
-                        fifo_head_offset(fifo, temp_length);                    // ͷָƫ
-                        memcpy(
-                            &(((uint32 *)fifo->buffer)[fifo->head]),
-                            &(((uint32 *)dat)[temp_length]),
-                            (length - temp_length) * 4);                        // ڶ
-                        fifo_head_offset(fifo, length - temp_length);           // ͷָƫ
-                    }break;
-                }
-            }
-            else
-            {
-                switch(fifo->type)
-                {
-                    case FIFO_DATA_8BIT:
-                    {
-                        memcpy(
-                            &(((uint8 *)fifo->buffer)[fifo->head]),
-                            dat, length);                                       // һд
-                        fifo_head_offset(fifo, length);                         // ͷָƫ
-                    }break;
-                    case FIFO_DATA_16BIT:
-                    {
-                        memcpy(
-                            &(((uint16 *)fifo->buffer)[fifo->head]),
-                            dat, length * 2);                                   // һд
-                        fifo_head_offset(fifo, length);                         // ͷָƫ
-                    }break;
-                    case FIFO_DATA_32BIT:
-                    {
-                        memcpy(
-                            &(((uint32 *)fifo->buffer)[fifo->head]),
-                            dat, length * 4);                                   // һд
-                        fifo_head_offset(fifo, length);                         // ͷָƫ
-                    }break;
-                }
-            }
-
-            fifo->size -= length;                                               // ʣ೤ȼС
-        }
-        else
-        {
-            return_state = FIFO_SPACE_NO_ENOUGH;                                // ǰ FIFO  д ؿռ䲻
-        }
-        fifo->execution &= ~FIFO_WRITE;                                         // дλ
-    }while(0);
+    if(NULL == dat)
+    {
+        return_state = FIFO_BUFFER_NULL;                                        // û쳣
+    }
+    else if(length > ring_free(&fifo->ring))
+    {
+        return_state = FIFO_SPACE_NO_ENOUGH;                                    // ǰ FIFO  д ؿռ䲻
+    }
+    else
+    {
+        ring_write(&fifo->ring, dat, length);
+    }
 
     return return_state;
 }
@@ -290,50 +429,20 @@ fifo_state_enum fifo_read_element (fifo_struct *fifo, void *dat, fifo_operation_
 {
     zf_assert(NULL != fifo);
     fifo_state_enum return_state = FIFO_SUCCESS;                                // ֵ
+    uint32 length = 0;
 
-    do
+    if(NULL == dat)
     {
-        if(NULL == dat)
-        {
-            return_state = FIFO_BUFFER_NULL;                                    // û쳣
-        }
-        else
-        {
-            if((FIFO_RESET | FIFO_CLEAR) & fifo->execution)                     // жǷǰ FIFO Ƿִջò
-            {
-                return_state = FIFO_READ_UNDO;                                  // ȡδ
-                break;
-            }
-
-            if(1 > fifo_used(fifo))
-            {
-                return_state = FIFO_DATA_NO_ENOUGH;                             // û ݳȲ
-                break;                                                          // ֱ˳
-            }
-
-            fifo->execution |= FIFO_READ;                                       // λ
-            switch(fifo->type)
-            {
-                case FIFO_DATA_8BIT:    *((uint8 *)dat) = ((uint8 *)fifo->buffer)[fifo->end];   break;
-                case FIFO_DATA_16BIT:   *((uint16 *)dat) = ((uint16 *)fifo->buffer)[fifo->end]; break;
-                case FIFO_DATA_32BIT:   *((uint32 *)dat) = ((uint32 *)fifo->buffer)[fifo->end]; break;
-            }
-            fifo->execution &= ~FIFO_READ;                                      // λ
-        }
-
-        if(FIFO_READ_AND_CLEAN == flag)                                         // ѡȡ FIFO ״̬
+        return_state = FIFO_BUFFER_NULL;
+    }
+    else
+    {
+        length = (FIFO_READ_AND_CLEAN == flag) ? ring_read(&fifo->ring, dat, 1) : ring_peek(&fifo->ring, dat, 1);
+        if(0 == length)
         {
-            if((FIFO_RESET | FIFO_CLEAR | FIFO_READ) == fifo->execution)        //    ȡ ״̬ 쳣
-            {
-                return_state = FIFO_CLEAR_UNDO;                                 // ղδ
-                break;
-            }
-            fifo->execution |= FIFO_CLEAR;                                      // λ
-            fifo_end_offset(fifo, 1);                                           // ƶ FIFO ͷָ
-            fifo->size += 1;                                                    // ͷŶӦȿռ
-            fifo->execution &= ~FIFO_CLEAR;                                     // λ
+            return_state = FIFO_DATA_NO_ENOUGH;                                 // û ݳȲ
         }
-    }while(0);
+    }
 
     return return_state;
 }
@@ -341,7 +450,7 @@ fifo_state_enum fifo_read_element (fifo_struct *fifo, void *dat, fifo_operation_
 //-------------------------------------------------------------------------------------------------------------------
 //       FIFO ȡ
 // ˵     *fifo               FIFO ָ
-// ˵     *dat                Ŀ껺ָ
+// ˵     *dat                Ŀ껺ָ Ϊ NULL ѡ FIFO_READ_AND_CLEAN ʱ
 // ˵     *length             ȡݳ ûôᱻ޸
 // ˵     flag                Ƿ FIFO ״̬ ѡǷնȡ
 // ز     fifo_state_enum     ״̬
@@ -353,84 +462,31 @@ fifo_state_enum fifo_read_buffer (fifo_struct *fifo, void *dat, uint32 *length,
     zf_assert(NULL != fifo);
     zf_assert(NULL != length);
     fifo_state_enum return_state = FIFO_SUCCESS;                                // ֵ
-    uint32 temp_length = 0;
-    uint32 fifo_data_length = 0;
+    uint32 request_length = *length;
 
-    do
+    if(NULL == dat)
     {
-        if(NULL == dat)
+        return_state = FIFO_BUFFER_NULL;
+        if(FIFO_READ_AND_CLEAN == flag)
         {
-            return_state = FIFO_BUFFER_NULL;
+            *length = ring_skip(&fifo->ring, request_length);
+        }
+    }
+    else
+    {
+        if(FIFO_READ_AND_CLEAN == flag)
+        {
+            *length = ring_read(&fifo->ring, dat, request_length);
         }
         else
         {
-            if((FIFO_RESET | FIFO_CLEAR) & fifo->execution)                     // жǷǰ FIFO Ƿִջò
-            {
-                *length = fifo_data_length;                                     // ȡĳ
-                return_state = FIFO_READ_UNDO;                                  // ȡδ
-                break;
-            }
-
-            fifo_data_length = fifo_used(fifo);                                 // ȡǰж
-            if(*length > fifo_data_length)                                      // жϳǷ㹻
-            {
-                *length = fifo_data_length;                                     // ȡĳ
-                return_state = FIFO_DATA_NO_ENOUGH;                             // ־ݲ
-                if(0 == fifo_data_length)                                       // û ֱ˳
-                {
-                    fifo->execution &= ~FIFO_READ;                              // λ
-                    break;
-                }
-            }
-
-            fifo->execution |= FIFO_READ;                                       // λ
-            temp_length = fifo->max - fifo->end;                                // βָ뻺βжٿռ
-            if(*length <= temp_length)                                          // 㹻һԶȡ
-            {
-                switch(fifo->type)
-                {
-                    case FIFO_DATA_8BIT:    memcpy(dat, &(((uint8 *)fifo->buffer)[fifo->end]), *length);        break;
-                    case FIFO_DATA_16BIT:   memcpy(dat, &(((uint16 *)fifo->buffer)[fifo->end]), *length * 2);   break;
-                    case FIFO_DATA_32BIT:   memcpy(dat, &(((uint32 *)fifo->buffer)[fifo->end]), *length * 4);   break;
-                }
-            }
-            else
-            {
-                switch(fifo->type)
-                {
-                    case FIFO_DATA_8BIT:
-                    {
-                        memcpy(dat, &(((uint8 *)fifo->buffer)[fifo->end]), temp_length);
-                        memcpy(&(((uint8 *)dat)[temp_length]), fifo->buffer, *length - temp_length);
-                    }break;
-                    case FIFO_DATA_16BIT:
-                    {
-                        memcpy(dat, &(((uint16 *)fifo->buffer)[fifo->end]), temp_length * 2);
-                        memcpy(&(((uint16 *)dat)[temp_length]), fifo->buffer, (*length - temp_length) * 2);
-                    }break;
-                    case FIFO_DATA_32BIT:
-                    {
-                        memcpy(dat, &(((uint32 *)fifo->buffer)[fifo->end]), temp_length * 4);
-                        memcpy(&(((uint32 *)dat)[temp_length]), fifo->buffer, (*length - temp_length) * 4);
-                    }break;
-                }
-            }
-            fifo->execution &= ~FIFO_READ;                                      // λ
+            *length = ring_peek(&fifo->ring, dat, request_length);
         }
-
-        if(FIFO_READ_AND_CLEAN == flag)                                         // ѡȡ FIFO ״̬
+        if(*length < request_length)
         {
-            if((FIFO_RESET | FIFO_CLEAR | FIFO_READ) == fifo->execution)        //    ȡ ״̬ 쳣
-            {
-                return_state = FIFO_CLEAR_UNDO;                                 // ղδ
-                break;
-            }
-            fifo->execution |= FIFO_CLEAR;                                      // λ
-            fifo_end_offset(fifo, *length);                                     // ƶ FIFO ͷָ
-            fifo->size += *length;                                              // ͷŶӦȿռ
-            fifo->execution &= ~FIFO_CLEAR;                                     // λ
+            return_state = FIFO_DATA_NO_ENOUGH;                                 // ־ݲ
         }
-    }while(0);
+    }
 
     return return_state;
 }
@@ -444,89 +500,30 @@ fifo_state_enum fifo_read_buffer (fifo_struct *fifo, void *dat, uint32 *length,
 // ز     fifo_state_enum     ״̬
 // ʹʾ     zf_log(fifo_read_tail_buffer(&fifo, data, &length, FIFO_READ_ONLY) == FIFO_SUCCESS, "fifo_read_buffer error");
 // עϢ     ʹ FIFO_READ_AND_CLEAN  ᶪݲ FIFO
-//              ʹ FIFO_READ_AND_CLEAN  ᶪݲ FIFO
-//              ʹ FIFO_READ_AND_CLEAN  ᶪݲ FIFO
 //-------------------------------------------------------------------------------------------------------------------
 fifo_state_enum fifo_read_tail_buffer (fifo_struct *fifo, void *dat, uint32 *length, fifo_operation_enum flag)
 {
     zf_assert(NULL != fifo);
     zf_assert(NULL != length);
     fifo_state_enum return_state = FIFO_SUCCESS;                                // ֵ
-    uint32 temp_length = 0;
-    uint32 fifo_data_length = 0;
+    uint32 request_length = *length;
 
-    do
+    if(NULL == dat)
     {
-        if(NULL == dat)
-        {
-            return_state = FIFO_BUFFER_NULL;
-        }
-        else
-        {
-            if((FIFO_RESET | FIFO_CLEAR | FIFO_WRITE) & fifo->execution)        // жǷǰ FIFO Ƿִջò
-            {
-                *length = fifo_data_length;                                     // ȡĳ
-                return_state = FIFO_READ_UNDO;                                  // ȡδ
-                break;
-            }
-
-            fifo_data_length = fifo_used(fifo);                                 // ȡǰж
-            if(*length > fifo_data_length)                                      // жϳǷ㹻
-            {
-                *length = fifo_data_length;                                     // ȡĳ
-                return_state = FIFO_DATA_NO_ENOUGH;                             // ־ݲ
-                if(0 == fifo_data_length)                                       // û ֱ˳
-                {
-                    fifo->execution &= ~FIFO_READ;                              // λ
-                    break;
-                }
-            }
-
-            fifo->execution |= FIFO_READ;                                       // λ
-            if((fifo->head > fifo->end) || (fifo->head >= *length))
-            {
-                switch(fifo->type)
-                {
-                    case FIFO_DATA_8BIT:    memcpy(dat, &(((uint8 *)fifo->buffer)[fifo->head - *length]), *length);     break;
-                    case FIFO_DATA_16BIT:   memcpy(dat, &(((uint16 *)fifo->buffer)[fifo->head - *length]), *length * 2);break;
-                    case FIFO_DATA_32BIT:   memcpy(dat, &(((uint32 *)fifo->buffer)[fifo->head - *length]), *length * 4);break;
-                }
-            }
-            else
-            {
-                temp_length = *length - fifo->head;                             // βָ뻺βжٿռ
-                switch(fifo->type)
-                {
-                    case FIFO_DATA_8BIT:
-                    {
-                        memcpy(dat, &(((uint8 *)fifo->buffer)[fifo->max - temp_length]), temp_length);
-                        memcpy(&(((uint8 *)dat)[temp_length]), &(((uint8 *)fifo->buffer)[fifo->head - *length]), (*length - temp_length));
-                    }break;
-                    case FIFO_DATA_16BIT:
-                    {
-                        memcpy(dat, &(((uint16 *)fifo->buffer)[fifo->max - temp_length]), temp_length * 2);
-                        memcpy(&(((uint16 *)dat)[temp_length]), &(((uint16 *)fifo->buffer)[fifo->head - *length]), (*length - temp_length) * 2);
-                    }break;
-                    case FIFO_DATA_32BIT:
-                    {
-                        memcpy(dat, &(((uint32 *)fifo->buffer)[fifo->max - temp_length]), temp_length * 4);
-                        memcpy(&(((uint32 *)dat)[temp_length]), &(((uint32 *)fifo->buffer)[fifo->head - *length]), (*length - temp_length) * 4);
-                    }break;
-                }
-            }
-            fifo->execution &= ~FIFO_READ;                                      // λ
-        }
-
-        if(FIFO_READ_AND_CLEAN == flag)                                         // ѡȡ FIFO ״̬
+        return_state = FIFO_BUFFER_NULL;
+    }
+    else
+    {
+        *length = ring_read_newest(&fifo->ring, dat, request_length);
+        if(*length < request_length)
         {
-            if((FIFO_RESET | FIFO_CLEAR | FIFO_READ) == fifo->execution)        //    ȡ ״̬ 쳣
-            {
-                return_state = FIFO_CLEAR_UNDO;                                 // ղδ
-                break;
-            }
-            fifo_clear(fifo);
+            return_state = FIFO_DATA_NO_ENOUGH;                                 // ־ݲ
         }
-    }while(0);
+    }
+    if(FIFO_READ_AND_CLEAN == flag)
+    {
+        ring_clear(&fifo->ring);
+    }
 
     return return_state;
 }
@@ -538,22 +535,15 @@ fifo_state_enum fifo_read_tail_buffer (fifo_struct *fifo, void *dat, uint32 *len
 // ˵     *buffer_addr        ҪصĻ
 // ˵     size                С
 // ز     fifo_state_enum     ״̬
-// ʹʾ     fifo_init(&user_fifo, user_buffer, 64);
-// עϢ
+// ʹʾ     fifo_init(&user_fifo, FIFO_DATA_8BIT, user_buffer, 64);
+// עϢ     size Ϊ 2 
 //-------------------------------------------------------------------------------------------------------------------
 fifo_state_enum fifo_init (fifo_struct *fifo, fifo_data_type_enum type, void *buffer_addr, uint32 size)
 {
     zf_assert(NULL != fifo);
-    fifo_state_enum return_state = FIFO_SUCCESS;
-    do
-    {
-        fifo->buffer    = buffer_addr;
-        fifo->execution = FIFO_IDLE;
-        fifo->type      = type;
-        fifo->head      = 0;
-        fifo->end       = 0;
-        fifo->size      = size;
-        fifo->max       = size;
-    }while(0);
-    return return_state;
+    zf_assert(0 != size && 0 == (size & (size - 1)));
+    fifo->type = type;
+    ring_init(&fifo->ring, buffer_addr, (uint32)type, size);
+
+    return FIFO_SUCCESS;
 }
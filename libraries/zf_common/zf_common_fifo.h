@@ -39,36 +39,59 @@
 
 #include "zf_common_typedef.h"
 
+//=================================================== λ ===================================================
+// ߵߣSPSC
+// д뷽ֻ޸ head ȡֻ޸ tail ߶ɵļ  mask ȡ±
+// дȡҪж ҲᱻԷܾ жѭ  CPU ֮䶼ֱʹ
+// ߵߣMPSC
+// д뷽ͨȽϽCMPSWAP reserve Ԥռ ɺԤ˳ύ head
+// ȡ SPSC ȫͬ
+// ʹ
+// ԪظΪ 2 
+//  CPU ʹʱ ring_struct λڷǻַDSPR  0xB  LMU 0x9  LMU ݻ ֤һ
+typedef struct
+{
+    void            *buffer;                                                    // ָ
+    uint32          mask;                                                       // Ԫظ - 1
+    uint32          shift;                                                      // Ԫֽ log2 08bit 116bit 232bit
+    volatile uint32 head;                                                       // ύд ֻд뷽޸
+    volatile uint32 tail;                                                       //  ֻɶȡ޸
+    volatile uint32 reserve;                                                    // MPSC Ԥд SPSC ʹ
+}ring_struct;
+
+// ̬ʼ size Ϊ 2 
+#define RING_STATIC_INIT(buffer_addr, element_shift, size)  {(buffer_addr), (size) - 1, (element_shift), 0, 0, 0}
+
+uint32          ring_used               (ring_struct *ring);
+uint32          ring_free               (ring_struct *ring);
+
+uint32          ring_write              (ring_struct *ring, const void *dat, uint32 length);
+uint32          ring_write_mpsc         (ring_struct *ring, const void *dat, uint32 length);
+uint32          ring_peek               (ring_struct *ring, void *dat, uint32 length);
+uint32          ring_read               (ring_struct *ring, void *dat, uint32 length);
+uint32          ring_read_newest        (ring_struct *ring, void *dat, uint32 length);
+uint32          ring_skip               (ring_struct *ring, uint32 length);
+void            ring_clear              (ring_struct *ring);
+
+void            ring_init               (ring_struct *ring, void *buffer_addr, uint32 element_shift, uint32 size);
+//=================================================== λ ===================================================
+
+//===================================================== FIFO ӿ =====================================================
+// fifo_xxx ԭнӿ ڲ ring_struct ʵ֣ߵߣ
+// дȡһڲ FIFO_WRITE_UNDO / FIFO_READ_UNDO
 typedef enum
 {
     FIFO_SUCCESS,                                                               // FIFO ɹ
 
-    FIFO_RESET_UNDO,                                                            // FIFO òδִ
-    FIFO_CLEAR_UNDO,                                                            // FIFO ղδִ
+    FIFO_RESET_UNDO,                                                            // FIFO òδִ  ٷ
+    FIFO_CLEAR_UNDO,                                                            // FIFO ղδִ  ٷ
     FIFO_BUFFER_NULL,                                                           // FIFO û쳣
-    FIFO_WRITE_UNDO,                                                            // FIFO дδִ
+    FIFO_WRITE_UNDO,                                                            // FIFO дδִ  ٷ
     FIFO_SPACE_NO_ENOUGH,                                                       // FIFO д ռ䲻
-    FIFO_READ_UNDO,                                                             // FIFO ȡδִ
+    FIFO_READ_UNDO,                                                             // FIFO ȡδִ  ٷ
     FIFO_DATA_NO_ENOUGH,                                                        // FIFO ȡ ݳȲ
 }fifo_state_enum;                                                               // FIFO 
 
-// ߼
-// ò   ǿ FIFO ʹ
-// д   Լдʱ
-// ˳ȡ   պòʱ
-// βȡ   պԼдʱ
-// ȡղ   պԼȡʱ
-// Ϊ˷ֹжǶ׵ݻ
-typedef enum
-{
-    FIFO_IDLE       = 0x00,                                                     // ״̬
-
-    FIFO_RESET      = 0x01,                                                     // ִû
-    FIFO_CLEAR      = 0x02,                                                     // ִջ
-    FIFO_WRITE      = 0x04,                                                     // ִд뻺
-    FIFO_READ       = 0x08,                                                     // ִжȡ
-}fifo_execution_enum;                                                           // FIFO ״̬ ΪǶʹԤ ޷ȫ
-
 typedef enum
 {
     FIFO_READ_AND_CLEAN,                                                        // FIFO ģʽ ȡͷŶӦ
@@ -80,19 +103,17 @@ typedef enum
     FIFO_DATA_8BIT,                                                             // FIFO λ 8bit
     FIFO_DATA_16BIT,                                                            // FIFO λ 16bit
     FIFO_DATA_32BIT,                                                            // FIFO λ 32bit
-}fifo_data_type_enum;
+}fifo_data_type_enum;                                                           // ֵΪԪֽ log2
 
 typedef struct
 {
-    uint8               execution;                                              // ִв
+    ring_struct         ring;                                                   // λ
     fifo_data_type_enum type;                                                   // 
-    void                *buffer;                                                // ָ
-    uint32              head;                                                   // ͷָ ָյĻ
-    uint32              end;                                                    // βָ ָǿջ棨ȫճ⣩
-    uint32              size;                                                   // ʣС
-    uint32              max;                                                    // ܴС
 }fifo_struct;
 
+// ̬ʼ size Ϊ 2 
+#define FIFO_STATIC_INIT(buffer_addr, data_type, size)      {RING_STATIC_INIT((buffer_addr), (data_type), (size)), (data_type)}
+
 fifo_state_enum fifo_clear              (fifo_struct *fifo);
 uint32          fifo_used               (fifo_struct *fifo);
 
@@ -103,5 +124,6 @@ fifo_state_enum fifo_read_buffer        (fifo_struct *fifo, void *dat, uint32 *l
 fifo_state_enum fifo_read_tail_buffer   (fifo_struct *fifo, void *dat, uint32 *length, fifo_operation_enum flag);
 
 fifo_state_enum fifo_init               (fifo_struct *fifo, fifo_data_type_enum type, void *buffer_addr, uint32 size);
+//===================================================== FIFO ӿ =====================================================
 
 #endif
@@ -44,16 +44,7 @@ extern uint32 seekfree_assistant_receive        (uint8 *buff, uint32 length);
 #if (1 == SEEKFREE_ASSISTANT_SET_PARAMETR_ENABLE)
 #include "zf_common_fifo.h"
 static uint8        seekfree_assistant_buffer[SEEKFREE_ASSISTANT_BUFFER_SIZE];                                      // FIFO
-static fifo_struct  seekfree_assistant_fifo =                                                                       // FIFOṹ
-{   
-    .buffer    = seekfree_assistant_buffer, 
-    .execution = FIFO_IDLE, 
-    .type      = FIFO_DATA_8BIT,    
-    .head      = 0, 
-    .end       = 0, 
-    .size      = SEEKFREE_ASSISTANT_BUFFER_SIZE,    
-    .max       = SEEKFREE_ASSISTANT_BUFFER_SIZE,    
-};  
+static fifo_struct  seekfree_assistant_fifo = FIFO_STATIC_INIT(seekfree_assistant_buffer, FIFO_DATA_8BIT, SEEKFREE_ASSISTANT_BUFFER_SIZE);   // FIFOṹ
 #endif
 
 static seekfree_assistant_camera_struct         seekfree_assistant_camera_data;                                     // ͼλЭ
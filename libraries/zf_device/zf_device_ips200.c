@@ -712,6 +712,61 @@ void ips200_show_string (uint16 x, uint16 y, const char dat[])
     }
 }
 
+//-------------------------------------------------------------------------------------------------------------------
+//      IPS200 ʾһַ ֻһʾ
+// ˵     x               x Χ [0, ips200_width_max-1]
+// ˵     y               y Χ [0, ips200_height_max-1]
+// ˵     dat             Ҫʾַ Ҫ '\0' β
+// ˵     len             ַ βܳĻұ߽
+// ز     void
+// ʹʾ     ips200_show_string_run(0, 0, "12.34", 5);
+// עϢ      ips200_show_string ʾЧͬ д ʡȥÿַ
+//              ֻˢ±仯ַľֲ Ŀǰ֧ 6x8  8x16 
+//-------------------------------------------------------------------------------------------------------------------
+void ips200_show_string_run (uint16 x, uint16 y, const char dat[], uint16 len)
+{
+    uint16 line_buffer[320];                                                    // һ Ļ
+    uint8 font_width = 0, font_height = 0;
+    uint16 i = 0, row = 0, col = 0;
+
+    switch(ips200_display_font)
+    {
+        case IPS200_6X8_FONT:   font_width = 6; font_height = 8;    break;
+        case IPS200_8X16_FONT:  font_width = 8; font_height = 16;   break;
+        case IPS200_16X16_FONT: return;                                         // ݲ֧
+    }
+
+    // ˶Ϣ ʾλ
+    // ôһĻʾʱ򳬹ĻֱʷΧ
+    zf_assert(0 < len);
+    zf_assert(x + len * font_width <= ips200_width_max);
+    zf_assert(y + font_height <= ips200_height_max);
+
+    if(IPS200_TYPE_SPI == ips200_display_type)
+    {
+        IPS200_CS(0);
+    }
+    ips200_set_region(x, y, x + len * font_width - 1, y + font_height - 1);
+    for(row = 0; font_height > row; row ++)
+    {
+        for(i = 0; len > i; i ++)
+        {
+            //  32 ΪȡģǴӿոʼȡ ո ascii  32
+            for(col = 0; font_width > col; col ++)
+            {
+                uint8 bits = (6 == font_width) ? (ascii_font_6x8[dat[i] - 32][col] >> row)
+                           : ((8 > row) ? (ascii_font_8x16[dat[i] - 32][col] >> row) : (ascii_font_8x16[dat[i] - 32][col + 8] >> (row - 8)));
+                line_buffer[i * font_width + col] = (bits & 0x01) ? ips200_pencolor : ips200_bgcolor;
+            }
+        }
+        ips200_write_16bit_data_array(line_buffer, len * font_width);
+    }
+    if(IPS200_TYPE_SPI == ips200_display_type)
+    {
+        IPS200_CS(1);
+    }
+}
+
 //-------------------------------------------------------------------------------------------------------------------
 //      IPS200 ʾ32λз (ȥЧ0)
 // ˵     x               x Χ [0, ips200_width_max-1]
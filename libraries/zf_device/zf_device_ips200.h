@@ -175,6 +175,7 @@ void    ips200_draw_line                (uint16 x_start, uint16 y_start, uint16
 
 void    ips200_show_char                (uint16 x, uint16 y, const char dat);
 void    ips200_show_string              (uint16 x, uint16 y, const char dat[]);
+void    ips200_show_string_run          (uint16 x, uint16 y, const char dat[], uint16 len);                                   // IPS200 ʾһַ ֻһʾ
 void    ips200_show_int                 (uint16 x, uint16 y, const int32 dat, uint8 num);
 void    ips200_show_uint                (uint16 x, uint16 y, const uint32 dat, uint8 num);
 void    ips200_show_float               (uint16 x, uint16 y, const double dat, uint8 num, uint8 pointnum);
@@ -83,6 +83,93 @@ static uint8 uart10_tx_buffer[1 + sizeof(Ifx_Fifo) + 8];
 static uint8 uart10_rx_buffer[1 + sizeof(Ifx_Fifo) + 8];
 static uint8 uart11_tx_buffer[1 + sizeof(Ifx_Fifo) + 8];
 static uint8 uart11_rx_buffer[1 + sizeof(Ifx_Fifo) + 8];
+
+#define UART_HW_TX_FIFO_SIZE    (16)                                            // ASCLIN ӲFIFO
+
+// ͻλ 趨һֽ ֿ
+static uint8 uart0_tx_ring[UART0_TX_BUFFER_SIZE + 1];
+static uint8 uart1_tx_ring[UART1_TX_BUFFER_SIZE + 1];
+static uint8 uart2_tx_ring[UART2_TX_BUFFER_SIZE + 1];
+static uint8 uart3_tx_ring[UART3_TX_BUFFER_SIZE + 1];
+static uint8 uart4_tx_ring[UART4_TX_BUFFER_SIZE + 1];
+static uint8 uart5_tx_ring[UART5_TX_BUFFER_SIZE + 1];
+static uint8 uart6_tx_ring[UART6_TX_BUFFER_SIZE + 1];
+static uint8 uart8_tx_ring[UART8_TX_BUFFER_SIZE + 1];
+static uint8 uart9_tx_ring[UART9_TX_BUFFER_SIZE + 1];
+static uint8 uart10_tx_ring[UART10_TX_BUFFER_SIZE + 1];
+static uint8 uart11_tx_ring[UART11_TX_BUFFER_SIZE + 1];
+
+typedef struct
+{
+    uint8           *buffer;
+    uint32          size;                                                       // 鳤 Сڵ1ʾôڲʹû
+    volatile uint32 head;                                                       // дλ  CPU д߳ lock ƽ
+    volatile uint32 tail;                                                       // λ ֻӦжϵ CPU ƽ
+    volatile uint32 dropped;                                                    // ֽ
+    IfxCpu_spinLock lock;                                                       // д߻  CPU Ч
+}uart_tx_ring_struct;
+
+static uart_tx_ring_struct uart_tx_ring_list[] =
+{
+    {uart0_tx_ring,  sizeof(uart0_tx_ring)},
+    {uart1_tx_ring,  sizeof(uart1_tx_ring)},
+    {uart2_tx_ring,  sizeof(uart2_tx_ring)},
+    {uart3_tx_ring,  sizeof(uart3_tx_ring)},
+    {uart4_tx_ring,  sizeof(uart4_tx_ring)},
+    {uart5_tx_ring,  sizeof(uart5_tx_ring)},
+    {uart6_tx_ring,  sizeof(uart6_tx_ring)},
+    {NULL,           0},                                                        // 7 ռλ
+    {uart8_tx_ring,  sizeof(uart8_tx_ring)},
+    {uart9_tx_ring,  sizeof(uart9_tx_ring)},
+    {uart10_tx_ring, sizeof(uart10_tx_ring)},
+    {uart11_tx_ring, sizeof(uart11_tx_ring)},
+};
+
+//-------------------------------------------------------------------------------------------------------------------
+//        ӷͻλݵӲFIFO ֱFIFO򻺳
+// ˵       asclin          ASCLIN ģַ
+// ˵       ring            ͻλ
+// ز       void
+// ʹʾ       uart_tx_fill_fifo(asclin, ring);
+// עϢ       ֻӦôڷжϵ CPU ϵ ǰرж
+//-------------------------------------------------------------------------------------------------------------------
+static void uart_tx_fill_fifo (Ifx_ASCLIN *asclin, uart_tx_ring_struct *ring)
+{
+    uint32 tail = ring->tail;
+    uint32 head = ring->head;
+    sint32 space = UART_HW_TX_FIFO_SIZE - (sint32)IfxAsclin_getTxFifoFillLevel(asclin);
+
+    while(0 < space -- && tail != head)
+    {
+        asclin->TXDATA.U = ring->buffer[tail];
+        tail = (tail + 1 >= ring->size) ? 0 : (tail + 1);
+    }
+    ring->tail = tail;
+}
+
+//-------------------------------------------------------------------------------------------------------------------
+//        ͻλλ
+// ˵       uart_n          ģ  zf_driver_uart.h  uart_index_enum ö嶨
+// ز       void
+// ʹʾ       uart_tx_ring_init(UART_1);
+// עϢ       ʹûĴڴ򿪷жϷ  FIFO ־ֻڻʱʹ
+//-------------------------------------------------------------------------------------------------------------------
+static void uart_tx_ring_init (uart_index_enum uart_n)
+{
+    uart_tx_ring_struct *ring = &uart_tx_ring_list[uart_n];
+    Ifx_ASCLIN *asclin = IfxAsclin_getAddress((IfxAsclin_Index)uart_n);
+
+    ring->head = 0;
+    ring->tail = 0;
+    ring->dropped = 0;
+    IfxCpu_resetSpinLock(&ring->lock);
+    if(1 < ring->size)
+    {
+        IfxAsclin_enableTxFifoFillLevelFlag(asclin, FALSE);
+        IfxAsclin_clearTxFifoFillLevelFlag(asclin);
+        IfxSrc_enable(IfxAsclin_getSrcPointerTx(asclin));
+    }
+}
 //-------------------------------------------------------------------------------------------------------------------
 //        жȼ
 // ˵       uart_n          ģ  zf_driver_uart.h  uart_index_enum ö嶨
@@ -458,10 +545,7 @@ void uart_mux (uart_index_enum uartn, uart_tx_pin_enum tx_pin, uart_rx_pin_enum
 //-------------------------------------------------------------------------------------------------------------------
 void uart_write_byte (uart_index_enum uart_n, const uint8 dat)
 {
-    IfxAsclin_Asc* uart_handle;
-    uart_handle = uart_get_handle(uart_n);
-
-    IfxAsclin_write8(uart_handle->asclin, &dat, 1);
+    uart_write_buffer(uart_n, &dat, 1);
 }
 
 //-------------------------------------------------------------------------------------------------------------------
@@ -469,16 +553,74 @@ void uart_write_byte (uart_index_enum uart_n, const uint8 dat)
 // ˵       uart_n          ģ  zf_driver_uart.h  uart_index_enum ö嶨
 // ˵       *buff           Ҫ͵ַ
 // ˵       len             ͳ
-// ز       void
+// ز       uint32          дֽ С len Ĳ򻺳
 // ʹʾ       uart_write_buffer(UART_1, &a[0], 5);
-// עϢ
+// עϢ       ˷ͻĴ  ɷжϼ
+//                 CPU ɵ д֮ ֻӦжϵ CPU ѻӲFIFO
+//                 CPU д FIFO ־ ɷ CPU ķжϷ
+//                δû ڷ CPU Ĺжϻµãʱ ȷ껺ʣ 
 //-------------------------------------------------------------------------------------------------------------------
-void uart_write_buffer (uart_index_enum uart_n, const uint8 *buff, uint32 len)
+uint32 uart_write_buffer (uart_index_enum uart_n, const uint8 *buff, uint32 len)
 {
-    IfxAsclin_Asc* uart_handle;
-    uart_handle = uart_get_handle(uart_n);
+    uart_tx_ring_struct *ring = &uart_tx_ring_list[uart_n];
+    Ifx_ASCLIN *asclin = IfxAsclin_getAddress((IfxAsclin_Index)uart_n);
+    uint32 head, tail, space, chunk;
+    boolean service_cpu;
+
+    if(1 >= ring->size)
+    {
+        IfxAsclin_write8(asclin, buff, len);
+        return len;
+    }
+
+    service_cpu = (IfxCpu_Irq_getTos(IfxCpu_getCoreIndex()) == IfxAsclin_getSrcPointerTx(asclin)->B.TOS);
+    if(service_cpu && !IfxCpu_areInterruptsEnabled())
+    {
+        uart_tx_flush(uart_n);
+        IfxAsclin_write8(asclin, buff, len);
+        return len;
+    }
+
+    boolean interrupt_state = disableInterrupts();
+    while(!IfxCpu_setSpinLock(&ring->lock, 0xFFFF));                           //  CPU дֻݳ
+
+    head  = ring->head;
+    tail  = ring->tail;
+    space = (tail > head) ? (tail - head - 1) : (ring->size - head + tail - 1);
+    if(len > space)
+    {
+        ring->dropped += len - space;
+        len = space;
+    }
+
+    chunk = ring->size - head;                                                  // ĩβռ
+    if(chunk > len)
+    {
+        chunk = len;
+    }
+    memcpy(&ring->buffer[head], buff, chunk);
+    memcpy(&ring->buffer[0], buff + chunk, len - chunk);
+    head += len;
+    __dsync();                                                                  //  head Է CPU ɼ
+    ring->head = (head >= ring->size) ? (head - ring->size) : head;
+    __dsync();
+    IfxCpu_resetSpinLock(&ring->lock);
+
+    if(service_cpu)
+    {
+        uart_tx_fill_fifo(asclin, ring);                                        // ӲFIFOпλֱ
+        if(ring->tail != ring->head)
+        {
+            IfxAsclin_enableTxFifoFillLevelFlag(asclin, TRUE);                  // ʣݽж
+        }
+    }
+    else if(0 != len)
+    {
+        IfxAsclin_enableTxFifoFillLevelFlag(asclin, TRUE);                      // ѷ CPU ķж
+    }
 
-    IfxAsclin_write8(uart_handle->asclin, buff, len);
+    restoreInterrupts(interrupt_state);
+    return len;
 }
 
 
@@ -492,12 +634,93 @@ void uart_write_buffer (uart_index_enum uart_n, const uint8 *buff, uint32 len)
 //-------------------------------------------------------------------------------------------------------------------
 void uart_write_string (uart_index_enum uart_n, const char *str)
 {
-    while(*str)
+    uart_write_buffer(uart_n, (const uint8 *)str, strlen(str));
+}
+
+//-------------------------------------------------------------------------------------------------------------------
+//        ڷжϴ ӷͻӲFIFO
+// ˵       uart_n          ģ  zf_driver_uart.h  uart_index_enum ö嶨
+// ز       void
+// ʹʾ       uart_tx_handler(UART_1);
+// עϢ        isr.c Ӧ uartx_tx_isr е պر FIFO ־
+//                رպټһ  CPU ڹرǰд벢˱־
+//-------------------------------------------------------------------------------------------------------------------
+void uart_tx_handler (uart_index_enum uart_n)
+{
+    uart_tx_ring_struct *ring = &uart_tx_ring_list[uart_n];
+    Ifx_ASCLIN *asclin = IfxAsclin_getAddress((IfxAsclin_Index)uart_n);
+
+    if(1 >= ring->size)
+    {
+        return;
+    }
+
+    boolean interrupt_state = disableInterrupts();
+    IfxAsclin_clearTxFifoFillLevelFlag(asclin);
+    uart_tx_fill_fifo(asclin, ring);
+    if(ring->tail == ring->head)
+    {
+        IfxAsclin_enableTxFifoFillLevelFlag(asclin, FALSE);
+        if(ring->tail != ring->head)
+        {
+            IfxAsclin_enableTxFifoFillLevelFlag(asclin, TRUE);
+        }
+    }
+    restoreInterrupts(interrupt_state);
+}
+
+//-------------------------------------------------------------------------------------------------------------------
+//        귢ͻڵȫ
+// ˵       uart_n          ģ  zf_driver_uart.h  uart_index_enum ö嶨
+// ز       void
+// ʹʾ       uart_tx_flush(UART_1);
+// עϢ       жϻҲʹ Ƿ CPU ʱȴ CPU ķж
+//-------------------------------------------------------------------------------------------------------------------
+void uart_tx_flush (uart_index_enum uart_n)
+{
+    uart_tx_ring_struct *ring = &uart_tx_ring_list[uart_n];
+    Ifx_ASCLIN *asclin = IfxAsclin_getAddress((IfxAsclin_Index)uart_n);
+    boolean service_cpu = (IfxCpu_Irq_getTos(IfxCpu_getCoreIndex()) == IfxAsclin_getSrcPointerTx(asclin)->B.TOS);
+
+    while(ring->tail != ring->head)
     {
-        uart_write_byte(uart_n, *str++);
+        if(service_cpu)
+        {
+            boolean interrupt_state = disableInterrupts();
+            uart_tx_fill_fifo(asclin, ring);
+            restoreInterrupts(interrupt_state);
+        }
     }
 }
 
+//-------------------------------------------------------------------------------------------------------------------
+//        ȡͻеȴ͵ֽ
+// ˵       uart_n          ģ  zf_driver_uart.h  uart_index_enum ö嶨
+// ز       uint32          ȴ͵ֽ ӲFIFOе
+// ʹʾ       uint32 pending = uart_tx_pending(UART_1);
+// עϢ
+//-------------------------------------------------------------------------------------------------------------------
+uint32 uart_tx_pending (uart_index_enum uart_n)
+{
+    uart_tx_ring_struct *ring = &uart_tx_ring_list[uart_n];
+    uint32 head = ring->head;
+    uint32 tail = ring->tail;
+
+    return (head >= tail) ? (head - tail) : (ring->size - tail + head);
+}
+
+//-------------------------------------------------------------------------------------------------------------------
+//        ȡͻۼֽ
+// ˵       uart_n          ģ  zf_driver_uart.h  uart_index_enum ö嶨
+// ز       uint32          ֽ ڳʼʱ
+// ʹʾ       uint32 dropped = uart_tx_dropped(UART_1);
+// עϢ
+//-------------------------------------------------------------------------------------------------------------------
+uint32 uart_tx_dropped (uart_index_enum uart_n)
+{
+    return uart_tx_ring_list[uart_n].dropped;
+}
+
 //-------------------------------------------------------------------------------------------------------------------
 //        ȡڽյݣwhlieȴ
 // ˵       uart_n          ģ  zf_driver_uart.h  uart_index_enum ö嶨
@@ -641,6 +864,7 @@ void uart_sbus_init (uart_index_enum uartn, uint32 baud, uart_tx_pin_enum tx_pin
     IfxAsclin_Asc_initModule(uart_get_handle(uartn), &uart_config);
     uart_rx_interrupt(uartn, 1);
     uart_tx_interrupt(uartn, 0);
+    uart_tx_ring_init(uartn);
     restoreInterrupts(interrupt_state);
 
 }
@@ -685,5 +909,6 @@ void uart_init (uart_index_enum uart_n, uint32 baud, uart_tx_pin_enum tx_pin, ua
     IfxAsclin_Asc_initModule(uart_get_handle(uart_n), &uart_config);
     uart_rx_interrupt(uart_n, 0);
     uart_tx_interrupt(uart_n, 0);
+    uart_tx_ring_init(uart_n);                              // ʹ÷ͻʱ򿪷жϷ
     restoreInterrupts(interrupt_state);
 }
@@ -40,6 +40,22 @@
 #include "ifxAsclin_Asc.h"
 #include "zf_common_typedef.h"
 
+// ڷͻλСֽڣ
+// 0   ʹû uart_write_xxx ֽڵȴӲɺŷأԭʼΪ
+// 0 ݿ ɷжϰ˵ӲFIFO ʱݱ
+// ʹûĴ  CPU д ֻзжڵ CPU  isr.c Ӧ uartx_tx_isr Ҫ uart_tx_handler()
+#define UART0_TX_BUFFER_SIZE    (1024)  // debug  printf
+#define UART1_TX_BUFFER_SIZE    (0)
+#define UART2_TX_BUFFER_SIZE    (0)
+#define UART3_TX_BUFFER_SIZE    (0)
+#define UART4_TX_BUFFER_SIZE    (0)
+#define UART5_TX_BUFFER_SIZE    (64)    // YIS ̬ģ
+#define UART6_TX_BUFFER_SIZE    (256)   // ODrive ASCII Э
+#define UART8_TX_BUFFER_SIZE    (0)
+#define UART9_TX_BUFFER_SIZE    (0)
+#define UART10_TX_BUFFER_SIZE   (0)
+#define UART11_TX_BUFFER_SIZE   (0)
+
 
 typedef enum            // öٴ öٶ岻û޸
 {
@@ -166,9 +182,14 @@ extern IfxAsclin_Asc uart11_handle;
 
 //==================================================== ====================================================
 void    uart_write_byte                     (uart_index_enum uartn, const uint8 dat);
-void    uart_write_buffer                   (uart_index_enum uartn, const uint8 *buff, uint32 len);
+uint32  uart_write_buffer                   (uart_index_enum uartn, const uint8 *buff, uint32 len);
 void    uart_write_string                   (uart_index_enum uartn, const char *str);
 
+void    uart_tx_handler                     (uart_index_enum uartn);
+void    uart_tx_flush                       (uart_index_enum uartn);
+uint32  uart_tx_pending                     (uart_index_enum uartn);
+uint32  uart_tx_dropped                     (uart_index_enum uartn);
+
 uint8   uart_read_byte                      (uart_index_enum uartn);
 uint8   uart_query_byte                     (uart_index_enum uartn, uint8 *dat);
 
@@ -0,0 +1,142 @@
+/* bike_plant.c - see bike_plant.h */
+#include "bike_plant.h"
+#include <math.h>
+#include <string.h>
+#include <stddef.h>
+
+#define PLANT_G             (9.81)
+#define PLANT_TWO_PI        (6.283185307179586)
+
+void bike_plant_default_param(bike_plant_param_t *p)
+{
+    p->mass_kg = 4.5f;
+    p->com_height_m = 0.16f;
+    p->frame_inertia = 0.16f;
+    p->roll_damping = 0.02f;
+    p->com_offset_m = 0.0f;
+
+    p->wheel_inertia = 0.0045f;
+    p->wheel_friction = 0.0004f;
+    p->torque_max = 2.5f;
+    p->wheel_speed_max = 60.0f;
+    p->torque_sign = 1.0f;
+
+    p->speed_mps = 0.0f;
+    p->speed_tau_s = 0.8f;
+    p->wheelbase_m = 0.3f;
+    p->com_ahead_m = 0.1f;
+    p->servo_rate_dps = 400.0f;
+
+    p->imu_rate_hz = 100.0f;
+    p->imu_latency_s = 0.004f;
+    p->imu_roll_noise_deg = 0.05f;
+    p->imu_gyro_noise_dps = 0.3f;
+    p->imu_gyro_bias_dps = 0.0f;
+    p->imu_acc_noise = 0.05f;
+    p->imu_roll_offset_deg = 0.0f;
+    p->cmd_latency_s = 0.0012f;
+}
+
+void bike_plant_reset(bike_plant_state_t *s, double roll_deg)
+{
+    memset(s, 0, sizeof(*s));
+    s->roll = roll_deg * (PLANT_TWO_PI / 360.0);
+}
+
+/* Available motor torque falls linearly to zero at the no-load speed. */
+static double plant_motor_torque(const bike_plant_param_t *p, double cmd, double wheel_speed)
+{
+    double w_max = p->wheel_speed_max * PLANT_TWO_PI;
+    double headroom = 1.0 - fabs(wheel_speed) / w_max;
+    double limit;
+
+    if (headroom < 0.0) headroom = 0.0;
+    /* derating only applies when the command would speed the wheel up further */
+    limit = ((cmd * wheel_speed) > 0.0) ? p->torque_max * headroom : p->torque_max;
+
+    if (cmd > limit) return limit;
+    if (cmd < -limit) return -limit;
+    return cmd;
+}
+
+/* One semi-implicit Euler step. The caller keeps dt <= 1ms. */
+void bike_plant_step(const bike_plant_param_t *p, bike_plant_state_t *s, double torque_cmd, double dt)
+{
+    double tau = plant_motor_torque(p, torque_cmd, s->wheel_speed);
+    double gravity = p->mass_kg * PLANT_G * p->com_height_m * sin(s->roll)
+                   + p->mass_kg * PLANT_G * p->com_offset_m * cos(s->roll);
+    double reaction = p->torque_sign * tau;
+    double steer_step = p->servo_rate_dps * (PLANT_TWO_PI / 360.0) * dt;
+    double steer_last = s->steer;
+    double steering;
+    double wheel_acc_abs;
+
+    s->torque_applied = tau;
+
+    /* drive spin-up, then the steering servo slews towards its command */
+    s->speed += (p->speed_mps - s->speed) * (dt / (p->speed_tau_s + dt));
+    s->steer += fmax(-steer_step, fmin(steer_step, s->steer_cmd - s->steer));
+    s->steer_rate = (s->steer - steer_last) / dt;
+    steering = p->mass_kg * p->com_height_m / p->wheelbase_m
+             * (s->speed * s->speed * s->steer + p->com_ahead_m * s->speed * s->steer_rate) * cos(s->roll);
+
+    /* frame: gravity tips it over, motor reaction torque and steering push back */
+    s->roll_acc = (gravity - reaction - p->roll_damping * s->roll_rate + s->disturbance) / p->frame_inertia;
+    s->roll_acc -= steering / p->frame_inertia;
+
+    /* wheel: absolute acceleration driven by motor torque minus bearing friction */
+    wheel_acc_abs = (tau - p->wheel_friction * s->wheel_speed) / p->wheel_inertia;
+
+    s->roll_rate += s->roll_acc * dt;
+    s->roll += s->roll_rate * dt;
+    /* wheel speed is measured relative to the frame (ODrive encoder) */
+    s->wheel_speed += (wheel_acc_abs - p->torque_sign * s->roll_acc) * dt;
+}
+
+typedef struct
+{
+    const char *name;
+    size_t offset;
+} plant_param_entry_t;
+
+static const plant_param_entry_t plant_param_table[] =
+{
+    { "mass",               offsetof(bike_plant_param_t, mass_kg) },
+    { "com_height",         offsetof(bike_plant_param_t, com_height_m) },
+    { "frame_inertia",      offsetof(bike_plant_param_t, frame_inertia) },
+    { "roll_damping",       offsetof(bike_plant_param_t, roll_damping) },
+    { "com_offset",         offsetof(bike_plant_param_t, com_offset_m) },
+    { "wheel_inertia",      offsetof(bike_plant_param_t, wheel_inertia) },
+    { "wheel_friction",     offsetof(bike_plant_param_t, wheel_friction) },
+    { "torque_max",         offsetof(bike_plant_param_t, torque_max) },
+    { "wheel_speed_max",    offsetof(bike_plant_param_t, wheel_speed_max) },
+    { "torque_sign",        offsetof(bike_plant_param_t, torque_sign) },
+    { "speed",              offsetof(bike_plant_param_t, speed_mps) },
+    { "speed_tau",          offsetof(bike_plant_param_t, speed_tau_s) },
+    { "wheelbase",          offsetof(bike_plant_param_t, wheelbase_m) },
+    { "com_ahead",          offsetof(bike_plant_param_t, com_ahead_m) },
+    { "servo_rate",         offsetof(bike_plant_param_t, servo_rate_dps) },
+    { "imu_rate",           offsetof(bike_plant_param_t, imu_rate_hz) },
+    { "imu_latency",        offsetof(bike_plant_param_t, imu_latency_s) },
+    { "roll_noise",         offsetof(bike_plant_param_t, imu_roll_noise_deg) },
+    { "gyro_noise",         offsetof(bike_plant_param_t, imu_gyro_noise_dps) },
+    { "gyro_bias",          offsetof(bike_plant_param_t, imu_gyro_bias_dps) },
+    { "acc_noise",          offsetof(bike_plant_param_t, imu_acc_noise) },
+    { "roll_offset",        offsetof(bike_plant_param_t, imu_roll_offset_deg) },
+    { "cmd_latency",        offsetof(bike_plant_param_t, cmd_latency_s) },
+};
+
+/* Returns 0 on success, -1 for an unknown parameter name. */
+int bike_plant_set_param(bike_plant_param_t *p, const char *name, float value)
+{
+    size_t i;
+    for (i = 0; i < sizeof(plant_param_table) / sizeof(plant_param_table[0]); i++)
+    {
+        if (strcmp(name, plant_param_table[i].name) == 0)
+        {
+            *(float *)((char *)p + plant_param_table[i].offset) = value;
+            return 0;
+        }
+    }
+    return -1;
+}
@@ -0,0 +1,71 @@
+/* bike_plant.h - reaction wheel bicycle roll model for the host simulation
+ *
+ * Lateral (roll) plane only: the bike is an inverted pendulum about the tyre
+ * contact line, the ODrive reaction wheel sits on the frame. Positive motor
+ * torque accelerates the wheel forward and pushes the frame towards negative
+ * roll (same sign convention the firmware uses: velocity_pid.kp < 0).
+ *
+ * Rolling forward at speed v, steering by delta moves the contact line under
+ * the frame: with the centre of mass com_ahead_m in front of the rear contact,
+ * the roll torque is m * h / wheelbase * (v^2 * delta + com_ahead * v * delta')
+ * (point mass, no trail or gyroscopic terms). The bike starts at rest and
+ * spins up to speed_mps with speed_tau_s; the steering follows its command at
+ * the servo's rate, a positive angle steers towards positive roll.
+ */
+#ifndef BIKE_PLANT_H
+#define BIKE_PLANT_H
+
+typedef struct
+{
+    /* frame */
+    float mass_kg;              /* total mass */
+    float com_height_m;         /* centre of mass above ground */
+    float frame_inertia;        /* roll inertia about the contact line (kg*m^2) */
+    float roll_damping;         /* viscous roll damping (N*m*s/rad) */
+    float com_offset_m;         /* lateral centre of mass offset (load off centre): a steady roll torque */
+
+    /* reaction wheel + ODrive */
+    float wheel_inertia;        /* kg*m^2 */
+    float wheel_friction;       /* viscous friction (N*m*s/rad) */
+    float torque_max;           /* stall torque the motor can deliver (N*m) */
+    float wheel_speed_max;      /* no-load speed (turns/s), torque derates linearly towards it */
+    float torque_sign;          /* +1: firmware torque > 0 pushes roll negative */
+
+    /* rolling and steering */
+    float speed_mps;            /* forward speed the drive is commanded to */
+    float speed_tau_s;          /* drive spin-up, first order */
+    float wheelbase_m;
+    float com_ahead_m;          /* centre of mass ahead of the rear contact */
+    float servo_rate_dps;       /* steering servo slew rate */
+
+    /* sensing / comms */
+    float imu_rate_hz;          /* YIS output rate */
+    float imu_latency_s;        /* internal filter + UART frame time */
+    float imu_roll_noise_deg;   /* 1 sigma */
+    float imu_gyro_noise_dps;   /* 1 sigma */
+    float imu_gyro_bias_dps;    /* constant gyro bias on the roll axis */
+    float imu_acc_noise;        /* accelerometer noise, m/s^2 1 sigma */
+    float imu_roll_offset_deg;  /* mounting offset seen by the IMU */
+    float cmd_latency_s;        /* torque command wire time (ASCII @115200 is ~1.2ms) */
+} bike_plant_param_t;
+
+typedef struct
+{
+    double roll;                /* rad */
+    double roll_rate;           /* rad/s */
+    double roll_acc;            /* rad/s^2, last step */
+    double wheel_speed;         /* rad/s, wheel relative to frame */
+    double torque_applied;      /* N*m actually produced by the motor */
+    double disturbance;         /* external roll torque (N*m) */
+    double speed;               /* m/s forward */
+    double steer;               /* rad, positive steers towards positive roll */
+    double steer_rate;          /* rad/s, last step */
+    double steer_cmd;           /* rad, servo command */
+} bike_plant_state_t;
+
+void  bike_plant_default_param  (bike_plant_param_t *p);
+void  bike_plant_reset          (bike_plant_state_t *s, double roll_deg);
+void  bike_plant_step           (const bike_plant_param_t *p, bike_plant_state_t *s, double torque_cmd, double dt);
+int   bike_plant_set_param      (bike_plant_param_t *p, const char *name, float value);
+
+#endif
@@ -0,0 +1,205 @@
+/* estimator_replay.c - replay a recorded YIS log through code/control/attitude_estimator.c
+ *
+ * Build (from the repository root):
+ *   gcc -O2 -std=c99 -Itools/sim/host -Icode/control \
+ *       tools/sim/estimator_replay.c code/control/attitude_estimator.c -lm -o estimator_replay
+ *
+ * Usage:
+ *   ./estimator_replay log.csv [-o estimates.csv]
+ *   ./estimator_replay -synth log.csv          write a synthetic log (truth column included)
+ *
+ * Log format, one frame per line (header lines starting with a letter or '#' are skipped):
+ *   t_s, gyro_x_dps, acc_y, acc_z, yis_roll_deg [, true_roll_deg]
+ *
+ * For every mode the tool prints the RMS error and the delay that best aligns the
+ * estimate with the reference (true roll when the log has it, otherwise the YIS roll).
+ * A smaller delay than the YIS pass-through is the phase-lag improvement we want.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "zf_common_headfile.h"
+#include "attitude_estimator.h"
+
+#define REPLAY_MAX_LAG_S        (0.1)
+
+typedef struct
+{
+    double t;
+    float gx, ay, az, yis_roll, truth;
+} replay_frame_t;
+
+/* host stand-in, the estimator itself never reads the clock */
+uint32 system_getval(void)
+{
+    return 0;
+}
+
+static replay_frame_t *frames = NULL;
+static size_t frame_count = 0;
+static int has_truth = 0;
+
+static int load_log(const char *path)
+{
+    char line[256];
+    size_t cap = 0;
+    FILE *f = fopen(path, "r");
+
+    if (!f)
+    {
+        fprintf(stderr, "cannot open %s\n", path);
+        return -1;
+    }
+    has_truth = 1;
+    while (fgets(line, sizeof(line), f))
+    {
+        replay_frame_t fr;
+        int n;
+
+        if (line[0] == '#' || (line[0] >= 'A' && line[0] <= 'z')) continue;
+        n = sscanf(line, "%lf,%f,%f,%f,%f,%f", &fr.t, &fr.gx, &fr.ay, &fr.az, &fr.yis_roll, &fr.truth);
+        if (n < 5) continue;
+        if (n < 6) has_truth = 0;
+        if (frame_count == cap)
+        {
+            cap = cap ? cap * 2 : 4096;
+            frames = (replay_frame_t *)realloc(frames, cap * sizeof(*frames));
+        }
+        frames[frame_count++] = fr;
+    }
+    fclose(f);
+    return frame_count > 1 ? 0 : -1;
+}
+
+static double gauss(void)
+{
+    double u1 = (rand() + 1.0) / (RAND_MAX + 2.0);
+    double u2 = (rand() + 1.0) / (RAND_MAX + 2.0);
+    return sqrt(-2.0 * log(u1)) * cos(6.283185307179586 * u2);
+}
+
+/* Roll motion with steps and two tones, YIS output modelled as 15ms delay + 25ms first order lag. */
+static int write_synthetic(const char *path)
+{
+    const double rate = 200.0, dur = 60.0, bias = 0.8, g = 9.80665;
+    const double delay = 0.015, tau = 0.025;
+    double t, roll, prev_roll = 0.0, yis = 0.0;
+    double hist[64] = { 0 };
+    int i, n = (int)(rate * dur), dly = (int)(delay * rate + 0.5);
+    FILE *f = fopen(path, "w");
+
+    if (!f) return -1;
+    srand(1);
+    fprintf(f, "t_s,gyro_x_dps,acc_y,acc_z,yis_roll_deg,true_roll_deg\n");
+    for (i = 0; i < n; i++)
+    {
+        double rate_dps, r;
+        t = i / rate;
+        roll = 3.0 * sin(6.2832 * 0.5 * t) + 1.5 * sin(6.2832 * 1.7 * t) + ((int)(t / 5.0) % 2 ? 4.0 : 0.0);
+        rate_dps = (i > 0) ? (roll - prev_roll) * rate : 0.0;
+        prev_roll = roll;
+        hist[i % 64] = roll;
+        yis += (hist[(i - dly + 64) % 64] - yis) * (1.0 / rate) / (tau + 1.0 / rate);
+        r = roll / 57.29577951308232;
+        fprintf(f, "%.4f,%.4f,%.4f,%.4f,%.4f,%.4f\n", t,
+                rate_dps + bias + 0.3 * gauss(),
+                g * sin(r) + 0.3 * gauss(), g * cos(r) + 0.3 * gauss(),
+                yis + 0.05 * gauss(), roll);
+    }
+    fclose(f);
+    return 0;
+}
+
+/* delay (s) that minimises the RMS between est[i] and ref[i - k] */
+static double best_lag(const float *est, const float *ref, size_t n, double dt, double *rms_out)
+{
+    int k, best_k = 0, max_k = (int)(REPLAY_MAX_LAG_S / dt);
+    double best = 1e30;
+    size_t i;
+
+    for (k = -max_k; k <= max_k; k++)
+    {
+        double sum = 0.0;
+        size_t cnt = 0;
+        for (i = (size_t)max_k; i + (size_t)max_k < n; i++)
+        {
+            double e = est[i] - ref[(long)i - k];
+            sum += e * e;
+            cnt++;
+        }
+        sum = cnt ? sqrt(sum / cnt) : 1e30;
+        if (k == 0) *rms_out = sum;
+        if (sum < best)
+        {
+            best = sum;
+            best_k = k;
+        }
+    }
+    return best_k * dt;
+}
+
+int main(int argc, char **argv)
+{
+    static const char *mode_name[] = { "yis", "complementary", "ekf" };
+    const char *out_path = NULL;
+    float *est[3], *ref;
+    FILE *out = NULL;
+    double dt_mean;
+    int m, i;
+    size_t k;
+
+    if (argc >= 3 && strcmp(argv[1], "-synth") == 0)
+    {
+        return write_synthetic(argv[2]) == 0 ? 0 : 1;
+    }
+    if (argc < 2 || load_log(argv[1]) != 0)
+    {
+        fprintf(stderr, "usage: %s log.csv [-o estimates.csv] | -synth log.csv\n", argv[0]);
+        return 1;
+    }
+    for (i = 2; i + 1 < argc; i++)
+    {
+        if (strcmp(argv[i], "-o") == 0) out_path = argv[++i];
+    }
+
+    ref = (float *)malloc(frame_count * sizeof(float));
+    for (m = 0; m < 3; m++)
+    {
+        est[m] = (float *)malloc(frame_count * sizeof(float));
+        attitude_estimator_init((attitude_mode_enum)m);
+        for (k = 0; k < frame_count; k++)
+        {
+            float dt = (k > 0) ? (float)(frames[k].t - frames[k - 1].t) : 0.0f;
+            attitude_estimator_update(frames[k].gx, frames[k].ay, frames[k].az, frames[k].yis_roll, dt);
+            est[m][k] = attitude_estimator_get_roll();
+        }
+    }
+    for (k = 0; k < frame_count; k++)
+    {
+        ref[k] = has_truth ? frames[k].truth : frames[k].yis_roll;
+    }
+
+    dt_mean = (frames[frame_count - 1].t - frames[0].t) / (double)(frame_count - 1);
+    printf("%zu frames, %.1f Hz, reference: %s\n", frame_count, 1.0 / dt_mean,
+           has_truth ? "true roll" : "YIS roll (positive lag = later than the module)");
+    printf("%-14s %10s %10s\n", "mode", "rms_deg", "lag_ms");
+    for (m = 0; m < 3; m++)
+    {
+        double rms = 0.0;
+        double lag = best_lag(est[m], ref, frame_count, dt_mean, &rms);
+        printf("%-14s %10.3f %10.1f\n", mode_name[m], rms, lag * 1000.0);
+    }
+
+    if (out_path && (out = fopen(out_path, "w")) != NULL)
+    {
+        fprintf(out, "t_s,ref_deg,yis_deg,cf_deg,ekf_deg\n");
+        for (k = 0; k < frame_count; k++)
+        {
+            fprintf(out, "%.4f,%.4f,%.4f,%.4f,%.4f\n", frames[k].t, ref[k], est[0][k], est[1][k], est[2][k]);
+        }
+        fclose(out);
+    }
+    return 0;
+}
@@ -0,0 +1,327 @@
+/* fifo_bench.c - libraries/zf_common/zf_common_fifo.c throughput and concurrency check
+ *
+ * Build (from the repository root):
+ *   gcc -O2 -std=c99 -pthread -Itools/sim/host -Itools/sim -Ilibraries/zf_common \
+ *       tools/sim/fifo_bench.c tools/sim/fifo_legacy.c libraries/zf_common/zf_common_fifo.c \
+ *       -o fifo_bench
+ *
+ * Part 1 pushes the same byte stream through the old execution-flag FIFO
+ * (fifo_legacy.c), the fifo_xxx shim and ring_xxx directly, one element at a
+ * time (UART RX ISR pattern) and in 16 / 64 byte blocks, and prints ns per byte.
+ * Part 2 runs ring_write/ring_read with producer and consumer on two threads and
+ * ring_write_mpsc with three producers, verifying every byte and the order of
+ * every record. Exit code 1 on any mismatch.
+ */
+#define _POSIX_C_SOURCE 200809L
+#include <pthread.h>
+#include <time.h>
+
+#include "zf_common_debug.h"
+#include "zf_common_fifo.h"
+#include "fifo_legacy.h"
+
+#define BENCH_BUFFER_SIZE       (1024)
+#define BENCH_THREAD_BUFFER     (65536)                 /* few hand-overs when the host has a single CPU */
+#define BENCH_BYTES             (16u * 1024u * 1024u)
+#define BENCH_STREAM_BYTES      (16u * 1024u * 1024u)
+#define BENCH_PRODUCERS         (3)
+#define BENCH_RECORDS           (200000u)
+
+static int failures = 0;
+
+void debug_assert_handler(uint8 pass, char *file, int line)
+{
+    if (!pass)
+    {
+        fprintf(stderr, "assert %s:%d\n", file, line);
+        exit(2);
+    }
+}
+
+uint32 interrupt_global_disable(void)
+{
+    return 0;
+}
+
+void interrupt_global_enable(uint32 primask)
+{
+    (void)primask;
+}
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* ------------------------------------------------------------------ part 1 */
+
+static uint8 storage[BENCH_BUFFER_SIZE];
+
+typedef enum { IMPL_LEGACY, IMPL_FIFO, IMPL_RING } impl_t;
+static const char *impl_name[] = { "legacy fifo", "fifo shim", "ring" };
+
+/* returns ns per byte, checksum guards against the loop being optimised out */
+static double run_single(impl_t impl, uint32 chunk, uint32 *checksum)
+{
+    legacy_fifo_struct legacy;
+    fifo_struct fifo;
+    ring_struct ring;
+    uint8 in[64], out[64];
+    uint32 sum = 0;
+    uint32 i, n;
+    double t0, t1;
+
+    legacy_fifo_init(&legacy, FIFO_DATA_8BIT, storage, BENCH_BUFFER_SIZE);
+    fifo_init(&fifo, FIFO_DATA_8BIT, storage, BENCH_BUFFER_SIZE);
+    ring_init(&ring, storage, 0, BENCH_BUFFER_SIZE);
+    for (i = 0; i < sizeof(in); i++)
+        in[i] = (uint8)(i * 7 + 1);
+
+    /* keep the buffer half full so block copies regularly wrap */
+    for (i = 0; i < BENCH_BUFFER_SIZE / 2 + 3; i++)
+    {
+        switch (impl)
+        {
+            case IMPL_LEGACY: legacy_fifo_write_element(&legacy, i); break;
+            case IMPL_FIFO:   fifo_write_element(&fifo, i); break;
+            case IMPL_RING:   ring_write(&ring, &in[i & 63], 1); break;
+        }
+    }
+
+    t0 = now_s();
+    for (n = 0; n < BENCH_BYTES; n += chunk)
+    {
+        uint32 length = chunk;
+        in[0] = (uint8)n;
+        switch (impl)
+        {
+            case IMPL_LEGACY:
+                if (1 == chunk)
+                {
+                    legacy_fifo_write_element(&legacy, in[0]);
+                    legacy_fifo_read_element(&legacy, out, FIFO_READ_AND_CLEAN);
+                }
+                else
+                {
+                    legacy_fifo_write_buffer(&legacy, in, chunk);
+                    legacy_fifo_read_buffer(&legacy, out, &length, FIFO_READ_AND_CLEAN);
+                }
+                break;
+            case IMPL_FIFO:
+                if (1 == chunk)
+                {
+                    fifo_write_element(&fifo, in[0]);
+                    fifo_read_element(&fifo, out, FIFO_READ_AND_CLEAN);
+                }
+                else
+                {
+                    fifo_write_buffer(&fifo, in, chunk);
+                    fifo_read_buffer(&fifo, out, &length, FIFO_READ_AND_CLEAN);
+                }
+                break;
+            case IMPL_RING:
+                ring_write(&ring, in, chunk);
+                ring_read(&ring, out, chunk);
+                break;
+        }
+        sum += out[0] + out[chunk - 1];
+    }
+    t1 = now_s();
+
+    *checksum += sum;
+    return (t1 - t0) * 1e9 / BENCH_BYTES;
+}
+
+/* same byte sequence out of all three implementations */
+static void check_equivalence(void)
+{
+    static uint8 s1[BENCH_BUFFER_SIZE], s2[BENCH_BUFFER_SIZE];
+    legacy_fifo_struct legacy;
+    fifo_struct fifo;
+    uint8 in[97], a[97], b[97];
+    uint32 i, round, la, lb;
+
+    legacy_fifo_init(&legacy, FIFO_DATA_8BIT, s1, BENCH_BUFFER_SIZE);
+    fifo_init(&fifo, FIFO_DATA_8BIT, s2, BENCH_BUFFER_SIZE);
+    srand(1);
+    for (round = 0; round < 200000; round++)
+    {
+        uint32 w = (uint32)rand() % sizeof(in);
+        uint32 r = (uint32)rand() % sizeof(in);
+        for (i = 0; i < w; i++)
+            in[i] = (uint8)rand();
+        if (legacy_fifo_write_buffer(&legacy, in, w) != fifo_write_buffer(&fifo, in, w))
+            failures++;
+        la = lb = r;
+        fifo_operation_enum op = (round & 3) ? FIFO_READ_AND_CLEAN : FIFO_READ_ONLY;
+        if (legacy_fifo_read_buffer(&legacy, a, &la, op) != fifo_read_buffer(&fifo, b, &lb, op)
+            || la != lb || memcmp(a, b, la) || legacy_fifo_used(&legacy) != fifo_used(&fifo))
+            failures++;
+        if (0 == round % 1000)
+        {
+            /* the legacy tail read indexes before the buffer once the data
+             * wraps, so check the newest bytes against a full peek instead */
+            static uint8 all[BENCH_BUFFER_SIZE];
+            uint32 used = fifo_used(&fifo);
+            la = used;
+            lb = 13;
+            fifo_read_buffer(&fifo, all, &la, FIFO_READ_ONLY);
+            fifo_read_tail_buffer(&fifo, b, &lb, FIFO_READ_ONLY);
+            if (lb != (used < 13 ? used : 13) || memcmp(all + used - lb, b, lb))
+                failures++;
+        }
+    }
+    printf("legacy / shim equivalence: 200000 random rounds, %s\n", failures ? "MISMATCH" : "identical");
+}
+
+/* ------------------------------------------------------------------ part 2 */
+
+static uint8 spsc_storage[BENCH_THREAD_BUFFER];
+static ring_struct spsc_ring;
+
+static void *spsc_producer(void *arg)
+{
+    uint8 block[64];
+    uint32 sent = 0, seed = 7;
+    (void)arg;
+    while (sent < BENCH_STREAM_BYTES)
+    {
+        uint32 i, length, written;
+        seed = seed * 1103515245u + 12345u;
+        length = 1 + (seed >> 16) % sizeof(block);
+        if (length > BENCH_STREAM_BYTES - sent)
+            length = BENCH_STREAM_BYTES - sent;
+        for (i = 0; i < length; i++)
+            block[i] = (uint8)(sent + i);
+        for (i = 0; i < length; i += written)
+            written = ring_write(&spsc_ring, block + i, length - i);
+        sent += length;
+    }
+    return NULL;
+}
+
+static void run_spsc(void)
+{
+    pthread_t producer;
+    uint8 block[80];
+    uint32 got = 0, errors = 0;
+    double t0, t1;
+
+    ring_init(&spsc_ring, spsc_storage, 0, BENCH_THREAD_BUFFER);
+    t0 = now_s();
+    pthread_create(&producer, NULL, spsc_producer, NULL);
+    while (got < BENCH_STREAM_BYTES)
+    {
+        uint32 i, length = ring_read(&spsc_ring, block, sizeof(block));
+        for (i = 0; i < length; i++)
+            if (block[i] != (uint8)(got + i))
+                errors++;
+        got += length;
+    }
+    pthread_join(producer, NULL);
+    t1 = now_s();
+
+    printf("spsc 2 threads: %u MB in %.2f s (%.1f MB/s), %u byte errors\n",
+           BENCH_STREAM_BYTES >> 20, t1 - t0, BENCH_STREAM_BYTES / (t1 - t0) / 1e6, errors);
+    failures += errors != 0;
+}
+
+typedef struct
+{
+    uint32 producer;
+    uint32 sequence;
+    uint32 check;
+} record_t;
+
+static uint32 mpsc_storage[BENCH_THREAD_BUFFER];
+static ring_struct mpsc_ring;
+
+static void *mpsc_producer(void *arg)
+{
+    record_t record;
+    record.producer = (uint32)(uintptr_t)arg;
+    for (record.sequence = 0; record.sequence < BENCH_RECORDS; record.sequence++)
+    {
+        record.check = record.producer * 0x9E3779B9u ^ record.sequence;
+        while (0 == ring_write_mpsc(&mpsc_ring, &record, sizeof(record) / 4))
+            sched_yield();
+    }
+    return NULL;
+}
+
+static void run_mpsc(void)
+{
+    pthread_t producer[BENCH_PRODUCERS];
+    uint32 expect[BENCH_PRODUCERS] = { 0 };
+    uint32 got = 0, errors = 0, p;
+    record_t record;
+    double t0, t1;
+
+    ring_init(&mpsc_ring, mpsc_storage, 2, BENCH_THREAD_BUFFER);
+    t0 = now_s();
+    for (p = 0; p < BENCH_PRODUCERS; p++)
+        pthread_create(&producer[p], NULL, mpsc_producer, (void *)(uintptr_t)p);
+    while (got < BENCH_PRODUCERS * BENCH_RECORDS)
+    {
+        if (ring_used(&mpsc_ring) < sizeof(record) / 4)
+            continue;
+        ring_read(&mpsc_ring, &record, sizeof(record) / 4);
+        if (record.producer >= BENCH_PRODUCERS
+            || record.sequence != expect[record.producer]
+            || record.check != (record.producer * 0x9E3779B9u ^ record.sequence))
+        {
+            errors++;
+        }
+        else
+        {
+            expect[record.producer]++;
+        }
+        got++;
+    }
+    for (p = 0; p < BENCH_PRODUCERS; p++)
+        pthread_join(producer[p], NULL);
+    t1 = now_s();
+
+    printf("mpsc %d producers: %u records in %.2f s (%.1f M records/s), %u torn/out-of-order\n",
+           BENCH_PRODUCERS, got, t1 - t0, got / (t1 - t0) / 1e6, errors);
+    failures += errors != 0;
+}
+
+int main(void)
+{
+    static const uint32 chunks[] = { 1, 16, 64 };
+    uint32 checksum = 0;
+    uint32 c;
+    int i;
+
+    check_equivalence();
+
+    printf("\n%-12s", "ns/byte");
+    for (c = 0; c < sizeof(chunks) / sizeof(chunks[0]); c++)
+        printf(" %9s%-3u", "block ", chunks[c]);
+    printf("\n");
+    for (i = IMPL_LEGACY; i <= IMPL_RING; i++)
+    {
+        printf("%-12s", impl_name[i]);
+        for (c = 0; c < sizeof(chunks) / sizeof(chunks[0]); c++)
+        {
+            double best = 1e9;
+            int repeat;
+            for (repeat = 0; repeat < 5; repeat++)          /* best of 5, host timing is noisy */
+            {
+                double t = run_single((impl_t)i, chunks[c], &checksum);
+                best = t < best ? t : best;
+            }
+            printf(" %12.3f", best);
+        }
+        printf("\n");
+    }
+    printf("(checksum %08x)\n\n", checksum);
+
+    run_spsc();
+    run_mpsc();
+
+    return failures ? 1 : 0;
+}
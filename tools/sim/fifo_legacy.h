@@ -0,0 +1,41 @@
+/* fifo_legacy.h - the fifo_struct implementation before the lock-free ring
+ *
+ * Verbatim logic of the old libraries/zf_common/zf_common_fifo.c (execution
+ * bitmask, per-type switch, modulo offsets), renamed to legacy_fifo_* so that
+ * fifo_bench.c can time it next to the current ring. Host only.
+ */
+#ifndef _fifo_legacy_h_
+#define _fifo_legacy_h_
+
+#include "zf_common_fifo.h"
+
+typedef enum
+{
+    LEGACY_FIFO_IDLE    = 0x00,
+    LEGACY_FIFO_RESET   = 0x01,
+    LEGACY_FIFO_CLEAR   = 0x02,
+    LEGACY_FIFO_WRITE   = 0x04,
+    LEGACY_FIFO_READ    = 0x08,
+}legacy_fifo_execution_enum;
+
+typedef struct
+{
+    uint8               execution;
+    fifo_data_type_enum type;
+    void                *buffer;
+    uint32              head;
+    uint32              end;
+    uint32              size;
+    uint32              max;
+}legacy_fifo_struct;
+
+fifo_state_enum legacy_fifo_clear               (legacy_fifo_struct *fifo);
+uint32          legacy_fifo_used                (legacy_fifo_struct *fifo);
+fifo_state_enum legacy_fifo_write_element       (legacy_fifo_struct *fifo, uint32 dat);
+fifo_state_enum legacy_fifo_write_buffer        (legacy_fifo_struct *fifo, void *dat, uint32 length);
+fifo_state_enum legacy_fifo_read_element        (legacy_fifo_struct *fifo, void *dat, fifo_operation_enum flag);
+fifo_state_enum legacy_fifo_read_buffer         (legacy_fifo_struct *fifo, void *dat, uint32 *length, fifo_operation_enum flag);
+fifo_state_enum legacy_fifo_read_tail_buffer    (legacy_fifo_struct *fifo, void *dat, uint32 *length, fifo_operation_enum flag);
+fifo_state_enum legacy_fifo_init                (legacy_fifo_struct *fifo, fifo_data_type_enum type, void *buffer_addr, uint32 size);
+
+#endif
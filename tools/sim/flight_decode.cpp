@@ -0,0 +1,269 @@
+// flight_decode.cpp - code/system/flight_recorder.c trace -> CSV
+//
+// Build (from the repository root):
+//   g++ -O2 -std=c++17 -Wall -Wextra tools/sim/flight_decode.cpp -o flight_decode
+//
+// Input is a raw capture of the debug UART after 'd' (any terminal log saved as
+// binary works, text around the trace is skipped) or a DFlash image. Every
+// "FREC" stream found is checked (version, record size, CRC-32) and written as
+// CSV, time in seconds relative to the trigger record. With several traces in
+// one capture, -o name.csv writes name_1.csv, name_2.csv, ...
+//
+//   ./flight_decode capture.bin > fall.csv
+//   ./flight_decode capture.bin -o fall.csv
+//
+// Exit code 1 when no valid trace was found.
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Must match flight_recorder.h (wire format, little endian)
+constexpr uint32_t kMagic = 0x43455246u;        // "FREC"
+constexpr uint16_t kVersion = 1;
+constexpr size_t kHeaderSize = 32;
+constexpr size_t kRecordSize = 40;
+constexpr uint32_t kMaxRecords = 65536;
+
+constexpr uint8_t kFlagEnable = 0x01;
+constexpr uint8_t kFlagAngleLoop = 0x02;
+constexpr uint8_t kFlagSpeedValid = 0x04;
+constexpr uint8_t kFlagTrigger = 0x08;
+constexpr uint8_t kFlagImuStale = 0x10;
+constexpr uint8_t kFlagWatchdog = 0x20;
+constexpr uint8_t kFlagLqr = 0x40;
+constexpr uint8_t kFlagDesatLimit = 0x80;
+
+const char *const kCauseNames[] = { "none", "fall", "manual", "imu_stale" };
+
+struct Header
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t record_size;
+    uint32_t record_count;
+    uint32_t trigger_index;
+    uint32_t tick_hz;
+    uint32_t cause;
+};
+
+struct Record
+{
+    uint32_t timestamp;
+    float roll, roll_rate, target_angle, target_rate;
+    float angle_integral, rate_integral, torque_cmd, wheel_speed;
+    uint16_t isr_us;
+    uint8_t flags;
+    uint8_t sequence;
+};
+
+uint32_t get_u32(const uint8_t *p)
+{
+    return uint32_t(p[0]) | uint32_t(p[1]) << 8 | uint32_t(p[2]) << 16 | uint32_t(p[3]) << 24;
+}
+
+uint16_t get_u16(const uint8_t *p)
+{
+    return uint16_t(p[0] | p[1] << 8);
+}
+
+float get_f32(const uint8_t *p)
+{
+    uint32_t bits = get_u32(p);
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+uint32_t crc32(const uint8_t *data, size_t length)
+{
+    uint32_t crc = 0xFFFFFFFFu;
+    while (length-- > 0)
+    {
+        crc ^= *data++;
+        for (int bit = 0; bit < 8; bit++)
+            crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
+
+Header parse_header(const uint8_t *p)
+{
+    Header h;
+    h.magic = get_u32(p);
+    h.version = get_u16(p + 4);
+    h.record_size = get_u16(p + 6);
+    h.record_count = get_u32(p + 8);
+    h.trigger_index = get_u32(p + 12);
+    h.tick_hz = get_u32(p + 16);
+    h.cause = get_u32(p + 20);
+    return h;
+}
+
+Record parse_record(const uint8_t *p)
+{
+    Record r;
+    r.timestamp = get_u32(p);
+    r.roll = get_f32(p + 4);
+    r.roll_rate = get_f32(p + 8);
+    r.target_angle = get_f32(p + 12);
+    r.target_rate = get_f32(p + 16);
+    r.angle_integral = get_f32(p + 20);
+    r.rate_integral = get_f32(p + 24);
+    r.torque_cmd = get_f32(p + 28);
+    r.wheel_speed = get_f32(p + 32);
+    r.isr_us = get_u16(p + 36);
+    r.flags = p[38];
+    r.sequence = p[39];
+    return r;
+}
+
+void write_csv(std::ostream &out, const Header &h, const std::vector<Record> &records)
+{
+    uint32_t trigger_ts = h.trigger_index < records.size() ? records[h.trigger_index].timestamp : 0;
+
+    out << "t_s,sequence,roll,roll_rate,target_angle,target_rate,angle_integral,rate_integral,"
+           "torque_cmd,wheel_speed,isr_us,enable,angle_loop,speed_valid,trigger,imu_stale,watchdog,lqr,desat_limit\n";
+    for (const Record &r : records)
+    {
+        // STM wraps after 2^32 ticks (43 s at 100 MHz); a 5 s trace never spans more than one wrap
+        double t = double(int32_t(r.timestamp - trigger_ts)) / h.tick_hz;
+        char line[320];
+        std::snprintf(line, sizeof(line), "%.6f,%u,%.4f,%.4f,%.4f,%.4f,%.5f,%.5f,%.4f,%.4f,%u,%d,%d,%d,%d,%d,%d,%d,%d\n",
+                      t, r.sequence, r.roll, r.roll_rate, r.target_angle, r.target_rate,
+                      r.angle_integral, r.rate_integral, r.torque_cmd, r.wheel_speed, r.isr_us,
+                      (r.flags & kFlagEnable) != 0, (r.flags & kFlagAngleLoop) != 0,
+                      (r.flags & kFlagSpeedValid) != 0, (r.flags & kFlagTrigger) != 0,
+                      (r.flags & kFlagImuStale) != 0, (r.flags & kFlagWatchdog) != 0,
+                      (r.flags & kFlagLqr) != 0, (r.flags & kFlagDesatLimit) != 0);
+        out << line;
+    }
+}
+
+std::string numbered(const std::string &name, int index)
+{
+    size_t dot = name.rfind('.');
+    std::string suffix = "_" + std::to_string(index);
+    return dot == std::string::npos ? name + suffix : name.substr(0, dot) + suffix + name.substr(dot);
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    std::string input, output;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "-o" && i + 1 < argc)
+            output = argv[++i];
+        else if (input.empty() && arg[0] != '-')
+            input = arg;
+        else
+        {
+            std::cerr << "usage: flight_decode capture.bin [-o trace.csv]\n";
+            return 2;
+        }
+    }
+    if (input.empty())
+    {
+        std::cerr << "usage: flight_decode capture.bin [-o trace.csv]\n";
+        return 2;
+    }
+
+    std::ifstream file(input, std::ios::binary);
+    if (!file)
+    {
+        std::cerr << "cannot open " << input << "\n";
+        return 2;
+    }
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    // first pass: find every valid stream
+    struct Trace { size_t offset; Header header; };
+    std::vector<Trace> traces;
+    for (size_t pos = 0; pos + kHeaderSize + 4 <= data.size(); pos++)
+    {
+        if (get_u32(&data[pos]) != kMagic)
+            continue;
+
+        Header h = parse_header(&data[pos]);
+        if (h.version != kVersion || h.record_size != kRecordSize || h.record_count > kMaxRecords || h.tick_hz == 0)
+        {
+            std::cerr << "offset " << pos << ": unsupported header (version " << h.version
+                      << ", record size " << h.record_size << ")\n";
+            continue;
+        }
+
+        size_t length = kHeaderSize + size_t(h.record_count) * kRecordSize;
+        if (pos + length + 4 > data.size())
+        {
+            std::cerr << "offset " << pos << ": truncated, " << data.size() - pos << " of "
+                      << length + 4 << " bytes\n";
+            continue;
+        }
+        if (crc32(&data[pos], length) != get_u32(&data[pos + length]))
+        {
+            std::cerr << "offset " << pos << ": CRC mismatch (bytes lost or text mixed into the stream)\n";
+            continue;
+        }
+
+        traces.push_back({ pos, h });
+        pos += length + 3;
+    }
+
+    if (traces.empty())
+    {
+        std::cerr << "no valid trace in " << input << "\n";
+        return 1;
+    }
+
+    for (size_t n = 0; n < traces.size(); n++)
+    {
+        const Header &h = traces[n].header;
+        const uint8_t *p = &data[traces[n].offset + kHeaderSize];
+        std::vector<Record> records;
+        unsigned gaps = 0;
+
+        for (uint32_t i = 0; i < h.record_count; i++)
+        {
+            records.push_back(parse_record(p + size_t(i) * kRecordSize));
+            if (i > 0 && uint8_t(records[i - 1].sequence + 1) != records[i].sequence)
+                gaps++;
+        }
+
+        std::cerr << "trace " << n + 1 << ": " << h.record_count << " records, cause "
+                  << (h.cause < 4 ? kCauseNames[h.cause] : "?") << ", trigger at " << h.trigger_index;
+        if (records.size() > 1)
+        {
+            double span = double(records.back().timestamp - records.front().timestamp) / h.tick_hz;
+            std::cerr << ", " << span << " s";
+        }
+        std::cerr << ", " << gaps << " sequence gaps\n";
+
+        if (output.empty())
+        {
+            write_csv(std::cout, h, records);
+        }
+        else
+        {
+            std::string name = traces.size() > 1 ? numbered(output, int(n + 1)) : output;
+            std::ofstream out(name);
+            if (!out)
+            {
+                std::cerr << "cannot write " << name << "\n";
+                return 2;
+            }
+            write_csv(out, h, records);
+        }
+    }
+    return 0;
+}
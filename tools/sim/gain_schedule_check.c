@@ -0,0 +1,367 @@
+/* gain_schedule_check.c - code/control/gain_schedule.c interpolation, record and swap check
+ *
+ * Build (from the repository root):
+ *   gcc -O2 -std=c99 -pthread -Itools/sim/host -Icode/control -Icode/system \
+ *       -Ilibraries/infineon_libraries/Service/CpuGeneric/SysSe/Math \
+ *       tools/sim/gain_schedule_check.c code/control/gain_schedule.c code/system/snapshot.c \
+ *       libraries/infineon_libraries/Service/CpuGeneric/SysSe/Math/Ifx_LutLinearF32.c -lm -o gain_schedule_check
+ *   ./gain_schedule_check
+ *
+ * On a table with uneven breakpoints and random gains:
+ *   interpolation  gain_schedule_eval() against a double precision reference at
+ *                  random speeds, the breakpoints and outside the range (held)
+ *   iLLD           the same value as Ifx_LutLinearF32_searchPosSeq() and
+ *                  _searchBin() on each compiled LUT inside the range
+ *   continuity     both segments meeting at a breakpoint give its value
+ *   validation     non-increasing or non-finite breakpoints and gains refused
+ *   record         pack / unpack round trip; every single bit flip, another
+ *                  shape and a valid record of an invalid table refused
+ *   swap           a writer thread publishes whole tables through a snapshot
+ *                  while a reader does what the 5ms ISR does (compile on a new
+ *                  sequence, evaluate): every evaluation comes from one table
+ * Also times eval against nine separate searches, and compile.
+ * Exit code 1 when a check fails.
+ */
+#define _POSIX_C_SOURCE 200809L
+#include <pthread.h>
+#include <time.h>
+
+#include "gain_schedule.h"
+#include "snapshot.h"
+
+#define CHECK_SPEEDS            (200000)
+#define CHECK_PUBLISHES         (2000000u)
+#define CHECK_TOLERANCE         (2e-5)
+
+static int failures = 0;
+static uint32 rng_state = 5;
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static double uniform(void)
+{
+    rng_state = rng_state * 1664525u + 1013904223u;
+    return (rng_state >> 8) / 16777216.0;
+}
+
+static double gauss(void)
+{
+    double u1, u2;
+
+    rng_state = rng_state * 1664525u + 1013904223u;
+    u1 = ((rng_state >> 8) + 1.0) / 16777217.0;
+    rng_state = rng_state * 1664525u + 1013904223u;
+    u2 = (rng_state >> 8) / 16777216.0;
+    return sqrt(-2.0 * log(u1)) * cos(6.283185307179586 * u2);
+}
+
+static void expect(int ok, const char *what)
+{
+    printf("  %-62s %s\n", what, ok ? "ok" : "FAIL");
+    failures += !ok;
+}
+
+static void test_table(gain_schedule_table_t *t)
+{
+    static const float speeds[GAIN_SCHEDULE_POINTS] = { 0.0f, 0.8f, 1.5f, 2.5f, 3.5f, 5.0f };
+    uint32 g, i;
+
+    memcpy(t->speed_mps, speeds, sizeof(speeds));
+    for (g = 0; g < GAIN_SCHEDULE_GAIN_NUM; g++)
+    {
+        for (i = 0; i < GAIN_SCHEDULE_POINTS; i++)
+        {
+            t->gain[g][i] = (float)(gauss() * (g + 1.0));
+        }
+    }
+}
+
+/* clamped linear interpolation in double */
+static double reference(const gain_schedule_table_t *t, uint32 g, double speed)
+{
+    uint32 i = 0;
+
+    if (speed <= t->speed_mps[0]) return t->gain[g][0];
+    if (speed >= t->speed_mps[GAIN_SCHEDULE_POINTS - 1]) return t->gain[g][GAIN_SCHEDULE_POINTS - 1];
+    while (speed > t->speed_mps[i + 1u]) i++;
+    return t->gain[g][i] + ((double)t->gain[g][i + 1u] - t->gain[g][i])
+           * (speed - t->speed_mps[i]) / ((double)t->speed_mps[i + 1u] - t->speed_mps[i]);
+}
+
+static double scale(const gain_schedule_table_t *t, uint32 g)
+{
+    double m = 1.0;
+    uint32 i;
+
+    for (i = 0; i < GAIN_SCHEDULE_POINTS; i++) m = fmax(m, fabs(t->gain[g][i]));
+    return m;
+}
+
+/* ================= swap ================= */
+static gain_schedule_table_t swap_slots[2];
+static snapshot_t swap_snapshot;
+static volatile int writer_done = 0;
+
+typedef struct
+{
+    uint32 compiles;
+    uint32 evals;
+    uint32 mixed;
+    uint32 backwards;
+} swap_result_t;
+
+static void *writer(void *arg)
+{
+    gain_schedule_table_t t;
+    uint32 k, g;
+
+    (void)arg;
+    test_table(&t);
+    for (k = 1; k <= CHECK_PUBLISHES; k++)
+    {
+        for (g = 0; g < GAIN_SCHEDULE_GAIN_NUM; g++)
+        {
+            gain_schedule_fill(&t, (gain_schedule_gain_enum)g, (float)k);
+        }
+        snapshot_publish(&swap_snapshot, &t);
+    }
+    writer_done = 1;
+    return NULL;
+}
+
+static void *reader(void *arg)
+{
+    swap_result_t *r = (swap_result_t *)arg;
+    gain_schedule_table_t received;
+    gain_schedule_lut_t lut;
+    float gain[GAIN_SCHEDULE_GAIN_NUM], last = 0.0f;
+    uint32 applied = 0, sequence, g;
+    uint32 speed = 0;
+    int compiled = 0;
+
+    while (!writer_done)
+    {
+        sequence = snapshot_sequence(&swap_snapshot);
+        if (sequence != applied && snapshot_read(&swap_snapshot, &received))
+        {
+            applied = sequence;
+            gain_schedule_compile(&lut, &received);
+            compiled = 1;
+            r->compiles++;
+        }
+        if (!compiled) continue;
+        gain_schedule_eval(&lut, (float)(speed++ % 60u) * 0.1f, gain);
+        r->evals++;
+        for (g = 1; g < GAIN_SCHEDULE_GAIN_NUM; g++)
+        {
+            if (gain[g] != gain[0])
+            {
+                r->mixed++;
+                break;
+            }
+        }
+        if (gain[0] < last) r->backwards++;
+        last = gain[0];
+    }
+    return NULL;
+}
+
+int main(void)
+{
+    gain_schedule_table_t t;
+    gain_schedule_lut_t lut;
+    char line[96];
+
+    test_table(&t);
+    expect(gain_schedule_valid(&t), "validation: test table accepted");
+    gain_schedule_compile(&lut, &t);
+
+    /* interpolation, iLLD */
+    {
+        float gain[GAIN_SCHEDULE_GAIN_NUM];
+        double err = 0.0, err_ifx = 0.0, err_bin = 0.0;
+        uint32 g;
+        int n;
+
+        for (n = 0; n < CHECK_SPEEDS + GAIN_SCHEDULE_POINTS + 1; n++)
+        {
+            float speed;
+
+            if (n < GAIN_SCHEDULE_POINTS) speed = t.speed_mps[n];
+            else if (n == GAIN_SCHEDULE_POINTS) speed = NAN;
+            else speed = (float)(uniform() * 7.0 - 1.0);
+
+            gain_schedule_eval(&lut, speed, gain);
+            for (g = 0; g < GAIN_SCHEDULE_GAIN_NUM; g++)
+            {
+                double want = reference(&t, g, isnan(speed) ? t.speed_mps[0] : speed);
+
+                err = fmax(err, fabs(gain[g] - want) / scale(&t, g));
+                if (speed >= t.speed_mps[0] && speed <= t.speed_mps[GAIN_SCHEDULE_POINTS - 1])
+                {
+                    err_ifx = fmax(err_ifx, fabs(gain[g] - Ifx_LutLinearF32_searchPosSeq(&lut.lut[g], speed)));
+                    err_bin = fmax(err_bin, fabs(gain[g] - Ifx_LutLinearF32_searchBin(&lut.lut[g], speed)));
+                }
+            }
+        }
+        printf("interpolation: max error %.2e of the row range, %.2e / %.2e from searchPosSeq / searchBin\n",
+               err, err_ifx, err_bin);
+        expect(err < CHECK_TOLERANCE, "interpolation: matches the reference, held outside the range");
+        expect(err_ifx == 0.0 && err_bin == 0.0, "iLLD: same value as searchPosSeq and searchBin");
+    }
+
+    /* continuity */
+    {
+        double jump = 0.0;
+        uint32 g, i;
+
+        for (g = 0; g < GAIN_SCHEDULE_GAIN_NUM; g++)
+        {
+            for (i = 1; i < GAIN_SCHEDULE_POINTS - 1u; i++)
+            {
+                float x = t.speed_mps[i];
+                const Ifx_LutLinearF32_Item *a = &lut.segment[g][i - 1u], *b = &lut.segment[g][i];
+
+                jump = fmax(jump, fabs((a->gain * x + a->offset) - (b->gain * x + b->offset)) / scale(&t, g));
+            }
+        }
+        snprintf(line, sizeof(line), "continuity: segments agree at the breakpoints (%.1e)", jump);
+        expect(jump < CHECK_TOLERANCE, line);
+    }
+
+    /* validation */
+    {
+        gain_schedule_table_t bad = t;
+        int refused = 1;
+
+        bad.speed_mps[3] = bad.speed_mps[2];
+        refused &= !gain_schedule_valid(&bad);
+        bad = t;
+        bad.speed_mps[4] = 0.1f;
+        refused &= !gain_schedule_valid(&bad);
+        bad = t;
+        bad.speed_mps[5] = INFINITY;
+        refused &= !gain_schedule_valid(&bad);
+        bad = t;
+        bad.gain[GAIN_LQR_WHEEL][2] = NAN;
+        refused &= !gain_schedule_valid(&bad);
+        expect(refused, "validation: repeated, decreasing, infinite breakpoint, NaN refused");
+    }
+
+    /* record */
+    {
+        uint32 record[GAIN_SCHEDULE_RECORD_WORDS], damaged[GAIN_SCHEDULE_RECORD_WORDS];
+        gain_schedule_table_t out, untouched;
+        uint32 w, b, accepted = 0;
+
+        gain_schedule_pack(&t, record);
+        expect(gain_schedule_unpack(record, &out) && memcmp(&out, &t, sizeof(t)) == 0,
+               "record: round trip");
+
+        for (w = 0; w < GAIN_SCHEDULE_RECORD_WORDS; w++)
+        {
+            for (b = 0; b < 32u; b++)
+            {
+                memcpy(damaged, record, sizeof(record));
+                damaged[w] ^= 1u << b;
+                accepted += gain_schedule_unpack(damaged, &out);
+            }
+        }
+        snprintf(line, sizeof(line), "record: all %u single bit flips refused", (unsigned)(GAIN_SCHEDULE_RECORD_WORDS * 32u));
+        expect(accepted == 0u, line);
+
+        /* well formed records the loader must still refuse; the table stays as it was */
+        memset(&untouched, 0x5a, sizeof(untouched));
+        out = untouched;
+        memcpy(damaged, record, sizeof(record));
+        damaged[1] += 1u;
+        damaged[GAIN_SCHEDULE_RECORD_WORDS - 1u] ^= record[1] ^ damaged[1];
+        accepted = gain_schedule_unpack(damaged, &out);
+        {
+            gain_schedule_table_t bad = t;
+
+            bad.speed_mps[1] = bad.speed_mps[0];
+            gain_schedule_pack(&bad, damaged);
+            accepted += gain_schedule_unpack(damaged, &out);
+        }
+        expect(accepted == 0u && memcmp(&out, &untouched, sizeof(out)) == 0,
+               "record: other shape or invalid table refused, table untouched");
+    }
+
+    /* swap */
+    {
+        pthread_t w, r;
+        swap_result_t result;
+        gain_schedule_table_t first;
+        double t0, elapsed;
+        uint32 g;
+
+        memset(&result, 0, sizeof(result));
+        snapshot_init(&swap_snapshot, swap_slots, sizeof(gain_schedule_table_t));
+        test_table(&first);
+        for (g = 0; g < GAIN_SCHEDULE_GAIN_NUM; g++)
+        {
+            gain_schedule_fill(&first, (gain_schedule_gain_enum)g, 0.0f);
+        }
+        snapshot_publish(&swap_snapshot, &first);
+
+        t0 = now_s();
+        pthread_create(&r, NULL, reader, &result);
+        pthread_create(&w, NULL, writer, NULL);
+        pthread_join(w, NULL);
+        pthread_join(r, NULL);
+        elapsed = now_s() - t0;
+        printf("swap: %u publishes, %u compiled, %u evaluations in %.2f s\n",
+               CHECK_PUBLISHES, result.compiles, result.evals, elapsed);
+        snprintf(line, sizeof(line), "swap: no evaluation mixes two tables (%u mixed)", result.mixed);
+        expect(result.mixed == 0u && result.evals > 0u, line);
+        snprintf(line, sizeof(line), "swap: never an older table after a newer one (%u)", result.backwards);
+        expect(result.backwards == 0u, line);
+    }
+
+    /* cost */
+    {
+        float gain[GAIN_SCHEDULE_GAIN_NUM];
+        volatile float sink = 0.0f;
+        uint32 runs = 5000000u, r, g;
+        double t0, t_eval, t_seq, t_compile;
+
+        t0 = now_s();
+        for (r = 0; r < runs; r++)
+        {
+            gain_schedule_eval(&lut, (float)(r & 63u) * 0.08f, gain);
+            sink += gain[r % GAIN_SCHEDULE_GAIN_NUM];
+        }
+        t_eval = now_s() - t0;
+
+        t0 = now_s();
+        for (r = 0; r < runs; r++)
+        {
+            for (g = 0; g < GAIN_SCHEDULE_GAIN_NUM; g++)
+            {
+                gain[g] = Ifx_LutLinearF32_searchPosSeq(&lut.lut[g], (float)(r & 63u) * 0.08f);
+            }
+            sink += gain[r % GAIN_SCHEDULE_GAIN_NUM];
+        }
+        t_seq = now_s() - t0;
+
+        t0 = now_s();
+        for (r = 0; r < runs / 10u; r++)
+        {
+            t.speed_mps[0] = -(float)(r & 1u) * 0.01f;
+            gain_schedule_compile(&lut, &t);
+            sink += lut.segment[r % GAIN_SCHEDULE_GAIN_NUM][0].offset;
+        }
+        t_compile = now_s() - t0;
+
+        printf("\neval: %.1f ns for all %d gains (%.1f ns with a search per gain), compile %.1f ns\n\n",
+               t_eval * 1e9 / runs, GAIN_SCHEDULE_GAIN_NUM, t_seq * 1e9 / runs, t_compile * 1e9 / (runs / 10u));
+    }
+
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,18 @@
+/* Ifx_Types.h - host (Linux) stand-in
+ *
+ * Just enough of the iLLD Cpu/Std types for the SysSe/Math headers
+ * (Ifx_LutLinearF32.h) next to the host zf_common_headfile.h.
+ */
+#ifndef IFX_TYPES_H
+#define IFX_TYPES_H
+
+#include "zf_common_headfile.h"
+
+typedef signed char         sint8;
+typedef signed short        sint16;
+typedef signed int          sint32;
+
+#define IFX_INLINE          static inline
+#define IFX_EXTERN          extern
+
+#endif
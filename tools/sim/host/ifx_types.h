@@ -0,0 +1,30 @@
+/* ifx_types.h - host (Linux) stand-in
+ *
+ * Lets libraries/zf_common sources that only need the basic iLLD types
+ * (zf_common_fifo.c) compile with gcc for the tools/sim benchmarks.
+ */
+#ifndef _ifx_types_h_
+#define _ifx_types_h_
+
+#include <stdint.h>
+
+typedef unsigned char       uint8;
+typedef unsigned short      uint16;
+typedef unsigned int        uint32;
+typedef unsigned long long  uint64;
+typedef signed char         sint8;
+typedef signed short        sint16;
+typedef signed int          sint32;
+typedef signed long long    sint64;
+typedef float               float32;
+typedef double              float64;
+typedef unsigned char       boolean;
+
+#ifndef TRUE
+#define TRUE                (1)
+#endif
+#ifndef FALSE
+#define FALSE               (0)
+#endif
+
+#endif
@@ -0,0 +1,63 @@
+/* zf_common_headfile.h - host (Linux) stand-in
+ *
+ * Only used by the software-in-the-loop build in tools/sim. It provides the
+ * small part of the Seekfree / iLLD surface that code/control and code/drivers
+ * headers rely on, so the control sources compile unchanged with gcc.
+ * Anything time related is backed by the simulator clock (sim_hal.c).
+ */
+#ifndef _zf_common_headfile_h_
+#define _zf_common_headfile_h_
+
+#include <math.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdlib.h>
+
+typedef unsigned char       uint8;
+typedef unsigned short      uint16;
+typedef unsigned int        uint32;
+typedef unsigned long long  uint64;
+typedef signed char         int8;
+typedef signed short        int16;
+typedef signed int          int32;
+typedef signed long long    int64;
+typedef float               float32;
+typedef unsigned char       boolean;
+
+typedef volatile uint8      vuint8;
+typedef volatile uint16     vuint16;
+typedef volatile uint32     vuint32;
+typedef volatile int32      vint32;
+
+#ifndef TRUE
+#define TRUE                (1)
+#endif
+#ifndef FALSE
+#define FALSE               (0)
+#endif
+
+typedef void (*callback_function)(void);
+
+/* code/system/profiler.h reads the AURIX STM directly, markers compile away on the host */
+#define PROFILER_ENABLE     (0)
+
+/* code/system/flight_recorder.h lives in LMU RAM and DFlash, hooks compile away on the host */
+#define FLIGHT_RECORDER_ENABLE  (0)
+
+/* code/control/imu_calibration.c keeps its record in DFlash, the host starts uncalibrated */
+#define IMU_CALIBRATION_FLASH   (0)
+
+/* code/control/gain_schedule.c keeps its table in DFlash, the host starts from the defaults */
+#define GAIN_SCHEDULE_FLASH     (0)
+
+#define ZF_ENABLE           (1)
+#define ZF_DISABLE          (0)
+
+/* zf_driver_timer: 10ns ticks since boot, driven by the simulator */
+uint32  system_getval       (void);
+#define system_getval_ms()  (system_getval() / 100000)
+#define system_getval_us()  (system_getval() / 100   )
+
+#endif
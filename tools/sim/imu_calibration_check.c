@@ -0,0 +1,186 @@
+/* imu_calibration_check.c - code/control/imu_calibration.c standstill and routine check
+ *
+ * Build (from the repository root):
+ *   gcc -O2 -std=c99 -Itools/sim/host -Itools/sim -Icode/control -Icode/system \
+ *       tools/sim/imu_calibration_check.c code/control/imu_calibration.c code/system/snapshot.c \
+ *       -lm -o imu_calibration_check
+ *   ./imu_calibration_check
+ *
+ * Feeds 200 Hz samples from a gyro with a constant bias on every axis and white
+ * noise, accel at 1 g, through the phases below (the module starts uncalibrated,
+ * the host build has no DFlash):
+ *   standing      30 s still: the automatic bias must converge
+ *   riding        10 s of roll / yaw motion: no window accepted, bias kept
+ *   tremor        10 s held by hand (1.5 deg/s wobble): no window accepted
+ *   routine       guided, 2 s of handling first, then still at 1.3 deg roll
+ *   leaning       guided, still but at 8 deg roll: must fail, calibration kept
+ *   fidgeting     guided, never still: must fail on the timeout
+ * Also times imu_calibration_update(). Exit code 1 when a check fails.
+ */
+#define _POSIX_C_SOURCE 200809L
+#include <time.h>
+
+#include "imu_calibration.h"
+
+#define CHECK_RATE_HZ           (200.0)
+#define CHECK_GYRO_NOISE_DPS    (0.15)
+#define CHECK_ROLL_NOISE_DEG    (0.05)
+#define CHECK_GRAVITY           (9.80665)
+#define CHECK_BIAS_TOL_DPS      (0.05)
+#define CHECK_ROLL_TOL_DEG      (0.05)
+
+static const double bias_true[3] = {0.8, -0.5, 1.2};
+
+static int failures = 0;
+static uint32 rng_state = 11;
+static double sim_time = 0.0;
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static double gauss(void)
+{
+    double u1, u2;
+
+    rng_state = rng_state * 1664525u + 1013904223u;
+    u1 = ((rng_state >> 8) + 1.0) / 16777217.0;
+    rng_state = rng_state * 1664525u + 1013904223u;
+    u2 = (rng_state >> 8) / 16777216.0;
+    return sqrt(-2.0 * log(u1)) * cos(6.283185307179586 * u2);
+}
+
+static void expect(int ok, const char *what)
+{
+    printf("  %-62s %s\n", what, ok ? "ok" : "FAIL");
+    failures += !ok;
+}
+
+/* duration_s of samples; rate(t) is the true roll rate, the other axes get
+   yaw_amp * sin; roll_deg is the true roll reading */
+static void run(double duration_s, double roll_deg, double roll_rate_amp, double yaw_amp, double freq_hz)
+{
+    double end = sim_time + duration_s;
+    float gyro[3], acc[3];
+
+    while (sim_time < end)
+    {
+        double w = 6.283185307179586 * freq_hz * sim_time;
+        double roll = roll_deg + roll_rate_amp / (6.283185307179586 * freq_hz + 1e-9) * -cos(w);
+
+        gyro[0] = (float)(bias_true[0] + roll_rate_amp * sin(w) + CHECK_GYRO_NOISE_DPS * gauss());
+        gyro[1] = (float)(bias_true[1] + CHECK_GYRO_NOISE_DPS * gauss());
+        gyro[2] = (float)(bias_true[2] + yaw_amp * sin(w) + CHECK_GYRO_NOISE_DPS * gauss());
+        acc[0] = 0.0f;
+        acc[1] = (float)(CHECK_GRAVITY * sin(roll * 0.017453292519943295));
+        acc[2] = (float)(CHECK_GRAVITY * cos(roll * 0.017453292519943295));
+        imu_calibration_update(gyro, acc, (float)(roll + CHECK_ROLL_NOISE_DEG * gauss()), (float)(1.0 / CHECK_RATE_HZ));
+        sim_time += 1.0 / CHECK_RATE_HZ;
+    }
+}
+
+static double bias_error(const imu_calibration_t *cal)
+{
+    double worst = 0.0, e;
+    int i;
+
+    for (i = 0; i < 3; i++)
+    {
+        e = fabs(cal->gyro_bias[i] - bias_true[i]);
+        worst = e > worst ? e : worst;
+    }
+    return worst;
+}
+
+int main(void)
+{
+    imu_calibration_status_t status;
+    const imu_calibration_t *cal;
+    imu_calibration_t kept;
+    uint32 still_before;
+    char line[96];
+    double t0, t1, routine_start, converged_at = -1.0;
+
+    imu_calibration_init();
+    cal = imu_calibration_get();
+
+    /* standing: automatic bias, roll offset untouched */
+    while (sim_time < 30.0)
+    {
+        run(1.0, 2.0, 0.0, 0.0, 1.0);
+        if (converged_at < 0.0 && bias_error(cal) < CHECK_BIAS_TOL_DPS)
+        {
+            converged_at = sim_time;
+        }
+    }
+    imu_calibration_get_status(&status);
+    printf("standing: bias %.3f %.3f %.3f (true %.1f %.1f %.1f), within %.2f deg/s after %.0f s, window std %.2f\n",
+           cal->gyro_bias[0], cal->gyro_bias[1], cal->gyro_bias[2], bias_true[0], bias_true[1], bias_true[2],
+           CHECK_BIAS_TOL_DPS, converged_at, status.window_std_dps);
+    snprintf(line, sizeof(line), "standing: automatic bias within %.2f deg/s (%.3f)", CHECK_BIAS_TOL_DPS, bias_error(cal));
+    expect(bias_error(cal) < CHECK_BIAS_TOL_DPS, line);
+    expect(cal->roll_offset == 0.0f, "standing: roll offset not learned automatically");
+
+    /* riding and tremor: nothing accepted */
+    kept = *cal;
+    still_before = status.still_windows;
+    run(10.0, 0.0, 30.0, 20.0, 0.7);
+    imu_calibration_get_status(&status);
+    expect(status.still_windows == still_before, "riding: no standstill window");
+    run(10.0, 0.0, 1.5, 1.5, 3.0);
+    imu_calibration_get_status(&status);
+    expect(status.still_windows == still_before, "tremor: no standstill window");
+    expect(memcmp(&kept, cal, sizeof(kept)) == 0, "riding, tremor: calibration kept");
+
+    /* guided routine at the balance point */
+    imu_calibration_start();
+    routine_start = sim_time;
+    run(2.0, 1.3, 20.0, 10.0, 1.0);
+    do
+    {
+        run(0.1, 1.3, 0.0, 0.0, 1.0);
+        imu_calibration_get_status(&status);
+    } while (status.routine == IMU_CAL_ROUTINE_RUNNING && sim_time - routine_start < 30.0);
+    printf("routine: %s after %.1f s, bias error %.3f deg/s, roll offset %.3f deg (true 1.3)\n",
+           status.routine == IMU_CAL_ROUTINE_DONE ? "done" : "not done", sim_time - routine_start,
+           bias_error(cal), cal->roll_offset);
+    expect(status.routine == IMU_CAL_ROUTINE_DONE, "routine: done");
+    snprintf(line, sizeof(line), "routine: bias within %.2f deg/s, roll offset within %.2f deg",
+             CHECK_BIAS_TOL_DPS, CHECK_ROLL_TOL_DEG);
+    expect(bias_error(cal) < CHECK_BIAS_TOL_DPS && fabs(cal->roll_offset - 1.3) < CHECK_ROLL_TOL_DEG, line);
+
+    /* leaning and fidgeting: fail, calibration kept */
+    kept = *cal;
+    imu_calibration_start();
+    run(IMU_CAL_ROUTINE_WINDOWS * IMU_CAL_WINDOW_S + 1.0, 8.0, 0.0, 0.0, 1.0);
+    imu_calibration_get_status(&status);
+    expect(status.routine == IMU_CAL_ROUTINE_FAILED && fabsf(cal->roll_offset - kept.roll_offset) < 1e-6f,
+           "leaning: failed, roll offset kept");
+
+    kept = *cal;
+    imu_calibration_start();
+    run(IMU_CAL_ROUTINE_TIMEOUT_S + 1.0, 1.3, 1.5, 1.5, 3.0);
+    imu_calibration_get_status(&status);
+    expect(status.routine == IMU_CAL_ROUTINE_FAILED && memcmp(&kept, cal, sizeof(kept)) == 0,
+           "fidgeting: failed on the timeout, calibration kept");
+
+    /* cost per sample */
+    {
+        float gyro[3] = {0.8f, -0.5f, 1.2f}, acc[3] = {0.0f, 0.2f, 9.8f};
+        uint32 runs = 20000000u, r;
+
+        t0 = now_s();
+        for (r = 0; r < runs; r++)
+        {
+            gyro[0] = 0.8f + (float)(r & 7u) * 0.01f;
+            imu_calibration_update(gyro, acc, 1.3f, 0.005f);
+        }
+        t1 = now_s();
+        printf("\nupdate: %.1f ns per sample\n\n", (t1 - t0) * 1e9 / runs);
+    }
+
+    return failures ? 1 : 0;
+}
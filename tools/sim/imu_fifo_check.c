@@ -0,0 +1,223 @@
+/* imu_fifo_check.c - code/drivers/imu_fifo.c decode and timestamp check
+ *
+ * Build (from the repository root):
+ *   gcc -O2 -std=c99 -Itools/sim/host -Icode/drivers \
+ *       tools/sim/imu_fifo_check.c code/drivers/imu_fifo.c -lm -o imu_fifo_check
+ *   ./imu_fifo_check
+ *
+ * Simulates the IMU660RA FIFO the way driver_imu_spi.c drains it: frames are
+ * written at 1600 Hz by a sensor clock CHECK_CLOCK_ERROR off nominal, the
+ * watermark interrupt fires when CHECK_WATERMARK frames are waiting and is
+ * stamped a few us late, and the burst reads everything waiting at that time
+ * (dummy byte first, capped at CHECK_BATCH_MAX frames). Every 40th burst starts
+ * 1.5 ms late (CPU busy, more frames waiting), every 25th burst over-reads one
+ * empty frame, and at 6 s the interrupt is lost for 200 ms (FIFO overflows,
+ * oldest frames lost).
+ * Checks: every frame decoded in order with its values, empty frames dropped,
+ * timestamps within CHECK_TIME_LIMIT_US of the true write time once locked
+ * (0.5 s settle after start and after the outage), the tracked period within
+ * 0.05% of the true one, and exactly one resync. Also times the decoder.
+ * Exit code 1 when a check fails.
+ */
+#define _POSIX_C_SOURCE 200809L
+#include <time.h>
+
+#include "imu_fifo.h"
+
+#define CHECK_TICKS_PER_US      (100u)
+#define CHECK_ODR_HZ            (1600u)
+#define CHECK_CLOCK_ERROR       (0.012)     /* sensor runs 1.2% fast */
+#define CHECK_WATERMARK         (8u)
+#define CHECK_BATCH_MAX         (32u)
+#define CHECK_FIFO_FRAMES       (170u)      /* 2 KB FIFO */
+#define CHECK_END_S             (12.0)
+#define CHECK_TIME_LIMIT_US     (10.0)
+#define CHECK_SETTLE_S          (0.5)
+
+static int failures = 0;
+static uint32 rng_state = 7;
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static double uniform(void)
+{
+    rng_state = rng_state * 1664525u + 1013904223u;
+    return (double)(rng_state >> 8) / 16777216.0;
+}
+
+static void expect(int ok, const char *what)
+{
+    printf("  %-62s %s\n", what, ok ? "ok" : "FAIL");
+    failures += !ok;
+}
+
+/* frame k carries k in every axis, offset per axis, so order and axis mix-ups show */
+static int16 frame_value(uint32 k, uint32 axis)
+{
+    return (int16)(((k * 7u) + axis * 1000u) & 0x7FFFu);
+}
+
+static void put16(uint8 *p, int16 v)
+{
+    p[0] = (uint8)((uint16)v & 0xFFu);
+    p[1] = (uint8)((uint16)v >> 8);
+}
+
+int main(void)
+{
+    static uint8 burst[IMU_FIFO_DUMMY_BYTES + (CHECK_BATCH_MAX + 1u) * IMU_FIFO_FRAME_BYTES];
+    imu_fifo_sample_t out[CHECK_BATCH_MAX + 1u];
+    imu_fifo_t fifo;
+    double period_true = 1.0 / (CHECK_ODR_HZ * (1.0 + CHECK_CLOCK_ERROR));
+    uint32 written = 0, read = 0, lost = 0;    /* frames: written by the sensor, read, dropped on overflow */
+    uint32 bursts = 0, decoded = 0, bad_value = 0, bad_order = 0, over_reads = 0;
+    uint32 expected_next = 0;
+    double max_time_error = 0.0, time_error_sum = 0.0, outage_from = 6.0, outage_to = 6.2;
+    uint32 time_checked = 0;
+    double burst_end = 0.0;
+    double t0, t1;
+    uint32 decode_runs = 0;
+
+    imu_fifo_init(&fifo, CHECK_TICKS_PER_US, CHECK_ODR_HZ, CHECK_WATERMARK);
+
+    for (;;)
+    {
+        uint32 waiting, take, n, i, axis, length;
+        uint8 over_read;
+        double edge, read_time;
+
+        /* watermark reached: the frame that makes read + lost + WATERMARK written */
+        edge = (read + lost + CHECK_WATERMARK) * period_true;
+        if (edge < burst_end)
+        {
+            edge = burst_end;                       /* still above the watermark: restarted at once */
+        }
+        if (edge >= CHECK_END_S)
+        {
+            break;
+        }
+        read_time = edge + (1.0 + 3.0 * uniform()) * 1e-6;
+        if (bursts % 40u == 39u)
+        {
+            read_time += 1.5e-3;
+        }
+        if (edge >= outage_from && edge < outage_to)
+        {
+            read_time = outage_to + 2e-3 * uniform();   /* interrupt lost, level check catches up */
+        }
+
+        /* frames waiting when the burst reads the fill level */
+        written = (uint32)(read_time / period_true);
+        waiting = written - read - lost;
+        if (waiting > CHECK_FIFO_FRAMES)
+        {
+            lost += waiting - CHECK_FIFO_FRAMES;    /* stream mode: oldest overwritten */
+            waiting = CHECK_FIFO_FRAMES;
+        }
+        take = waiting > CHECK_BATCH_MAX ? CHECK_BATCH_MAX : waiting;
+        over_read = (bursts % 25u == 24u);
+
+        burst[0] = 0xA5;                            /* dummy byte */
+        for (i = 0; i < take; i++)
+        {
+            uint8 *p = burst + IMU_FIFO_DUMMY_BYTES + i * IMU_FIFO_FRAME_BYTES;
+            uint32 k = read + lost + i;
+
+            for (axis = 0; axis < 6u; axis++)
+            {
+                put16(p + axis * 2u, frame_value(k, axis));
+            }
+        }
+        if (over_read)
+        {
+            uint8 *p = burst + IMU_FIFO_DUMMY_BYTES + take * IMU_FIFO_FRAME_BYTES;
+
+            for (axis = 0; axis < 6u; axis++)
+            {
+                put16(p + axis * 2u, IMU_FIFO_INVALID);
+            }
+            over_reads++;
+        }
+        length = IMU_FIFO_DUMMY_BYTES + (take + over_read) * IMU_FIFO_FRAME_BYTES;
+        burst_end = read_time + 20e-6 + length * 1.2e-6;   /* length read, then the burst at ~1.2 us per byte */
+
+        /* stamp: the interrupt time, or the restart time for a late burst */
+        n = imu_fifo_decode(&fifo, burst, length, (uint32)(read_time * 1e8 + 0.5), waiting,
+                            out, CHECK_BATCH_MAX + 1u);
+        if (n != take)
+        {
+            bad_order++;
+        }
+
+        if (lost != 0u && expected_next < read + lost)
+        {
+            expected_next = read + lost;            /* overflow: the gap is expected */
+        }
+        for (i = 0; i < n; i++)
+        {
+            uint32 k = expected_next + i;
+            double truth = (k + 1u) * period_true;  /* frame k is written at the end of its period */
+            double error_us = fabs((double)(int32)(out[i].timestamp - (uint32)(truth * 1e8 + 0.5)) / CHECK_TICKS_PER_US);
+
+            for (axis = 0; axis < 3u; axis++)
+            {
+                bad_value += out[i].gyro[axis] != frame_value(k, axis);
+                bad_value += out[i].acc[axis] != frame_value(k, axis + 3u);
+            }
+            if (truth > CHECK_SETTLE_S && !(truth > outage_from && truth < outage_to + CHECK_SETTLE_S))
+            {
+                max_time_error = error_us > max_time_error ? error_us : max_time_error;
+                time_error_sum += error_us;
+                time_checked++;
+            }
+        }
+        expected_next += n;
+        read += take;
+        decoded += n;
+        bursts++;
+    }
+
+    /* decoder cost: the same 8 frame burst over and over */
+    {
+        uint32 runs = 2000000u, r;
+        imu_fifo_t bench;
+        uint32 sink = 0;
+
+        imu_fifo_init(&bench, CHECK_TICKS_PER_US, CHECK_ODR_HZ, CHECK_WATERMARK);
+        t0 = now_s();
+        for (r = 0; r < runs; r++)
+        {
+            sink += imu_fifo_decode(&bench, burst, IMU_FIFO_DUMMY_BYTES + CHECK_WATERMARK * IMU_FIFO_FRAME_BYTES,
+                                    r * 500000u, CHECK_WATERMARK, out, CHECK_BATCH_MAX);
+        }
+        t1 = now_s();
+        decode_runs = sink;
+    }
+
+    printf("%u bursts, %u frames decoded, %u lost to the outage, %u empty frames over-read\n",
+           bursts, decoded, lost, over_reads);
+    printf("decode: %.1f ns per frame (8 frame bursts)\n", (t1 - t0) * 1e9 / decode_runs);
+    printf("timestamp error: max %.1f us, mean %.2f us over %u frames\n",
+           max_time_error, time_checked ? time_error_sum / time_checked : 0.0, time_checked);
+    printf("period: tracked %.2f us, true %.2f us, nominal %.2f us\n\n",
+           fifo.period / CHECK_TICKS_PER_US, period_true * 1e6, fifo.period_nominal / CHECK_TICKS_PER_US);
+
+    expect(bad_value == 0u && bad_order == 0u, "every frame decoded in order with its values");
+    expect(fifo.invalid == over_reads, "over-read empty frames dropped");
+    {
+        char line[96];
+
+        snprintf(line, sizeof(line), "timestamps within %.0f us once locked (%.1f)", CHECK_TIME_LIMIT_US, max_time_error);
+        expect(max_time_error < CHECK_TIME_LIMIT_US, line);
+        snprintf(line, sizeof(line), "period within 0.05%% of the sensor clock");
+        expect(fabs(fifo.period / 1e8 - period_true) < period_true * 5e-4, line);
+        snprintf(line, sizeof(line), "one resync, after the outage (%u)", fifo.resyncs);
+        expect(fifo.resyncs == 1u, line);
+    }
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,285 @@
+/* imu_fusion_check.c - code/drivers/imu_fusion.c alignment, fault handling and switch-over check
+ *
+ * Build (from the repository root):
+ *   gcc -O2 -std=c99 -Itools/sim/host -Icode/drivers \
+ *       tools/sim/imu_fusion_check.c code/drivers/imu_fusion.c -lm -o imu_fusion_check
+ *   ./imu_fusion_check
+ *
+ * Synthetic roll motion seen by two IMUs, fed exactly like driver_imu_fusion.c
+ * does on the target (STM at 100 MHz):
+ *   YIS  200 Hz, header arrives IMU_CHECK_YIS_LAG_US after the measurement
+ *   SPI  1600 Hz, delivered in FIFO batches of 8 (up to 5 ms late), gyro bias
+ *        and accel offset, more noise
+ * and fused on every SPI batch, and on each frame while only the YIS is used. Timeline:
+ *    0 ..  8 s  both healthy: lag and SPI offsets must be found
+ *    8 .. 12 s  YIS unplugged: switch to SPI, roll integrated
+ *   12 .. 15 s  YIS back: used again after the recovery time
+ *   15 .. 17 s  SPI stuck (same sample repeated)
+ *   18 .. 20 s  SPI gyro x off by 20 deg/s: disagreement, SPI dropped
+ * Every output is compared with the true motion at its timestamp; the largest
+ * error around each switch and the largest step between two outputs beyond the
+ * true change show whether a switch causes a transient.
+ * Exit code 1 when a check fails.
+ */
+#include "imu_fusion.h"
+
+#define IMU_CHECK_TICKS_PER_US  (100u)
+#define IMU_CHECK_SPI_US        (625u)      /* 1600 Hz */
+#define IMU_CHECK_YIS_US        (5000u)
+#define IMU_CHECK_YIS_LAG_US    (6000u)
+#define IMU_CHECK_BATCH         (8u)        /* FIFO watermark */
+#define IMU_CHECK_END_S         (20.0)
+#define IMU_CHECK_G             (9.80665f)
+#define IMU_CHECK_PI            (3.14159265358979)
+
+static const float spi_gyro_bias[3] = { 1.5f, -0.8f, 0.4f };
+static const float spi_acc_offset[3] = { 0.2f, -0.1f, 0.3f };
+
+static int failures = 0;
+static uint32 rng_state = 1;
+
+static float noise(float sigma)
+{
+    float sum = 0.0f;
+    int i;
+
+    for (i = 0; i < 4; i++)                     /* roughly gaussian */
+    {
+        rng_state = rng_state * 1103515245u + 12345u;
+        sum += (float)(rng_state >> 8) / 16777216.0f - 0.5f;
+    }
+    return sum * sigma * 1.7320508f;
+}
+
+/* true motion: roll swinging at two frequencies, small pitch/yaw rates */
+static double truth_roll_deg(double t)
+{
+    return 8.0 * sin(2.0 * IMU_CHECK_PI * 0.7 * t) + 2.0 * sin(2.0 * IMU_CHECK_PI * 3.1 * t);
+}
+
+static void truth(double t, float gyro[3], float acc[3], float *roll)
+{
+    double r = truth_roll_deg(t);
+    double rate = 8.0 * 2.0 * IMU_CHECK_PI * 0.7 * cos(2.0 * IMU_CHECK_PI * 0.7 * t) +
+                  2.0 * 2.0 * IMU_CHECK_PI * 3.1 * cos(2.0 * IMU_CHECK_PI * 3.1 * t);
+
+    gyro[0] = (float)rate;
+    gyro[1] = (float)(3.0 * sin(2.0 * IMU_CHECK_PI * 1.1 * t));
+    gyro[2] = (float)(2.0 * cos(2.0 * IMU_CHECK_PI * 0.5 * t));
+    acc[0] = 0.0f;
+    acc[1] = (float)(IMU_CHECK_G * sin(r * IMU_CHECK_PI / 180.0));
+    acc[2] = (float)(IMU_CHECK_G * cos(r * IMU_CHECK_PI / 180.0));
+    *roll = (float)r;
+}
+
+static double seconds(uint32 ticks)
+{
+    return (double)ticks / (IMU_CHECK_TICKS_PER_US * 1e6);
+}
+
+typedef struct
+{
+    const char *name;
+    double from_s;
+    double to_s;
+    float max_gyro_error;
+    float max_roll_error;
+    float max_step;                             /* |output change - true change| between outputs */
+    float min_share;
+    float max_share;
+    uint8 spi_faults;
+    uint8 yis_faults;
+} phase_t;
+
+static phase_t phases[] =
+{
+    { "both healthy",      2.0,  8.0, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0, 0 },
+    { "YIS unplugged",     8.0, 12.0, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0, 0 },
+    { "YIS back",         12.0, 15.0, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0, 0 },
+    { "SPI stuck",        15.0, 17.0, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0, 0 },
+    { "SPI gyro x +20",   18.0, 20.0, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0, 0 },
+};
+#define PHASES (sizeof(phases) / sizeof(phases[0]))
+
+static void expect(int ok, const char *what)
+{
+    printf("  %-58s %s\n", what, ok ? "ok" : "FAIL");
+    failures += !ok;
+}
+
+int main(void)
+{
+    static imu_fusion_t fusion;
+    imu_fusion_status_t status;
+    yis_imu_t out, prev_out = { 0 };
+    float prev_true_gyro = 0.0f;
+    uint32 n, phase, stuck_at = 0, batch_count = 0;
+    uint8 yis_new = 0, spi_new = 0;
+    float batch_gyro[IMU_CHECK_BATCH][3], batch_acc[IMU_CHECK_BATCH][3];
+    uint32 batch_time[IMU_CHECK_BATCH];
+    uint16 tid = 0;
+    int have_prev = 0;
+    float gyro[3], acc[3], roll, stuck_gyro[3], stuck_acc[3];
+    uint32 spi_samples = (uint32)(IMU_CHECK_END_S * 1e6 / IMU_CHECK_SPI_US);
+    uint32 lag_at_8s = 0;
+    float offset_error_at_8s = 0.0f;
+    uint32 switch_to_spi_us = 0;
+
+    imu_fusion_init(&fusion, IMU_CHECK_TICKS_PER_US, IMU_CHECK_SPI_US);
+
+    for (n = 0; n < spi_samples; n++)
+    {
+        uint32 now = 12345u + n * IMU_CHECK_SPI_US * IMU_CHECK_TICKS_PER_US;  /* arbitrary STM start */
+        double t = (double)n * IMU_CHECK_SPI_US * 1e-6;
+        float spi_gyro[3], spi_acc[3];
+        uint32 axis;
+
+        /* SPI sample at now */
+        truth(t, gyro, acc, &roll);
+        for (axis = 0; axis < 3u; axis++)
+        {
+            spi_gyro[axis] = gyro[axis] + spi_gyro_bias[axis] + noise(0.3f);
+            spi_acc[axis] = acc[axis] + spi_acc_offset[axis] + noise(0.05f);
+        }
+        if (t >= 15.0 && t < 17.0)
+        {
+            if (stuck_at == 0u)
+            {
+                memcpy(stuck_gyro, spi_gyro, sizeof(stuck_gyro));
+                memcpy(stuck_acc, spi_acc, sizeof(stuck_acc));
+                stuck_at = n;
+            }
+            memcpy(spi_gyro, stuck_gyro, sizeof(stuck_gyro));
+            memcpy(spi_acc, stuck_acc, sizeof(stuck_acc));
+        }
+        if (t >= 18.0)
+        {
+            spi_gyro[0] += 20.0f;
+        }
+        /* queued in the FIFO, delivered a whole watermark at a time */
+        memcpy(batch_gyro[batch_count], spi_gyro, sizeof(spi_gyro));
+        memcpy(batch_acc[batch_count], spi_acc, sizeof(spi_acc));
+        batch_time[batch_count] = now;
+        spi_new = 0;
+        yis_new = 0;
+        if (++batch_count == IMU_CHECK_BATCH)
+        {
+            for (batch_count = 0; batch_count < IMU_CHECK_BATCH; batch_count++)
+            {
+                imu_fusion_push_spi(&fusion, batch_gyro[batch_count], batch_acc[batch_count], batch_time[batch_count], 0);
+            }
+            batch_count = 0;
+            spi_new = 1;
+        }
+
+        /* YIS header arriving now, measured IMU_CHECK_YIS_LAG_US earlier */
+        if ((n * IMU_CHECK_SPI_US) % IMU_CHECK_YIS_US == 0u && n * IMU_CHECK_SPI_US >= IMU_CHECK_YIS_LAG_US &&
+            !(t >= 8.0 && t < 12.0))
+        {
+            yis_imu_t frame;
+            double tm = t - IMU_CHECK_YIS_LAG_US * 1e-6;
+
+            memset(&frame, 0, sizeof(frame));
+            truth(tm, gyro, acc, &roll);
+            frame.wx = gyro[0] + noise(0.1f);
+            frame.wy = gyro[1] + noise(0.1f);
+            frame.wz = gyro[2] + noise(0.1f);
+            frame.ax = acc[0] + noise(0.02f);
+            frame.ay = acc[1] + noise(0.02f);
+            frame.az = acc[2] + noise(0.02f);
+            frame.roll = roll + noise(0.05f);
+            frame.timestamp = now;
+            frame.tid = tid++;
+            imu_fusion_push_yis(&fusion, &frame);
+            yis_new = 1;
+        }
+
+        /* output on every SPI batch, and on every frame while YIS only */
+        if (!(spi_new || (yis_new && fusion.share >= 1.0f)) || !imu_fusion_output(&fusion, now, &out))
+        {
+            continue;
+        }
+
+        /* compare with the truth at the output's measurement time */
+        {
+            double tm = seconds(out.timestamp - 12345u);
+            float gyro_error, roll_error, step;
+
+            truth(tm, gyro, acc, &roll);
+            imu_fusion_get_status(&fusion, &status);
+            gyro_error = fabsf(out.wx - gyro[0]);
+            roll_error = fabsf(out.roll - roll);
+            step = have_prev ? fabsf((out.wx - prev_out.wx) - (gyro[0] - prev_true_gyro)) : 0.0f;
+
+            for (phase = 0; phase < PHASES; phase++)
+            {
+                phase_t *p = &phases[phase];
+
+                if (t < p->from_s || t >= p->to_s)
+                {
+                    continue;
+                }
+                p->max_gyro_error = gyro_error > p->max_gyro_error ? gyro_error : p->max_gyro_error;
+                p->max_roll_error = roll_error > p->max_roll_error ? roll_error : p->max_roll_error;
+                p->max_step = step > p->max_step ? step : p->max_step;
+                p->min_share = status.yis_share < p->min_share ? status.yis_share : p->min_share;
+                p->max_share = status.yis_share > p->max_share ? status.yis_share : p->max_share;
+                p->spi_faults |= status.spi_faults;
+                p->yis_faults |= status.yis_faults;
+            }
+
+            if (switch_to_spi_us == 0u && t >= 8.0 && status.yis_share <= 0.0f)
+            {
+                switch_to_spi_us = (uint32)((t - 8.0) * 1e6);
+            }
+            if (lag_at_8s == 0u && t >= 7.99)
+            {
+                uint32 axis2;
+
+                lag_at_8s = status.lag_us;
+                for (axis2 = 0; axis2 < 3u; axis2++)
+                {
+                    float e = fabsf(status.gyro_offset[axis2] - spi_gyro_bias[axis2]);
+                    offset_error_at_8s = e > offset_error_at_8s ? e : offset_error_at_8s;
+                }
+            }
+
+            prev_out = out;
+            prev_true_gyro = gyro[0];
+            have_prev = 1;
+        }
+    }
+
+    printf("%-16s %10s %10s %10s %12s %6s %6s\n", "phase", "gyro err", "roll err", "step", "YIS share", "YIS", "SPI");
+    for (phase = 0; phase < PHASES; phase++)
+    {
+        const phase_t *p = &phases[phase];
+
+        printf("%-16s %10.2f %10.2f %10.2f %5.2f..%4.2f %#6x %#6x\n", p->name, p->max_gyro_error, p->max_roll_error,
+               p->max_step, p->min_share, p->max_share, p->yis_faults, p->spi_faults);
+    }
+    printf("\n");
+
+    {
+        char line[96];
+
+        snprintf(line, sizeof(line), "lag estimate %u us (true %u us)", lag_at_8s, IMU_CHECK_YIS_LAG_US);
+        expect(lag_at_8s >= IMU_CHECK_YIS_LAG_US - IMU_CHECK_SPI_US && lag_at_8s <= IMU_CHECK_YIS_LAG_US + IMU_CHECK_SPI_US, line);
+        snprintf(line, sizeof(line), "SPI gyro offset within 0.2 deg/s of the bias (%.3f)", offset_error_at_8s);
+        expect(offset_error_at_8s < 0.2f, line);
+        expect(phases[0].spi_faults == 0u && phases[0].yis_faults == 0u && phases[0].min_share >= 1.0f,
+               "both healthy: no fault, YIS only");
+        snprintf(line, sizeof(line), "YIS unplugged: SPI only after %u us", switch_to_spi_us);
+        expect(switch_to_spi_us > 0u && switch_to_spi_us < 100000u && (phases[1].yis_faults & IMU_FUSION_FAULT_STALE), line);
+        expect(phases[1].max_gyro_error < 3.0f && phases[1].max_step < 3.0f, "YIS unplugged: no transient (gyro error, step < 3 deg/s)");
+        expect(phases[1].max_roll_error < 1.0f, "YIS unplugged: integrated roll within 1 deg");
+        expect(phases[2].max_share >= 1.0f && phases[2].max_gyro_error < 3.0f && phases[2].max_step < 3.0f,
+               "YIS back: YIS only again, no transient");
+        expect((phases[3].spi_faults & IMU_FUSION_FAULT_STUCK) && phases[3].min_share >= 1.0f, "SPI stuck: flagged, YIS kept");
+        expect((phases[4].spi_faults & IMU_FUSION_FAULT_RESIDUAL) && phases[4].max_gyro_error < 3.0f,
+               "SPI gyro x off: disagreement flagged, YIS kept");
+    }
+
+    (void)stuck_at;
+    return failures ? 1 : 0;
+}
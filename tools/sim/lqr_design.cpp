@@ -0,0 +1,369 @@
+// lqr_design.cpp - state feedback gains for the LQR balance mode -> code/control/lqr_gains.h
+//
+// Build (from the repository root):
+//   g++ -O2 -std=c++17 -Wall -Wextra -Itools/sim tools/sim/lqr_design.cpp tools/sim/bike_plant.c -o lqr_design
+//
+// Linearises tools/sim/bike_plant.c about upright (state roll, roll rate, wheel
+// speed relative to the frame; input motor torque), discretises it with a zero
+// order hold at the 5 ms control tick and solves the discrete Riccati equation
+// for every weight set below (Bryson's rule: each state and the torque weighted
+// by one over its acceptable excursion squared). The gains are converted to the
+// firmware units (deg, deg/s, turns/s -> N*m) and written as a constant table.
+// Every set must stay stable with the torque applied one tick late, which is
+// about what IMU latency and the ODrive command add on the bike; the printed
+// delay margin is how late it may come.
+//
+//   ./lqr_design                                   # print gains and poles
+//   ./lqr_design -o code/control/lqr_gains.h       # regenerate the firmware table
+//   ./lqr_design -p com_height=0.2 -o lqr_gains.h  # other plant (same names as bike_sim)
+//
+// Exit code 1 (and no table written) when a weight set is rejected.
+
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "bike_plant.h"
+
+namespace {
+
+constexpr int kStates = 3;                      // roll, roll rate, wheel speed
+constexpr double kTickS = 0.005;                // BALANCE_CTRL_DT_S
+constexpr double kGravity = 9.81;               // as bike_plant.c
+constexpr double kPi = 3.141592653589793;
+constexpr double kDeg = kPi / 180.0;
+constexpr int kMaxLateTicks = 20;
+
+using Vec = std::array<double, kStates>;
+using Mat = std::array<Vec, kStates>;
+
+// Acceptable excursions: roll (deg), roll rate (deg/s), wheel speed (turns/s), torque (N*m).
+// The wheel speed weight is what spins the wheel down; small values let it drift.
+struct WeightSet
+{
+    const char *name;
+    double roll_deg;
+    double rate_dps;
+    double wheel_rps;
+    double torque_nm;
+};
+
+const WeightSet kWeightSets[] = {
+    { "soft",    3.0, 60.0, 20.0, 1.0 },
+    { "nominal", 2.0, 40.0, 15.0, 1.0 },
+    { "stiff",   1.0, 30.0, 10.0, 1.0 },
+};
+
+struct Model
+{
+    Mat a;                                      // x(k+1) = a x(k) + b u(k)
+    Vec b;
+};
+
+Mat multiply(const Mat &x, const Mat &y)
+{
+    Mat r{};
+    for (int i = 0; i < kStates; i++)
+        for (int j = 0; j < kStates; j++)
+            for (int k = 0; k < kStates; k++)
+                r[i][j] += x[i][k] * y[k][j];
+    return r;
+}
+
+// Continuous model, same equations as bike_plant_step() with sin(roll) = roll
+void linearise(const bike_plant_param_t &p, Mat &a, Vec &b)
+{
+    double j = p.frame_inertia, s = p.torque_sign;
+    double gravity = p.mass_kg * kGravity * p.com_height_m / j;
+    double damping = p.roll_damping / j;
+
+    a = Mat{};
+    a[0][1] = 1.0;
+    a[1][0] = gravity;
+    a[1][1] = -damping;
+    // the encoder sees the wheel relative to the frame: minus the frame's roll acceleration
+    a[2][0] = -s * gravity;
+    a[2][1] = s * damping;
+    a[2][2] = -p.wheel_friction / p.wheel_inertia;
+    b = Vec{ 0.0, -s / j, 1.0 / p.wheel_inertia + s * s / j };
+}
+
+// Zero order hold: exp([a b; 0 0] dt) by scaling and squaring a Taylor series
+Model discretise(const Mat &a, const Vec &b, double dt)
+{
+    constexpr int n = kStates + 1;
+    using Big = std::array<std::array<double, n>, n>;
+    Big m{}, e{}, term{};
+    double norm = 0.0;
+    int squarings = 0;
+
+    for (int i = 0; i < kStates; i++)
+    {
+        for (int k = 0; k < kStates; k++)
+            m[i][k] = a[i][k] * dt;
+        m[i][kStates] = b[i] * dt;
+    }
+    for (int i = 0; i < n; i++)
+        for (int k = 0; k < n; k++)
+            norm = std::fmax(norm, std::fabs(m[i][k]));
+    while (norm * n > 0.5)
+    {
+        norm *= 0.5;
+        squarings++;
+    }
+    for (int i = 0; i < n; i++)
+        for (int k = 0; k < n; k++)
+            m[i][k] = std::ldexp(m[i][k], -squarings);
+
+    for (int i = 0; i < n; i++)
+        e[i][i] = term[i][i] = 1.0;
+    for (int order = 1; order <= 16; order++)
+    {
+        Big next{};
+        for (int i = 0; i < n; i++)
+            for (int k = 0; k < n; k++)
+            {
+                for (int l = 0; l < n; l++)
+                    next[i][k] += term[i][l] * m[l][k];
+                next[i][k] /= order;
+            }
+        term = next;
+        for (int i = 0; i < n; i++)
+            for (int k = 0; k < n; k++)
+                e[i][k] += term[i][k];
+    }
+    while (squarings-- > 0)
+    {
+        Big sq{};
+        for (int i = 0; i < n; i++)
+            for (int k = 0; k < n; k++)
+                for (int l = 0; l < n; l++)
+                    sq[i][k] += e[i][l] * e[l][k];
+        e = sq;
+    }
+
+    Model d;
+    for (int i = 0; i < kStates; i++)
+    {
+        for (int k = 0; k < kStates; k++)
+            d.a[i][k] = e[i][k];
+        d.b[i] = e[i][kStates];
+    }
+    return d;
+}
+
+// Riccati iteration in Joseph form, P = Q + (A - b k)' P (A - b k) + r k' k with
+// k = (r + b'Pb)^-1 b'PA, which keeps P symmetric where the textbook form drifts
+// off on the slow wheel mode. Returns false without convergence.
+bool solve_lqr(const Model &d, const Vec &q, double r, Vec &k)
+{
+    Mat p{};
+    for (int i = 0; i < kStates; i++)
+        p[i][i] = q[i];
+
+    for (int iteration = 0; iteration < 1000000; iteration++)
+    {
+        Vec pb{};
+        double bpb = r, change = 0.0;
+        Mat closed, pc, next;
+
+        for (int i = 0; i < kStates; i++)
+            for (int l = 0; l < kStates; l++)
+                pb[i] += p[i][l] * d.b[l];
+        for (int l = 0; l < kStates; l++)
+            bpb += d.b[l] * pb[l];
+        for (int j = 0; j < kStates; j++)
+        {
+            double bpa = 0.0;
+            for (int l = 0; l < kStates; l++)
+                bpa += pb[l] * d.a[l][j];
+            k[j] = bpa / bpb;
+        }
+
+        for (int i = 0; i < kStates; i++)
+            for (int j = 0; j < kStates; j++)
+                closed[i][j] = d.a[i][j] - d.b[i] * k[j];
+        pc = multiply(p, closed);
+        for (int i = 0; i < kStates; i++)
+            for (int j = 0; j < kStates; j++)
+            {
+                double cpc = 0.0;
+                for (int l = 0; l < kStates; l++)
+                    cpc += closed[l][i] * pc[l][j];
+                next[i][j] = (i == j ? q[i] : 0.0) + cpc + r * k[i] * k[j];
+                change = std::fmax(change, std::fabs(next[i][j] - p[i][j]) / (std::fabs(next[i][j]) + 1e-12));
+            }
+        p = next;
+        if (!std::isfinite(change))
+            return false;
+        if (change < 1e-12)
+            return true;
+    }
+    return false;
+}
+
+// Spectral radius of the closed loop with the torque applied `late` ticks after
+// the state it was computed from (state extended by the pending torques).
+// Estimated from |M^(2^n)|^(1/2^n).
+double spectral_radius(const Model &d, const Vec &k, int late)
+{
+    const int n = kStates + late;
+    std::vector<std::vector<double>> m(n, std::vector<double>(n, 0.0)), sq = m;
+    double log_scale = 0.0;
+    double steps = 1.0;
+
+    for (int i = 0; i < kStates; i++)
+    {
+        for (int j = 0; j < kStates; j++)
+            m[i][j] = d.a[i][j] - (late == 0 ? d.b[i] * k[j] : 0.0);
+        if (late > 0)
+            m[i][n - 1] = d.b[i];               // oldest pending torque is applied now
+    }
+    if (late > 0)
+    {
+        for (int j = 0; j < kStates; j++)
+            m[kStates][j] = -k[j];              // newest pending torque
+        for (int i = kStates + 1; i < n; i++)
+            m[i][i - 1] = 1.0;
+    }
+
+    for (int squaring = 0; squaring < 16; squaring++)
+    {
+        double norm = 0.0;
+        for (int i = 0; i < n; i++)
+            for (int j = 0; j < n; j++)
+            {
+                sq[i][j] = 0.0;
+                for (int l = 0; l < n; l++)
+                    sq[i][j] += m[i][l] * m[l][j];
+                norm = std::fmax(norm, std::fabs(sq[i][j]));
+            }
+        if (norm == 0.0 || !std::isfinite(norm))
+            return norm == 0.0 ? 0.0 : INFINITY;
+        // keep the entries near 1, remember the scale in log form
+        log_scale = 2.0 * log_scale + std::log(norm);
+        steps *= 2.0;
+        for (int i = 0; i < n; i++)
+            for (int j = 0; j < n; j++)
+                m[i][j] = sq[i][j] / norm;
+    }
+    return std::exp(log_scale / steps);
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    bike_plant_param_t plant;
+    std::string output;
+
+    bike_plant_default_param(&plant);
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "-o" && i + 1 < argc)
+        {
+            output = argv[++i];
+        }
+        else if (arg == "-p" && i + 1 < argc)
+        {
+            std::string setting = argv[++i];
+            size_t eq = setting.find('=');
+            if (eq == std::string::npos ||
+                bike_plant_set_param(&plant, setting.substr(0, eq).c_str(), std::stof(setting.substr(eq + 1))) != 0)
+            {
+                std::cerr << "bad plant parameter '" << setting << "'\n";
+                return 2;
+            }
+        }
+        else
+        {
+            std::cerr << "usage: lqr_design [-p name=value]... [-o lqr_gains.h]\n";
+            return 2;
+        }
+    }
+
+    Mat a;
+    Vec b;
+    linearise(plant, a, b);
+    Model d = discretise(a, b, kTickS);
+
+    // state in SI units (rad, rad/s, rad/s) -> firmware units (deg, deg/s, turns/s)
+    const Vec to_si = { kDeg, kDeg, 2.0 * kPi };
+    std::ostringstream table;
+    int failures = 0;
+
+    std::printf("open loop: unstable pole %.2f rad/s, %d weight sets at %.0f ms\n",
+                std::sqrt(a[1][0]), int(sizeof(kWeightSets) / sizeof(kWeightSets[0])), kTickS * 1e3);
+    std::printf("%-8s %10s %10s %10s %10s %12s\n", "set", "Nm/deg", "Nm/(deg/s)", "Nm/(rps)", "slowest s", "delay margin");
+    for (const WeightSet &w : kWeightSets)
+    {
+        Vec q = { 1.0 / std::pow(w.roll_deg * kDeg, 2.0), 1.0 / std::pow(w.rate_dps * kDeg, 2.0),
+                  1.0 / std::pow(w.wheel_rps * 2.0 * kPi, 2.0) };
+        Vec k{};
+        bool ok = solve_lqr(d, q, 1.0 / (w.torque_nm * w.torque_nm), k);
+        double radius = spectral_radius(d, k, 0);
+        int margin = 0;
+        Vec fw;
+
+        // ticks the torque may come late before the loop goes unstable
+        while (ok && margin < kMaxLateTicks && spectral_radius(d, k, margin + 1) < 1.0)
+            margin++;
+        for (int j = 0; j < kStates; j++)
+            fw[j] = k[j] * to_si[j];
+        std::printf("%-8s %10.5f %10.5f %10.5f %10.2f %9d ms%s\n", w.name, fw[0], fw[1], fw[2],
+                    -kTickS / std::log(radius), int(margin * kTickS * 1e3 + 0.5),
+                    ok && radius < 1.0 && margin >= 1 ? "" : "  REJECTED");
+        if (!ok || !(radius < 1.0) || margin < 1)
+        {
+            failures++;
+            continue;
+        }
+
+        char line[160];
+        std::snprintf(line, sizeof(line), "    { \"%s\",%*s{ %.6ef, %.6ef, %.6ef } },\n", w.name,
+                      int(8 - std::string(w.name).size()), "", fw[0], fw[1], fw[2]);
+        table << line;
+    }
+
+    if (!output.empty() && failures == 0)
+    {
+        std::ofstream out(output);
+        if (!out)
+        {
+            std::cerr << "cannot write " << output << "\n";
+            return 2;
+        }
+        char line[256];
+        out << "/* lqr_gains.h - generated by tools/sim/lqr_design.cpp, do not edit */\n"
+               "#ifndef LQR_GAINS_H\n"
+               "#define LQR_GAINS_H\n\n";
+        std::snprintf(line, sizeof(line),
+                      "/* Plant: %.2f kg, centre of mass %.3f m, roll inertia %.3f kg*m^2, wheel inertia %.4f kg*m^2,\n"
+                      " * torque sign %+.0f; zero order hold at %.0f ms.\n"
+                      " * torque = -(k[0] (roll - target) + k[1] roll_rate + k[2] wheel_speed), in deg, deg/s, turns/s -> N*m */\n",
+                      plant.mass_kg, plant.com_height_m, plant.frame_inertia, plant.wheel_inertia, plant.torque_sign,
+                      kTickS * 1e3);
+        out << line
+            << "#define LQR_STATE_NUM                   (3)\n\n"
+               "typedef struct\n"
+               "{\n"
+               "    const char *name;\n"
+               "    float k[LQR_STATE_NUM];\n"
+               "} lqr_gain_set_t;\n\n"
+               "static const lqr_gain_set_t lqr_gain_sets[] =\n"
+               "{\n"
+            << table.str()
+            << "};\n\n"
+               "#define LQR_GAIN_SET_NUM                (sizeof(lqr_gain_sets) / sizeof(lqr_gain_sets[0]))\n\n"
+               "#endif\n";
+        std::cerr << "wrote " << output << "\n";
+    }
+
+    return failures ? 1 : 0;
+}
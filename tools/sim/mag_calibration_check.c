@@ -0,0 +1,262 @@
+/* mag_calibration_check.c - code/drivers/mag_calibration.c fit and heading check
+ *
+ * Build (from the repository root):
+ *   gcc -O2 -std=c99 -Itools/sim/host -Icode/drivers \
+ *       tools/sim/mag_calibration_check.c code/drivers/mag_calibration.c -lm -o mag_calibration_check
+ *   ./mag_calibration_check
+ *
+ * A 480 mGauss field with 60 deg inclination is seen through a hard iron offset
+ * (150, -90, 60), a symmetric soft iron matrix (axis gains 0.8 .. 1.25) and
+ * CHECK_NOISE white noise. Orientations are random headings with random roll
+ * and pitch; accel is gravity plus noise in the same body frame.
+ *   sphere     uniform random orientations (calibration on the bench)
+ *   hand       full turns with roll and pitch within +-45 deg (the bike carried
+ *              and turned by hand)
+ *   wheels     full turns with roll and pitch within +-25 deg: must be refused,
+ *              the centre comes out tens of mGauss off
+ *   yaw only   level full turns: must be refused
+ *   few        fewer than MAG_FIT_SAMPLES_MIN samples: must be refused
+ * For the accepted fits: hard iron within 2 mGauss, RMS corrected field strength
+ * error below 1% and RMS tilt-compensated heading error below CHECK_HEADING_LIMIT
+ * on fresh orientations with up to 30 deg of tilt (the uncalibrated heading
+ * error is printed for comparison). Also times mag_fit_add(), mag_fit_solve() and
+ * mag_heading(). Exit code 1 when a check fails.
+ */
+#define _POSIX_C_SOURCE 200809L
+#include <time.h>
+
+#include "mag_calibration.h"
+
+#define CHECK_FIELD             (480.0)
+#define CHECK_INCLINATION_DEG   (60.0)
+#define CHECK_NOISE             (2.0)       /* mGauss per axis */
+#define CHECK_ACC_NOISE         (0.05)      /* m/s^2 */
+#define CHECK_GRAVITY           (9.80665)
+#define CHECK_SAMPLES           (3000u)
+#define CHECK_HEADINGS          (2000u)
+#define CHECK_HEADING_LIMIT     (1.0)       /* deg RMS */
+#define CHECK_PI                (3.141592653589793)
+#define CHECK_DEG               (CHECK_PI / 180.0)
+
+static const double hard_iron[3] = {150.0, -90.0, 60.0};
+static double soft_iron[3][3];
+
+static int failures = 0;
+static uint32 rng_state = 5;
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static double uniform(void)
+{
+    rng_state = rng_state * 1664525u + 1013904223u;
+    return (double)(rng_state >> 8) / 16777216.0;
+}
+
+static double gauss(void)
+{
+    double u1 = uniform() + 1e-12, u2 = uniform();
+    return sqrt(-2.0 * log(u1)) * cos(2.0 * CHECK_PI * u2);
+}
+
+static void expect(int ok, const char *what)
+{
+    printf("  %-62s %s\n", what, ok ? "ok" : "FAIL");
+    failures += !ok;
+}
+
+/* body (x forward, y left, z up) -> world (x north, y west, z up) for a heading
+   clockwise from north, then pitch about y and roll about x */
+static void rotation(double heading, double pitch, double roll, double r[3][3])
+{
+    double ch = cos(heading), sh = sin(heading), cp = cos(pitch), sp = sin(pitch), cr = cos(roll), sr = sin(roll);
+    double rz[3][3] = {{ch, sh, 0.0}, {-sh, ch, 0.0}, {0.0, 0.0, 1.0}};
+    double ry[3][3] = {{cp, 0.0, sp}, {0.0, 1.0, 0.0}, {-sp, 0.0, cp}};
+    double rx[3][3] = {{1.0, 0.0, 0.0}, {0.0, cr, -sr}, {0.0, sr, cr}};
+    double t[3][3];
+    int i, j, k;
+
+    for (i = 0; i < 3; i++)
+        for (j = 0; j < 3; j++)
+        {
+            t[i][j] = 0.0;
+            for (k = 0; k < 3; k++) t[i][j] += ry[i][k] * rx[k][j];
+        }
+    for (i = 0; i < 3; i++)
+        for (j = 0; j < 3; j++)
+        {
+            r[i][j] = 0.0;
+            for (k = 0; k < 3; k++) r[i][j] += rz[i][k] * t[k][j];
+        }
+}
+
+/* raw mag through the hard / soft iron plus noise, accel = gravity reaction plus noise */
+static void sample(double heading, double pitch, double roll, float mag[3], float acc[3])
+{
+    double r[3][3], field_b[3], ideal;
+    double field_w[3] = {CHECK_FIELD * cos(CHECK_INCLINATION_DEG * CHECK_DEG), 0.0,
+                         -CHECK_FIELD * sin(CHECK_INCLINATION_DEG * CHECK_DEG)};
+    int i, j;
+
+    rotation(heading, pitch, roll, r);
+    for (i = 0; i < 3; i++)
+    {
+        field_b[i] = 0.0;
+        for (j = 0; j < 3; j++) field_b[i] += r[j][i] * field_w[j];
+        acc[i] = (float)(r[2][i] * CHECK_GRAVITY + CHECK_ACC_NOISE * gauss());
+    }
+    for (i = 0; i < 3; i++)
+    {
+        ideal = hard_iron[i];
+        for (j = 0; j < 3; j++) ideal += soft_iron[i][j] * field_b[j];
+        mag[i] = (float)(ideal + CHECK_NOISE * gauss());
+    }
+}
+
+static double wrap180(double a)
+{
+    while (a > 180.0) a -= 360.0;
+    while (a < -180.0) a += 360.0;
+    return a;
+}
+
+typedef struct
+{
+    const char *name;
+    double tilt_deg;                    /* <0: uniform sphere */
+    uint32 samples;
+    int    expect_ok;
+} check_case_t;
+
+static void sphere_orientation(double *heading, double *pitch, double *roll)
+{
+    *heading = 2.0 * CHECK_PI * uniform();
+    *pitch = asin(2.0 * uniform() - 1.0);
+    *roll = 2.0 * CHECK_PI * uniform() - CHECK_PI;
+}
+
+int main(void)
+{
+    static const check_case_t cases[] =
+    {
+        {"sphere",   -1.0, CHECK_SAMPLES, 1},
+        {"hand",     45.0, CHECK_SAMPLES, 1},
+        {"wheels",   25.0, CHECK_SAMPLES, 0},
+        {"yaw only",  0.0, CHECK_SAMPLES, 0},
+        {"few",      -1.0, MAG_FIT_SAMPLES_MIN / 2u, 0},
+    };
+    static const char *results[] = {"ok", "too few", "singular", "not an ellipsoid", "distorted"};
+    /* symmetric soft iron: rotation of diag(1.25, 0.8, 1.0) */
+    double gains[3] = {1.25, 0.8, 1.0}, a = 0.5, b = 0.3;
+    double q[3][3] = {{cos(a), -sin(a), 0}, {sin(a) * cos(b), cos(a) * cos(b), -sin(b)}, {sin(a) * sin(b), cos(a) * sin(b), cos(b)}};
+    double t_add = 0.0, t_solve = 0.0, t_heading = 0.0;
+    uint32 adds = 0, headings = 0;
+    uint32 c, i, j, k;
+
+    for (i = 0; i < 3; i++)
+        for (j = 0; j < 3; j++)
+        {
+            soft_iron[i][j] = 0.0;
+            for (k = 0; k < 3; k++) soft_iron[i][j] += q[i][k] * gains[k] * q[j][k];
+        }
+
+    for (c = 0; c < sizeof(cases) / sizeof(cases[0]); c++)
+    {
+        const check_case_t *cs = &cases[c];
+        mag_fit_t fit;
+        mag_calibration_t cal, raw_cal;
+        mag_fit_result_enum result;
+        float residual, mag[3], acc[3];
+        uint32 invalid = 0;
+        double t0, offset_error = 0.0, field_error = 0.0, heading_error = 0.0, raw_heading_error = 0.0;
+        char line[96];
+
+        mag_fit_reset(&fit);
+        for (i = 0; i < cs->samples; i++)
+        {
+            double heading, pitch, roll;
+
+            if (cs->tilt_deg < 0.0)
+            {
+                sphere_orientation(&heading, &pitch, &roll);
+            }
+            else
+            {
+                heading = 2.0 * CHECK_PI * (double)i / 300.0;          /* 10 turns */
+                pitch = cs->tilt_deg * CHECK_DEG * sin(2.0 * CHECK_PI * (double)i / 470.0);
+                roll = cs->tilt_deg * CHECK_DEG * sin(2.0 * CHECK_PI * (double)i / 170.0);
+            }
+            sample(heading, pitch, roll, mag, acc);
+            t0 = now_s();
+            mag_fit_add(&fit, mag);
+            t_add += now_s() - t0;
+            adds++;
+        }
+
+        t0 = now_s();
+        result = mag_fit_solve(&fit, &cal, &residual);
+        t0 = now_s() - t0;
+        t_solve = t0 > t_solve ? t0 : t_solve;
+
+        if (result != MAG_FIT_OK)
+        {
+            printf("%-9s %u samples: %s\n", cs->name, cs->samples, results[result]);
+            snprintf(line, sizeof(line), "%s: %s", cs->name, cs->expect_ok ? "fit accepted" : "fit refused");
+            expect(!cs->expect_ok, line);
+            continue;
+        }
+
+        for (i = 0; i < 3; i++)
+        {
+            double e = fabs(cal.hard_iron[i] - hard_iron[i]);
+            offset_error = e > offset_error ? e : offset_error;
+        }
+
+        /* fresh orientations, tilt up to 30 deg */
+        mag_calibration_identity(&raw_cal, 0.0f);
+        for (i = 0; i < CHECK_HEADINGS; i++)
+        {
+            double heading = 2.0 * CHECK_PI * uniform();
+            double pitch = (uniform() * 2.0 - 1.0) * 30.0 * CHECK_DEG;
+            double roll = (uniform() * 2.0 - 1.0) * 30.0 * CHECK_DEG;
+            mag_heading_t out, raw_out;
+            double e;
+
+            sample(heading, pitch, roll, mag, acc);
+            t0 = now_s();
+            mag_heading(&cal, mag, acc, &out);
+            t_heading += now_s() - t0;
+            headings++;
+            mag_heading(&raw_cal, mag, acc, &raw_out);
+            e = wrap180(out.heading_deg - heading / CHECK_DEG);
+            heading_error += e * e;
+            e = fabs(wrap180(raw_out.heading_deg - heading / CHECK_DEG));
+            raw_heading_error = e > raw_heading_error ? e : raw_heading_error;
+            e = out.field_ratio - 1.0;
+            field_error += e * e;
+            invalid += !out.valid;
+        }
+        heading_error = sqrt(heading_error / CHECK_HEADINGS);
+        field_error = sqrt(field_error / CHECK_HEADINGS);
+
+        printf("%-9s %u samples: residual %.4f, field %.1f (true %.0f), hard iron error %.2f, "
+               "heading error %.2f deg RMS (uncalibrated up to %.1f deg)\n",
+               cs->name, cs->samples, residual, cal.field, CHECK_FIELD, offset_error, heading_error, raw_heading_error);
+        snprintf(line, sizeof(line), "%s: fit accepted", cs->name);
+        expect(cs->expect_ok, line);
+        snprintf(line, sizeof(line), "%s: hard iron within 2 mGauss (%.2f)", cs->name, offset_error);
+        expect(offset_error < 2.0, line);
+        snprintf(line, sizeof(line), "%s: field strength error below 1%% RMS (%.2f%%), all valid", cs->name, field_error * 100.0);
+        expect(field_error < 0.01 && invalid == 0u, line);
+        snprintf(line, sizeof(line), "%s: heading error below %.1f deg RMS (%.2f)", cs->name, CHECK_HEADING_LIMIT, heading_error);
+        expect(heading_error < CHECK_HEADING_LIMIT, line);
+    }
+
+    printf("\nmag_fit_add %.0f ns per sample, mag_fit_solve up to %.1f us, mag_heading %.0f ns (host)\n",
+           t_add * 1e9 / adds, t_solve * 1e6, t_heading * 1e9 / headings);
+    return failures ? 1 : 0;
+}
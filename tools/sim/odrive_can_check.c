@@ -0,0 +1,227 @@
+/* odrive_can_check.c - code/drivers/odrive_cansimple.c against the stand-in ODrive
+ *
+ * Build (from the repository root):
+ *   gcc -O2 -std=c99 -Itools/sim/host -Itools/sim -Icode/drivers \
+ *       tools/sim/odrive_can_check.c tools/sim/odrive_can_model.c code/drivers/odrive_cansimple.c \
+ *       -lm -o odrive_can_check
+ *
+ * Runs the firmware side of the protocol (what driver_odrive.c does in its CAN
+ * backend) against odrive_can_model over an ideal 1 Mbit/s bus and checks that
+ * torque commands arrive bit exact, that every encoder estimate is decoded to the
+ * value the model sent, and that foreign / malformed frames are ignored.
+ * Prints wire latency and bus load; exit code 1 on any mismatch.
+ */
+#define _POSIX_C_SOURCE 199309L
+#include <time.h>
+
+#include "zf_common_headfile.h"
+#include "odrive_cansimple.h"
+#include "odrive_can_model.h"
+
+#define CHECK_BAUDRATE          (1000000.0)
+#define CHECK_NODE_ID           (3u)
+#define CHECK_STEP_S            (0.00001)
+#define CHECK_CTRL_PERIOD_S     (0.005)
+#define CHECK_DURATION_S        (2.0)
+#define CHECK_QUEUE_LEN         (64)
+
+typedef struct
+{
+    odrive_can_frame_t frame;
+    double deliver_s;
+} bus_slot_t;
+
+typedef struct
+{
+    bus_slot_t slot[CHECK_QUEUE_LEN];
+    int count;
+    double busy_until_s;
+    double busy_total_s;
+} bus_t;
+
+static int failures = 0;
+
+uint32 system_getval(void)
+{
+    return 0;
+}
+
+#define EXPECT(cond, ...) do { if (!(cond)) { failures++; printf("FAIL: " __VA_ARGS__); printf("\n"); } } while (0)
+
+/* standard frame incl. worst case bit stuffing and interframe space */
+static double frame_time_s(const odrive_can_frame_t *f)
+{
+    int dlc = f->rtr ? 0 : f->dlc;
+    int bits = 47 + 8 * dlc + (34 + 8 * dlc - 1) / 4;
+    return bits / CHECK_BAUDRATE;
+}
+
+/* single shared bus, frames serialised in submission order */
+static void bus_send(bus_t *b, double now_s, const odrive_can_frame_t *f)
+{
+    double start = (b->busy_until_s > now_s) ? b->busy_until_s : now_s;
+    double t = frame_time_s(f);
+
+    if (b->count == CHECK_QUEUE_LEN)
+    {
+        failures++;
+        printf("FAIL: bus queue overflow\n");
+        return;
+    }
+    b->slot[b->count].frame = *f;
+    b->slot[b->count].deliver_s = start + t;
+    b->count++;
+    b->busy_until_s = start + t;
+    b->busy_total_s += t;
+}
+
+static int bus_pop(bus_t *b, double now_s, odrive_can_frame_t *f)
+{
+    if (b->count == 0 || b->slot[0].deliver_s > now_s) return 0;
+    *f = b->slot[0].frame;
+    memmove(&b->slot[0], &b->slot[1], (size_t)(b->count - 1) * sizeof(bus_slot_t));
+    b->count--;
+    return 1;
+}
+
+static double host_ns_per_pack(void)
+{
+    struct timespec t0, t1;
+    odrive_can_frame_t f;
+    volatile uint8 sink = 0;
+    const int n = 1000000;
+    int i;
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (i = 0; i < n; i++)
+    {
+        odrive_can_pack_set_input_torque(CHECK_NODE_ID, (float)i * 1e-6f, &f);
+        sink ^= f.data[1];
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    (void)sink;
+    return ((t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec)) / n;
+}
+
+int main(void)
+{
+    odrive_can_model_t model;
+    odrive_can_feedback_t fb;
+    odrive_can_frame_t f, tx[4];
+    bus_t to_odrive, to_mcu;
+    double now = 0.0, next_ctrl = 0.0, cmd_sent_s = -1.0, latency_max = 0.0;
+    float last_cmd = 0.0f;
+    uint32 cmds = 0, enc_expected = 0;
+    float enc_sent_vel[CHECK_QUEUE_LEN];
+    int enc_head = 0, enc_tail = 0;
+    int i, n;
+
+    memset(&to_odrive, 0, sizeof(to_odrive));
+    memset(&to_mcu, 0, sizeof(to_mcu));
+    memset(&fb, 0, sizeof(fb));
+    odrive_can_model_init(&model, CHECK_NODE_ID);
+
+    /* same start-up as odrive_init(): torque mode + passthrough, then closed loop */
+    odrive_can_pack_set_controller_mode(CHECK_NODE_ID, ODRIVE_CONTROL_MODE_TORQUE_CONTROL, ODRIVE_INPUT_MODE_PASSTHROUGH, &f);
+    bus_send(&to_odrive, now, &f);
+    odrive_can_pack_set_axis_state(CHECK_NODE_ID, ODRIVE_AXIS_STATE_CLOSED_LOOP_CONTROL, &f);
+    bus_send(&to_odrive, now, &f);
+    /* a torque command for another node must not move this axis */
+    odrive_can_pack_set_input_torque(CHECK_NODE_ID + 1u, 5.0f, &f);
+    bus_send(&to_odrive, now, &f);
+
+    while (now < CHECK_DURATION_S)
+    {
+        if (now >= next_ctrl)
+        {
+            next_ctrl += CHECK_CTRL_PERIOD_S;
+            last_cmd = 0.5f * (float)sin(6.283185307179586 * 1.5 * now);
+            odrive_can_pack_set_input_torque(CHECK_NODE_ID, last_cmd, &f);
+            bus_send(&to_odrive, now, &f);
+            cmd_sent_s = now;
+            cmds++;
+        }
+
+        while (bus_pop(&to_odrive, now, &f))
+        {
+            odrive_can_model_receive(&model, &f);
+            if (ODRIVE_CAN_CMD_OF(f.id) == ODRIVE_CAN_CMD_SET_INPUT_TORQUE && ODRIVE_CAN_NODE_OF(f.id) == CHECK_NODE_ID)
+            {
+                EXPECT(memcmp(&model.input_torque, &last_cmd, sizeof(float)) == 0,
+                       "torque %.9g arrived as %.9g", last_cmd, model.input_torque);
+                if (cmd_sent_s > CHECK_CTRL_PERIOD_S && now - cmd_sent_s > latency_max) latency_max = now - cmd_sent_s;
+            }
+        }
+
+        n = odrive_can_model_step(&model, now, CHECK_STEP_S, tx, 4);
+        for (i = 0; i < n; i++)
+        {
+            if (ODRIVE_CAN_CMD_OF(tx[i].id) == ODRIVE_CAN_CMD_GET_ENCODER_ESTIMATES)
+            {
+                memcpy(&enc_sent_vel[enc_head], &tx[i].data[4], sizeof(float));
+                enc_head = (enc_head + 1) % CHECK_QUEUE_LEN;
+                enc_expected++;
+            }
+            bus_send(&to_mcu, now, &tx[i]);
+        }
+
+        while (bus_pop(&to_mcu, now, &f))
+        {
+            if (odrive_can_decode(&f, CHECK_NODE_ID, &fb) == ODRIVE_CAN_CMD_GET_ENCODER_ESTIMATES)
+            {
+                EXPECT(fb.vel_rps == enc_sent_vel[enc_tail], "velocity %.9g decoded as %.9g",
+                       enc_sent_vel[enc_tail], fb.vel_rps);
+                enc_tail = (enc_tail + 1) % CHECK_QUEUE_LEN;
+            }
+        }
+        now += CHECK_STEP_S;
+    }
+
+    EXPECT(model.control_mode == ODRIVE_CONTROL_MODE_TORQUE_CONTROL && model.input_mode == ODRIVE_INPUT_MODE_PASSTHROUGH,
+           "controller mode %u/%u", (unsigned)model.control_mode, (unsigned)model.input_mode);
+    EXPECT(model.frames_ignored == 1u, "model ignored %u frames, expected 1 (foreign node)", (unsigned)model.frames_ignored);
+    EXPECT(fb.encoder_count + 2u >= enc_expected, "decoded %u of %u encoder frames", (unsigned)fb.encoder_count, (unsigned)enc_expected);
+    EXPECT(fb.heartbeat_count >= 19u && fb.axis_state == ODRIVE_AXIS_STATE_CLOSED_LOOP_CONTROL,
+           "heartbeat count %u state %u", (unsigned)fb.heartbeat_count, (unsigned)fb.axis_state);
+
+    printf("encoder estimates    %u sent, %u decoded, heartbeats %u\n",
+           (unsigned)enc_expected, (unsigned)fb.encoder_count, (unsigned)fb.heartbeat_count);
+
+    /* malformed / foreign frames leave the feedback untouched */
+    {
+        odrive_can_feedback_t before = fb;
+        f.id = ODRIVE_CAN_ID(CHECK_NODE_ID, ODRIVE_CAN_CMD_GET_ENCODER_ESTIMATES);
+        f.dlc = 4u;
+        f.rtr = 0u;
+        EXPECT(odrive_can_decode(&f, CHECK_NODE_ID, &fb) == 0u, "short encoder frame accepted");
+        f.dlc = 8u;
+        f.id = ODRIVE_CAN_ID(CHECK_NODE_ID + 1u, ODRIVE_CAN_CMD_GET_ENCODER_ESTIMATES);
+        EXPECT(odrive_can_decode(&f, CHECK_NODE_ID, &fb) == 0u, "foreign node frame accepted");
+        EXPECT(memcmp(&before, &fb, sizeof(fb)) == 0, "feedback changed by rejected frames");
+    }
+
+    /* remote request path used by odrive_request_speed() when the cyclic stream is missing */
+    model.encoder_period_s = 0.0;
+    odrive_can_pack_request(CHECK_NODE_ID, ODRIVE_CAN_CMD_GET_ENCODER_ESTIMATES, &f);
+    odrive_can_model_receive(&model, &f);
+    n = odrive_can_model_step(&model, now, CHECK_STEP_S, tx, 4);
+    EXPECT(n >= 1 && odrive_can_decode(&tx[0], CHECK_NODE_ID, &fb) == ODRIVE_CAN_CMD_GET_ENCODER_ESTIMATES,
+           "remote request not answered");
+
+    /* estop drops the axis to idle, reported by the next heartbeat */
+    odrive_can_pack_command(CHECK_NODE_ID, ODRIVE_CAN_CMD_ESTOP, &f);
+    odrive_can_model_receive(&model, &f);
+    model.heartbeat_due_s = now;
+    n = odrive_can_model_step(&model, now, CHECK_STEP_S, tx, 4);
+    for (i = 0; i < n; i++) odrive_can_decode(&tx[i], CHECK_NODE_ID, &fb);
+    EXPECT(fb.axis_state == ODRIVE_AXIS_STATE_IDLE && fb.axis_error != 0u, "estop not reflected in heartbeat");
+
+    odrive_can_pack_set_input_torque(CHECK_NODE_ID, 0.0f, &f);
+    printf("torque commands      %u, wire time %.1f us each, worst command->ODrive %.1f us (steady state)\n",
+           (unsigned)cmds, frame_time_s(&f) * 1e6, latency_max * 1e6);
+    printf("bus load             %.1f %% at %.0f kbit/s\n",
+           100.0 * (to_odrive.busy_total_s + to_mcu.busy_total_s) / CHECK_DURATION_S, CHECK_BAUDRATE / 1000.0);
+    printf("pack cost (host)     %.1f ns per Set_Input_Torque\n", host_ns_per_pack());
+    printf("%s\n", failures ? "FAILED" : "OK");
+    return failures ? 1 : 0;
+}
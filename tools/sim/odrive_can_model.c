@@ -0,0 +1,123 @@
+/* odrive_can_model.c - see odrive_can_model.h */
+#include "odrive_can_model.h"
+
+static uint32 rd_u32(const uint8 *p)
+{
+    return (uint32)p[0] | ((uint32)p[1] << 8) | ((uint32)p[2] << 16) | ((uint32)p[3] << 24);
+}
+
+static float rd_f32(const uint8 *p)
+{
+    union { uint32 u; float f; } v;
+    v.u = rd_u32(p);
+    return v.f;
+}
+
+static void wr_u32(uint8 *p, uint32 x)
+{
+    p[0] = (uint8)x; p[1] = (uint8)(x >> 8); p[2] = (uint8)(x >> 16); p[3] = (uint8)(x >> 24);
+}
+
+static void wr_f32(uint8 *p, float f)
+{
+    union { uint32 u; float f; } v;
+    v.f = f;
+    wr_u32(p, v.u);
+}
+
+void odrive_can_model_init(odrive_can_model_t *m, uint8 node_id)
+{
+    memset(m, 0, sizeof(*m));
+    m->node_id = node_id;
+    m->axis_state = 1u;
+    m->inertia = 0.002;
+    m->encoder_period_s = 0.005;
+    m->heartbeat_period_s = 0.1;
+}
+
+void odrive_can_model_receive(odrive_can_model_t *m, const odrive_can_frame_t *frame)
+{
+    uint32 cmd = frame->id & 0x1Fu;
+
+    if ((frame->id >> 5) != m->node_id)
+    {
+        m->frames_ignored++;
+        return;
+    }
+    m->frames_in++;
+
+    if (frame->rtr)
+    {
+        if (cmd == 0x009u) m->pending_rtr = 1u;
+        else m->frames_ignored++;
+        return;
+    }
+
+    switch (cmd)
+    {
+        case 0x002u:                                    /* Estop */
+            m->axis_state = 1u;
+            m->axis_error |= 0x00000800u;
+            m->input_torque = 0.0f;
+            break;
+        case 0x007u:
+            if (frame->dlc >= 4u) m->axis_state = (uint8)rd_u32(&frame->data[0]);
+            break;
+        case 0x00Bu:
+            if (frame->dlc >= 8u)
+            {
+                m->control_mode = rd_u32(&frame->data[0]);
+                m->input_mode = rd_u32(&frame->data[4]);
+            }
+            break;
+        case 0x00Eu:
+            if (frame->dlc >= 4u) m->input_torque = rd_f32(&frame->data[0]);
+            break;
+        case 0x018u:
+            m->axis_error = 0u;
+            break;
+        default:
+            m->frames_ignored++;
+            break;
+    }
+}
+
+static void make_encoder_frame(const odrive_can_model_t *m, odrive_can_frame_t *f)
+{
+    memset(f, 0, sizeof(*f));
+    f->id = ((uint32)m->node_id << 5) | 0x009u;
+    f->dlc = 8u;
+    wr_f32(&f->data[0], (float)m->pos_turns);
+    wr_f32(&f->data[4], (float)m->vel_rps);
+}
+
+int odrive_can_model_step(odrive_can_model_t *m, double now_s, double dt_s, odrive_can_frame_t *out, int max_out)
+{
+    int n = 0;
+    double torque = 0.0;
+
+    if (m->axis_state == 8u && m->control_mode == 1u)
+    {
+        torque = m->input_torque;
+    }
+    m->vel_rps += torque / m->inertia / 6.283185307179586 * dt_s;
+    m->pos_turns += m->vel_rps * dt_s;
+
+    if ((m->pending_rtr || (m->encoder_period_s > 0.0 && now_s >= m->encoder_due_s)) && n < max_out)
+    {
+        make_encoder_frame(m, &out[n++]);
+        if (!m->pending_rtr) m->encoder_due_s += m->encoder_period_s;
+        m->pending_rtr = 0u;
+    }
+    if (now_s >= m->heartbeat_due_s && n < max_out)
+    {
+        odrive_can_frame_t *f = &out[n++];
+        memset(f, 0, sizeof(*f));
+        f->id = ((uint32)m->node_id << 5) | 0x001u;
+        f->dlc = 8u;
+        wr_u32(&f->data[0], m->axis_error);
+        f->data[4] = m->axis_state;
+        m->heartbeat_due_s += m->heartbeat_period_s;
+    }
+    return n;
+}
@@ -0,0 +1,39 @@
+/* odrive_can_model.h - stand-in ODrive axis speaking CANSimple on the host
+ *
+ * Decodes the raw frame bytes itself (it does not reuse odrive_cansimple.c) so a
+ * symmetric encode/decode bug in the firmware protocol layer is still caught.
+ */
+#ifndef ODRIVE_CAN_MODEL_H
+#define ODRIVE_CAN_MODEL_H
+
+#include "zf_common_headfile.h"
+#include "odrive_cansimple.h"
+
+typedef struct
+{
+    uint8  node_id;
+    uint8  axis_state;              /* 1 idle, 8 closed loop */
+    uint32 axis_error;
+    uint32 control_mode;
+    uint32 input_mode;
+    float  input_torque;            /* last Set_Input_Torque, applied in closed loop torque mode */
+    double pos_turns;
+    double vel_rps;
+    double inertia;                 /* kg m^2 at the motor */
+    double encoder_period_s;        /* encoder_rate_ms, 0 = remote requests only */
+    double heartbeat_period_s;      /* heartbeat_rate_ms */
+    double encoder_due_s;
+    double heartbeat_due_s;
+    uint32 frames_in;
+    uint32 frames_ignored;          /* other node / unknown command */
+    uint8  pending_rtr;             /* answer a remote request on the next step */
+} odrive_can_model_t;
+
+void odrive_can_model_init      (odrive_can_model_t *m, uint8 node_id);
+void odrive_can_model_receive   (odrive_can_model_t *m, const odrive_can_frame_t *frame);
+
+/* Advances the axis by dt and writes the frames it transmits in that step.
+ * Returns the number of frames written (at most max_out). */
+int  odrive_can_model_step      (odrive_can_model_t *m, double now_s, double dt_s, odrive_can_frame_t *out, int max_out);
+
+#endif
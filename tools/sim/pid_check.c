@@ -0,0 +1,279 @@
+/* pid_check.c - code/control/pid.c step, saturation and gain change check
+ *
+ * Build (from the repository root):
+ *   gcc -O2 -std=c99 -Itools/sim/host -Itools/sim -Icode/control \
+ *       tools/sim/pid_check.c tools/sim/pid_legacy.c code/control/pid.c -lm -o pid_check
+ *   ./pid_check
+ *
+ * Runs pid.c next to the old balance_control.c update (pid_legacy.c) at 5 ms:
+ *   kick        setpoint step 0 -> 10 with kd > 0, measurement still: the new
+ *               controller must move by the P step only
+ *   windup      PI on a first order plant (gain 2, 0.5 s, output +-1) holding a
+ *               standing load: a setpoint step that saturates the output, and a
+ *               3 s overload the output range cannot hold; overshoot and
+ *               settling to 2% no worse than before
+ *   gain change kp tripled at steady state with setpoint weight 0.5: output step
+ *               at the change below 1% of the range (the unweighted jump printed)
+ *   filter      kd on a measurement with white noise: derivative term spread
+ *               with the 20 ms filter at most a third of the unfiltered one
+ *   feedforward zero gains: the output is the clamped feedforward
+ * Also times both updates per call. Exit code 1 when a check fails.
+ */
+#define _POSIX_C_SOURCE 200809L
+#include <time.h>
+
+#include "pid.h"
+#include "pid_legacy.h"
+
+#define CHECK_DT_S              (0.005f)
+#define CHECK_PLANT_GAIN        (2.0f)
+#define CHECK_PLANT_TAU_S       (0.5f)
+
+static int failures = 0;
+static uint32 rng_state = 3;
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static double gauss(void)
+{
+    double u1, u2;
+
+    rng_state = rng_state * 1664525u + 1013904223u;
+    u1 = ((rng_state >> 8) + 1.0) / 16777217.0;
+    rng_state = rng_state * 1664525u + 1013904223u;
+    u2 = (rng_state >> 8) / 16777216.0;
+    return sqrt(-2.0 * log(u1)) * cos(6.283185307179586 * u2);
+}
+
+static void expect(int ok, const char *what)
+{
+    printf("  %-62s %s\n", what, ok ? "ok" : "FAIL");
+    failures += !ok;
+}
+
+static pid_config_t config(float kp, float ki, float kd, float limit)
+{
+    pid_config_t c;
+
+    c.kp = kp;
+    c.ki = ki;
+    c.kd = kd;
+    c.setpoint_weight_p = 1.0f;
+    c.setpoint_weight_d = 0.0f;
+    c.derivative_tau_s = 0.0f;
+    c.tracking_tau_s = 0.0f;           /* half the integral time */
+    c.output_limit = limit;
+    return c;
+}
+
+static legacy_pid_t legacy(float kp, float ki, float kd, float max_integral, float limit)
+{
+    legacy_pid_t l;
+
+    memset(&l, 0, sizeof(l));
+    l.kp = kp;
+    l.ki = ki;
+    l.kd = kd;
+    l.max_integral = max_integral;
+    l.output_limit = limit;
+    return l;
+}
+
+/* overshoot and settling time to 2% after the step or the release */
+typedef struct
+{
+    float overshoot;
+    float settle_s;
+    float peak_integral;
+} windup_result_t;
+
+/* kp 2, ki 4 on the plant: settle on a standing load at setpoint 0, then step the
+   setpoint to 1 (P alone saturates the output); overload_until_s > 0 instead
+   holds setpoint 1 and adds a load the output range cannot hold from 2 s to
+   overload_until_s */
+static windup_result_t windup(int use_legacy, float overload_until_s)
+{
+    pid_config_t c = config(2.0f, 4.0f, 0.0f, 1.0f);
+    pid_controller_t pid;
+    legacy_pid_t old = legacy(2.0f, 4.0f, 0.0f, 10.0f, 1.0f);
+    windup_result_t r = {0.0f, 0.0f, 0.0f};
+    float y = 0.0f, setpoint, u, load, t, start, last_outside;
+
+    start = (overload_until_s > 0.0f) ? overload_until_s : 3.0f;
+    last_outside = start;
+    pid_init(&pid, &c);
+    for (t = 0.0f; t < start + 8.0f; t += CHECK_DT_S)
+    {
+        setpoint = (overload_until_s > 0.0f || t >= start) ? 1.0f : 0.0f;
+        load = 0.8f;
+        if (overload_until_s > 0.0f && t >= 2.0f && t < overload_until_s)
+        {
+            load = 2.6f;                /* needs u = 1.8 */
+        }
+        if (use_legacy)
+        {
+            u = legacy_pid_update(&old, setpoint - y, CHECK_DT_S);
+            legacy_pid_saturation(&old, setpoint - y, u, CHECK_DT_S);
+            r.peak_integral = fmaxf(r.peak_integral, old.ki * old.integral);
+        }
+        else
+        {
+            u = pid_update(&pid, setpoint, y, 0.0f, CHECK_DT_S);
+            r.peak_integral = fmaxf(r.peak_integral, pid.integral);
+        }
+        y += (CHECK_PLANT_GAIN * u - load - y) * (CHECK_DT_S / CHECK_PLANT_TAU_S);
+        if (t >= start)
+        {
+            r.overshoot = fmaxf(r.overshoot, y - 1.0f);
+            if (fabsf(y - 1.0f) > 0.02f) last_outside = t;
+        }
+    }
+    r.settle_s = last_outside - start;
+    return r;
+}
+
+int main(void)
+{
+    char line[96];
+
+    /* kick */
+    {
+        pid_config_t c = config(1.0f, 0.5f, 0.2f, 100.0f);
+        pid_controller_t pid;
+        legacy_pid_t old = legacy(1.0f, 0.5f, 0.2f, 50.0f, 100.0f);
+        float before, after, old_before, old_after;
+
+        pid_init(&pid, &c);
+        before = pid_update(&pid, 0.0f, 0.0f, 0.0f, CHECK_DT_S);
+        after = pid_update(&pid, 10.0f, 0.0f, 0.0f, CHECK_DT_S);
+        old_before = legacy_pid_update(&old, 0.0f, CHECK_DT_S);
+        old_after = legacy_pid_update(&old, 10.0f, CHECK_DT_S);
+        printf("kick: output step %.2f (before %.2f, P step 10)\n", after - before, old_after - old_before);
+        snprintf(line, sizeof(line), "kick: setpoint step moves the output by the P step (%.2f)", after - before);
+        expect(fabsf(after - before - 10.0f) < 0.01f, line);
+    }
+
+    /* windup */
+    {
+        windup_result_t n = windup(0, 0.0f), o = windup(1, 0.0f);
+
+        printf("windup step: overshoot %.3f settle %.2f s peak I %.2f (before %.3f, %.2f s, %.2f)\n",
+               n.overshoot, n.settle_s, n.peak_integral, o.overshoot, o.settle_s, o.peak_integral);
+        snprintf(line, sizeof(line), "windup step: overshoot no worse than before (%.3f)", n.overshoot);
+        expect(n.overshoot <= o.overshoot + 1e-3f, line);
+        snprintf(line, sizeof(line), "windup step: settles no later than before (%.2f s)", n.settle_s);
+        expect(n.settle_s <= o.settle_s + CHECK_DT_S, line);
+
+        n = windup(0, 5.0f);
+        o = windup(1, 5.0f);
+        printf("windup overload: overshoot %.3f settle %.2f s peak I %.2f (before %.3f, %.2f s, %.2f)\n",
+               n.overshoot, n.settle_s, n.peak_integral, o.overshoot, o.settle_s, o.peak_integral);
+        snprintf(line, sizeof(line), "windup overload: overshoot no worse than before (%.3f)", n.overshoot);
+        expect(n.overshoot <= o.overshoot + 1e-3f, line);
+        snprintf(line, sizeof(line), "windup overload: settles no later than before (%.2f s)", n.settle_s);
+        expect(n.settle_s <= o.settle_s + CHECK_DT_S, line);
+    }
+
+    /* gain change */
+    {
+        pid_config_t c = config(0.5f, 2.0f, 0.0f, 1.0f);
+        pid_controller_t pid;
+        float y = 0.0f, u = 0.0f, before, jump, t;
+
+        c.setpoint_weight_p = 0.5f;
+        pid_init(&pid, &c);
+        for (t = 0.0f; t < 5.0f; t += CHECK_DT_S)
+        {
+            u = pid_update(&pid, 1.0f, y, 0.0f, CHECK_DT_S);
+            y += (CHECK_PLANT_GAIN * u - y) * (CHECK_DT_S / CHECK_PLANT_TAU_S);
+        }
+        before = u;
+        jump = (1.5f - 0.5f) * pid.last_p_input;
+        pid_set_gains(&pid, 1.5f, 2.0f, 0.0f);
+        u = pid_update(&pid, 1.0f, y, 0.0f, CHECK_DT_S);
+        printf("gain change: output step %.4f (without transfer %.3f)\n", u - before, jump);
+        snprintf(line, sizeof(line), "gain change: kp x3 moves the output by < 1%% of range (%.4f)", u - before);
+        expect(fabsf(u - before) < 0.01f, line);
+    }
+
+    /* filter */
+    {
+        pid_config_t c = config(0.0f, 0.0f, 0.2f, 1000.0f);
+        pid_controller_t raw, filtered;
+        double s_raw = 0.0, s_filtered = 0.0;
+        float y;
+        int i, n = 20000;
+
+        pid_init(&raw, &c);
+        c.derivative_tau_s = 0.02f;
+        pid_init(&filtered, &c);
+        for (i = 0; i < n; i++)
+        {
+            y = (float)(0.01 * gauss());
+            s_raw += pow(pid_update(&raw, 0.0f, y, 0.0f, CHECK_DT_S), 2.0);
+            s_filtered += pow(pid_update(&filtered, 0.0f, y, 0.0f, CHECK_DT_S), 2.0);
+        }
+        s_raw = sqrt(s_raw / n);
+        s_filtered = sqrt(s_filtered / n);
+        printf("filter: derivative term RMS %.3f unfiltered, %.3f with 20 ms\n", s_raw, s_filtered);
+        snprintf(line, sizeof(line), "filter: 20 ms filter cuts the noise at least 3x (%.1fx)", s_raw / s_filtered);
+        expect(s_filtered * 3.0 <= s_raw, line);
+    }
+
+    /* feedforward */
+    {
+        pid_config_t c = config(0.0f, 0.0f, 0.0f, 1.0f);
+        pid_controller_t pid;
+        float a, b;
+
+        pid_init(&pid, &c);
+        a = pid_update(&pid, 3.0f, 1.0f, 0.4f, CHECK_DT_S);
+        b = pid_update(&pid, 3.0f, 1.0f, 2.0f, CHECK_DT_S);
+        expect(fabsf(a - 0.4f) < 1e-6f && b == 1.0f, "feedforward: passed through, clamped");
+    }
+
+    /* cost per call */
+    {
+        pid_config_t c = config(-1.0f, 0.5f, 0.0f, 3.0f);
+        pid_controller_t pid;
+        legacy_pid_t old = legacy(-1.0f, 0.5f, 0.0f, 10.0f, 3.0f);
+        volatile float sink = 0.0f;
+        uint32 runs = 20000000u, r;
+        double t0, t_old, t_new, t_new_d;
+
+        pid_init(&pid, &c);
+        t0 = now_s();
+        for (r = 0; r < runs; r++)
+        {
+            sink = legacy_pid_update(&old, (float)(r & 7u) * 0.1f - sink, 0.005f);
+        }
+        t_old = now_s() - t0;
+
+        t0 = now_s();
+        for (r = 0; r < runs; r++)
+        {
+            sink = pid_update(&pid, (float)(r & 7u) * 0.1f, sink, 0.0f, 0.005f);
+        }
+        t_new = now_s() - t0;
+
+        c.kd = 0.05f;
+        c.derivative_tau_s = 0.01f;
+        pid_init(&pid, &c);
+        t0 = now_s();
+        for (r = 0; r < runs; r++)
+        {
+            sink = pid_update(&pid, (float)(r & 7u) * 0.1f, sink, 0.0f, 0.005f);
+        }
+        t_new_d = now_s() - t0;
+
+        printf("\nupdate: before %.1f ns, now %.1f ns (kd = 0), %.1f ns (kd, filtered) per call\n\n",
+               t_old * 1e9 / runs, t_new * 1e9 / runs, t_new_d * 1e9 / runs);
+    }
+
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,64 @@
+/* pid_legacy.c - see pid_legacy.h */
+#include "pid_legacy.h"
+
+static inline float constrain_float(float value, float min_val, float max_val)
+{
+    if (value < min_val) return min_val;
+    if (value > max_val) return max_val;
+    return value;
+}
+
+float legacy_pid_update(legacy_pid_t *pid, float error, float dt)
+{
+    if (dt <= 0.0f) dt = 1e-6f;
+
+    float p_term = pid->kp * error;
+
+    float derivative = (error - pid->last_error) / dt;
+    pid->last_error = error;
+    float d_term = pid->kd * derivative;
+
+    float i_term = pid->ki * pid->integral;
+    float out_pre = p_term + i_term + d_term;
+
+    uint8 saturated_hi = (out_pre > pid->output_limit);
+    uint8 saturated_lo = (out_pre < -pid->output_limit);
+
+    uint8 allow_integrate = 0;
+    if (!saturated_hi && !saturated_lo)
+    {
+        allow_integrate = 1;
+    }
+    else
+    {
+        if (saturated_hi && (error < 0.0f)) allow_integrate = 1;
+        if (saturated_lo && (error > 0.0f)) allow_integrate = 1;
+    }
+
+    if (allow_integrate)
+    {
+        pid->integral += error * dt;
+        pid->integral = constrain_float(pid->integral, -pid->max_integral, pid->max_integral);
+    }
+
+    i_term = pid->ki * pid->integral;
+    float output = p_term + i_term + d_term;
+    return constrain_float(output, -pid->output_limit, pid->output_limit);
+}
+
+void legacy_pid_saturation(legacy_pid_t *pid, float error, float output, float dt)
+{
+    if ((fabsf(output) > (pid->output_limit * 0.97f)) && (error * output) > 0.0f)
+    {
+        pid->saturation_s += dt;
+        if (pid->saturation_s > 0.5f)
+        {
+            pid->integral *= 0.5f;
+            pid->saturation_s = 0.25f;
+        }
+    }
+    else
+    {
+        pid->saturation_s = 0.0f;
+    }
+}
@@ -0,0 +1,30 @@
+/* pid_legacy.h - the PID update balance_control.c used before code/control/pid.c
+ *
+ * Derivative of the raw error, conditional integration, integral limited in
+ * error * s, and the rate loop's "halve the integral after 0.5 s saturated and
+ * not correcting" rule as a separate call, so pid_check.c can run both side by
+ * side. Host only.
+ */
+#ifndef _pid_legacy_h_
+#define _pid_legacy_h_
+
+#include "zf_common_headfile.h"
+
+typedef struct
+{
+    float kp;
+    float ki;
+    float kd;
+    float integral;
+    float last_error;
+    float max_integral;
+    float output_limit;
+    float saturation_s;
+} legacy_pid_t;
+
+float legacy_pid_update         (legacy_pid_t *pid, float error, float dt);
+
+/* after legacy_pid_update() on the rate loop, with the clamped output */
+void  legacy_pid_saturation     (legacy_pid_t *pid, float error, float output, float dt);
+
+#endif
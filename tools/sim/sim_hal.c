@@ -0,0 +1,264 @@
+/* sim_hal.c - see sim_hal.h */
+#include "sim_hal.h"
+#include "zf_common_headfile.h"
+#include "driver_imu_fusion.h"
+#include "driver_odrive.h"
+#include "driver_motor.h"
+#include "driver_servo.h"
+#include "snapshot.h"
+
+#define SIM_DELAY_SLOTS         (64u)
+#define SIM_RAD2DEG             (57.29577951308232)
+#define SIM_GRAVITY             (9.80665)
+#define SIM_SPEED_MPS_PER_PERCENT (0.05)       /* BALANCE_SPEED_MPS_PER_PERCENT */
+
+typedef struct
+{
+    double release_s;
+    float  v[4];
+} sim_delay_slot_t;
+
+typedef struct
+{
+    sim_delay_slot_t slot[SIM_DELAY_SLOTS];
+    unsigned int head;
+    unsigned int tail;
+} sim_delay_line_t;
+
+static const bike_plant_param_t *plant_param;
+static double sim_now_s = 0.0;
+static double imu_next_sample_s = 0.0;
+static sim_delay_line_t imu_line;
+static sim_delay_line_t cmd_line;
+static double motor_cmd = 0.0;
+static float  wheel_rps = 0.0f;
+static float  servo_angle = SERVO_ANGLE_CENTER;      /* last servo_set_angle() */
+static double servo_output = SERVO_ANGLE_CENTER;     /* what the PWM carries */
+static double servo_next_period_s = 0.0;
+static unsigned long long rng_state = 1;
+static callback_function imu_frame_callback = NULL;
+
+/* published like driver_imu.c does, through the real snapshot.c */
+static yis_imu_t imu_frame;
+static yis_imu_t imu_slots[2];
+static snapshot_t imu_snapshot;
+
+static void delay_push(sim_delay_line_t *l, double release_s, const float *v)
+{
+    unsigned int next = (l->head + 1u) % SIM_DELAY_SLOTS;
+    if (next == l->tail)
+    {
+        l->tail = (l->tail + 1u) % SIM_DELAY_SLOTS;     /* overflow: drop oldest */
+    }
+    l->slot[l->head].release_s = release_s;
+    memcpy(l->slot[l->head].v, v, sizeof(l->slot[l->head].v));
+    l->head = next;
+}
+
+/* Pops one matured entry per call so every IMU frame is delivered individually. */
+static int delay_pop(sim_delay_line_t *l, double now_s, float *v)
+{
+    if (l->tail != l->head && l->slot[l->tail].release_s <= now_s)
+    {
+        memcpy(v, l->slot[l->tail].v, sizeof(l->slot[l->tail].v));
+        l->tail = (l->tail + 1u) % SIM_DELAY_SLOTS;
+        return 1;
+    }
+    return 0;
+}
+
+static double sim_uniform(void)
+{
+    /* xorshift64* */
+    rng_state ^= rng_state >> 12;
+    rng_state ^= rng_state << 25;
+    rng_state ^= rng_state >> 27;
+    return (double)((rng_state * 2685821657736338717ULL) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+double sim_hal_gauss(void)
+{
+    double u1 = sim_uniform();
+    double u2 = sim_uniform();
+    if (u1 < 1e-12) u1 = 1e-12;
+    return sqrt(-2.0 * log(u1)) * cos(6.283185307179586 * u2);
+}
+
+void sim_hal_reset(const bike_plant_param_t *p, unsigned int seed)
+{
+    plant_param = p;
+    sim_now_s = 0.0;
+    imu_next_sample_s = 0.0;
+    memset(&imu_line, 0, sizeof(imu_line));
+    memset(&cmd_line, 0, sizeof(cmd_line));
+    memset(&imu_frame, 0, sizeof(imu_frame));
+    snapshot_init(&imu_snapshot, imu_slots, sizeof(yis_imu_t));
+    motor_cmd = 0.0;
+    wheel_rps = 0.0f;
+    servo_angle = SERVO_ANGLE_CENTER;
+    servo_output = SERVO_ANGLE_CENTER;
+    servo_next_period_s = 0.0;
+    rng_state = 0x9E3779B97F4A7C15ULL ^ ((unsigned long long)seed * 0x100000001B3ULL);
+    if (rng_state == 0) rng_state = 1;
+}
+
+void sim_hal_set_time(double t_s)
+{
+    sim_now_s = t_s;
+}
+
+double sim_hal_get_time(void)
+{
+    return sim_now_s;
+}
+
+void sim_hal_imu_update(const bike_plant_state_t *s)
+{
+    float v[4];
+
+    if (sim_now_s >= imu_next_sample_s)
+    {
+        double roll_meas = s->roll + plant_param->imu_roll_offset_deg / SIM_RAD2DEG;
+        double lever = plant_param->com_height_m;
+
+        imu_next_sample_s += 1.0 / plant_param->imu_rate_hz;
+        /* module roll output (its own filter is modelled by imu_latency_s) */
+        v[0] = (float)(roll_meas * SIM_RAD2DEG + plant_param->imu_roll_noise_deg * sim_hal_gauss());
+        v[1] = (float)(s->roll_rate * SIM_RAD2DEG + plant_param->imu_gyro_bias_dps
+                       + plant_param->imu_gyro_noise_dps * sim_hal_gauss());
+        /* specific force in the frame: gravity + tangential/centripetal terms of the IMU sitting at the COM */
+        v[2] = (float)(SIM_GRAVITY * sin(roll_meas) - lever * s->roll_acc
+                       + plant_param->imu_acc_noise * sim_hal_gauss());
+        v[3] = (float)(SIM_GRAVITY * cos(roll_meas) - lever * s->roll_rate * s->roll_rate
+                       + plant_param->imu_acc_noise * sim_hal_gauss());
+        delay_push(&imu_line, sim_now_s + plant_param->imu_latency_s, v);
+    }
+
+    while (delay_pop(&imu_line, sim_now_s, v))
+    {
+        imu_frame.roll = v[0];
+        imu_frame.wx = v[1];
+        imu_frame.ay = v[2];
+        imu_frame.az = v[3];
+        imu_frame.timestamp = system_getval();  /* arrival, same time base as system_getval() here */
+        imu_frame.tid++;
+        snapshot_publish(&imu_snapshot, &imu_frame);
+        if (imu_frame_callback != NULL)
+        {
+            imu_frame_callback();
+        }
+    }
+}
+
+double sim_hal_motor_command(void)
+{
+    float v[4];
+    while (delay_pop(&cmd_line, sim_now_s, v))
+    {
+        motor_cmd = v[0];
+    }
+    return motor_cmd;
+}
+
+void sim_hal_set_wheel_speed(double rps)
+{
+    wheel_rps = (float)rps;
+}
+
+double sim_hal_servo_angle(void)
+{
+    while (sim_now_s >= servo_next_period_s)
+    {
+        servo_output = servo_angle;
+        servo_next_period_s += 1.0 / SERVO_PWM_FREQ;
+    }
+    return servo_output;
+}
+
+/* =========================
+ * Firmware driver stand-ins
+ * ========================= */
+uint32 system_getval(void)
+{
+    /* 10ns ticks, wraps like the real STM based counter */
+    return (uint32)(unsigned long long)(sim_now_s * 1e8);
+}
+
+void imu_set_frame_callback(callback_function callback)
+{
+    imu_frame_callback = callback;
+}
+
+uint8 imu_get_sample(yis_imu_t *sample)
+{
+    return snapshot_read(&imu_snapshot, sample);
+}
+
+uint32 imu_get_sample_age_us(const yis_imu_t *sample)
+{
+    return (system_getval() - sample->timestamp) / 100u;
+}
+
+void odrive_init(void)
+{
+}
+
+void odrive_set_torque(float torque)
+{
+    float v[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+    if (plant_param == NULL) return;
+    if (torque > ODRIVE_TORQUE_MAX) torque = ODRIVE_TORQUE_MAX;
+    if (torque < ODRIVE_TORQUE_MIN) torque = ODRIVE_TORQUE_MIN;
+    v[0] = torque;
+    delay_push(&cmd_line, sim_now_s + plant_param->cmd_latency_s, v);
+}
+
+void odrive_stop(void)
+{
+    odrive_set_torque(0.0f);
+}
+
+void odrive_request_speed(void)
+{
+}
+
+void odrive_poll(void)
+{
+}
+
+uint8 odrive_get_speed(float *out_rps)
+{
+    if (!out_rps) return 0;
+    *out_rps = wheel_rps;
+    return 1;
+}
+
+/* Open loop speed percentage of the plant's forward speed */
+int16 motor_get_speed(void)
+{
+    if (plant_param == NULL) return 0;
+    return (int16)lround(plant_param->speed_mps / SIM_SPEED_MPS_PER_PERCENT);
+}
+
+void servo_init(float init_angle)
+{
+    servo_set_angle(init_angle);
+}
+
+void servo_set_angle(float angle)
+{
+    if (angle < SERVO_ANGLE_MIN) angle = SERVO_ANGLE_MIN;
+    if (angle > SERVO_ANGLE_MAX) angle = SERVO_ANGLE_MAX;
+    servo_angle = angle;
+}
+
+float servo_get_angle(void)
+{
+    return servo_angle;
+}
+
+void servo_set_center(void)
+{
+    servo_set_angle(SERVO_ANGLE_CENTER);
+}
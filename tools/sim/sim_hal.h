@@ -0,0 +1,33 @@
+/* sim_hal.h - simulated hardware behind the firmware's driver interfaces
+ *
+ * Implements imu_get_sample() / odrive_* / servo_* / motor_get_speed() /
+ * system_getval() for the host build so
+ * code/control can run unchanged against bike_plant. The IMU stream stands for
+ * the fused output of driver_imu_fusion, i.e. the YIS frames while both sources
+ * are healthy.
+ */
+#ifndef SIM_HAL_H
+#define SIM_HAL_H
+
+#include "bike_plant.h"
+
+void   sim_hal_reset            (const bike_plant_param_t *p, unsigned int seed);
+void   sim_hal_set_time         (double t_s);
+double sim_hal_get_time         (void);
+
+/* Sample the plant at the IMU rate and deliver frames after imu_latency_s. */
+void   sim_hal_imu_update       (const bike_plant_state_t *s);
+
+/* Torque command that has reached the ODrive by now (after cmd_latency_s). */
+double sim_hal_motor_command    (void);
+
+/* Feed the wheel speed the ODrive would report back (turns/s). */
+void   sim_hal_set_wheel_speed  (double rps);
+
+/* Servo angle (deg, 90 centre) the 50 Hz PWM carries by now: a new
+   servo_set_angle() takes effect at the next period boundary. */
+double sim_hal_servo_angle      (void);
+
+double sim_hal_gauss            (void);
+
+#endif
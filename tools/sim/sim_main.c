@@ -0,0 +1,382 @@
+/* sim_main.c - software-in-the-loop gain sweep for code/control/balance_control.c
+ *
+ * Build (from the repository root):
+ *   gcc -O2 -std=c99 -Itools/sim/host -Itools/sim -Icode/control -Icode/drivers -Icode/system \
+ *       -Ilibraries/infineon_libraries/Service/CpuGeneric/SysSe/Math \
+ *       tools/sim/sim_main.c tools/sim/sim_hal.c tools/sim/bike_plant.c \
+ *       code/control/balance_control.c code/control/attitude_estimator.c code/control/imu_calibration.c \
+ *       code/control/pid.c code/control/gain_schedule.c code/system/snapshot.c -lm -o bike_sim
+ *
+ * Usage:
+ *   ./bike_sim [-t sec] [-n trials] [-r roll0_deg] [-d push_nm] [-s seed] [-m pid|lqr|steer]
+ *              [-w on|off] [-a yis|cf|ekf] [-p name=value]... [-g akp,aki,akd,vkp,vki,vkd]... [gains.csv]
+ *
+ * Without -g or a gains file a built-in grid over angle Kp x velocity Kp is run.
+ * -m lqr runs every gain set of code/control/lqr_gains.h in BALANCE_MODE_LQR
+ * instead, one row per set. -w switches the wheel momentum desaturation
+ * (cascade modes) on or off, -p com_offset=... loads the bike off centre.
+ * -m steer runs the grid in BALANCE_MODE_STEER, which shares the torque demand
+ * with the steering servo; it needs the bike rolling, -p speed=... (m/s).
+ * Every gain set is simulated for n trials with a random initial roll and a
+ * lateral push half way through. One CSV row per gain set goes to stdout:
+ *   settling time (to +-0.5deg of the held lean, before the push), overshoot, peak motor torque,
+ *   peak wheel speed, the fraction of trials that fell, the mean time upright
+ *   and the mean time until the wheel reached SIM_WHEEL_SAT of its no-load
+ *   speed (nan when it never did).
+ */
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "zf_common_headfile.h"
+#include "balance_control.h"
+#include "driver_imu_fusion.h"
+#include "attitude_estimator.h"
+#include "imu_calibration.h"
+#include "driver_servo.h"
+#include "bike_plant.h"
+#include "sim_hal.h"
+
+#define SIM_PLANT_DT_S          (0.0005)
+#define SIM_CTRL_DT_S           (0.005)
+#define SIM_SETTLE_BAND_DEG     (0.5)
+#define SIM_FALL_DEG            (35.0)
+#define SIM_PUSH_LEN_S          (0.1)
+#define SIM_WHEEL_SAT           (0.9)       /* of wheel_speed_max: little torque left to speed up */
+#define SIM_MAX_GAIN_SETS       (256)
+#define SIM_RAD2DEG             (57.29577951308232)
+
+typedef struct
+{
+    float g[6];     /* akp aki akd vkp vki vkd */
+    int   lqr_gain_set;         /* >= 0: BALANCE_MODE_LQR with this lqr_gains.h row */
+} sim_gain_set_t;
+
+typedef struct
+{
+    double duration_s;
+    int    trials;
+    double roll0_deg;
+    double push_nm;
+    unsigned int seed;
+    int    attitude_mode;       /* -1: keep the firmware default */
+    int    mode;                /* -m, balance_mode_enum */
+    int    desat;               /* -w: -1 keeps the firmware default */
+} sim_config_t;
+
+typedef struct
+{
+    int    fell;
+    int    settled;
+    double settle_s;
+    double overshoot_deg;
+    double peak_torque;
+    double peak_wheel_rps;
+    double run_s;               /* until the fall, or the whole trial */
+    double sat_s;               /* first time at SIM_WHEEL_SAT, < 0: never */
+} sim_trial_result_t;
+
+/* balance_control only exposes relative adjustments, walk the gains there. */
+static void sim_apply_gains(const sim_gain_set_t *gs)
+{
+    float cur[6];
+    balance_control_get_pid_params_full(&cur[0], &cur[1], &cur[2], &cur[3], &cur[4], &cur[5]);
+    balance_control_adjust_angle_kp(gs->g[0] - cur[0]);
+    balance_control_adjust_angle_ki(gs->g[1] - cur[1]);
+    balance_control_adjust_angle_kd(gs->g[2] - cur[2]);
+    balance_control_adjust_velocity_kp(gs->g[3] - cur[3]);
+    balance_control_adjust_velocity_ki(gs->g[4] - cur[4]);
+    balance_control_adjust_velocity_kd(gs->g[5] - cur[5]);
+}
+
+static void sim_run_trial(const bike_plant_param_t *p, const sim_config_t *cfg, const sim_gain_set_t *gs,
+                          unsigned int seed, sim_trial_result_t *r)
+{
+    bike_plant_state_t s;
+    double t = 0.0;
+    double next_ctrl = 0.0;
+    double push_t = cfg->duration_s * 0.5;
+    double roll0, equilibrium, err0, err;
+    balance_control_state_t state;
+    double last_outside = 0.0;
+    long steps = (long)(cfg->duration_s / SIM_PLANT_DT_S);
+    long i;
+    int enabled = 0;
+    yis_imu_t frame;
+
+    sim_hal_reset(p, seed);
+    roll0 = cfg->roll0_deg * (2.0 * fabs(sim_hal_gauss()) > 1.0 ? 1.0 : 0.5) * (sim_hal_gauss() > 0.0 ? 1.0 : -1.0);
+    bike_plant_reset(&s, roll0);
+
+    balance_control_init();
+    if (cfg->attitude_mode >= 0) attitude_estimator_set_mode((attitude_mode_enum)cfg->attitude_mode);
+    if (cfg->desat >= 0) balance_control_set_desat_enable((uint8)cfg->desat);
+    if (gs->lqr_gain_set >= 0)
+    {
+        balance_control_select_lqr_gain_set((uint8)gs->lqr_gain_set);
+        balance_control_set_mode(BALANCE_MODE_LQR);
+    }
+    else
+    {
+        balance_control_set_mode(cfg->mode == BALANCE_MODE_STEER ? BALANCE_MODE_STEER : BALANCE_MODE_PID);
+        sim_apply_gains(gs);
+    }
+
+    /* the controller regulates the calibrated IMU angle to target_angle, the frame settles where that holds */
+    equilibrium = balance_control_get_target_angle() + imu_calibration_get()->roll_offset - p->imu_roll_offset_deg;
+    err0 = roll0 - equilibrium;
+
+    memset(r, 0, sizeof(*r));
+    r->run_s = cfg->duration_s;
+    r->sat_s = -1.0;
+
+    for (i = 0; i < steps; i++)
+    {
+        double roll_deg;
+
+        t = (double)i * SIM_PLANT_DT_S;
+        sim_hal_set_time(t);
+        sim_hal_imu_update(&s);
+
+        if (t >= next_ctrl)
+        {
+            next_ctrl += SIM_CTRL_DT_S;
+            /* like on the bike: enable once the IMU is delivering, the controller drops out on stale data */
+            if (!enabled && imu_get_sample(&frame))
+            {
+                balance_control_set_enable(1);
+                enabled = 1;
+            }
+            balance_control_update_5ms_isr();
+        }
+
+        s.disturbance = (t >= push_t && t < push_t + SIM_PUSH_LEN_S) ? cfg->push_nm : 0.0;
+        s.steer_cmd = (sim_hal_servo_angle() - SERVO_ANGLE_CENTER) / SIM_RAD2DEG;
+        bike_plant_step(p, &s, sim_hal_motor_command(), SIM_PLANT_DT_S);
+        sim_hal_set_wheel_speed(s.wheel_speed / (2.0 * 3.141592653589793));
+
+        roll_deg = s.roll * SIM_RAD2DEG;
+        if (fabs(roll_deg) > SIM_FALL_DEG || (enabled && !balance_control_get_enable()))
+        {
+            r->fell = 1;
+            r->run_s = t;
+            break;
+        }
+
+        if (fabs(s.torque_applied) > r->peak_torque) r->peak_torque = fabs(s.torque_applied);
+        if (fabs(s.wheel_speed) / 6.283185307 > r->peak_wheel_rps) r->peak_wheel_rps = fabs(s.wheel_speed) / 6.283185307;
+        if (r->sat_s < 0.0 && r->peak_wheel_rps >= SIM_WHEEL_SAT * p->wheel_speed_max) r->sat_s = t;
+
+        if (t < push_t)
+        {
+            /* measured from the lean the controller holds, including the wheel desaturation bias */
+            balance_control_get_state(&state);
+            err = roll_deg - equilibrium - state.desat_bias_deg;
+            if (fabs(err) > SIM_SETTLE_BAND_DEG) last_outside = t;
+            /* overshoot: excursion past equilibrium on the far side from the start */
+            if (err * err0 < 0.0 && fabs(err) > r->overshoot_deg) r->overshoot_deg = fabs(err);
+        }
+    }
+
+    r->settled = (!r->fell) && (last_outside < push_t - 0.5);
+    r->settle_s = last_outside;
+}
+
+static void sim_run_gain_set(const bike_plant_param_t *p, const sim_config_t *cfg, const sim_gain_set_t *gs)
+{
+    sim_trial_result_t r;
+    int k, falls = 0, settled = 0, saturated = 0;
+    double settle_sum = 0.0, overshoot_max = 0.0, torque_max = 0.0, wheel_max = 0.0, run_sum = 0.0, sat_sum = 0.0;
+
+    for (k = 0; k < cfg->trials; k++)
+    {
+        sim_run_trial(p, cfg, gs, cfg->seed + (unsigned int)k * 7919u, &r);
+        falls += r.fell;
+        if (r.settled)
+        {
+            settled++;
+            settle_sum += r.settle_s;
+        }
+        if (r.overshoot_deg > overshoot_max) overshoot_max = r.overshoot_deg;
+        if (r.peak_torque > torque_max) torque_max = r.peak_torque;
+        if (r.peak_wheel_rps > wheel_max) wheel_max = r.peak_wheel_rps;
+        run_sum += r.run_s;
+        if (r.sat_s >= 0.0)
+        {
+            saturated++;
+            sat_sum += r.sat_s;
+        }
+    }
+
+    if (gs->lqr_gain_set >= 0) printf("%s,", balance_control_get_lqr_gain_set_name((uint8)gs->lqr_gain_set));
+    else printf("%.3f,%.3f,%.3f,%.3f,%.4f,%.3f,", gs->g[0], gs->g[1], gs->g[2], gs->g[3], gs->g[4], gs->g[5]);
+    if (settled > 0) printf("%.3f,", settle_sum / settled);
+    else printf("nan,");
+    printf("%.3f,%.3f,%.2f,%.3f,%.2f,", overshoot_max, torque_max, wheel_max, (double)falls / cfg->trials,
+           run_sum / cfg->trials);
+    if (saturated > 0) printf("%.2f\n", sat_sum / saturated);
+    else printf("nan\n");
+}
+
+static int sim_parse_gains(const char *text, sim_gain_set_t *gs)
+{
+    gs->lqr_gain_set = -1;
+    return sscanf(text, "%f,%f,%f,%f,%f,%f",
+                  &gs->g[0], &gs->g[1], &gs->g[2], &gs->g[3], &gs->g[4], &gs->g[5]) == 6 ? 0 : -1;
+}
+
+static int sim_load_gain_file(const char *path, sim_gain_set_t *sets, int count)
+{
+    char line[256];
+    FILE *f = fopen(path, "r");
+    if (!f)
+    {
+        fprintf(stderr, "cannot open %s\n", path);
+        return -1;
+    }
+    while (count < SIM_MAX_GAIN_SETS && fgets(line, sizeof(line), f))
+    {
+        if (line[0] == '#' || line[0] == '\n') continue;
+        if (sim_parse_gains(line, &sets[count]) == 0) count++;
+    }
+    fclose(f);
+    return count;
+}
+
+static int sim_default_grid(sim_gain_set_t *sets)
+{
+    static const float akp[] = { 0.5f, 1.0f, 2.0f, 4.0f, 8.0f };
+    static const float vkp[] = { -0.25f, -0.5f, -1.0f, -2.0f, -4.0f };
+    int i, j, n = 0;
+    for (i = 0; i < (int)(sizeof(akp) / sizeof(akp[0])); i++)
+    {
+        for (j = 0; j < (int)(sizeof(vkp) / sizeof(vkp[0])); j++)
+        {
+            memset(&sets[n], 0, sizeof(sets[n]));
+            sets[n].g[0] = akp[i];
+            sets[n].g[3] = vkp[j];
+            sets[n].lqr_gain_set = -1;
+            n++;
+        }
+    }
+    return n;
+}
+
+int main(int argc, char **argv)
+{
+    static sim_gain_set_t sets[SIM_MAX_GAIN_SETS];
+    bike_plant_param_t plant;
+    sim_config_t cfg = { 10.0, 20, 5.0, 0.8, 1u, -1, BALANCE_MODE_PID, -1 };
+    int n_sets = 0;
+    int i;
+    struct timespec w0, w1;
+    double wall_s, sim_s;
+
+    bike_plant_default_param(&plant);
+
+    for (i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) cfg.duration_s = atof(argv[++i]);
+        else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) cfg.trials = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) cfg.roll0_deg = atof(argv[++i]);
+        else if (strcmp(argv[i], "-d") == 0 && i + 1 < argc) cfg.push_nm = atof(argv[++i]);
+        else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) cfg.seed = (unsigned int)atoi(argv[++i]);
+        else if (strcmp(argv[i], "-m") == 0 && i + 1 < argc)
+        {
+            i++;
+            if (strcmp(argv[i], "pid") == 0) cfg.mode = BALANCE_MODE_PID;
+            else if (strcmp(argv[i], "lqr") == 0) cfg.mode = BALANCE_MODE_LQR;
+            else if (strcmp(argv[i], "steer") == 0) cfg.mode = BALANCE_MODE_STEER;
+            else
+            {
+                fprintf(stderr, "bad control mode '%s'\n", argv[i]);
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "-w") == 0 && i + 1 < argc)
+        {
+            i++;
+            if (strcmp(argv[i], "on") == 0) cfg.desat = 1;
+            else if (strcmp(argv[i], "off") == 0) cfg.desat = 0;
+            else
+            {
+                fprintf(stderr, "bad desaturation switch '%s'\n", argv[i]);
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "-a") == 0 && i + 1 < argc)
+        {
+            i++;
+            if (strcmp(argv[i], "yis") == 0) cfg.attitude_mode = ATTITUDE_MODE_YIS;
+            else if (strcmp(argv[i], "cf") == 0) cfg.attitude_mode = ATTITUDE_MODE_COMPLEMENTARY;
+            else if (strcmp(argv[i], "ekf") == 0) cfg.attitude_mode = ATTITUDE_MODE_EKF;
+            else
+            {
+                fprintf(stderr, "bad attitude mode '%s'\n", argv[i]);
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "-p") == 0 && i + 1 < argc)
+        {
+            char name[64];
+            float value;
+            if (sscanf(argv[++i], "%63[^=]=%f", name, &value) != 2 || bike_plant_set_param(&plant, name, value) != 0)
+            {
+                fprintf(stderr, "bad plant parameter '%s'\n", argv[i]);
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "-g") == 0 && i + 1 < argc)
+        {
+            if (n_sets < SIM_MAX_GAIN_SETS && sim_parse_gains(argv[++i], &sets[n_sets]) == 0) n_sets++;
+            else
+            {
+                fprintf(stderr, "bad gain set '%s'\n", argv[i]);
+                return 1;
+            }
+        }
+        else if (argv[i][0] != '-')
+        {
+            n_sets = sim_load_gain_file(argv[i], sets, n_sets);
+            if (n_sets < 0) return 1;
+        }
+        else
+        {
+            fprintf(stderr, "unknown option %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    if (cfg.trials < 1) cfg.trials = 1;
+    if (cfg.mode == BALANCE_MODE_LQR)
+    {
+        for (n_sets = 0; n_sets < (int)balance_control_get_lqr_gain_set_num(); n_sets++)
+        {
+            memset(&sets[n_sets], 0, sizeof(sets[n_sets]));
+            sets[n_sets].lqr_gain_set = n_sets;
+        }
+        printf("lqr_gain_set,settle_s,overshoot_deg,peak_torque_nm,peak_wheel_rps,fall_rate,run_s,sat_s\n");
+    }
+    else
+    {
+        if (n_sets == 0) n_sets = sim_default_grid(sets);
+        printf("akp,aki,akd,vkp,vki,vkd,settle_s,overshoot_deg,peak_torque_nm,peak_wheel_rps,fall_rate,run_s,sat_s\n");
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &w0);
+    for (i = 0; i < n_sets; i++)
+    {
+        sim_run_gain_set(&plant, &cfg, &sets[i]);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &w1);
+
+    wall_s = (double)(w1.tv_sec - w0.tv_sec) + (double)(w1.tv_nsec - w0.tv_nsec) * 1e-9;
+    sim_s = cfg.duration_s * cfg.trials * n_sets;
+    fprintf(stderr, "%d gain sets x %d trials, %.0f s simulated in %.2f s wall (%.0fx real time)\n",
+            n_sets, cfg.trials, sim_s, wall_s, wall_s > 0.0 ? sim_s / wall_s : 0.0);
+    return 0;
+}
@@ -0,0 +1,198 @@
+/* snapshot_check.c - code/system/snapshot.c torn-read check
+ *
+ * Build (from the repository root):
+ *   gcc -O2 -std=c99 -pthread -Itools/sim/host -Icode/system \
+ *       tools/sim/snapshot_check.c code/system/snapshot.c -o snapshot_check
+ *   ./snapshot_check
+ *
+ * Part 1 replays the same-core case step by step: a "higher priority ISR" reads
+ * while the writer is half way through filling the back slot and must get the
+ * previous sample whole. Part 2 runs one writer thread against three reader
+ * threads (the cross-core case). Every sample is 80 bytes like yis_imu_t, all
+ * words carrying the same counter, so a reader that mixed two samples sees
+ * different words. Readers also require the counter never to go backwards.
+ * Exit code 1 on any torn or out-of-order read.
+ */
+#define _POSIX_C_SOURCE 200809L
+#include <pthread.h>
+#include <time.h>
+
+#include "snapshot.h"
+
+#define CHECK_WORDS             (20)
+#define CHECK_READERS           (3)
+#define CHECK_PUBLISHES         (20000000u)
+
+typedef struct
+{
+    uint32 word[CHECK_WORDS];
+} sample_t;
+
+static sample_t slots[2];
+static snapshot_t snap;
+static volatile int writer_done = 0;
+static int failures = 0;
+
+typedef struct
+{
+    uint32 reads;
+    uint32 torn;
+    uint32 backwards;
+} reader_result_t;
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static int sample_is_whole(const sample_t *s)
+{
+    int i;
+
+    for (i = 1; i < CHECK_WORDS; i++)
+    {
+        if (s->word[i] != s->word[0])
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/* ------------------------------------------------------------------ part 1 */
+
+static void check_preempted_writer(void)
+{
+    sample_t out, value;
+    sample_t *back;
+    uint32 n, i, bad = 0;
+
+    snapshot_init(&snap, slots, sizeof(sample_t));
+    if (snapshot_read(&snap, &out))
+    {
+        bad++;                                  /* nothing published yet */
+    }
+
+    for (n = 1; n <= 1000u; n++)
+    {
+        back = snapshot_write_begin(&snap);
+        for (i = 0; i < n % CHECK_WORDS; i++)   /* writer interrupted after i words */
+        {
+            back->word[i] = n;
+        }
+        if (n > 1u && (!snapshot_read(&snap, &out) || !sample_is_whole(&out) || out.word[0] != n - 1u))
+        {
+            bad++;
+        }
+        for (; i < CHECK_WORDS; i++)
+        {
+            back->word[i] = n;
+        }
+        snapshot_write_commit(&snap);
+
+        if (!snapshot_read(&snap, &out) || out.word[0] != n || !sample_is_whole(&out))
+        {
+            bad++;
+        }
+    }
+
+    /* sequence wrap: 0 stays reserved for "never published" */
+    snap.sequence = 0xFFFFFFFFu;
+    for (i = 0; i < CHECK_WORDS; i++)
+    {
+        value.word[i] = 7u;
+    }
+    snapshot_publish(&snap, &value);
+    if (snapshot_sequence(&snap) == 0u || !snapshot_read(&snap, &out) || out.word[0] != 7u)
+    {
+        bad++;
+    }
+
+    printf("preempted writer: 1000 interrupted publishes, %u bad reads -> %s\n", bad, bad ? "FAIL" : "ok");
+    failures += (bad != 0u);
+}
+
+/* ------------------------------------------------------------------ part 2 */
+
+static void *writer(void *arg)
+{
+    sample_t *back;
+    uint32 n;
+    int i;
+
+    (void)arg;
+    for (n = 1; n <= CHECK_PUBLISHES; n++)
+    {
+        back = snapshot_write_begin(&snap);
+        for (i = 0; i < CHECK_WORDS; i++)
+        {
+            back->word[i] = n;
+        }
+        snapshot_write_commit(&snap);
+    }
+    writer_done = 1;
+    return NULL;
+}
+
+static void *reader(void *arg)
+{
+    reader_result_t *r = arg;
+    sample_t out;
+    uint32 last = 0;
+
+    while (!writer_done)
+    {
+        if (!snapshot_read(&snap, &out))
+        {
+            continue;
+        }
+        r->reads++;
+        r->torn += !sample_is_whole(&out);
+        r->backwards += (out.word[0] < last);
+        last = out.word[0];
+    }
+    return NULL;
+}
+
+static void check_threads(void)
+{
+    pthread_t writer_thread, reader_thread[CHECK_READERS];
+    reader_result_t result[CHECK_READERS];
+    uint32 reads = 0, torn = 0, backwards = 0;
+    double t0, t1;
+    int i;
+
+    snapshot_init(&snap, slots, sizeof(sample_t));
+    memset(result, 0, sizeof(result));
+    writer_done = 0;
+
+    t0 = now_s();
+    for (i = 0; i < CHECK_READERS; i++)
+    {
+        pthread_create(&reader_thread[i], NULL, reader, &result[i]);
+    }
+    pthread_create(&writer_thread, NULL, writer, NULL);
+    pthread_join(writer_thread, NULL);
+    for (i = 0; i < CHECK_READERS; i++)
+    {
+        pthread_join(reader_thread[i], NULL);
+        reads += result[i].reads;
+        torn += result[i].torn;
+        backwards += result[i].backwards;
+    }
+    t1 = now_s();
+
+    printf("1 writer / %d readers: %u publishes, %u reads in %.2f s, %u torn, %u out of order -> %s\n",
+           CHECK_READERS, CHECK_PUBLISHES, reads, t1 - t0, torn, backwards,
+           (torn == 0u && backwards == 0u) ? "ok" : "FAIL");
+    failures += (torn != 0u || backwards != 0u);
+}
+
+int main(void)
+{
+    check_preempted_writer();
+    check_threads();
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,157 @@
+/* yis_legacy.c - see yis_legacy.h */
+#include "yis_legacy.h"
+
+typedef enum
+{
+    STATE_IDLE = 0,
+    STATE_HEADER1,
+    STATE_HEADER2,
+    STATE_SKIP_ID1,
+    STATE_SKIP_ID2,
+    STATE_GET_LEN,
+    STATE_DATA,
+    STATE_SKIP_CK1,
+    STATE_SKIP_CK2,
+    STATE_DROP_FRAME
+} yis_parse_state_t;
+
+static yis_imu_t yis_frame;
+static uint8  data_buffer[YIS_MAX_PAYLOAD_LEN];
+static uint8  frame_len = 0;
+static uint8  data_index = 0;
+static yis_parse_state_t parser_state = STATE_IDLE;
+static uint8  drop_remaining = 0;
+static uint8  drop_ck_remaining = 0;
+static yis_sample_callback_t frame_callback = NULL;
+
+static inline int yis_len_is_valid(uint8 len)
+{
+    if (len < YIS_MIN_PAYLOAD_LEN) return 0;
+    if (len > YIS_MAX_PAYLOAD_LEN) return 0;
+    return 1;
+}
+
+static inline float legacy_get(uint8 pos)
+{
+    int32 raw = (int32)((uint32)data_buffer[pos+3] << 24 |
+                        (uint32)data_buffer[pos+2] << 16 |
+                        (uint32)data_buffer[pos+1] << 8  |
+                        (uint32)data_buffer[pos+0]);
+    return raw * 0.000001f;
+}
+
+static void yis_parse_frame(void)
+{
+    uint8 pos = 0;
+
+    while (pos < frame_len)
+    {
+        if ((uint8)(frame_len - pos) < 2u) break;
+
+        uint8 data_id = data_buffer[pos++];
+        uint8 sub_len = data_buffer[pos++];
+
+        if ((uint8)(frame_len - pos) < sub_len) break;
+
+        if (data_id == 0x10 && sub_len >= 12u)
+        {
+            yis_frame.ax = legacy_get(pos);
+            yis_frame.ay = legacy_get(pos + 4);
+            yis_frame.az = legacy_get(pos + 8);
+            pos += sub_len;
+        }
+        else if (data_id == 0x20 && sub_len >= 12u)
+        {
+            yis_frame.wx = legacy_get(pos);
+            yis_frame.wy = legacy_get(pos + 4);
+            yis_frame.wz = legacy_get(pos + 8);
+            pos += sub_len;
+        }
+        else if (data_id == 0x40 && sub_len >= 12u)
+        {
+            yis_frame.pitch = legacy_get(pos);
+            yis_frame.roll = legacy_get(pos + 4);
+            yis_frame.yaw = legacy_get(pos + 8);
+            pos += sub_len;
+        }
+        else
+        {
+            pos += sub_len;
+        }
+    }
+}
+
+void legacy_yis_init(yis_sample_callback_t callback)
+{
+    memset(&yis_frame, 0, sizeof(yis_frame));
+    frame_callback = callback;
+    parser_state = STATE_IDLE;
+    frame_len = 0;
+    data_index = 0;
+    drop_remaining = 0;
+    drop_ck_remaining = 0;
+}
+
+void legacy_yis_parse_byte(uint8 data)
+{
+    switch (parser_state)
+    {
+        case STATE_IDLE:
+            if (data == YIS_HEADER_1) parser_state = STATE_HEADER1;
+            break;
+
+        case STATE_HEADER1:
+            parser_state = (data == YIS_HEADER_2) ? STATE_HEADER2 : STATE_IDLE;
+            break;
+
+        case STATE_HEADER2:
+            parser_state = STATE_SKIP_ID1;
+            break;
+
+        case STATE_SKIP_ID1:
+            parser_state = STATE_SKIP_ID2;
+            break;
+
+        case STATE_SKIP_ID2:
+            frame_len  = data;
+            data_index = 0;
+            if (!yis_len_is_valid(frame_len))
+            {
+                drop_remaining    = frame_len;
+                drop_ck_remaining = 2u;
+                parser_state      = STATE_DROP_FRAME;
+                break;
+            }
+            parser_state = (frame_len > 0u) ? STATE_DATA : STATE_SKIP_CK1;
+            break;
+
+        case STATE_DATA:
+            data_buffer[data_index++] = data;
+            if (data_index >= frame_len)
+                parser_state = STATE_SKIP_CK1;
+            break;
+
+        case STATE_SKIP_CK1:
+            parser_state = STATE_SKIP_CK2;
+            break;
+
+        case STATE_SKIP_CK2:
+            yis_parse_frame();
+            parser_state = STATE_IDLE;
+            if (frame_callback != NULL) frame_callback(&yis_frame);
+            break;
+
+        case STATE_DROP_FRAME:
+            if (drop_remaining > 0u)
+                drop_remaining--;
+            else if (drop_ck_remaining > 0u)
+                drop_ck_remaining--;
+            else
+                parser_state = STATE_IDLE;
+            break;
+
+        default:
+            parser_state = STATE_IDLE;
+            break;
+    }
+}
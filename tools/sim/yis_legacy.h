@@ -0,0 +1,16 @@
+/* yis_legacy.h - the byte-at-a-time YIS parser before the DMA frame parser
+ *
+ * Same state machine and payload decoding as the old code/drivers/driver_imu.c
+ * (one call per received byte from the UART5 RX interrupt), with the UART and the
+ * mailbox replaced by a callback so yis_parse_bench.c can time it next to
+ * code/drivers/yis_parser.c. Host only.
+ */
+#ifndef _yis_legacy_h_
+#define _yis_legacy_h_
+
+#include "yis_parser.h"
+
+void legacy_yis_init        (yis_sample_callback_t callback);
+void legacy_yis_parse_byte  (uint8 data);
+
+#endif
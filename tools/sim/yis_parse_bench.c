@@ -0,0 +1,575 @@
+/* yis_parse_bench.c - code/drivers/yis_parser.c throughput and equivalence check
+ *
+ * Build (from the repository root):
+ *   gcc -O2 -std=c99 -Itools/sim/host -Itools/sim -Icode/drivers \
+ *       tools/sim/yis_parse_bench.c tools/sim/yis_legacy.c code/drivers/yis_parser.c \
+ *       -o yis_parse_bench
+ *   ./yis_parse_bench                  # synthetic streams
+ *   ./yis_parse_bench capture.bin      # raw UART5 bytes recorded from the module
+ *
+ * Runs every stream through the old byte-at-a-time state machine (yis_legacy.c,
+ * one call per byte = one UART RX interrupt per byte) and through yis_parser
+ * fed the way the DMA feeds it on the target: a 512 byte ring, each "transfer"
+ * writes exactly the byte count the previous yis_parser_process() asked for and
+ * then calls it again (one call = one DMA interrupt). A third run feeds fixed
+ * 256 byte blocks (half-buffer events). Prints ns per byte, ns per frame and calls
+ * per frame, and requires the decoded sample sequences to be identical on clean
+ * streams.
+ *
+ * The noisy synthetic stream also carries cut frames and frames with a flipped
+ * bit. There the bulk parser must deliver exactly the intact frames, count every
+ * damaged one as dropped, and stamp each sample with its header byte's arrival
+ * time (byte i of the stream arrives at i * BENCH_BYTE_TICKS). Finally
+ * yis_checksum() is timed against a byte-at-a-time Fletcher loop, and
+ * yis_decode_payload() is checked value by value on payloads carrying every data
+ * ID and timed against the old per-ID switch decoder.
+ * Exit code 1 on any mismatch.
+ */
+#define _POSIX_C_SOURCE 200809L
+#include <time.h>
+
+#include "yis_parser.h"
+#include "yis_legacy.h"
+
+#define BENCH_RING_SIZE         (512u)
+#define BENCH_BLOCK             (256u)
+#define BENCH_FRAMES            (200000u)
+#define BENCH_MAX_SAMPLES       (2u * BENCH_FRAMES)
+#define BENCH_BYTE_TICKS        (868u)      /* 10 bits at 115200 Bd in 10 ns ticks */
+
+typedef struct
+{
+    const char *name;
+    const uint8 *data;
+    uint32 length;
+    int clean;                                  /* legacy and bulk must agree sample for sample */
+    const uint32 *header_at;                    /* stream offset of every intact frame, in order */
+    uint32 intact;
+    uint32 damaged;                             /* frames cut short or corrupted */
+} stream_t;
+
+static yis_imu_t *samples[2];
+static uint32 sample_count[2];
+static uint32 sample_slot;
+static int failures = 0;
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void collect(const yis_imu_t *sample)
+{
+    if (sample_count[sample_slot] < BENCH_MAX_SAMPLES)
+    {
+        samples[sample_slot][sample_count[sample_slot]++] = *sample;
+    }
+}
+
+/* ------------------------------------------------------------------ streams */
+
+static uint32 rng_state = 1;
+
+static uint32 rng(void)
+{
+    rng_state = rng_state * 1103515245u + 12345u;
+    return rng_state >> 8;
+}
+
+static uint8 *put_field(uint8 *p, uint8 id, int32 a, int32 b, int32 c)
+{
+    int32 v[3] = { a, b, c };
+    int i;
+
+    *p++ = id;
+    *p++ = 12;
+    for (i = 0; i < 3; i++)
+    {
+        *p++ = (uint8)v[i];
+        *p++ = (uint8)(v[i] >> 8);
+        *p++ = (uint8)(v[i] >> 16);
+        *p++ = (uint8)(v[i] >> 24);
+    }
+    return p;
+}
+
+/* reference: the plain definition, one byte at a time */
+static uint16 checksum_reference(const uint8 *data, uint32 length)
+{
+    uint8 ck1 = 0, ck2 = 0;
+
+    while (length--)
+    {
+        ck1 = (uint8)(ck1 + *data++);
+        ck2 = (uint8)(ck2 + ck1);
+    }
+    return (uint16)(ck1 | (ck2 << 8));
+}
+
+/* 0x10 acc + 0x20 gyro + 0x40 euler, 49 bytes per frame like the module's default output */
+static uint32 make_stream(stream_t *s, uint8 *out, uint32 *header_at, uint32 frames, int dirty)
+{
+    uint8 *p = out;
+    uint32 n;
+
+    s->intact = 0;
+    s->damaged = 0;
+    for (n = 0; n < frames; n++)
+    {
+        uint8 *frame, *len;
+        uint16 ck;
+
+        if (dirty && rng() % 100 == 0)
+        {
+            uint32 junk = 1 + rng() % 8;        /* line noise between frames */
+            while (junk--)
+            {
+                uint8 b = (uint8)rng();
+                *p++ = (b == YIS_HEADER_1) ? 0 : b;
+            }
+        }
+
+        frame = p;
+        *p++ = YIS_HEADER_1;
+        *p++ = YIS_HEADER_2;
+        *p++ = (uint8)n;
+        *p++ = (uint8)(n >> 8);
+        len = p++;
+        p = put_field(p, 0x10, (int32)(rng() % 2000000) - 1000000, (int32)(rng() % 2000000) - 1000000, 9810000);
+        p = put_field(p, 0x20, (int32)(rng() % 400000000) - 200000000, (int32)(rng() % 2000000) - 1000000, 0);
+        p = put_field(p, 0x40, (int32)(rng() % 20000000) - 10000000, (int32)(rng() % 70000000) - 35000000, 1000);
+        *len = (uint8)(p - len - 1);
+        ck = checksum_reference(frame + 2, (uint32)(p - frame - 2));
+        *p++ = (uint8)ck;
+        *p++ = (uint8)(ck >> 8);
+
+        if (dirty && rng() % 1000 == 0)
+        {
+            p = frame + 5 + rng() % 40;         /* frame cut short, next header follows */
+            s->damaged++;
+        }
+        else if (dirty && rng() % 500 == 0)
+        {
+            frame[5 + rng() % (*len + 2u)] ^= (uint8)(1u << (rng() % 8));     /* bit error past LEN */
+            s->damaged++;
+        }
+        else
+        {
+            header_at[s->intact++] = (uint32)(frame - out);
+        }
+    }
+    return (uint32)(p - out);
+}
+
+/* ------------------------------------------------------------------ runs */
+
+static double run_legacy(const stream_t *s)
+{
+    double t0, t1;
+    uint32 i;
+
+    legacy_yis_init(collect);
+    t0 = now_s();
+    for (i = 0; i < s->length; i++)
+    {
+        legacy_yis_parse_byte(s->data[i]);
+    }
+    t1 = now_s();
+    return t1 - t0;
+}
+
+/* DMA model: ring + transfer of exactly the requested size; returns calls */
+static double run_bulk(const stream_t *s, uint32 block, uint32 *calls, yis_parser_t *parser_out)
+{
+    static uint8 ring[BENCH_RING_SIZE];
+    yis_parser_t parser;
+    uint32 written = 0, needed = YIS_FRAME_HEAD_SIZE;
+    double t0, t1;
+
+    yis_parser_init(&parser, ring, BENCH_RING_SIZE);
+    yis_parser_set_byte_time(&parser, BENCH_BYTE_TICKS);
+    *calls = 0;
+    t0 = now_s();
+    while (written < s->length)
+    {
+        uint32 count = (block != 0u) ? block : needed;
+        uint32 offset = written & (BENCH_RING_SIZE - 1u);
+        uint32 first;
+
+        if (count > s->length - written)
+        {
+            count = s->length - written;
+        }
+        first = BENCH_RING_SIZE - offset;
+        if (first > count)
+        {
+            first = count;
+        }
+        memcpy(&ring[offset], &s->data[written], first);
+        memcpy(ring, &s->data[written + first], count - first);
+        written += count;
+
+        needed = yis_parser_process(&parser, written, (written - 1u) * BENCH_BYTE_TICKS, collect);
+        if (needed > BENCH_RING_SIZE / 2u)
+        {
+            needed = BENCH_RING_SIZE / 2u;
+        }
+        (*calls)++;
+    }
+    t1 = now_s();
+    *parser_out = parser;
+    return t1 - t0;
+}
+
+/* the module's measurement fields; tid and timestamp only exist on the bulk side */
+static int same_measurement(const yis_imu_t *a, const yis_imu_t *b)
+{
+    return a->pitch == b->pitch && a->roll == b->roll && a->yaw == b->yaw &&
+           a->wx == b->wx && a->wy == b->wy && a->wz == b->wz &&
+           a->ax == b->ax && a->ay == b->ay && a->az == b->az;
+}
+
+/* bulk side against what the generator knows: intact frames only, damaged ones dropped, exact timestamps */
+static void check_integrity(const stream_t *s, const yis_parser_t *parser, const char *what)
+{
+    uint32 late = 0, i;
+
+    if (s->header_at == NULL)
+    {
+        printf("  %-18s %u frames, %u bad checksum, %u dropped\n", what, parser->frames,
+               parser->bad_checksum, parser->dropped);
+        return;
+    }
+    for (i = 0; i < sample_count[1] && i < s->intact; i++)
+    {
+        late += (samples[1][i].timestamp != s->header_at[i] * BENCH_BYTE_TICKS);
+    }
+    printf("  %-18s %u / %u intact frames, %u bad checksum, %u / %u dropped, %u timestamps off -> %s\n",
+           what, sample_count[1], s->intact, parser->bad_checksum, parser->dropped, s->damaged, late,
+           (sample_count[1] == s->intact && parser->dropped == s->damaged && late == 0) ? "ok" : "MISMATCH");
+    failures += (sample_count[1] != s->intact || parser->dropped != s->damaged || late != 0);
+}
+
+static void compare(const stream_t *s, const char *what)
+{
+    uint32 n = sample_count[0] < sample_count[1] ? sample_count[0] : sample_count[1];
+    uint32 diff = 0, i;
+
+    for (i = 0; i < n; i++)
+    {
+        if (!same_measurement(&samples[0][i], &samples[1][i]))
+        {
+            diff++;
+        }
+    }
+    if (s->clean)
+    {
+        printf("  %-18s %u / %u samples, %u differ -> %s\n", what, sample_count[0], sample_count[1], diff,
+               (diff == 0 && sample_count[0] == sample_count[1]) ? "identical" : "MISMATCH");
+        failures += (diff != 0 || sample_count[0] != sample_count[1]);
+    }
+    else
+    {
+        printf("  %-18s legacy %u samples (damaged frames included), bulk %u samples\n", what,
+               sample_count[0], sample_count[1]);
+    }
+}
+
+static void bench(const stream_t *s)
+{
+    double best_legacy = 1e9, best_dma = 1e9, best_block = 1e9;
+    uint32 dma_calls = 0, block_calls = 0, frames;
+    yis_parser_t parser;
+    int repeat;
+
+    printf("%s: %u bytes\n", s->name, s->length);
+    for (repeat = 0; repeat < 5; repeat++)      /* best of 5, host timing is noisy */
+    {
+        double t;
+
+        sample_slot = 0;
+        sample_count[0] = 0;
+        t = run_legacy(s);
+        best_legacy = t < best_legacy ? t : best_legacy;
+
+        sample_slot = 1;
+        sample_count[1] = 0;
+        t = run_bulk(s, 0, &dma_calls, &parser);
+        best_dma = t < best_dma ? t : best_dma;
+        if (repeat == 0)
+        {
+            compare(s, "per-frame DMA");
+            check_integrity(s, &parser, "");
+        }
+
+        sample_count[1] = 0;
+        t = run_bulk(s, BENCH_BLOCK, &block_calls, &parser);
+        best_block = t < best_block ? t : best_block;
+        if (repeat == 0)
+        {
+            compare(s, "256 B blocks");
+            check_integrity(s, &parser, "");
+        }
+    }
+
+    frames = sample_count[0] != 0u ? sample_count[0] : 1u;
+    printf("  %-18s %8s %10s %12s\n", "", "ns/byte", "ns/frame", "calls/frame");
+    printf("  %-18s %8.2f %10.1f %12.2f\n", "legacy per byte",
+           best_legacy * 1e9 / s->length, best_legacy * 1e9 / frames, (double)s->length / frames);
+    printf("  %-18s %8.2f %10.1f %12.2f\n", "bulk per frame",
+           best_dma * 1e9 / s->length, best_dma * 1e9 / frames, (double)dma_calls / frames);
+    printf("  %-18s %8.2f %10.1f %12.2f\n\n", "bulk 256 B",
+           best_block * 1e9 / s->length, best_block * 1e9 / frames, (double)block_calls / frames);
+}
+
+/* fixed 44 byte TID + LEN + payload runs out of the clean stream */
+static void bench_checksum(const stream_t *s)
+{
+    const uint32 frames = 1000000u, span = 44u;
+    volatile uint16 sink = 0;
+    double t0, t_ref, t_fast;
+    uint32 i, mismatch = 0;
+
+    for (i = 0; i < 1000u; i++)
+    {
+        const uint8 *p = &s->data[(i * 977u) % (s->length - 128u)];
+        uint32 len = 1u + i % 128u;
+        mismatch += (yis_checksum(p, len) != checksum_reference(p, len));
+    }
+
+    t0 = now_s();
+    for (i = 0; i < frames; i++)
+    {
+        sink ^= checksum_reference(&s->data[(i * 49u) % (s->length - span)], span);
+    }
+    t_ref = now_s() - t0;
+    t0 = now_s();
+    for (i = 0; i < frames; i++)
+    {
+        sink ^= yis_checksum(&s->data[(i * 49u) % (s->length - span)], span);
+    }
+    t_fast = now_s() - t0;
+
+    printf("checksum over %u bytes: byte loop %.1f ns, yis_checksum %.1f ns, %u / 1000 lengths differ -> %s\n",
+           span, t_ref * 1e9 / frames, t_fast * 1e9 / frames, mismatch, mismatch == 0u ? "ok" : "MISMATCH");
+    failures += (mismatch != 0u);
+    (void)sink;
+}
+
+/* ------------------------------------------------------------------ decode */
+
+static uint8 *put_raw(uint8 *p, uint8 id, const int32 *v, uint32 count, uint32 width)
+{
+    uint32 i, k;
+
+    *p++ = id;
+    *p++ = (uint8)(count * width);
+    for (i = 0; i < count; i++)
+    {
+        for (k = 0; k < width; k++)
+        {
+            *p++ = (uint8)((uint32)v[i] >> (8u * k));
+        }
+    }
+    return p;
+}
+
+/* the pre-table decoder: one hand-written case per ID, acceleration, gyro and euler only */
+static inline float switch_get(const uint8 *p)
+{
+    int32 raw = (int32)((uint32)p[3] << 24 | (uint32)p[2] << 16 | (uint32)p[1] << 8 | (uint32)p[0]);
+    return (float)raw * 0.000001f;
+}
+
+static void switch_decode(const uint8 *payload, uint32 length, yis_imu_t *sample)
+{
+    uint32 pos = 0;
+
+    while (length - pos >= 2u)
+    {
+        uint8 data_id = payload[pos];
+        uint8 sub_len = payload[pos + 1u];
+        const uint8 *data = &payload[pos + 2u];
+
+        pos += 2u;
+        if (length - pos < sub_len)
+        {
+            break;
+        }
+        pos += sub_len;
+        if (sub_len < 12u)
+        {
+            continue;
+        }
+        switch (data_id)
+        {
+            case 0x10: sample->ax = switch_get(data); sample->ay = switch_get(data + 4); sample->az = switch_get(data + 8); break;
+            case 0x20: sample->wx = switch_get(data); sample->wy = switch_get(data + 4); sample->wz = switch_get(data + 8); break;
+            case 0x40: sample->pitch = switch_get(data); sample->roll = switch_get(data + 4); sample->yaw = switch_get(data + 8); break;
+            default: break;
+        }
+    }
+}
+
+typedef void (*decode_fn)(const uint8 *payload, uint32 length, yis_imu_t *sample);
+
+static double time_decode(decode_fn decode, const uint8 *payloads, uint32 stride, const uint8 *lengths, uint32 count)
+{
+    const uint32 rounds = 20u;
+    yis_imu_t sample;
+    double t0, best = 1e9;
+    uint32 r, i;
+    int repeat;
+
+    memset(&sample, 0, sizeof(sample));
+    for (repeat = 0; repeat < 5; repeat++)
+    {
+        t0 = now_s();
+        for (r = 0; r < rounds; r++)
+        {
+            for (i = 0; i < count; i++)
+            {
+                decode(&payloads[i * stride], lengths[i], &sample);
+            }
+        }
+        t0 = now_s() - t0;
+        best = t0 < best ? t0 : best;
+    }
+    if (sample.roll == 12345.0f)                /* keep the stores */
+    {
+        printf(" ");
+    }
+    return best * 1e9 / ((double)rounds * count);
+}
+
+/* every decoded ID against the generated integers; default payloads against the switch decoder */
+static void bench_decode(void)
+{
+    const uint32 count = 10000u, stride = YIS_MAX_PAYLOAD_LEN;
+    uint8 *plain = malloc(count * stride), *full = malloc(count * stride);
+    uint8 plain_len[10000], full_len[10000];
+    uint32 i, k, bad = 0;
+
+    if (plain == NULL || full == NULL)
+    {
+        failures++;
+        return;
+    }
+
+    for (i = 0; i < count; i++)
+    {
+        int32 acc[3], gyr[3], eul[3], mag[3], quat[4], temp, stamp;
+        yis_imu_t a, b;
+        uint8 *p;
+
+        for (k = 0; k < 3; k++)
+        {
+            acc[k] = (int32)(rng() % 40000000) - 20000000;
+            gyr[k] = (int32)(rng() % 400000000) - 200000000;
+            eul[k] = (int32)(rng() % 360000000) - 180000000;
+            mag[k] = (int32)(rng() % 2000000) - 1000000;
+        }
+        for (k = 0; k < 4; k++)
+        {
+            quat[k] = (int32)(rng() % 2000001) - 1000000;
+        }
+        temp = (int32)(rng() % 12000) - 4000;   /* -40 .. 80 degC */
+        stamp = (int32)(rng() << 8);
+
+        p = put_raw(&plain[i * stride], 0x10, acc, 3, 4);
+        p = put_raw(p, 0x20, gyr, 3, 4);
+        p = put_raw(p, 0x40, eul, 3, 4);
+        plain_len[i] = (uint8)(p - &plain[i * stride]);
+
+        p = put_raw(&full[i * stride], 0x01, &temp, 1, 2);
+        p = put_raw(p, 0x10, acc, 3, 4);
+        p = put_raw(p, 0x20, gyr, 3, 4);
+        p = put_raw(p, 0x31, mag, 3, 4);
+        p = put_raw(p, 0x40, eul, 3, 4);
+        p = put_raw(p, 0x41, quat, 4, 4);
+        p = put_raw(p, 0x51, &stamp, 1, 4);
+        full_len[i] = (uint8)(p - &full[i * stride]);
+
+        memset(&a, 0, sizeof(a));
+        memset(&b, 0, sizeof(b));
+        yis_decode_payload(&plain[i * stride], plain_len[i], &a);
+        switch_decode(&plain[i * stride], plain_len[i], &b);
+        bad += !same_measurement(&a, &b) || a.fields != (YIS_FIELD_ACC | YIS_FIELD_GYRO | YIS_FIELD_EULER);
+
+        yis_decode_payload(&full[i * stride], full_len[i], &a);
+        bad += a.fields != 0x7Fu || a.temperature != (float)temp * 0.01f || a.sample_time_us != (uint32)stamp ||
+               a.ax != (float)acc[0] * 0.000001f || a.wz != (float)gyr[2] * 0.000001f ||
+               a.mx != (float)mag[0] * 0.001f || a.mz != (float)mag[2] * 0.001f || a.roll != (float)eul[1] * 0.000001f ||
+               a.q0 != (float)quat[0] * 0.000001f || a.q3 != (float)quat[3] * 0.000001f;
+    }
+
+    printf("decode: %u payloads, %u wrong -> %s\n", count, bad, bad == 0u ? "ok" : "MISMATCH");
+    printf("  %-34s %8s\n", "", "ns/frame");
+    printf("  %-34s %8.1f\n", "switch, acc + gyro + euler (42 B)",
+           time_decode(switch_decode, plain, stride, plain_len, count));
+    printf("  %-34s %8.1f\n", "table, acc + gyro + euler (42 B)",
+           time_decode(yis_decode_payload, plain, stride, plain_len, count));
+    printf("  %-34s %8.1f\n", "table, all 7 IDs (92 B)",
+           time_decode(yis_decode_payload, full, stride, full_len, count));
+    failures += (bad != 0u);
+    free(plain);
+    free(full);
+}
+
+int main(int argc, char **argv)
+{
+    uint32 capacity = BENCH_FRAMES * 80u;
+    uint8 *clean = malloc(capacity), *dirty = malloc(capacity);
+    uint32 *header_at = malloc(BENCH_FRAMES * sizeof(uint32));
+    stream_t s;
+    int i;
+
+    samples[0] = malloc(BENCH_MAX_SAMPLES * sizeof(yis_imu_t));
+    samples[1] = malloc(BENCH_MAX_SAMPLES * sizeof(yis_imu_t));
+    if (clean == NULL || dirty == NULL || header_at == NULL || samples[0] == NULL || samples[1] == NULL)
+    {
+        return 2;
+    }
+
+    if (argc > 1)
+    {
+        for (i = 1; i < argc; i++)
+        {
+            FILE *f = fopen(argv[i], "rb");
+            if (f == NULL)
+            {
+                fprintf(stderr, "cannot open %s\n", argv[i]);
+                return 2;
+            }
+            s.name = argv[i];
+            s.data = clean;
+            s.length = (uint32)fread(clean, 1, capacity, f);
+            s.clean = 1;
+            s.header_at = NULL;
+            fclose(f);
+            bench(&s);
+        }
+    }
+    else
+    {
+        s.name = "synthetic clean";
+        s.data = clean;
+        s.header_at = header_at;
+        s.length = make_stream(&s, clean, header_at, BENCH_FRAMES, 0);
+        s.clean = 1;
+        bench(&s);
+        bench_checksum(&s);
+        bench_decode();
+        printf("\n");
+
+        s.name = "synthetic with noise, cut and corrupted frames";
+        s.data = dirty;
+        s.length = make_stream(&s, dirty, header_at, BENCH_FRAMES, 1);
+        s.clean = 0;
+        bench(&s);
+    }
+
+    return failures ? 1 : 0;
+}
@@ -33,25 +33,51 @@
 * 2022-11-04       pudding            first version
 ********************************************************************************************************************/
 #include "zf_common_headfile.h"
-#include "driver_imu.h"
+#include "driver_imu_fusion.h"
+#include "driver_mag.h"
 #include "driver_servo.h"
 #include "driver_motor.h"
 #include "driver_odrive.h"
 #include "zf_device_key.h"        // 使用库的按键驱动
 #include "balance_control.h"
 #include "ui_control.h"
+#include "profiler.h"
+#include "multicore.h"
+#include "flight_recorder.h"
+#include "IfxCcu6.h"
+#include "IfxSrc.h"
 
-// ========== 全局变量 ==========
-uint8 system_enable = 0;     // 系统使能标志（0=停止，1=运行）
-uint8 param_index = 0;       // 当前调节的参数索引（0~5）
-static const char* param_names[] = {
-    "Angle Kp",      // 0: 角度环比例
-    "Angle Ki",      // 1: 角度环积分
-    "Angle Kd",      // 2: 角度环微分
-    "Velocity Kp",   // 3: 速度环比例
-    "Velocity Ki",   // 4: 速度环积分
-    "Velocity Kd"    // 5: 速度环微分
-};
+// ========== 控制使能（CPU1 按键 K1 经核间邮箱发来） ==========
+// 关闭时 balance_control_set_enable() 会发送 ODrive 停止命令，CAN 发送只在 CPU0 上进行
+static void control_enable_handler(const void *data, uint32 length)
+{
+    uint8 enable = (length >= 1u) ? *(const uint8 *)data : 0u;
+
+    balance_control_set_enable(enable);
+    if (enable) {
+        gpio_high(P20_9);  // LED点亮表示运行
+    } else {
+        gpio_low(P20_9);   // LED熄灭表示停止
+    }
+}
+
+// ========== 控制模式（CPU1 调试串口 'b' 经核间邮箱发来） ==========
+// 与 5ms 中断同在 CPU0、互不嵌套，切换发生在两拍之间
+static void control_mode_handler(const void *data, uint32 length)
+{
+    const uint8 *mode = (const uint8 *)data;
+
+    if (length >= 1u) {
+        balance_control_set_mode((balance_mode_enum)mode[0]);
+    }
+}
+
+// ========== 控制节拍触发（BALANCE_SCHEDULE_IMU_FRAME） ==========
+// IMU 帧处理中调用：置位 CCU60 通道0 的服务请求，控制一拍仍在 5ms 中断里执行，不会与看门狗节拍重入
+static void control_step_trigger(void)
+{
+    IfxSrc_setRequest(IfxCcu6_getSrcAddress(&MODULE_CCU60, IfxCcu6_ServiceRequest_1));
+}
 
 
 #pragma section all "cpu0_dsram"
@@ -67,24 +93,33 @@ int core0_main(void)
 {
     clock_init();                   // ��ȡʱ��Ƶ��<��ر���>
     debug_init();                   // ��ʼ��Ĭ�ϵ��Դ���
+    profiler_init();                // 执行时间统计（需在各驱动和中断之前初始化）
+    multicore_init();               // 核间邮箱（需在中断路由到其他CPU的驱动之前初始化）
+    flight_recorder_init();         // 控制状态黑匣子（LMU 环形缓冲，需在 5ms 中断启动之前初始化）
+    multicore_set_handler(MULTICORE_MSG_CONTROL_ENABLE, control_enable_handler);
+    multicore_set_handler(MULTICORE_MSG_CONTROL_MODE, control_mode_handler);
     
     // 硬件驱动初始化
     gpio_init(P20_9, GPO, GPIO_LOW, GPO_PUSH_PULL);  // LED指示灯初始化
     servo_init(90.0f);              // 初始化舵机（中心位置）
     motor_init();                   // 初始化电机（停止状态）
     odrive_init();                  // 初始化ODrive动量轮
+    seekfree_assistant_interface_init(SEEKFREE_ASSISTANT_DEBUG_UART);  // 逐飞助手走调试串口
     key_init(10);                   // 初始化按键（10ms扫描周期）
     
     // 传感器和控制初始化
     yis_init();                     // 初始化IMU
+    imu_init();                     // 初始化板载IMU与融合（需在 yis_init 之后）
+    mag_init();                     // 磁力计标定加载与航向（需在 imu_init 之后）
     balance_control_init();         // 初始化平衡控制
+    balance_control_set_step_trigger(control_step_trigger);
     
     // 人机交互初始化
     ui_control_init();              // 初始化屏幕显示
     ui_control_show_splash();       // 显示启动画面
     
     // 定时器初始化
-    pit_ms_init(CCU60_CH0, 5);      // 5ms - IMU + balance control update
+    pit_ms_init(CCU60_CH0, 5);      // 5ms - balance control update（帧调度时为看门狗）
     // �˴���д�û����� ���������ʼ�������
 
 
@@ -95,89 +130,8 @@ int core0_main(void)
     printf("System initialized successfully!\r\n");
     printf("Servo and Motor drivers ready.\r\n");
     
-    uint32 last_speed_request = 0;  // 上次轮速请求时间
-    
-    while (TRUE)
-    {
-        // 高频轮询ODrive串口数据（每个循环都调用，非阻塞）
-        odrive_poll();
-        
-        // 低频发送轮速查询请求（每50ms发一次，20Hz）
-        uint32 current_time = system_getval_ms();
-        if (current_time - last_speed_request >= 50) {
-            last_speed_request = current_time;
-            odrive_request_speed();  // 仅发送命令，不阻塞
-        }
-        
-        // 按键扫描（库会自动根据period处理时序）
-        key_scanner();
-        
-        // 按键事件处理
-        if (key_get_state(KEY_1) == KEY_SHORT_PRESS) {
-            // K1: 启动/停止系统
-            key_clear_state(KEY_1);  // 清除按键状态
-            system_enable = !system_enable;
-            balance_control_set_enable(system_enable);  // 设置控制使能
-            if (system_enable) {
-                printf("System ENABLED\r\n");
-                gpio_high(P20_9);  // LED点亮表示运行
-            } else {
-                printf("System STOPPED\r\n");
-                gpio_low(P20_9);   // LED熄灭表示停止
-            }
-        }
-        
-        if (key_get_state(KEY_2) == KEY_SHORT_PRESS) {
-            // K2: 切换调节参数
-            key_clear_state(KEY_2);
-            param_index = (param_index + 1) % 6;  // 现在有6个参数
-            float angle_kp, angle_ki, angle_kd, vel_kp, vel_ki, vel_kd;
-            balance_control_get_pid_params_full(&angle_kp, &angle_ki, &angle_kd, &vel_kp, &vel_ki, &vel_kd);
-            printf("\r\n=== Select: %s ===\r\n", param_names[param_index]);
-            printf("Angle: Kp=%.3f Ki=%.3f Kd=%.3f\r\n", angle_kp, angle_ki, angle_kd);
-            printf("Vel:   Kp=%.3f Ki=%.4f Kd=%.3f\r\n", vel_kp, vel_ki, vel_kd);
-        }
-        
-        if (key_get_state(KEY_3) == KEY_SHORT_PRESS) {
-            // K3: 增大当前参数
-            key_clear_state(KEY_3);
-            
-            switch (param_index) {
-                case 0: balance_control_adjust_angle_kp(0.1f); break;      // 角度Kp 步长0.1
-                case 1: balance_control_adjust_angle_ki(0.05f); break;     // 角度Ki 步长0.05
-                case 2: balance_control_adjust_angle_kd(0.01f); break;     // 角度Kd 步长0.01
-                case 3: balance_control_adjust_velocity_kp(-0.1f); break;  // 速度Kp 步长0.1（负数，减负=增大绝对值）
-                case 4: balance_control_adjust_velocity_ki(0.001f); break; // 速度Ki 步长0.001
-                case 5: balance_control_adjust_velocity_kd(0.01f); break;  // 速度Kd 步长0.01
-            }
-            
-            float angle_kp, angle_ki, angle_kd, vel_kp, vel_ki, vel_kd;
-            balance_control_get_pid_params_full(&angle_kp, &angle_ki, &angle_kd, &vel_kp, &vel_ki, &vel_kd);
-            printf("+ %s -> A[%.2f,%.2f,%.2f] V[%.2f,%.3f,%.2f]\r\n", 
-                   param_names[param_index], angle_kp, angle_ki, angle_kd, vel_kp, vel_ki, vel_kd);
-        }
-        
-        if (key_get_state(KEY_4) == KEY_SHORT_PRESS) {
-            // K4: 减小当前参数
-            key_clear_state(KEY_4);
-            
-            switch (param_index) {
-                case 0: balance_control_adjust_angle_kp(-0.1f); break;     // 角度Kp 步长0.1
-                case 1: balance_control_adjust_angle_ki(-0.05f); break;    // 角度Ki 步长0.05
-                case 2: balance_control_adjust_angle_kd(-0.01f); break;    // 角度Kd 步长0.01
-                case 3: balance_control_adjust_velocity_kp(0.1f); break;   // 速度Kp 步长0.1（负数，加正=减小绝对值）
-                case 4: balance_control_adjust_velocity_ki(-0.001f); break;// 速度Ki 步长0.001
-                case 5: balance_control_adjust_velocity_kd(-0.01f); break; // 速度Kd 步长0.01
-            }
-            
-            float angle_kp, angle_ki, angle_kd, vel_kp, vel_ki, vel_kd;
-            balance_control_get_pid_params_full(&angle_kp, &angle_ki, &angle_kd, &vel_kp, &vel_ki, &vel_kd);
-            printf("- %s -> A[%.2f,%.2f,%.2f] V[%.2f,%.3f,%.2f]\r\n", 
-                   param_names[param_index], angle_kp, angle_ki, angle_kd, vel_kp, vel_ki, vel_kd);
-        }
-        
-        system_delay_ms(10);  // 10ms扫描周期
-    }
+    // ODrive轮询/轮速请求、按键与屏幕、调试输出按 multicore.c 中的任务表分配到各CPU
+    multicore_run();
 }
 #pragma section all restore
 // **************************** �������� ****************************
@@ -34,9 +34,288 @@
 ********************************************************************************************************************/
 
 #include "zf_common_headfile.h"
+#include "driver_odrive.h"
+#include "driver_imu_fusion.h"
+#include "zf_device_key.h"        // ʹÿİ
+#include "balance_control.h"
+#include "ui_control.h"
+#include "profiler.h"
+#include "multicore.h"
+#include "flight_recorder.h"
+#include "imu_calibration.h"
+#include "driver_mag.h"
 #pragma section all "cpu1_dsram"
 // #pragma section all restore֮ȫֱCPU1RAM
 
+// CPU1ڡĻCORE_UIԴCORE_TELEMETRY
+// ڼ code/system/multicore.c е
+
+// ========== ȫֱ ==========
+uint8 system_enable = 0;     // ϵͳʹܱ־0=ֹͣ1=У
+uint8 param_index = 0;       // ǰڵĲ0~5
+static const char* param_names[] = {
+    "Angle Kp",      // 0: ǶȻ
+    "Angle Ki",      // 1: ǶȻ
+    "Angle Kd",      // 2: ǶȻ΢
+    "Velocity Kp",   // 3: ٶȻ
+    "Velocity Ki",   // 4: ٶȻ
+    "Velocity Kd"    // 5: ٶȻ΢
+};
+
+// ========== Ļˢ ==========
+// жֻ balance_control_state_t գȡղػĻ
+// ػ CPU1 ϽУռ CPU0 ʱ
+void ui_task(void)
+{
+    PROFILER_BEGIN(PROFILER_UI);
+
+    balance_control_state_t balance_state;
+    balance_control_get_state(&balance_state);
+
+    ui_display_data_t ui_data;
+    ui_data.angle = balance_state.roll_filtered_deg;
+    ui_data.angular_velocity = balance_state.roll_rate_deg_s;
+    ui_data.control_output = balance_state.control_output;
+    ui_data.target_angle = balance_state.target_angle;
+    ui_data.system_status = system_enable ? 0 : 1;  // 0=У1=ֹͣ
+    ui_data.isr_time_max_us = balance_state.isr_time_max_us;
+
+    // ȡPID6
+    balance_control_get_pid_params_full(&ui_data.angle_kp, &ui_data.angle_ki, &ui_data.angle_kd,
+                                         &ui_data.velocity_kp, &ui_data.velocity_ki, &ui_data.velocity_kd);
+    ui_data.selected_param = param_index;
+
+    // ȡ
+    float speed;
+    if (odrive_get_speed(&speed)) {
+        ui_data.wheel_speed_rps = speed;
+    } else {
+        ui_data.wheel_speed_rps = 0.0f;  // Чʱʾ0
+    }
+
+    ui_control_update(&ui_data);    // ڲ UI_UPDATE_INTERVAL_MS Ƶ
+    PROFILER_END(PROFILER_UI);
+}
+
+// ========== 10ms ==========
+// ֱӸдƲ float д룩ͣ˼佻 CPU0
+void key_task(void)
+{
+    float angle_kp, angle_ki, angle_kd, vel_kp, vel_ki, vel_kd;
+
+    // ɨ裨Զperiodʱ
+    key_scanner();
+
+    if (key_get_state(KEY_1) == KEY_SHORT_PRESS) {
+        // K1: /ֹͣϵͳ
+        key_clear_state(KEY_1);  // ״̬
+        system_enable = !system_enable;
+        if (multicore_post(CORE_CONTROL, MULTICORE_MSG_CONTROL_ENABLE, &system_enable, 1)) {
+            printf(system_enable ? "System ENABLED\r\n" : "System STOPPED\r\n");
+        } else {
+            system_enable = !system_enable;  // ԭ״̬
+        }
+    }
+
+    if (key_get_state(KEY_2) == KEY_SHORT_PRESS) {
+        // K2: лڲ
+        key_clear_state(KEY_2);
+        param_index = (param_index + 1) % 6;  // 6
+        balance_control_get_pid_params_full(&angle_kp, &angle_ki, &angle_kd, &vel_kp, &vel_ki, &vel_kd);
+        printf("\r\n=== Select: %s ===\r\n", param_names[param_index]);
+        printf("Angle: Kp=%.3f Ki=%.3f Kd=%.3f\r\n", angle_kp, angle_ki, angle_kd);
+        printf("Vel:   Kp=%.3f Ki=%.4f Kd=%.3f\r\n", vel_kp, vel_ki, vel_kd);
+    }
+
+    if (key_get_state(KEY_3) == KEY_SHORT_PRESS) {
+        // K3: ǰ
+        key_clear_state(KEY_3);
+
+        switch (param_index) {
+            case 0: balance_control_adjust_angle_kp(0.1f); break;      // ǶKp 0.1
+            case 1: balance_control_adjust_angle_ki(0.05f); break;     // ǶKi 0.05
+            case 2: balance_control_adjust_angle_kd(0.01f); break;     // ǶKd 0.01
+            case 3: balance_control_adjust_velocity_kp(-0.1f); break;  // ٶKp 0.1=ֵ
+            case 4: balance_control_adjust_velocity_ki(0.001f); break; // ٶKi 0.001
+            case 5: balance_control_adjust_velocity_kd(0.01f); break;  // ٶKd 0.01
+        }
+
+        balance_control_get_pid_params_full(&angle_kp, &angle_ki, &angle_kd, &vel_kp, &vel_ki, &vel_kd);
+        printf("+ %s -> A[%.2f,%.2f,%.2f] V[%.2f,%.3f,%.2f]\r\n",
+               param_names[param_index], angle_kp, angle_ki, angle_kd, vel_kp, vel_ki, vel_kd);
+    }
+
+    if (key_get_state(KEY_4) == KEY_SHORT_PRESS) {
+        // K4: Сǰ
+        key_clear_state(KEY_4);
+
+        switch (param_index) {
+            case 0: balance_control_adjust_angle_kp(-0.1f); break;     // ǶKp 0.1
+            case 1: balance_control_adjust_angle_ki(-0.05f); break;    // ǶKi 0.05
+            case 2: balance_control_adjust_angle_kd(-0.01f); break;    // ǶKd 0.01
+            case 3: balance_control_adjust_velocity_kp(0.1f); break;   // ٶKp 0.1=Сֵ
+            case 4: balance_control_adjust_velocity_ki(-0.001f); break;// ٶKi 0.001
+            case 5: balance_control_adjust_velocity_kd(-0.01f); break; // ٶKd 0.01
+        }
+
+        balance_control_get_pid_params_full(&angle_kp, &angle_ki, &angle_kd, &vel_kp, &vel_ki, &vel_kd);
+        printf("- %s -> A[%.2f,%.2f,%.2f] V[%.2f,%.3f,%.2f]\r\n",
+               param_names[param_index], angle_kp, angle_ki, angle_kd, vel_kp, vel_ki, vel_kd);
+    }
+}
+
+// ========== ȱ's' ==========
+static void schedule_report(void)
+{
+    static const char *row_names[GAIN_SCHEDULE_GAIN_NUM] = {
+        "angle kp", "angle ki", "angle kd", "rate kp", "rate ki", "rate kd", "lqr roll", "lqr rate", "lqr wheel"
+    };
+    gain_schedule_table_t schedule;
+    balance_control_state_t balance_state;
+    uint32 g, i;
+
+    balance_control_get_schedule(&schedule);
+    balance_control_get_state(&balance_state);
+    printf("gain schedule (now %.2f m/s, LQR rows %s)\r\n", balance_state.forward_speed_mps,
+           balance_control_get_lqr_gain_set_name(balance_control_get_lqr_gain_set()));
+    printf("%-10s", "m/s");
+    for (i = 0; i < GAIN_SCHEDULE_POINTS; i++) {
+        printf(" %8.2f", schedule.speed_mps[i]);
+    }
+    printf("\r\n");
+    for (g = 0; g < GAIN_SCHEDULE_GAIN_NUM; g++) {
+        printf("%-10s", row_names[g]);
+        for (i = 0; i < GAIN_SCHEDULE_POINTS; i++) {
+            printf(" %8.4f", schedule.gain[g][i]);
+        }
+        printf("\r\n");
+    }
+}
+
+// ========== Դͳ ==========
+// 'p'ӡִʱͳƱÿֻһΣʱ
+// 'r'ͳ
+// 'o'ʾǰ8ִʱ䣬λus100msһ֡
+// 'l'ӡCPU˼䶪
+// 'u'ӡĻˢºʱд
+// 'f'ֶϻӣټ¼0.5s󶳽ᣩ
+// 'd'Զĺϻݣ޶ʱDFlashбһݣ tools/sim/flight_decode תΪCSV
+// 'a'ϻ¿ʼ¼
+// 'y'ӡ YIS IMU ͳƣ֡ DMA жϴ
+// 'i'ӡ IMU ں״̬·ϡYIS Ȩءӳٹƣ궨ź
+// 'c'IMU 궨ϵͳֹͣʱѳƽ㾲ֹԼ 3sƫ밲װƫǴ DFlashϵԶأ
+// 'm'Ʊ궨ʼ / ųתȦбԼ 45 ȣӲУ DFlashϵԶأ
+// 'b'лƽģʽPID  -> LQRǰ棩-> LQR 棨lqr_gains.h-> +֣STEER-> PIDҲлԱԱ
+// 'g'õٶȶϵ㣺ȫ -> ϵ0..5 -> ȫ
+// 's'ӡȱٶȶϵϵȫ棩
+// 'w'ȱ DFlashϵԶ
+// 'z'طȥͣģʽ PID/STEER °ƫĿǶȣ÷ֽ٣ӡǰƫ
+void telemetry_task(void)
+{
+    static uint8 assistant_enable = 0;
+    static uint32 last_assistant_send = 0;
+    uint8 cmd;
+
+    while (debug_read_ring_buffer(&cmd, 1)) {
+        if (cmd == 'p') {
+            profiler_report_start();
+        } else if (cmd == 'r') {
+            profiler_reset();
+            printf("Profiler reset\r\n");
+        } else if (cmd == 'o') {
+            assistant_enable = !assistant_enable;
+        } else if (cmd == 'l') {
+            multicore_report();
+        } else if (cmd == 'u') {
+            ui_render_stats_t ui_stats;
+            ui_control_get_stats(&ui_stats);
+            printf("ui frames %lu  last %lu us  max %lu us  pixels %lu (%lu regions)\r\n",
+                   (unsigned long)ui_stats.frames, (unsigned long)ui_stats.last_us, (unsigned long)ui_stats.max_us,
+                   (unsigned long)ui_stats.last_pixels, (unsigned long)ui_stats.last_runs);
+        } else if (cmd == 'f') {
+            flight_recorder_trigger(FLIGHT_RECORDER_CAUSE_MANUAL);
+        } else if (cmd == 'd') {
+            flight_recorder_dump();
+        } else if (cmd == 'a') {
+            flight_recorder_rearm();
+        } else if (cmd == 'y') {
+            yis_report();
+        } else if (cmd == 'i') {
+            imu_report();
+            imu_calibration_report();
+            mag_report();
+        } else if (cmd == 'c') {
+            if (system_enable) {
+                printf("imu calibration: stop the system first\r\n");
+            } else {
+                imu_calibration_start();
+            }
+        } else if (cmd == 'm') {
+            mag_calibration_toggle();
+        } else if (cmd == 'b') {
+            balance_control_state_t balance_state;
+            uint8 mode = BALANCE_MODE_LQR;
+            uint8 set = balance_control_get_lqr_gain_set();
+
+            // LQR ڵȱβֻࣩģʽ䷢ CPU0
+            balance_control_get_state(&balance_state);
+            if (balance_state.mode == BALANCE_MODE_LQR) {
+                if (set + 1u < balance_control_get_lqr_gain_set_num()) {
+                    balance_control_select_lqr_gain_set(set + 1u);
+                } else if (set == balance_control_get_lqr_gain_set_num()) {
+                    balance_control_select_lqr_gain_set(0u);   // DFlash еı֮ӵһ鿪ʼ
+                } else {
+                    mode = BALANCE_MODE_STEER;
+                }
+            } else if (balance_state.mode == BALANCE_MODE_STEER) {
+                mode = BALANCE_MODE_PID;
+            }
+            if (mode == balance_state.mode || multicore_post(CORE_CONTROL, MULTICORE_MSG_CONTROL_MODE, &mode, 1)) {
+                if (mode == BALANCE_MODE_LQR) {
+                    printf("balance mode: LQR %s\r\n", balance_control_get_lqr_gain_set_name(balance_control_get_lqr_gain_set()));
+                } else if (mode == BALANCE_MODE_STEER) {
+                    printf("balance mode: STEER cascade, servo + wheel (%.2f m/s, steer %.1f deg)\r\n",
+                           balance_state.forward_speed_mps, balance_state.steer_deg);
+                } else {
+                    printf("balance mode: PID cascade\r\n");
+                }
+            }
+        } else if (cmd == 'g') {
+            gain_schedule_table_t schedule;
+            int8 point = balance_control_get_schedule_point() + 1;
+
+            balance_control_select_schedule_point(point < GAIN_SCHEDULE_POINTS ? point : -1);
+            point = balance_control_get_schedule_point();
+            balance_control_get_schedule(&schedule);
+            if (point < 0) {
+                printf("gain schedule: keys move all points\r\n");
+            } else {
+                printf("gain schedule: keys edit point %d (%.2f m/s)\r\n", point, schedule.speed_mps[point]);
+            }
+        } else if (cmd == 's') {
+            schedule_report();
+        } else if (cmd == 'w') {
+            balance_control_save_schedule();
+            printf("gain schedule saved\r\n");
+        } else if (cmd == 'z') {
+            balance_control_state_t balance_state;
+
+            balance_control_set_desat_enable(!balance_control_get_desat_enable());
+            balance_control_get_state(&balance_state);
+            printf("wheel desaturation %s: bias %.2f deg, wheel %.1f rps\r\n",
+                   balance_control_get_desat_enable() ? "on" : "off",
+                   balance_state.desat_bias_deg, balance_state.wheel_speed_rps);
+        }
+    }
+
+    profiler_report_step();
+
+    if (assistant_enable && (system_getval_ms() - last_assistant_send >= 100)) {
+        last_assistant_send = system_getval_ms();
+        profiler_send_assistant();
+    }
+}
+
 
 // ̵뵽֮ӦѡйȻrefreshˢһ֮ٱ
 // ĬΪرŻԼһѡproperties->C/C++ Build->Setting
@@ -59,14 +338,6 @@ void core1_main(void)
 
     // ˴дû ʼ
     cpu_wait_event_ready();                 // ȴкĳʼ
-    while (TRUE)
-    {
-        // ˴дҪѭִеĴ
-
-
-
-
-        // ˴дҪѭִеĴ
-    }
+    multicore_run();                        // ִз CPU1  ͳƸ
 }
 #pragma section all restore
@@ -33,6 +33,7 @@
 * 2022-11-04       pudding            first version
 ********************************************************************************************************************/
 #include "zf_common_headfile.h"
+#include "multicore.h"
 #pragma section all "cpu2_dsram"
 // #pragma section all restore֮ȫֱCPU1RAM
 
@@ -58,15 +59,7 @@ void core2_main(void)
 
     // ˴дû ʼ
     cpu_wait_event_ready();                 // ȴкĳʼ
-    while (TRUE)
-    {
-        // ˴дҪѭִеĴ
-
-
-
-
-        // ˴дҪѭִеĴ
-    }
+    multicore_run();                        // CPU2CORE_SENSORYIS ֡ DMA жнIMU660RA ں PIT ں˼佻 CPU0
 }
 
 
@@ -34,6 +34,7 @@
 ********************************************************************************************************************/
 
 #include "zf_common_headfile.h"
+#include "multicore.h"
 #pragma section all "cpu3_dsram"
 // #pragma section all restore֮ȫֱCPU1RAM
 
@@ -59,15 +60,7 @@ void core3_main(void)
 
     // ˴дû ʼ
     cpu_wait_event_ready();                 // ȴкĳʼ
-    while (TRUE)
-    {
-        // ˴дҪѭִеĴ
-
-
-
-
-        // ˴дҪѭִеĴ
-    }
+    multicore_run();                        // CPU3δֻͳƸ
 }
 
 
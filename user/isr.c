@@ -36,13 +36,11 @@
 #include "isr_config.h"
 #include "isr.h"
 #include "driver_imu.h"
+#include "driver_imu_fusion.h"
+#include "driver_imu_spi.h"
 #include "balance_control.h"
-#include "ui_control.h"
 #include "driver_odrive.h"
-
-// 外部变量声明
-extern uint8 system_enable;
-extern uint8 param_index;
+#include "multicore.h"
 
 // 对于TC系列默认是不支持中断嵌套的，希望支持中断嵌套需要在中断内使用 interrupt_global_enable(0); 来开启中断嵌套
 // 简单点说实际上进入中断后TC系列的硬件自动调用了 interrupt_global_disable(); 来拒绝响应任何的中断，因此需要我们自己手动调用 interrupt_global_enable(0); 来开启中断的响应。
@@ -53,34 +51,8 @@ IFX_INTERRUPT(cc60_pit_ch0_isr, CCU6_0_CH0_INT_VECTAB_NUM, CCU6_0_CH0_ISR_PRIORI
     interrupt_global_enable(0);                     // 使能中断嵌套
     pit_clear_flag(CCU60_CH0);
     
-    // 更新平衡控制
+    // 更新平衡控制（内部发布状态快照，屏幕刷新在主循环中完成）
     balance_control_update_5ms_isr();
-    
-    // 更新屏幕显示
-    balance_control_state_t balance_state;
-    balance_control_get_state(&balance_state);
-    
-    ui_display_data_t ui_data;
-    ui_data.angle = balance_state.roll_filtered_deg;
-    ui_data.angular_velocity = balance_state.roll_rate_deg_s;
-    ui_data.control_output = balance_state.control_output;
-    ui_data.target_angle = balance_state.target_angle;
-    ui_data.system_status = system_enable ? 0 : 1;  // 0=运行，1=停止
-    
-    // 获取PID参数（完整6个参数）
-    balance_control_get_pid_params_full(&ui_data.angle_kp, &ui_data.angle_ki, &ui_data.angle_kd,
-                                         &ui_data.velocity_kp, &ui_data.velocity_ki, &ui_data.velocity_kd);
-    ui_data.selected_param = param_index;
-    
-    // 获取轮速（使用新的API）
-    float speed;
-    if (odrive_get_speed(&speed)) {
-        ui_data.wheel_speed_rps = speed;
-    } else {
-        ui_data.wheel_speed_rps = 0.0f;  // 无有效数据时显示0
-    }
-    
-    ui_control_update(&ui_data);
 }
 
 
@@ -99,9 +71,7 @@ IFX_INTERRUPT(cc61_pit_ch0_isr, CCU6_1_CH0_INT_VECTAB_NUM, CCU6_1_CH0_ISR_PRIORI
     interrupt_global_enable(0);                     // �����ж�Ƕ��
     pit_clear_flag(CCU61_CH0);
 
-
-
-
+    imu_pit_handler();
 }
 
 IFX_INTERRUPT(cc61_pit_ch1_isr, CCU6_1_CH1_INT_VECTAB_NUM, CCU6_1_CH1_ISR_PRIORITY)
@@ -124,9 +94,7 @@ IFX_INTERRUPT(exti_ch0_ch4_isr, EXTI_CH0_CH4_INT_VECTAB_NUM, EXTI_CH0_CH4_INT_PR
     if(exti_flag_get(ERU_CH0_REQ0_P15_4))           // ͨ��0�ж�
     {
         exti_flag_clear(ERU_CH0_REQ0_P15_4);
-
-
-
+        imu_spi_exti_handler();
     }
 
     if(exti_flag_get(ERU_CH4_REQ13_P15_5))          // ͨ��4�ж�
@@ -208,6 +176,7 @@ IFX_INTERRUPT(dma_ch5_isr, DMA_INT_VECTAB_NUM, DMA_INT_PRIO)
 IFX_INTERRUPT(uart0_tx_isr, UART0_INT_VECTAB_NUM, UART0_TX_INT_PRIO)
 {
     interrupt_global_enable(0);                     // �����ж�Ƕ��
+    uart_tx_handler(UART_0);
 
 
 
@@ -226,6 +195,7 @@ IFX_INTERRUPT(uart0_rx_isr, UART0_INT_VECTAB_NUM, UART0_RX_INT_PRIO)
 IFX_INTERRUPT(uart1_tx_isr, UART1_INT_VECTAB_NUM, UART1_TX_INT_PRIO)
 {
     interrupt_global_enable(0);                     // �����ж�Ƕ��
+    uart_tx_handler(UART_1);
 
 
 
@@ -241,6 +211,7 @@ IFX_INTERRUPT(uart1_rx_isr, UART1_INT_VECTAB_NUM, UART1_RX_INT_PRIO)
 IFX_INTERRUPT(uart2_tx_isr, UART2_INT_VECTAB_NUM, UART2_TX_INT_PRIO)
 {
     interrupt_global_enable(0);                     // �����ж�Ƕ��
+    uart_tx_handler(UART_2);
 
 
 
@@ -259,6 +230,7 @@ IFX_INTERRUPT(uart2_rx_isr, UART2_INT_VECTAB_NUM, UART2_RX_INT_PRIO)
 IFX_INTERRUPT(uart3_tx_isr, UART3_INT_VECTAB_NUM, UART3_TX_INT_PRIO)
 {
     interrupt_global_enable(0);                     // �����ж�Ƕ��
+    uart_tx_handler(UART_3);
 
 
 
@@ -277,6 +249,7 @@ IFX_INTERRUPT(uart3_rx_isr, UART3_INT_VECTAB_NUM, UART3_RX_INT_PRIO)
 IFX_INTERRUPT(uart4_tx_isr, UART4_INT_VECTAB_NUM, UART4_TX_INT_PRIO)
 {
     interrupt_global_enable(0);                     // �����ж�Ƕ��
+    uart_tx_handler(UART_4);
 
 
 
@@ -293,6 +266,7 @@ IFX_INTERRUPT(uart4_rx_isr, UART4_INT_VECTAB_NUM, UART4_RX_INT_PRIO)
 IFX_INTERRUPT(uart5_tx_isr, UART5_INT_VECTAB_NUM, UART5_TX_INT_PRIO)
 {
     interrupt_global_enable(0);                     // �����ж�Ƕ��
+    uart_tx_handler(UART_5);
 
 
 
@@ -301,7 +275,6 @@ IFX_INTERRUPT(uart5_tx_isr, UART5_INT_VECTAB_NUM, UART5_TX_INT_PRIO)
 IFX_INTERRUPT(uart5_rx_isr, UART5_INT_VECTAB_NUM, UART5_RX_INT_PRIO)
 {
     interrupt_global_enable(0);                     // �����ж�Ƕ��
-    yis_uart_rx_handler();
 
 
 
@@ -310,6 +283,7 @@ IFX_INTERRUPT(uart5_rx_isr, UART5_INT_VECTAB_NUM, UART5_RX_INT_PRIO)
 IFX_INTERRUPT(uart6_tx_isr, UART6_INT_VECTAB_NUM, UART6_TX_INT_PRIO)
 {
     interrupt_global_enable(0);                     // �����ж�Ƕ��
+    uart_tx_handler(UART_6);
 
 
 
@@ -326,6 +300,7 @@ IFX_INTERRUPT(uart6_rx_isr, UART6_INT_VECTAB_NUM, UART6_RX_INT_PRIO)
 IFX_INTERRUPT(uart8_tx_isr, UART8_INT_VECTAB_NUM, UART8_TX_INT_PRIO)
 {
     interrupt_global_enable(0);                     // �����ж�Ƕ��
+    uart_tx_handler(UART_8);
 
 
 
@@ -342,6 +317,7 @@ IFX_INTERRUPT(uart8_rx_isr, UART8_INT_VECTAB_NUM, UART8_RX_INT_PRIO)
 IFX_INTERRUPT(uart9_tx_isr, UART9_INT_VECTAB_NUM, UART9_TX_INT_PRIO)
 {
     interrupt_global_enable(0);                     // �����ж�Ƕ��
+    uart_tx_handler(UART_9);
 
 
 
@@ -358,6 +334,7 @@ IFX_INTERRUPT(uart9_rx_isr, UART9_INT_VECTAB_NUM, UART9_RX_INT_PRIO)
 IFX_INTERRUPT(uart10_tx_isr, UART10_INT_VECTAB_NUM, UART10_TX_INT_PRIO)
 {
     interrupt_global_enable(0);                     // �����ж�Ƕ��
+    uart_tx_handler(UART_10);
 
 
 
@@ -374,6 +351,7 @@ IFX_INTERRUPT(uart10_rx_isr, UART10_INT_VECTAB_NUM, UART10_RX_INT_PRIO)
 IFX_INTERRUPT(uart11_tx_isr, UART11_INT_VECTAB_NUM, UART11_TX_INT_PRIO)
 {
     interrupt_global_enable(0);                     // �����ж�Ƕ��
+    uart_tx_handler(UART_11);
 
 
 
@@ -442,5 +420,47 @@ IFX_INTERRUPT(uart11_er_isr, UART11_INT_VECTAB_NUM, UART11_ER_INT_PRIO)
     interrupt_global_enable(0);                     // �����ж�Ƕ��
     IfxAsclin_Asc_isrError(&uart11_handle);
 }
+
+// CAN0 RX FIFO0 新消息中断：ODrive 编码器估计/心跳帧
+IFX_INTERRUPT(can0_rx_isr, CAN0_INT_VECTAB_NUM, CAN0_RX_INT_PRIO)
+{
+    interrupt_global_enable(0);                     // �����ж�Ƕ��
+    odrive_can_rx_isr();
+}
+
+// 核间邮箱中断：multicore_post() 置位目标 CPU 的 GPSR 软件中断，在这里分发消息
+IFX_INTERRUPT(cpu0_mailbox_isr, CPU0_MAILBOX_INT_VECTAB_NUM, CPU0_MAILBOX_INT_PRIO)
+{
+    interrupt_global_enable(0);                     // 使能中断嵌套
+    multicore_mailbox_isr();
+}
+IFX_INTERRUPT(cpu1_mailbox_isr, CPU1_MAILBOX_INT_VECTAB_NUM, CPU1_MAILBOX_INT_PRIO)
+{
+    interrupt_global_enable(0);                     // 使能中断嵌套
+    multicore_mailbox_isr();
+}
+IFX_INTERRUPT(cpu2_mailbox_isr, CPU2_MAILBOX_INT_VECTAB_NUM, CPU2_MAILBOX_INT_PRIO)
+{
+    interrupt_global_enable(0);                     // 使能中断嵌套
+    multicore_mailbox_isr();
+}
+IFX_INTERRUPT(cpu3_mailbox_isr, CPU3_MAILBOX_INT_VECTAB_NUM, CPU3_MAILBOX_INT_PRIO)
+{
+    interrupt_global_enable(0);                     // 使能中断嵌套
+    multicore_mailbox_isr();
+}
+
+// YIS IMU 接收 DMA 传输结束中断：每收齐一帧进一次（code/drivers/driver_imu.c）
+IFX_INTERRUPT(yis_dma_isr, YIS_DMA_INT_VECTAB_NUM, YIS_DMA_INT_PRIO)
+{
+    interrupt_global_enable(0);                     // 使能中断嵌套
+    yis_dma_rx_handler();
+}
+
+IFX_INTERRUPT(imu_spi_dma_isr, IMU_SPI_DMA_INT_VECTAB_NUM, IMU_SPI_DMA_INT_PRIO)
+{
+    interrupt_global_enable(0);                     // 使能中断嵌套
+    imu_spi_dma_handler();
+}
 // **************************** �����жϺ��� ****************************
 
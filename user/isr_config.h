@@ -45,7 +45,7 @@
 #define CCU6_0_CH1_INT_SERVICE  IfxSrc_Tos_cpu0
 #define CCU6_0_CH1_ISR_PRIORITY 51
 
-#define CCU6_1_CH0_INT_SERVICE  IfxSrc_Tos_cpu0
+#define CCU6_1_CH0_INT_SERVICE  IfxSrc_Tos_cpu2     // IMU ں 1kHz ȡ IMU660RA FIFO  YIS ֡ CORE_SENSORCPU2
 #define CCU6_1_CH0_ISR_PRIORITY 52
 
 #define CCU6_1_CH1_INT_SERVICE  IfxSrc_Tos_cpu0
@@ -55,7 +55,7 @@
 
 //================================================GPIOжϲض===============================================
 // ͨ0ͨ4ǹһжϺ жڲͨ־λж˭ж
-#define EXTI_CH0_CH4_INT_SERVICE IfxSrc_Tos_cpu0    // ERUͨ0ͨ4жϷͣж˭Ӧ IfxSrc_Tos_cpu0 IfxSrc_Tos_cpu1 IfxSrc_Tos_dma  Ϊֵ
+#define EXTI_CH0_CH4_INT_SERVICE IfxSrc_Tos_cpu2    // IMU660RA INT1 FIFO ˮλжϣP15_4 CORE_SENSORCPU2 QSPI DMA ȡ
 #define EXTI_CH0_CH4_INT_PRIO   60                  // ERUͨ0ͨ4жȼ ȼΧ1-255 ԽȼԽ ƽʱʹõĵƬһ
 
 // ͨ1ͨ5ǹһжϺ жڲͨ־λ ж˭ж
@@ -77,7 +77,8 @@
 
 
 //===================================================жϲض===============================================
-#define UART0_INT_SERVICE       IfxSrc_Tos_cpu0     // 崮0жϷͣж˭Ӧ IfxSrc_Tos_cpu0 IfxSrc_Tos_cpu1 IfxSrc_Tos_dma  Ϊֵ
+#define UART0_INT_SERVICE       IfxSrc_Tos_cpu1     // 崮0жϷͣж˭Ӧ IfxSrc_Tos_cpu0 IfxSrc_Tos_cpu1 IfxSrc_Tos_dma  Ϊֵ
+                                                    // Դ  CORE_TELEMETRYCPU1 ͻֻɸ CPU д
 #define UART0_TX_INT_PRIO       11                  // 崮0жȼ ȼΧ1-255 ԽȼԽ ƽʱʹõĵƬһ
 #define UART0_RX_INT_PRIO       10                  // 崮0жȼ ȼΧ1-255 ԽȼԽ ƽʱʹõĵƬһ
 #define UART0_ER_INT_PRIO       12                  // 崮0жȼ ȼΧ1-255 ԽȼԽ ƽʱʹõĵƬһ
@@ -102,7 +103,7 @@
 #define UART4_RX_INT_PRIO       23
 #define UART4_ER_INT_PRIO       24
 
-#define UART5_INT_SERVICE       IfxSrc_Tos_cpu0
+#define UART5_INT_SERVICE       IfxSrc_Tos_cpu2     // YIS IMU   DMA ˣ YIS_DMA_CH CORE_SENSORCPU2ֱ֡ӷ
 #define UART5_TX_INT_PRIO       25
 #define UART5_RX_INT_PRIO       26
 #define UART5_ER_INT_PRIO       27
@@ -133,6 +134,34 @@
 #define UART11_ER_INT_PRIO       42
 
 
+//===================================================CANжϲض===============================================
+#define CAN0_INT_SERVICE        IfxSrc_Tos_cpu0     // CAN0жϷͣODrive CANSimple IfxSrc_Tos_cpu0 IfxSrc_Tos_cpu1 IfxSrc_Tos_dma  Ϊֵ
+#define CAN0_RX_INT_PRIO        45                  // CAN0 RX FIFO0Ϣжȼ 5msж ڸж
+
+
+//===================================================˼жϲض===============================================
+// ж GPSR  x ̶ CPUx Ӧcode/system/multicore.c ж CPU 
+#define CPU0_MAILBOX_INT_PRIO   44                  // CPU0 ˼жȼ ں̬ 5msжCANж ƽսж
+#define CPU1_MAILBOX_INT_PRIO   46
+#define CPU2_MAILBOX_INT_PRIO   47
+#define CPU3_MAILBOX_INT_PRIO   48
+
+
+//===================================================YIS IMU DMAض===============================================
+// UART5  DMA ͨ YIS_DMA_CH Ӧcode/drivers/driver_imu.cȼͨţ DMA Ӧظ
+#define YIS_DMA_CH              (10)                // YIS  DMA ͨ ͷռͨ 5
+#define YIS_DMA_INT_SERVICE     IfxSrc_Tos_cpu2     // DMA ж  CORE_SENSORCPU2֡
+#define YIS_DMA_INT_PRIO        49                  // ÿ֡һ ԭ UART5 ֽڽж
+
+
+//===================================================IMU660RA SPI DMAض===============================================
+// QSPI0 / DMA ͨ IMU_SPI_TX_DMA_CH / IMU_SPI_RX_DMA_CH Ӧcode/drivers/driver_imu_spi.cȼͨ
+#define IMU_SPI_TX_DMA_CH       (11)                // ͨ ȼڽͨ  FIFO ȱȡ
+#define IMU_SPI_RX_DMA_CH       (12)
+#define IMU_SPI_DMA_INT_SERVICE IfxSrc_Tos_cpu2     //  DMA ж  CORE_SENSORCPU2 FIFO 
+#define IMU_SPI_DMA_INT_PRIO    43                  // ÿΣFIFO_LENGTHFIFO_DATA ں PIT ˮλж
+
+
 
 
 
@@ -163,4 +192,14 @@
 #define UART10_INT_VECTAB_NUM        (int)UART10_INT_SERVICE          > 0 ? (int)UART10_INT_SERVICE        - 1 : (int)UART10_INT_SERVICE
 #define UART11_INT_VECTAB_NUM        (int)UART11_INT_SERVICE          > 0 ? (int)UART11_INT_SERVICE        - 1 : (int)UART11_INT_SERVICE
 
+#define CAN0_INT_VECTAB_NUM          (int)CAN0_INT_SERVICE            > 0 ? (int)CAN0_INT_SERVICE          - 1 : (int)CAN0_INT_SERVICE
+
+#define CPU0_MAILBOX_INT_VECTAB_NUM  (0)
+#define CPU1_MAILBOX_INT_VECTAB_NUM  (1)
+#define CPU2_MAILBOX_INT_VECTAB_NUM  (2)
+#define CPU3_MAILBOX_INT_VECTAB_NUM  (3)
+
+#define YIS_DMA_INT_VECTAB_NUM       (int)YIS_DMA_INT_SERVICE         > 0 ? (int)YIS_DMA_INT_SERVICE       - 1 : (int)YIS_DMA_INT_SERVICE
+#define IMU_SPI_DMA_INT_VECTAB_NUM   (int)IMU_SPI_DMA_INT_SERVICE     > 0 ? (int)IMU_SPI_DMA_INT_SERVICE   - 1 : (int)IMU_SPI_DMA_INT_SERVICE
+
 #endif